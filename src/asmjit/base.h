@@ -11,7 +11,9 @@
 // [Dependencies]
 #include "./base/arch.h"
 #include "./base/assembler.h"
+#include "./base/bitops.h"
 #include "./base/codebuilder.h"
+#include "./base/codecache.h"
 #include "./base/codecompiler.h"
 #include "./base/codeemitter.h"
 #include "./base/codeholder.h"
@@ -23,6 +25,8 @@
 #include "./base/logging.h"
 #include "./base/operand.h"
 #include "./base/osutils.h"
+#include "./base/perflistener.h"
+#include "./base/reclaimer.h"
 #include "./base/runtime.h"
 #include "./base/simdtypes.h"
 #include "./base/string.h"
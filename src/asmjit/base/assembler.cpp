@@ -28,6 +28,7 @@ Assembler::Assembler() noexcept
     _bufferData(nullptr),
     _bufferEnd(nullptr),
     _bufferPtr(nullptr),
+    _bufferOffset(0),
     _op4(),
     _op5() {}
 
@@ -42,11 +43,7 @@ Assembler::~Assembler() noexcept {
 Error Assembler::onAttach(CodeHolder* code) noexcept {
   // Attach to the end of the .text section.
   _section = code->_sections[0];
-  uint8_t* p = _section->_buffer._data;
-
-  _bufferData = p;
-  _bufferEnd  = p + _section->_buffer._capacity;
-  _bufferPtr  = p + _section->_buffer._length;
+  _setBuffer(_section->_buffer, _section->_buffer._length);
 
   _op4.reset();
   _op5.reset();
@@ -59,6 +56,7 @@ Error Assembler::onDetach(CodeHolder* code) noexcept {
   _bufferData = nullptr;
   _bufferEnd  = nullptr;
   _bufferPtr  = nullptr;
+  _bufferOffset = 0;
 
   _op4.reset();
   _op5.reset();
@@ -113,7 +111,7 @@ void Assembler::sync() noexcept {
   ASMJIT_ASSERT(_bufferData == _section->_buffer._data); // `_bufferStart` is a shortcut to `_section->buffer.data`.
 
   // Update only if the current offset is greater than the section length.
-  size_t offset = (size_t)(_bufferPtr - _bufferData);
+  size_t offset = getOffset();
   if (_section->getBuffer().getLength() < offset)
     _section->_buffer._length = offset;
 }
@@ -126,7 +124,7 @@ Error Assembler::setOffset(size_t offset) {
   if (_lastError) return _lastError;
 
   size_t length = std::max(_section->getBuffer().getLength(), getOffset());
-  if (ASMJIT_UNLIKELY(offset > length))
+  if (ASMJIT_UNLIKELY(offset > length || offset < _bufferOffset))
     return setLastError(DebugUtils::errored(kErrorInvalidArgument));
 
   // If the `Assembler` generated any code the `_bufferPtr` may be higher than
@@ -135,7 +133,7 @@ Error Assembler::setOffset(size_t offset) {
   if (_section->_buffer._length < length)
     _section->_buffer._length = length;
 
-  _bufferPtr = _bufferData + offset;
+  _bufferPtr = _bufferData + (offset - _bufferOffset);
   return kErrorOk;
 }
 
@@ -214,9 +212,17 @@ Error Assembler::bind(const Label& label) {
   }
 #endif // !ASMJIT_DISABLE_LOGGING
 
-  Error err = kErrorOk;
+  Error err = _code->_journalLabel(le);
+  if (ASMJIT_UNLIKELY(err))
+    return setLastError(err);
+
   size_t pos = getOffset();
 
+  // Links are kept while there are live checkpoints, `CodeHolder::rollback()`
+  // needs them to unbind the label.
+  bool keepLinks = _code->hasCheckpoints();
+
+  uint32_t sectionId = _section->getId();
   LabelLink* link = le->_links;
   LabelLink* prev = nullptr;
 
@@ -227,8 +233,26 @@ Error Assembler::bind(const Label& label) {
     if (relocId != RelocEntry::kInvalidId) {
       // Adjust relocation data.
       RelocEntry* re = _code->_relocations[relocId];
+      re->_targetSectionId = sectionId;
       re->_data += static_cast<uint64_t>(pos);
     }
+    else if (link->sectionId != sectionId) {
+      // The displacement is in another section, its value is not known until
+      // sections are laid out, so turn the link into a relocation.
+      CodeBuffer& buf = _code->_sections[link->sectionId]->_buffer;
+      RelocEntry* re;
+
+      Error reErr = _code->newRelocEntry(&re, RelocEntry::kTypeRelToRel, *buf.getDataAt(static_cast<size_t>(offset)));
+      if (ASMJIT_LIKELY(reErr == kErrorOk)) {
+        re->_sourceSectionId = link->sectionId;
+        re->_targetSectionId = sectionId;
+        re->_sourceOffset = static_cast<uint64_t>(offset);
+        re->_data = static_cast<uint64_t>(static_cast<int64_t>(pos) + link->rel);
+      }
+      else {
+        err = reErr;
+      }
+    }
     else {
       // Not using relocId, this means that we are overwriting a real
       // displacement in the CodeBuffer.
@@ -236,26 +260,29 @@ Error Assembler::bind(const Label& label) {
         static_cast<intptr_t>(pos) - offset + link->rel);
 
       // Size of the value we are going to patch. Only BYTE/DWORD is allowed.
-      uint32_t size = _bufferData[offset];
+      uint8_t* p = _section->_buffer.getDataAt(static_cast<size_t>(offset));
+      uint32_t size = p[0];
       if (size == 4)
-        Utils::writeI32u(_bufferData + offset, static_cast<int32_t>(patchedValue));
+        Utils::writeI32u(p, static_cast<int32_t>(patchedValue));
       else if (size == 1 && Utils::isInt8(patchedValue))
-        _bufferData[offset] = static_cast<uint8_t>(patchedValue & 0xFF);
+        p[0] = static_cast<uint8_t>(patchedValue & 0xFF);
       else
         err = DebugUtils::errored(kErrorInvalidDisplacement);
     }
 
     prev = link->prev;
     _code->_unresolvedLabelsCount--;
-    _code->_baseHeap.release(link, sizeof(LabelLink));
+    if (!keepLinks)
+      _code->_baseHeap.release(link, sizeof(LabelLink));
 
     link = prev;
   }
 
   // Set as bound.
-  le->_sectionId = _section->getId();
+  le->_sectionId = sectionId;
   le->_offset = pos;
-  le->_links = nullptr;
+  if (!keepLinks)
+    le->_links = nullptr;
   resetInlineComment();
 
   if (err != kErrorOk)
@@ -264,6 +291,28 @@ Error Assembler::bind(const Label& label) {
   return kErrorOk;
 }
 
+Error Assembler::section(SectionEntry* section) {
+  if (_lastError) return _lastError;
+  ASMJIT_ASSERT(_code != nullptr);
+
+  uint32_t sectionId = section ? section->getId() : SectionEntry::kInvalidId;
+  if (ASMJIT_UNLIKELY(sectionId >= _code->_sections.getLength() || _code->_sections[sectionId] != section))
+    return setLastError(DebugUtils::errored(kErrorInvalidSection));
+
+#if !defined(ASMJIT_DISABLE_LOGGING)
+  if (_globalOptions & kOptionLoggingEnabled)
+    _code->_logger->logf(".section %s\n", section->getName());
+#endif // !ASMJIT_DISABLE_LOGGING
+
+  // Store the length of the current section before leaving it.
+  sync();
+
+  _section = section;
+  _setBuffer(section->_buffer, section->_buffer._length);
+
+  return kErrorOk;
+}
+
 Error Assembler::embed(const void* data, uint32_t size) {
   if (_lastError) return _lastError;
 
@@ -321,6 +370,7 @@ Error Assembler::embedLabel(const Label& label) {
     if (ASMJIT_UNLIKELY(!link))
       return setLastError(DebugUtils::errored(kErrorNoHeapMemory));
     link->relocId = re->getId();
+    link->size = gpSize;
   }
 
   // Emit dummy DWORD/QWORD depending on the address size.
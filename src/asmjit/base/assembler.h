@@ -69,26 +69,40 @@ public:
   //! Called by \ref CodeHolder::sync().
   ASMJIT_API virtual void sync() noexcept;
 
-  //! Get the capacity of the current CodeBuffer.
+  //! Get the capacity of the current CodeBuffer (of its last chunk if chunked).
   ASMJIT_INLINE size_t getBufferCapacity() const noexcept { return (size_t)(_bufferEnd - _bufferData); }
   //! Get the number of remaining bytes in the current CodeBuffer.
   ASMJIT_INLINE size_t getRemainingSpace() const noexcept { return (size_t)(_bufferEnd - _bufferPtr); }
 
   //! Get the current position in the CodeBuffer.
-  ASMJIT_INLINE size_t getOffset() const noexcept { return (size_t)(_bufferPtr - _bufferData); }
+  ASMJIT_INLINE size_t getOffset() const noexcept { return _bufferOffset + (size_t)(_bufferPtr - _bufferData); }
   //! Set the current position in the CodeBuffer to `offset`.
   //!
   //! NOTE: The `offset` cannot be outside of the buffer length (even if it's
-  //! within buffer's capacity).
+  //! within buffer's capacity), and it must be within the last chunk if the
+  //! buffer is chunked.
   ASMJIT_API Error setOffset(size_t offset);
 
-  //! Get start of the CodeBuffer of the current section.
+  //! Get start of the CodeBuffer of the current section (of its last chunk,
+  //! which starts at `getBufferOffset()`, if chunked).
   ASMJIT_INLINE uint8_t* getBufferData() const noexcept { return _bufferData; }
+  //! Get the offset of `getBufferData()` in the current section.
+  ASMJIT_INLINE size_t getBufferOffset() const noexcept { return _bufferOffset; }
   //! Get end (first invalid byte) of the current section.
   ASMJIT_INLINE uint8_t* getBufferEnd() const noexcept { return _bufferEnd; }
   //! Get pointer in the CodeBuffer of the current section.
   ASMJIT_INLINE uint8_t* getBufferPtr() const noexcept { return _bufferPtr; }
 
+  //! Use the data of `cb` and continue at `offset` (internal).
+  ASMJIT_INLINE void _setBuffer(const CodeBuffer& cb, size_t offset) noexcept {
+    uint8_t* p = cb._data;
+
+    _bufferData   = p;
+    _bufferEnd    = p + cb._capacity;
+    _bufferPtr    = p + (offset - cb._dataOffset);
+    _bufferOffset = cb._dataOffset;
+  }
+
   // --------------------------------------------------------------------------
   // [Code-Generation]
   // --------------------------------------------------------------------------
@@ -100,6 +114,7 @@ public:
     uint32_t type = Label::kTypeGlobal,
     uint32_t parentId = 0) override;
   ASMJIT_API Error bind(const Label& label) override;
+  ASMJIT_API Error section(SectionEntry* section) override;
   ASMJIT_API Error embed(const void* data, uint32_t size) override;
   ASMJIT_API Error embedLabel(const Label& label) override;
   ASMJIT_API Error embedConstPool(const Label& label, const ConstPool& pool) override;
@@ -138,6 +153,7 @@ public:
   uint8_t* _bufferData;                  //!< Start of the CodeBuffer of the current section.
   uint8_t* _bufferEnd;                   //!< End (first invalid byte) of the current section.
   uint8_t* _bufferPtr;                   //!< Pointer in the CodeBuffer of the current section.
+  size_t _bufferOffset;                  //!< Offset of `_bufferData` in the current section.
 
   Operand_ _op4;                         //!< 5th operand data, used only temporarily.
   Operand_ _op5;                         //!< 6th operand data, used only temporarily.
@@ -0,0 +1,568 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Dependencies]
+#include "../base/bitops.h"
+#include "../base/cpuinfo.h"
+
+// Kernels that use SSE2 and AVX2 are compiled by target attributes so they
+// don't require the whole library to be compiled for these instruction sets.
+#if (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64) && \
+    (ASMJIT_CC_MSC_GE(19, 0, 0) || ASMJIT_CC_GCC_GE(4, 9, 0) || ASMJIT_CC_CLANG_GE(3, 8, 0))
+# define ASMJIT_BITOPS_X86 1
+# include <immintrin.h>
+# if ASMJIT_CC_MSC
+#  define ASMJIT_BITOPS_TARGET_SSE2
+#  define ASMJIT_BITOPS_TARGET_AVX2
+# else
+#  define ASMJIT_BITOPS_TARGET_SSE2 __attribute__((__target__("sse2")))
+#  define ASMJIT_BITOPS_TARGET_AVX2 __attribute__((__target__("avx2")))
+# endif
+#else
+# define ASMJIT_BITOPS_X86 0
+#endif
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+typedef BitOps::BitWord BitWord;
+
+// ============================================================================
+// [asmjit::BitOps - Operators]
+// ============================================================================
+
+struct BitOpsOr {
+  static ASMJIT_INLINE BitWord op(BitWord a, BitWord b) noexcept { return a | b; }
+#if ASMJIT_BITOPS_X86
+  static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_SSE2 __m128i op(__m128i a, __m128i b) noexcept { return _mm_or_si128(a, b); }
+  static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_AVX2 __m256i op(__m256i a, __m256i b) noexcept { return _mm256_or_si256(a, b); }
+#endif // ASMJIT_BITOPS_X86
+};
+
+struct BitOpsAnd {
+  static ASMJIT_INLINE BitWord op(BitWord a, BitWord b) noexcept { return a & b; }
+#if ASMJIT_BITOPS_X86
+  static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_SSE2 __m128i op(__m128i a, __m128i b) noexcept { return _mm_and_si128(a, b); }
+  static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_AVX2 __m256i op(__m256i a, __m256i b) noexcept { return _mm256_and_si256(a, b); }
+#endif // ASMJIT_BITOPS_X86
+};
+
+struct BitOpsAndNot {
+  static ASMJIT_INLINE BitWord op(BitWord a, BitWord b) noexcept { return a & ~b; }
+#if ASMJIT_BITOPS_X86
+  // NOTE: `andnot` instructions negate the first operand.
+  static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_SSE2 __m128i op(__m128i a, __m128i b) noexcept { return _mm_andnot_si128(b, a); }
+  static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_AVX2 __m256i op(__m256i a, __m256i b) noexcept { return _mm256_andnot_si256(b, a); }
+#endif // ASMJIT_BITOPS_X86
+};
+
+// ============================================================================
+// [asmjit::BitOps - Scalar]
+// ============================================================================
+
+static BitWord BitOps_copyScalar(BitWord* dst, const BitWord* src, size_t n) noexcept {
+  BitWord r = 0;
+  for (size_t i = 0; i < n; i++) {
+    BitWord t = src[i];
+    dst[i] = t;
+    r |= t;
+  }
+  return r;
+}
+
+template<typename Op>
+static BitWord BitOps_binaryScalar(BitWord* dst, const BitWord* a, const BitWord* b, size_t n) noexcept {
+  BitWord r = 0;
+  for (size_t i = 0; i < n; i++) {
+    BitWord t = Op::op(a[i], b[i]);
+    dst[i] = t;
+    r |= t;
+  }
+  return r;
+}
+
+static BitWord BitOps_orAndNotSrcScalar(BitWord* dst, const BitWord* a, BitWord* b, size_t n) noexcept {
+  BitWord r = 0;
+  for (size_t i = 0; i < n; i++) {
+    BitWord x = a[i];
+    BitWord y = b[i];
+
+    dst[i] = x | y;
+    y &= ~x;
+
+    b[i] = y;
+    r |= y;
+  }
+  return r;
+}
+
+static bool BitOps_equalsScalar(const BitWord* a, const BitWord* b, size_t n) noexcept {
+  for (size_t i = 0; i < n; i++)
+    if (a[i] != b[i])
+      return false;
+  return true;
+}
+
+static size_t BitOps_popcountScalar(const BitWord* a, size_t n) noexcept {
+  size_t r = 0;
+  for (size_t i = 0; i < n; i++)
+    r += BitOps::_popcountWord(a[i]);
+  return r;
+}
+
+static void BitOps_fillScalar(BitWord* dst, BitWord pattern, size_t n) noexcept {
+  for (size_t i = 0; i < n; i++)
+    dst[i] = pattern;
+}
+
+static const BitOps::Funcs BitOps_scalarFuncs = {
+  BitOps_copyScalar,
+  BitOps_binaryScalar<BitOpsOr>,
+  BitOps_binaryScalar<BitOpsAnd>,
+  BitOps_binaryScalar<BitOpsAndNot>,
+  BitOps_orAndNotSrcScalar,
+  BitOps_equalsScalar,
+  BitOps_popcountScalar,
+  BitOps_fillScalar
+};
+
+#if ASMJIT_BITOPS_X86
+// ============================================================================
+// [asmjit::BitOps - SSE2]
+// ============================================================================
+
+//! \internal
+//!
+//! Number of `BitWord`s per 128-bit vector.
+static const size_t kBitOpsWordsPer128 = 16 / sizeof(BitWord);
+
+static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_SSE2 BitWord BitOps_anySSE2(__m128i x) noexcept {
+  return static_cast<BitWord>(_mm_movemask_epi8(_mm_cmpeq_epi8(x, _mm_setzero_si128())) != 0xFFFF);
+}
+
+static ASMJIT_BITOPS_TARGET_SSE2 BitWord BitOps_copySSE2(BitWord* dst, const BitWord* src, size_t n) noexcept {
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer128 <= n; i += kBitOpsWordsPer128) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), x);
+    acc = _mm_or_si128(acc, x);
+  }
+
+  return BitOps_anySSE2(acc) | BitOps_copyScalar(dst + i, src + i, n - i);
+}
+
+template<typename Op>
+static ASMJIT_BITOPS_TARGET_SSE2 BitWord BitOps_binarySSE2(BitWord* dst, const BitWord* a, const BitWord* b, size_t n) noexcept {
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer128 <= n; i += kBitOpsWordsPer128) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+    __m128i t = Op::op(x, y);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), t);
+    acc = _mm_or_si128(acc, t);
+  }
+
+  return BitOps_anySSE2(acc) | BitOps_binaryScalar<Op>(dst + i, a + i, b + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_SSE2 BitWord BitOps_orAndNotSrcSSE2(BitWord* dst, const BitWord* a, BitWord* b, size_t n) noexcept {
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer128 <= n; i += kBitOpsWordsPer128) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_or_si128(x, y));
+    y = _mm_andnot_si128(x, y);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(b + i), y);
+    acc = _mm_or_si128(acc, y);
+  }
+
+  return BitOps_anySSE2(acc) | BitOps_orAndNotSrcScalar(dst + i, a + i, b + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_SSE2 bool BitOps_equalsSSE2(const BitWord* a, const BitWord* b, size_t n) noexcept {
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer128 <= n; i += kBitOpsWordsPer128) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+    __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+
+    if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) != 0xFFFF)
+      return false;
+  }
+
+  return BitOps_equalsScalar(a + i, b + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_SSE2 size_t BitOps_popcountSSE2(const BitWord* a, size_t n) noexcept {
+  const __m128i m1 = _mm_set1_epi8(0x55);
+  const __m128i m2 = _mm_set1_epi8(0x33);
+  const __m128i m4 = _mm_set1_epi8(0x0F);
+
+  __m128i acc = _mm_setzero_si128();
+  size_t i = 0;
+
+  // Count bits of each byte and sum bytes to 64-bit lanes by `psadbw`.
+  for (; i + kBitOpsWordsPer128 <= n; i += kBitOpsWordsPer128) {
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+
+    x = _mm_sub_epi8(x, _mm_and_si128(_mm_srli_epi64(x, 1), m1));
+    x = _mm_add_epi8(_mm_and_si128(x, m2), _mm_and_si128(_mm_srli_epi64(x, 2), m2));
+    x = _mm_and_si128(_mm_add_epi8(x, _mm_srli_epi64(x, 4)), m4);
+
+    acc = _mm_add_epi64(acc, _mm_sad_epu8(x, _mm_setzero_si128()));
+  }
+
+  uint64_t lanes[2];
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), acc);
+  return static_cast<size_t>(lanes[0] + lanes[1]) + BitOps_popcountScalar(a + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_SSE2 void BitOps_fillSSE2(BitWord* dst, BitWord pattern, size_t n) noexcept {
+  BitWord patternVec[kBitOpsWordsPer128];
+  for (size_t j = 0; j < kBitOpsWordsPer128; j++)
+    patternVec[j] = pattern;
+
+  __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(patternVec));
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer128 <= n; i += kBitOpsWordsPer128)
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), x);
+
+  BitOps_fillScalar(dst + i, pattern, n - i);
+}
+
+static const BitOps::Funcs BitOps_sse2Funcs = {
+  BitOps_copySSE2,
+  BitOps_binarySSE2<BitOpsOr>,
+  BitOps_binarySSE2<BitOpsAnd>,
+  BitOps_binarySSE2<BitOpsAndNot>,
+  BitOps_orAndNotSrcSSE2,
+  BitOps_equalsSSE2,
+  BitOps_popcountSSE2,
+  BitOps_fillSSE2
+};
+
+// ============================================================================
+// [asmjit::BitOps - AVX2]
+// ============================================================================
+
+//! \internal
+//!
+//! Number of `BitWord`s per 256-bit vector.
+static const size_t kBitOpsWordsPer256 = 32 / sizeof(BitWord);
+
+static ASMJIT_INLINE ASMJIT_BITOPS_TARGET_AVX2 BitWord BitOps_anyAVX2(__m256i x) noexcept {
+  return static_cast<BitWord>(_mm256_testz_si256(x, x) == 0);
+}
+
+static ASMJIT_BITOPS_TARGET_AVX2 BitWord BitOps_copyAVX2(BitWord* dst, const BitWord* src, size_t n) noexcept {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer256 <= n; i += kBitOpsWordsPer256) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), x);
+    acc = _mm256_or_si256(acc, x);
+  }
+
+  return BitOps_anyAVX2(acc) | BitOps_copyScalar(dst + i, src + i, n - i);
+}
+
+template<typename Op>
+static ASMJIT_BITOPS_TARGET_AVX2 BitWord BitOps_binaryAVX2(BitWord* dst, const BitWord* a, const BitWord* b, size_t n) noexcept {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer256 <= n; i += kBitOpsWordsPer256) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+    __m256i t = Op::op(x, y);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), t);
+    acc = _mm256_or_si256(acc, t);
+  }
+
+  return BitOps_anyAVX2(acc) | BitOps_binaryScalar<Op>(dst + i, a + i, b + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_AVX2 BitWord BitOps_orAndNotSrcAVX2(BitWord* dst, const BitWord* a, BitWord* b, size_t n) noexcept {
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer256 <= n; i += kBitOpsWordsPer256) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_or_si256(x, y));
+    y = _mm256_andnot_si256(x, y);
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(b + i), y);
+    acc = _mm256_or_si256(acc, y);
+  }
+
+  return BitOps_anyAVX2(acc) | BitOps_orAndNotSrcScalar(dst + i, a + i, b + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_AVX2 bool BitOps_equalsAVX2(const BitWord* a, const BitWord* b, size_t n) noexcept {
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer256 <= n; i += kBitOpsWordsPer256) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + i));
+
+    if (_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)) != -1)
+      return false;
+  }
+
+  return BitOps_equalsScalar(a + i, b + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_AVX2 size_t BitOps_popcountAVX2(const BitWord* a, size_t n) noexcept {
+  // Number of bits set in each nibble, looked up by `vpshufb`.
+  const __m256i lut = _mm256_setr_epi8(
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+    0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const __m256i m4 = _mm256_set1_epi8(0x0F);
+
+  __m256i acc = _mm256_setzero_si256();
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer256 <= n; i += kBitOpsWordsPer256) {
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(x, m4));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(x, 4), m4));
+
+    acc = _mm256_add_epi64(acc, _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256()));
+  }
+
+  uint64_t lanes[4];
+  _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), acc);
+  return static_cast<size_t>(lanes[0] + lanes[1] + lanes[2] + lanes[3]) + BitOps_popcountScalar(a + i, n - i);
+}
+
+static ASMJIT_BITOPS_TARGET_AVX2 void BitOps_fillAVX2(BitWord* dst, BitWord pattern, size_t n) noexcept {
+  BitWord patternVec[kBitOpsWordsPer256];
+  for (size_t j = 0; j < kBitOpsWordsPer256; j++)
+    patternVec[j] = pattern;
+
+  __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(patternVec));
+  size_t i = 0;
+
+  for (; i + kBitOpsWordsPer256 <= n; i += kBitOpsWordsPer256)
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), x);
+
+  BitOps_fillScalar(dst + i, pattern, n - i);
+}
+
+static const BitOps::Funcs BitOps_avx2Funcs = {
+  BitOps_copyAVX2,
+  BitOps_binaryAVX2<BitOpsOr>,
+  BitOps_binaryAVX2<BitOpsAnd>,
+  BitOps_binaryAVX2<BitOpsAndNot>,
+  BitOps_orAndNotSrcAVX2,
+  BitOps_equalsAVX2,
+  BitOps_popcountAVX2,
+  BitOps_fillAVX2
+};
+#endif // ASMJIT_BITOPS_X86
+
+// ============================================================================
+// [asmjit::BitOps - Dispatch]
+// ============================================================================
+
+// Kernels are selected when first used. Concurrent initialization is benign
+// as all threads store the same pointer.
+static const BitOps::Funcs* BitOps_current;
+
+uint32_t BitOps::getHostLevel() noexcept {
+#if ASMJIT_BITOPS_X86
+  const CpuInfo& cpu = CpuInfo::getHost();
+
+  if (cpu.hasFeature(CpuInfo::kX86FeatureAVX2))
+    return kLevelAVX2;
+
+  if (cpu.hasFeature(CpuInfo::kX86FeatureSSE2))
+    return kLevelSSE2;
+#endif // ASMJIT_BITOPS_X86
+
+  return kLevelScalar;
+}
+
+const BitOps::Funcs* BitOps::getFuncs(uint32_t level) noexcept {
+  if (level > getHostLevel())
+    return nullptr;
+
+#if ASMJIT_BITOPS_X86
+  if (level == kLevelAVX2) return &BitOps_avx2Funcs;
+  if (level == kLevelSSE2) return &BitOps_sse2Funcs;
+#endif // ASMJIT_BITOPS_X86
+
+  return &BitOps_scalarFuncs;
+}
+
+const BitOps::Funcs* BitOps::_getFuncs() noexcept {
+  const Funcs* funcs = BitOps_current;
+
+  if (ASMJIT_UNLIKELY(!funcs)) {
+    funcs = getFuncs(getHostLevel());
+    BitOps_current = funcs;
+  }
+
+  return funcs;
+}
+
+uint32_t BitOps::getLevel() noexcept {
+  const Funcs* funcs = _getFuncs();
+
+#if ASMJIT_BITOPS_X86
+  if (funcs == &BitOps_avx2Funcs) return kLevelAVX2;
+  if (funcs == &BitOps_sse2Funcs) return kLevelSSE2;
+#endif // ASMJIT_BITOPS_X86
+
+  return kLevelScalar;
+}
+
+void BitOps::setLevel(uint32_t level) noexcept {
+  uint32_t hostLevel = getHostLevel();
+  BitOps_current = getFuncs(level < hostLevel ? level : hostLevel);
+}
+
+// ============================================================================
+// [asmjit::BitOps - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+static BitWord BitOps_testRand(uint32_t& seed) noexcept {
+  BitWord r = 0;
+  for (uint32_t i = 0; i < sizeof(BitWord); i += 2) {
+    seed = seed * 1103515245 + 12345;
+    r = (r << 16) | static_cast<BitWord>((seed >> 8) & 0xFFFF);
+  }
+  return r;
+}
+
+UNIT(base_bitops) {
+  enum { kMaxWords = 70 };
+
+  BitWord a[kMaxWords + 1];
+  BitWord b[kMaxWords + 1];
+  BitWord expDst[kMaxWords + 1];
+  BitWord expB[kMaxWords + 1];
+  BitWord dst[kMaxWords + 1];
+  BitWord bCopy[kMaxWords + 1];
+
+  const BitOps::Funcs* ref = BitOps::getFuncs(BitOps::kLevelScalar);
+  uint32_t hostLevel = BitOps::getHostLevel();
+  INFO("Host level: %u", hostLevel);
+
+  EXPECT(ref != nullptr, "Scalar kernels must always be available");
+  EXPECT(BitOps::getFuncs(hostLevel + 1) == nullptr,
+    "Kernels above the host level must not be available");
+
+  for (uint32_t level = BitOps::kLevelScalar; level <= hostLevel; level++) {
+    const BitOps::Funcs* funcs = BitOps::getFuncs(level);
+    INFO("Testing kernels of level %u", level);
+    EXPECT(funcs != nullptr, "Kernels of level %u must be available", level);
+
+    uint32_t seed = 0x1234 + level;
+    for (size_t n = 0; n <= kMaxWords; n++) {
+      // Start at an odd word to test unaligned access.
+      BitWord* pa = a + (n & 1);
+      BitWord* pb = b + (n & 1);
+
+      for (size_t i = 0; i < n; i++) {
+        pa[i] = BitOps_testRand(seed);
+        pb[i] = BitOps_testRand(seed);
+      }
+
+      // Make some arrays sparse, so `any` results are tested both ways.
+      if ((n % 3) == 0) {
+        for (size_t i = 0; i < n; i++)
+          pb[i] &= pa[i];
+      }
+
+      BitWord r, expR;
+
+      r = funcs->copy(dst, pa, n);
+      expR = ref->copy(expDst, pa, n);
+      EXPECT((r != 0) == (expR != 0) && ::memcmp(dst, expDst, n * sizeof(BitWord)) == 0,
+        "BitOps::copy() of %u words failed at level %u", unsigned(n), level);
+
+      r = funcs->or_(dst, pa, pb, n);
+      expR = ref->or_(expDst, pa, pb, n);
+      EXPECT((r != 0) == (expR != 0) && ::memcmp(dst, expDst, n * sizeof(BitWord)) == 0,
+        "BitOps::or_() of %u words failed at level %u", unsigned(n), level);
+
+      r = funcs->and_(dst, pa, pb, n);
+      expR = ref->and_(expDst, pa, pb, n);
+      EXPECT((r != 0) == (expR != 0) && ::memcmp(dst, expDst, n * sizeof(BitWord)) == 0,
+        "BitOps::and_() of %u words failed at level %u", unsigned(n), level);
+
+      r = funcs->andNot(dst, pb, pa, n);
+      expR = ref->andNot(expDst, pb, pa, n);
+      EXPECT((r != 0) == (expR != 0) && ::memcmp(dst, expDst, n * sizeof(BitWord)) == 0,
+        "BitOps::andNot() of %u words failed at level %u", unsigned(n), level);
+
+      ::memcpy(bCopy, pb, n * sizeof(BitWord));
+      ::memcpy(expB, pb, n * sizeof(BitWord));
+      r = funcs->orAndNotSrc(dst, pa, bCopy, n);
+      expR = ref->orAndNotSrc(expDst, pa, expB, n);
+      EXPECT((r != 0) == (expR != 0) &&
+             ::memcmp(dst, expDst, n * sizeof(BitWord)) == 0 &&
+             ::memcmp(bCopy, expB, n * sizeof(BitWord)) == 0,
+        "BitOps::orAndNotSrc() of %u words failed at level %u", unsigned(n), level);
+
+      EXPECT(funcs->popcount(pa, n) == ref->popcount(pa, n),
+        "BitOps::popcount() of %u words failed at level %u", unsigned(n), level);
+
+      ::memcpy(dst, pa, n * sizeof(BitWord));
+      EXPECT(funcs->equals(dst, pa, n),
+        "BitOps::equals() of %u equal words failed at level %u", unsigned(n), level);
+
+      if (n) {
+        dst[n - 1] ^= static_cast<BitWord>(1) << (n % BitOps::kBitsPerWord);
+        EXPECT(!funcs->equals(dst, pa, n),
+          "BitOps::equals() of %u different words failed at level %u", unsigned(n), level);
+      }
+
+      dst[n] = 0;
+      funcs->fill(dst, ~static_cast<BitWord>(0), n);
+      EXPECT(funcs->popcount(dst, n) == n * BitOps::kBitsPerWord && dst[n] == 0,
+        "BitOps::fill() of %u words failed at level %u", unsigned(n), level);
+    }
+  }
+
+  INFO("Testing dispatch");
+  uint32_t savedLevel = BitOps::getLevel();
+
+  BitOps::setLevel(BitOps::kLevelScalar);
+  EXPECT(BitOps::getLevel() == BitOps::kLevelScalar);
+
+  BitOps::setLevel(0xFFFFFFFFU);
+  EXPECT(BitOps::getLevel() == hostLevel);
+
+  BitOps::setLevel(savedLevel);
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
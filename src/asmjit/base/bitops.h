@@ -0,0 +1,235 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_BASE_BITOPS_H
+#define _ASMJIT_BASE_BITOPS_H
+
+// [Dependencies]
+#include "../base/utils.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+//! \addtogroup asmjit_base
+//! \{
+
+// ============================================================================
+// [asmjit::BitOps]
+// ============================================================================
+
+//! \internal
+//!
+//! Operations on arrays of bit-words used by \ref ZoneBitVector and liveness
+//! analysis of the register allocator.
+//!
+//! Short arrays are processed inline. Arrays of at least `kMinDispatchWords`
+//! words are processed by kernels selected at runtime by the features of the
+//! host CPU (AVX2 or SSE2 on X86/X64, scalar otherwise).
+//!
+//! Functions that produce a result return a non-zero value if any bit of the
+//! result is set.
+struct BitOps {
+  //! Storage of bits, the same as \ref ZoneBitVector::BitWord.
+  typedef uintptr_t BitWord;
+
+  enum {
+    //! Number of bits per `BitWord`.
+    kBitsPerWord = static_cast<int>(sizeof(BitWord)) * 8,
+    //! Minimum number of words processed by dispatched kernels.
+    kMinDispatchWords = 8
+  };
+
+  //! Implementation of kernels.
+  ASMJIT_ENUM(Level) {
+    kLevelScalar = 0,                    //!< Portable C++.
+    kLevelSSE2 = 1,                      //!< X86/X64 SSE2.
+    kLevelAVX2 = 2                       //!< X86/X64 AVX2.
+  };
+
+  //! Table of kernels of a single level.
+  struct Funcs {
+    BitWord (*copy)(BitWord* dst, const BitWord* src, size_t n);
+    BitWord (*or_)(BitWord* dst, const BitWord* a, const BitWord* b, size_t n);
+    BitWord (*and_)(BitWord* dst, const BitWord* a, const BitWord* b, size_t n);
+    BitWord (*andNot)(BitWord* dst, const BitWord* a, const BitWord* b, size_t n);
+    BitWord (*orAndNotSrc)(BitWord* dst, const BitWord* a, BitWord* b, size_t n);
+    bool (*equals)(const BitWord* a, const BitWord* b, size_t n);
+    size_t (*popcount)(const BitWord* a, size_t n);
+    void (*fill)(BitWord* dst, BitWord pattern, size_t n);
+  };
+
+  // --------------------------------------------------------------------------
+  // [Dispatch]
+  // --------------------------------------------------------------------------
+
+  //! Get the level of kernels currently used.
+  ASMJIT_API static uint32_t getLevel() noexcept;
+  //! Get the highest level supported by the host CPU.
+  ASMJIT_API static uint32_t getHostLevel() noexcept;
+  //! Use kernels of `level`, which is clamped to `getHostLevel()`.
+  //!
+  //! Only useful for testing and benchmarking, must not be called while the
+  //! kernels are being used by other threads.
+  ASMJIT_API static void setLevel(uint32_t level) noexcept;
+  //! Get kernels of `level`, or null if the host CPU doesn't support them.
+  ASMJIT_API static const Funcs* getFuncs(uint32_t level) noexcept;
+
+  //! \internal
+  ASMJIT_API static const Funcs* _getFuncs() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Ops]
+  // --------------------------------------------------------------------------
+
+  //! `dst = src`.
+  static ASMJIT_INLINE BitWord copy(BitWord* dst, const BitWord* src, size_t n) noexcept {
+    if (n >= kMinDispatchWords)
+      return _getFuncs()->copy(dst, src, n);
+
+    BitWord r = 0;
+    for (size_t i = 0; i < n; i++) {
+      BitWord t = src[i];
+      dst[i] = t;
+      r |= t;
+    }
+    return r;
+  }
+
+  //! `dst = a | b`.
+  static ASMJIT_INLINE BitWord or_(BitWord* dst, const BitWord* a, const BitWord* b, size_t n) noexcept {
+    if (n >= kMinDispatchWords)
+      return _getFuncs()->or_(dst, a, b, n);
+
+    BitWord r = 0;
+    for (size_t i = 0; i < n; i++) {
+      BitWord t = a[i] | b[i];
+      dst[i] = t;
+      r |= t;
+    }
+    return r;
+  }
+
+  //! `dst = a & b`.
+  static ASMJIT_INLINE BitWord and_(BitWord* dst, const BitWord* a, const BitWord* b, size_t n) noexcept {
+    if (n >= kMinDispatchWords)
+      return _getFuncs()->and_(dst, a, b, n);
+
+    BitWord r = 0;
+    for (size_t i = 0; i < n; i++) {
+      BitWord t = a[i] & b[i];
+      dst[i] = t;
+      r |= t;
+    }
+    return r;
+  }
+
+  //! `dst = a & ~b`.
+  static ASMJIT_INLINE BitWord andNot(BitWord* dst, const BitWord* a, const BitWord* b, size_t n) noexcept {
+    if (n >= kMinDispatchWords)
+      return _getFuncs()->andNot(dst, a, b, n);
+
+    BitWord r = 0;
+    for (size_t i = 0; i < n; i++) {
+      BitWord t = a[i] & ~b[i];
+      dst[i] = t;
+      r |= t;
+    }
+    return r;
+  }
+
+  //! `dst = a | b` and `b = b & ~a`, returns non-zero if any bit of new `b` is set.
+  //!
+  //! Used by liveness analysis to merge live bits and to keep only these that
+  //! were not live before. `dst` and `a` can be the same array.
+  static ASMJIT_INLINE BitWord orAndNotSrc(BitWord* dst, const BitWord* a, BitWord* b, size_t n) noexcept {
+    if (n >= kMinDispatchWords)
+      return _getFuncs()->orAndNotSrc(dst, a, b, n);
+
+    BitWord r = 0;
+    for (size_t i = 0; i < n; i++) {
+      BitWord x = a[i];
+      BitWord y = b[i];
+
+      dst[i] = x | y;
+      y &= ~x;
+
+      b[i] = y;
+      r |= y;
+    }
+    return r;
+  }
+
+  //! Get whether `a` and `b` are equal.
+  static ASMJIT_INLINE bool equals(const BitWord* a, const BitWord* b, size_t n) noexcept {
+    if (n >= kMinDispatchWords)
+      return _getFuncs()->equals(a, b, n);
+
+    for (size_t i = 0; i < n; i++)
+      if (a[i] != b[i])
+        return false;
+    return true;
+  }
+
+  //! Get the number of bits set in `a`.
+  static ASMJIT_INLINE size_t popcount(const BitWord* a, size_t n) noexcept {
+    if (n >= kMinDispatchWords)
+      return _getFuncs()->popcount(a, n);
+
+    size_t r = 0;
+    for (size_t i = 0; i < n; i++)
+      r += _popcountWord(a[i]);
+    return r;
+  }
+
+  //! Set all words of `dst` to `pattern`.
+  static ASMJIT_INLINE void fill(BitWord* dst, BitWord pattern, size_t n) noexcept {
+    if (n >= kMinDispatchWords) {
+      _getFuncs()->fill(dst, pattern, n);
+      return;
+    }
+
+    for (size_t i = 0; i < n; i++)
+      dst[i] = pattern;
+  }
+
+  //! \internal
+  static ASMJIT_INLINE size_t _popcountWord(BitWord x) noexcept {
+#if ASMJIT_ARCH_64BIT
+    return Utils::bitCount(static_cast<uint32_t>(x)) +
+           Utils::bitCount(static_cast<uint32_t>(static_cast<uint64_t>(x) >> 32));
+#else
+    return Utils::bitCount(static_cast<uint32_t>(x));
+#endif
+  }
+
+  //! \internal
+  //!
+  //! Get the index of the first bit set in `x`, which must be non-zero.
+  static ASMJIT_INLINE uint32_t _findFirstBitWord(BitWord x) noexcept {
+    ASMJIT_ASSERT(x != 0);
+#if ASMJIT_ARCH_64BIT
+    uint32_t lo = static_cast<uint32_t>(x);
+    if (lo)
+      return Utils::findFirstBit(lo);
+    return 32 + Utils::findFirstBit(static_cast<uint32_t>(static_cast<uint64_t>(x) >> 32));
+#else
+    return Utils::findFirstBit(static_cast<uint32_t>(x));
+#endif
+  }
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // _ASMJIT_BASE_BITOPS_H
@@ -153,6 +153,18 @@ CBComment* CodeBuilder::newCommentNode(const char* s, size_t len) noexcept {
   return newNodeT<CBComment>(s);
 }
 
+CBSection* CodeBuilder::newSectionNode(uint32_t sectionId) noexcept {
+  return newNodeT<CBSection>(sectionId);
+}
+
+Error CodeBuilder::markCold(const Label& label) noexcept {
+  CBLabel* node;
+  ASMJIT_PROPAGATE(getCBLabel(&node, label));
+
+  node->orFlags(CBNode::kFlagIsCold);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CodeBuilder - Code-Emitter]
 // ============================================================================
@@ -209,6 +221,22 @@ Error CodeBuilder::bind(const Label& label) {
   return kErrorOk;
 }
 
+Error CodeBuilder::section(SectionEntry* section) {
+  if (_lastError) return _lastError;
+  ASMJIT_ASSERT(_code != nullptr);
+
+  uint32_t sectionId = section ? section->getId() : SectionEntry::kInvalidId;
+  if (ASMJIT_UNLIKELY(sectionId >= _code->getSections().getLength() || _code->getSectionEntry(sectionId) != section))
+    return setLastError(DebugUtils::errored(kErrorInvalidSection));
+
+  CBSection* node = newSectionNode(sectionId);
+  if (ASMJIT_UNLIKELY(!node))
+    return setLastError(DebugUtils::errored(kErrorNoHeapMemory));
+
+  addNode(node);
+  return kErrorOk;
+}
+
 Error CodeBuilder::align(uint32_t mode, uint32_t alignment) {
   if (_lastError) return _lastError;
 
@@ -425,7 +453,6 @@ void CodeBuilder::removeNodes(CBNode* first, CBNode* last) noexcept {
   CBNode* node = first;
   for (;;) {
     CBNode* next = node->getNext();
-    ASMJIT_ASSERT(next != nullptr);
 
     node->_prev = nullptr;
     node->_next = nullptr;
@@ -436,6 +463,8 @@ void CodeBuilder::removeNodes(CBNode* first, CBNode* last) noexcept {
 
     if (node == last)
       break;
+
+    ASMJIT_ASSERT(next != nullptr);
     node = next;
   }
 }
@@ -497,71 +526,169 @@ ASMJIT_FAVOR_SIZE Error CodeBuilder::deletePass(CBPass* pass) noexcept {
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::CodeBuilder - Checkpoint]
+// ============================================================================
+
+Error CodeBuilder::saveCheckpoint(Checkpoint* out) noexcept {
+  if (_lastError) return _lastError;
+  ASMJIT_ASSERT(_code != nullptr);
+
+  ASMJIT_PROPAGATE(_code->saveCheckpoint(&out->code));
+  out->cursor = _cursor;
+  _cbDataZone.saveState(&out->dataZone);
+  return kErrorOk;
+}
+
+Error CodeBuilder::rollback(const Checkpoint& cp) noexcept {
+  if (_lastError) return _lastError;
+  ASMJIT_ASSERT(_code != nullptr);
+
+  ASMJIT_PROPAGATE(_code->rollback(cp.code));
+
+  // Nodes added after the checkpoint are between the saved and current cursor.
+  if (_cursor != cp.cursor) {
+    CBNode* first = cp.cursor ? cp.cursor->getNext() : _firstNode;
+    if (first)
+      removeNodes(first, _cursor);
+  }
+  _cursor = cp.cursor;
+
+  // `CBLabel` nodes of labels that still exist are kept, they are not part of
+  // the code anymore if they were bound after the checkpoint.
+  _cbLabels.truncate(cp.code.labelCount);
+  _cbDataZone.restoreState(cp.dataZone);
+  return kErrorOk;
+}
+
+Error CodeBuilder::releaseCheckpoint(const Checkpoint& cp) noexcept {
+  if (_lastError) return _lastError;
+  ASMJIT_ASSERT(_code != nullptr);
+
+  return _code->releaseCheckpoint(cp.code);
+}
+
+// ============================================================================
+// [asmjit::CodeBuilder - Zone Statistics]
+// ============================================================================
+
+void CodeBuilder::getZoneStats(ZoneStats* out) const noexcept {
+  ZoneStats stats;
+
+  _cbBaseZone.getStats(out);
+  _cbDataZone.getStats(&stats);
+  out->add(stats);
+  _cbPassZone.getStats(&stats);
+  out->add(stats);
+  _cbHeap.getStats(&stats);
+  out->add(stats);
+}
+
+static Error CodeBuilder_dumpZoneStats(StringBuilder& sb, const char* name, const ZoneStats& stats) noexcept {
+  return sb.appendFormat("%-16s: %llu reserved, %llu used, %llu peak, %llu blocks\n",
+    name,
+    static_cast<unsigned long long>(stats.reservedBytes),
+    static_cast<unsigned long long>(stats.usedBytes),
+    static_cast<unsigned long long>(stats.peakUsedBytes),
+    static_cast<unsigned long long>(stats.blockCount));
+}
+
+ASMJIT_FAVOR_SIZE Error CodeBuilder::dumpZoneStats(StringBuilder& sb) const noexcept {
+  ZoneStats stats;
+
+  if (_code) {
+    _code->getZoneStats(&stats);
+    ASMJIT_PROPAGATE(CodeBuilder_dumpZoneStats(sb, "CodeHolder", stats));
+  }
+
+  getZoneStats(&stats);
+  ASMJIT_PROPAGATE(CodeBuilder_dumpZoneStats(sb, "CodeBuilder", stats));
+
+  for (size_t i = 0, len = _cbPasses.getLength(); i < len; i++) {
+    const CBPass* pass = _cbPasses[i];
+    ASMJIT_PROPAGATE(CodeBuilder_dumpZoneStats(sb, pass->getName(), pass->getZoneStats()));
+  }
+
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CodeBuilder - Serialization]
 // ============================================================================
 
 Error CodeBuilder::serialize(CodeEmitter* dst) {
   Error err = kErrorOk;
-  CBNode* node_ = getFirstNode();
+  CBNode* node = getFirstNode();
 
   do {
-    dst->setInlineComment(node_->getInlineComment());
+    err = _serializeNode(dst, node);
+    if (err) break;
+    node = node->getNext();
+  } while (node);
 
-    switch (node_->getType()) {
-      case CBNode::kNodeAlign: {
-        CBAlign* node = static_cast<CBAlign*>(node_);
-        err = dst->align(node->getMode(), node->getAlignment());
-        break;
-      }
+  return err;
+}
 
-      case CBNode::kNodeData: {
-        CBData* node = static_cast<CBData*>(node_);
-        err = dst->embed(node->getData(), node->getSize());
-        break;
-      }
+Error CodeBuilder::_serializeNode(CodeEmitter* dst, CBNode* node_) {
+  Error err = kErrorOk;
+  dst->setInlineComment(node_->getInlineComment());
 
-      case CBNode::kNodeFunc:
-      case CBNode::kNodeLabel: {
-        CBLabel* node = static_cast<CBLabel*>(node_);
-        err = dst->bind(node->getLabel());
-        break;
-      }
+  switch (node_->getType()) {
+    case CBNode::kNodeAlign: {
+      CBAlign* node = static_cast<CBAlign*>(node_);
+      err = dst->align(node->getMode(), node->getAlignment());
+      break;
+    }
 
-      case CBNode::kNodeLabelData: {
-        CBLabelData* node = static_cast<CBLabelData*>(node_);
-        err = dst->embedLabel(node->getLabel());
-        break;
-      }
+    case CBNode::kNodeData: {
+      CBData* node = static_cast<CBData*>(node_);
+      err = dst->embed(node->getData(), node->getSize());
+      break;
+    }
 
-      case CBNode::kNodeConstPool: {
-        CBConstPool* node = static_cast<CBConstPool*>(node_);
-        err = dst->embedConstPool(node->getLabel(), node->getConstPool());
-        break;
-      }
+    case CBNode::kNodeFunc:
+    case CBNode::kNodeLabel: {
+      CBLabel* node = static_cast<CBLabel*>(node_);
+      err = dst->bind(node->getLabel());
+      break;
+    }
 
-      case CBNode::kNodeInst:
-      case CBNode::kNodeFuncCall: {
-        CBInst* node = node_->as<CBInst>();
-        dst->setOptions(node->getOptions());
-        dst->setExtraReg(node->getExtraReg());
-        err = dst->emitOpArray(node->getInstId(), node->getOpArray(), node->getOpCount());
-        break;
-      }
+    case CBNode::kNodeLabelData: {
+      CBLabelData* node = static_cast<CBLabelData*>(node_);
+      err = dst->embedLabel(node->getLabel());
+      break;
+    }
 
-      case CBNode::kNodeComment: {
-        CBComment* node = static_cast<CBComment*>(node_);
-        err = dst->comment(node->getInlineComment());
-        break;
-      }
+    case CBNode::kNodeConstPool: {
+      CBConstPool* node = static_cast<CBConstPool*>(node_);
+      err = dst->embedConstPool(node->getLabel(), node->getConstPool());
+      break;
+    }
 
-      default:
-        break;
+    case CBNode::kNodeInst:
+    case CBNode::kNodeFuncCall: {
+      CBInst* node = node_->as<CBInst>();
+      dst->setOptions(node->getOptions());
+      dst->setExtraReg(node->getExtraReg());
+      err = dst->emitOpArray(node->getInstId(), node->getOpArray(), node->getOpCount());
+      break;
     }
 
-    if (err) break;
-    node_ = node_->getNext();
-  } while (node_);
+    case CBNode::kNodeComment: {
+      CBComment* node = static_cast<CBComment*>(node_);
+      err = dst->comment(node->getInlineComment());
+      break;
+    }
+
+    case CBNode::kNodeSection: {
+      CBSection* node = static_cast<CBSection*>(node_);
+      err = dst->section(_code->getSectionEntry(node->getId()));
+      break;
+    }
+
+    default:
+      break;
+  }
 
   return err;
 }
@@ -572,9 +699,148 @@ Error CodeBuilder::serialize(CodeEmitter* dst) {
 
 CBPass::CBPass(const char* name) noexcept
   : _cb(nullptr),
-    _name(name) {}
+    _name(name) { _zoneStats.reset(); }
 CBPass::~CBPass() noexcept {}
 
+// ============================================================================
+// [asmjit::CBHotColdPass]
+// ============================================================================
+
+// Get whether `node` ends a block, the node itself is not part of the block.
+static ASMJIT_INLINE bool CBHotColdPass_isBoundary(const CBNode* node) noexcept {
+  uint32_t type = node->getType();
+  return type == CBNode::kNodeLabel     ||
+         type == CBNode::kNodeFunc      ||
+         type == CBNode::kNodeConstPool ||
+         type == CBNode::kNodeSentinel  ||
+         type == CBNode::kNodeSection;
+}
+
+// Get whether `node` emits code or data when serialized.
+static ASMJIT_INLINE bool CBHotColdPass_emitsCode(const CBNode* node) noexcept {
+  uint32_t type = node->getType();
+  return type == CBNode::kNodeInst     ||
+         type == CBNode::kNodeFuncCall ||
+         type == CBNode::kNodeData     ||
+         type == CBNode::kNodeAlign    ||
+         type == CBNode::kNodeLabelData;
+}
+
+// Get the unconditional jump that ends the code emitted up to `node` (inclusive)
+// within its block, null if the execution can continue after `node`.
+static CBNode* CBHotColdPass_getEndJmp(CBNode* node) noexcept {
+  while (node && !CBHotColdPass_isBoundary(node)) {
+    if (CBHotColdPass_emitsCode(node))
+      return node->getType() == CBNode::kNodeInst && node->isJmp() ? node : nullptr;
+    node = node->getPrev();
+  }
+  return nullptr;
+}
+
+CBHotColdPass::CBHotColdPass() noexcept
+  : CBPass("HotCold"),
+    _movedCount(0) {}
+CBHotColdPass::~CBHotColdPass() noexcept {}
+
+Error CBHotColdPass::process(Zone* zone) noexcept {
+  ASMJIT_UNUSED(zone);
+
+  CodeBuilder* cb = _cb;
+  CodeHolder* code = cb->getCode();
+
+  CBNode* coldFirst = nullptr;
+  CBNode* coldLast = nullptr;
+  uint32_t coldAlignment = 1;
+
+  // Id of the section at the end of the code, restored after the cold code.
+  uint32_t sectionId = 0;
+  _movedCount = 0;
+
+  CBNode* node = cb->getFirstNode();
+  while (node) {
+    if (node->getType() == CBNode::kNodeSection)
+      sectionId = node->as<CBSection>()->getId();
+
+    if (node->getType() != CBNode::kNodeLabel || !node->isCold()) {
+      node = node->getNext();
+      continue;
+    }
+
+    // The block ends before the next label, alignment of its code must be
+    // preserved by the alignment of the cold section.
+    CBNode* first = node;
+    CBNode* last = node;
+    uint32_t alignment = 1;
+
+    while (last->getNext() && !CBHotColdPass_isBoundary(last->getNext())) {
+      last = last->getNext();
+      if (last->getType() == CBNode::kNodeAlign)
+        alignment = std::max<uint32_t>(alignment, last->as<CBAlign>()->getAlignment());
+    }
+
+    node = last->getNext();
+
+    CBNode* jmp = CBHotColdPass_getEndJmp(first->getPrev());
+    if (!jmp || !CBHotColdPass_getEndJmp(last))
+      continue;
+
+    // Unlink the block, it always has a previous node (the jump).
+    CBNode* prev = first->_prev;
+    prev->_next = node;
+
+    if (node)
+      node->_prev = prev;
+    else
+      cb->_lastNode = prev;
+
+    first->_prev = coldLast;
+    last->_next = nullptr;
+
+    if (coldLast)
+      coldLast->_next = first;
+    else
+      coldFirst = first;
+
+    coldLast = last;
+    coldAlignment = std::max<uint32_t>(coldAlignment, alignment);
+    _movedCount++;
+
+    // The jump over the block is useless if it jumps to the next node now.
+    // Nodes flagged as jumps are always `CBJump`.
+    if (jmp->getNext() == node && jmp->as<CBJump>()->getTarget() == node)
+      cb->removeNode(jmp);
+  }
+
+  if (!coldFirst)
+    return kErrorOk;
+
+  SectionEntry* cold = code->getSectionByName(".text.cold");
+  if (!cold)
+    ASMJIT_PROPAGATE(code->newSection(&cold, ".text.cold", Globals::kInvalidIndex, SectionEntry::kFlagExec | SectionEntry::kFlagConst, coldAlignment));
+  else if (cold->getAlignment() < coldAlignment)
+    cold->setAlignment(coldAlignment);
+
+  CBSection* enter = cb->newSectionNode(cold->getId());
+  CBSection* leave = cb->newSectionNode(sectionId);
+
+  if (ASMJIT_UNLIKELY(!enter || !leave))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  // Append the cold code to the end, wrapped by section switches.
+  CBNode* tail = cb->_lastNode;
+  tail->_next = enter;
+  enter->_prev = tail;
+
+  enter->_next = coldFirst;
+  coldFirst->_prev = enter;
+
+  coldLast->_next = leave;
+  leave->_prev = coldLast;
+
+  cb->_lastNode = leave;
+  return kErrorOk;
+}
+
 } // asmjit namespace
 
 // [Api-End]
@@ -40,6 +40,7 @@ class CBInst;
 class CBJump;
 class CBLabel;
 class CBLabelData;
+class CBSection;
 class CBSentinel;
 
 //! \addtogroup asmjit_base
@@ -54,6 +55,13 @@ public:
   ASMJIT_NONCOPYABLE(CodeBuilder)
   typedef CodeEmitter Base;
 
+  //! Saved state of `CodeBuilder`, see `saveCheckpoint()` and `rollback()`.
+  struct Checkpoint {
+    CodeHolder::Checkpoint code;         //!< State of the attached `CodeHolder`.
+    CBNode* cursor;                      //!< Cursor.
+    Zone::State dataZone;                //!< State of the data zone.
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -124,6 +132,12 @@ public:
   ASMJIT_API CBConstPool* newConstPool() noexcept;
   //! Create a new \ref CBComment node.
   ASMJIT_API CBComment* newCommentNode(const char* s, size_t len) noexcept;
+  //! Create a new \ref CBSection node.
+  ASMJIT_API CBSection* newSectionNode(uint32_t sectionId) noexcept;
+
+  //! Mark the block that starts at `label` as unlikely to be executed, see
+  //! \ref CBHotColdPass.
+  ASMJIT_API Error markCold(const Label& label) noexcept;
 
   // --------------------------------------------------------------------------
   // [Code-Emitter]
@@ -132,6 +146,7 @@ public:
   ASMJIT_API virtual Label newLabel() override;
   ASMJIT_API virtual Label newNamedLabel(const char* name, size_t nameLength = Globals::kInvalidIndex, uint32_t type = Label::kTypeGlobal, uint32_t parentId = kInvalidValue) override;
   ASMJIT_API virtual Error bind(const Label& label) override;
+  ASMJIT_API virtual Error section(SectionEntry* section) override;
   ASMJIT_API virtual Error align(uint32_t mode, uint32_t alignment) override;
   ASMJIT_API virtual Error embed(const void* data, uint32_t size) override;
   ASMJIT_API virtual Error embedLabel(const Label& label) override;
@@ -188,12 +203,46 @@ public:
   //! Remove `pass` from the list of passes and delete it.
   ASMJIT_API Error deletePass(CBPass* pass) noexcept;
 
+  // --------------------------------------------------------------------------
+  // [Zone Statistics]
+  // --------------------------------------------------------------------------
+
+  //! Get memory usage of zones owned by the `CodeBuilder` (not including the
+  //! zones of the attached `CodeHolder`).
+  ASMJIT_API virtual void getZoneStats(ZoneStats* out) const noexcept;
+
+  //! Dump memory usage of the attached `CodeHolder`, the `CodeBuilder`, and of
+  //! each pass (as measured by the last `finalize()`) to `sb`.
+  ASMJIT_API Error dumpZoneStats(StringBuilder& sb) const noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Checkpoint]
+  // --------------------------------------------------------------------------
+
+  //! Save the state of the `CodeBuilder` and of the attached `CodeHolder`.
+  ASMJIT_API Error saveCheckpoint(Checkpoint* out) noexcept;
+
+  //! Rewind to the state saved by `saveCheckpoint()`.
+  //!
+  //! Removes all nodes added after the checkpoint and labels created after it,
+  //! see \ref CodeHolder::rollback(). Nodes must have been added after the
+  //! cursor saved by the checkpoint, which becomes the cursor again.
+  ASMJIT_API Error rollback(const Checkpoint& cp) noexcept;
+
+  //! Release the checkpoint `cp`, see \ref CodeHolder::releaseCheckpoint().
+  ASMJIT_API Error releaseCheckpoint(const Checkpoint& cp) noexcept;
+
   // --------------------------------------------------------------------------
   // [Serialization]
   // --------------------------------------------------------------------------
 
   ASMJIT_API virtual Error serialize(CodeEmitter* dst);
 
+  //! \internal
+  //!
+  //! Serialize a single `node` to `dst`.
+  ASMJIT_API Error _serializeNode(CodeEmitter* dst, CBNode* node);
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
@@ -250,12 +299,50 @@ public:
   ASMJIT_INLINE const CodeBuilder* cb() const noexcept { return _cb; }
   ASMJIT_INLINE const char* getName() const noexcept { return _name; }
 
+  //! Get memory used by the last `process()` call.
+  //!
+  //! Includes the zone passed to `process()` and any other memory the pass
+  //! accounts to it, filled by `CodeBuilder::finalize()`.
+  ASMJIT_INLINE const ZoneStats& getZoneStats() const noexcept { return _zoneStats; }
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
 
   CodeBuilder* _cb;                      //!< CodeBuilder this pass is assigned to.
   const char* _name;                     //!< Name of the pass.
+  ZoneStats _zoneStats;                  //!< Memory used by the last `process()`.
+};
+
+// ============================================================================
+// [asmjit::CBHotColdPass]
+// ============================================================================
+
+//! `CodeBuilder` pass that moves cold blocks to the ".text.cold" section.
+//!
+//! A cold block starts at a label marked by \ref CodeBuilder::markCold() and
+//! ends before the next label. It's only moved if it can't be entered by
+//! falling through from the previous block and if it ends with an unconditional
+//! jump, so the hot code becomes denser without changing what it does. Jumps
+//! between the sections are resolved by \ref CodeHolder::relocate().
+//!
+//! The pass must run after the code has been lowered (i.e. after `RAPass` of
+//! \ref CodeCompiler), which is the case if it's added after the compiler was
+//! attached. The code must start in the first section of \ref CodeHolder.
+class ASMJIT_VIRTAPI CBHotColdPass : public CBPass {
+public:
+  ASMJIT_NONCOPYABLE(CBHotColdPass)
+  typedef CBPass Base;
+
+  ASMJIT_API CBHotColdPass() noexcept;
+  ASMJIT_API virtual ~CBHotColdPass() noexcept;
+
+  ASMJIT_API virtual Error process(Zone* zone) noexcept override;
+
+  //! Get the number of blocks moved by the last `process()`.
+  ASMJIT_INLINE uint32_t getMovedCount() const noexcept { return _movedCount; }
+
+  uint32_t _movedCount;                  //!< Number of blocks moved by the last `process()`.
 };
 
 // ============================================================================
@@ -290,6 +377,7 @@ public:
     kNodeConstPool  = 6,                 //!< Node is \ref CBConstPool.
     kNodeComment    = 7,                 //!< Node is \ref CBComment.
     kNodeSentinel   = 8,                 //!< Node is \ref CBSentinel.
+    kNodeSection    = 9,                 //!< Node is \ref CBSection.
 
     // [CodeCompiler]
     kNodeFunc       = 16,                //!< Node is \ref CCFunc (considered as \ref CBLabel by \ref CodeBuilder).
@@ -332,7 +420,10 @@ public:
     kFlagIsSpecial = 0x0100,
 
     //! Whether the instruction is an FPU instruction.
-    kFlagIsFp = 0x0200
+    kFlagIsFp = 0x0200,
+
+    //! If the `CBLabel` starts a block that is unlikely to be executed.
+    kFlagIsCold = 0x0400
   };
 
   // --------------------------------------------------------------------------
@@ -406,6 +497,8 @@ public:
   ASMJIT_INLINE bool isSpecial() const noexcept { return hasFlag(kFlagIsSpecial); }
   //! Get whether the node is `CBInst` and the instruction uses x87-FPU.
   ASMJIT_INLINE bool isFp() const noexcept { return hasFlag(kFlagIsFp); }
+  //! Get whether the node is `CBLabel` that starts a cold block.
+  ASMJIT_INLINE bool isCold() const noexcept { return hasFlag(kFlagIsCold); }
 
   ASMJIT_INLINE bool hasPosition() const noexcept { return _position != 0; }
   //! Get flow index.
@@ -881,6 +974,42 @@ public:
   ASMJIT_INLINE ~CBComment() noexcept {}
 };
 
+// ============================================================================
+// [asmjit::CBSection]
+// ============================================================================
+
+//! Section (CodeBuilder).
+//!
+//! Switches the section where the code that follows is emitted.
+class CBSection : public CBNode {
+public:
+  ASMJIT_NONCOPYABLE(CBSection)
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `CBSection` instance.
+  ASMJIT_INLINE CBSection(CodeBuilder* cb, uint32_t id) noexcept
+    : CBNode(cb, kNodeSection),
+      _id(id) {}
+  //! Destroy the `CBSection` instance (NEVER CALLED).
+  ASMJIT_INLINE ~CBSection() noexcept {}
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get the section id.
+  ASMJIT_INLINE uint32_t getId() const noexcept { return _id; }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uint32_t _id;                          //!< Section id.
+};
+
 // ============================================================================
 // [asmjit::CBSentinel]
 // ============================================================================
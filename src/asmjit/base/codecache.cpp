@@ -0,0 +1,694 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Dependencies]
+#include "../base/codecache.h"
+#include "../base/cpuinfo.h"
+#include "../base/runtime.h"
+#include "../base/utils.h"
+
+#if ASMJIT_OS_POSIX
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <sys/stat.h>
+# include <unistd.h>
+#endif // ASMJIT_OS_POSIX
+
+#if defined(ASMJIT_TEST) && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+# include <stdio.h>
+# include "../x86/x86assembler.h"
+#endif // ASMJIT_TEST
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::CodeCache - File Format]
+// ============================================================================
+
+// The file starts with `CodeCacheHeader` followed by entries, which are only
+// appended. Each entry starts with `CodeCacheEntry` followed by relocations
+// (`CodeCacheReloc[]`), the key, and the code, padded to 8 bytes. An entry is
+// marked as replaced if the same key is stored again.
+
+enum {
+  kCodeCacheMagic = 0x43434A41U,         //!< 'AJCC'.
+  kCodeCacheVersion = 1,                 //!< Version of the file format.
+  kCodeCacheEntryReplaced = 0x1          //!< Entry was replaced by a newer one.
+};
+
+//! \internal
+//!
+//! Initial size of the cache file.
+static const size_t kCodeCacheInitialSize = 65536;
+
+//! \internal
+struct CodeCacheHeader {
+  uint32_t magic;                        //!< Magic, `kCodeCacheMagic`.
+  uint32_t version;                      //!< Version of the format, `kCodeCacheVersion`.
+  uint64_t fingerprint;                  //!< Fingerprint of AsmJit, `CodeInfo`, and CPU.
+  uint64_t usedSize;                     //!< Size of the header and all entries.
+  uint64_t entryCount;                   //!< Number of entries (including replaced ones).
+};
+
+//! \internal
+struct CodeCacheEntry {
+  uint64_t keyHash;                      //!< Hash of the key.
+  uint64_t contentHash;                  //!< Hash of relocations, key, and code.
+  uint32_t totalSize;                    //!< Size of the entry including padding.
+  uint32_t flags;                        //!< Entry flags.
+  uint32_t keySize;                      //!< Size of the key.
+  uint32_t codeSize;                     //!< Size of the code (without trampolines).
+  uint32_t relocCount;                   //!< Number of relocations.
+  uint32_t trampolinesSize;              //!< Size of trampolines, see \ref CodeHolder::getTrampolinesSize().
+};
+
+//! \internal
+struct CodeCacheReloc {
+  uint8_t type;                          //!< Relocation type, see \ref RelocEntry::Type.
+  uint8_t size;                          //!< Relocation size.
+  uint8_t reserved[6];                   //!< Reserved.
+  uint64_t sourceOffset;                 //!< Offset of the relocated data in the code.
+  uint64_t data;                         //!< Relocation data.
+};
+
+// ============================================================================
+// [asmjit::CodeCache - Helpers]
+// ============================================================================
+
+typedef CodeCache::IndexEntry IndexEntry;
+
+//! \internal
+//!
+//! 64-bit FNV-1a hash of `size` bytes of `data` continuing from `hash`.
+static uint64_t codeCacheHash(uint64_t hash, const void* data, size_t size) noexcept {
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  for (size_t i = 0; i < size; i++) {
+    hash ^= p[i];
+    hash *= ASMJIT_UINT64_C(0x100000001B3);
+  }
+  return hash;
+}
+
+//! \internal
+static const uint64_t kCodeCacheHashInit = ASMJIT_UINT64_C(0xCBF29CE484222325);
+
+static ASMJIT_INLINE CodeCacheHeader* codeCacheGetHeader(CodeCache* self) noexcept {
+  return reinterpret_cast<CodeCacheHeader*>(self->_data);
+}
+
+static ASMJIT_INLINE CodeCacheReloc* codeCacheGetRelocs(CodeCacheEntry* entry) noexcept {
+  return reinterpret_cast<CodeCacheReloc*>(entry + 1);
+}
+
+static ASMJIT_INLINE uint8_t* codeCacheGetKey(CodeCacheEntry* entry) noexcept {
+  return reinterpret_cast<uint8_t*>(codeCacheGetRelocs(entry) + entry->relocCount);
+}
+
+static ASMJIT_INLINE uint8_t* codeCacheGetCode(CodeCacheEntry* entry) noexcept {
+  return codeCacheGetKey(entry) + entry->keySize;
+}
+
+//! \internal
+//!
+//! Get the hash of relocations, key, and code of `entry`.
+static ASMJIT_INLINE uint64_t codeCacheHashContent(CodeCacheEntry* entry) noexcept {
+  size_t size = entry->relocCount * sizeof(CodeCacheReloc) + entry->keySize + entry->codeSize;
+  return codeCacheHash(kCodeCacheHashInit, codeCacheGetRelocs(entry), size);
+}
+
+//! \internal
+//!
+//! Get the fingerprint of the library, `codeInfo`, and the host CPU.
+static uint64_t codeCacheFingerprint(const CodeInfo& codeInfo) noexcept {
+  const CpuInfo& cpu = CpuInfo::getHost();
+  uint32_t arch = (cpu.getArchInfo().getType() << 8) | cpu.getArchInfo().getSubType();
+  uint32_t version = kCodeCacheVersion;
+
+  uint64_t hash = kCodeCacheHashInit;
+  hash = codeCacheHash(hash, ASMJIT_VERSION_STRING, sizeof(ASMJIT_VERSION_STRING));
+  hash = codeCacheHash(hash, &version, sizeof(version));
+  hash = codeCacheHash(hash, &codeInfo, sizeof(CodeInfo));
+  hash = codeCacheHash(hash, &arch, sizeof(arch));
+  hash = codeCacheHash(hash, cpu.getFeatures().getBits(), sizeof(CpuFeatures::BitWord) * CpuFeatures::kNumBitWords);
+  return hash;
+}
+
+// ============================================================================
+// [asmjit::CodeCache - File]
+// ============================================================================
+
+//! \internal
+//!
+//! Unmap the file.
+static void codeCacheUnmap(CodeCache* self) noexcept {
+  if (!self->_data) return;
+
+#if ASMJIT_OS_WINDOWS
+  ::UnmapViewOfFile(self->_data);
+  ::CloseHandle(self->_hMapping);
+  self->_hMapping = nullptr;
+#else
+  ::munmap(self->_data, self->_mappedSize);
+#endif // ASMJIT_OS_WINDOWS
+
+  self->_data = nullptr;
+  self->_mappedSize = 0;
+}
+
+//! \internal
+//!
+//! Resize the file to `size` bytes and map it.
+static Error codeCacheMap(CodeCache* self, size_t size) noexcept {
+  codeCacheUnmap(self);
+
+#if ASMJIT_OS_WINDOWS
+  DWORD sizeHi = static_cast<DWORD>(static_cast<uint64_t>(size) >> 32);
+  DWORD sizeLo = static_cast<DWORD>(size & 0xFFFFFFFFU);
+
+  HANDLE hMapping = ::CreateFileMappingW(self->_hFile, nullptr, PAGE_READWRITE, sizeHi, sizeLo, nullptr);
+  if (ASMJIT_UNLIKELY(!hMapping))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  void* p = ::MapViewOfFile(hMapping, FILE_MAP_ALL_ACCESS, 0, 0, size);
+  if (ASMJIT_UNLIKELY(!p)) {
+    ::CloseHandle(hMapping);
+    return DebugUtils::errored(kErrorInvalidState);
+  }
+
+  self->_hMapping = hMapping;
+#else
+  struct stat st;
+  if (ASMJIT_UNLIKELY(::fstat(self->_fd, &st) != 0))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  if (static_cast<uint64_t>(st.st_size) < static_cast<uint64_t>(size) &&
+      ASMJIT_UNLIKELY(::ftruncate(self->_fd, static_cast<off_t>(size)) != 0))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, self->_fd, 0);
+  if (ASMJIT_UNLIKELY(p == MAP_FAILED))
+    return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_WINDOWS
+
+  self->_data = static_cast<uint8_t*>(p);
+  self->_mappedSize = size;
+  return kErrorOk;
+}
+
+//! \internal
+//!
+//! Get the current size of the file.
+static uint64_t codeCacheGetFileSize(CodeCache* self) noexcept {
+#if ASMJIT_OS_WINDOWS
+  LARGE_INTEGER size;
+  if (!::GetFileSizeEx(self->_hFile, &size))
+    return 0;
+  return static_cast<uint64_t>(size.QuadPart);
+#else
+  struct stat st;
+  if (::fstat(self->_fd, &st) != 0)
+    return 0;
+  return static_cast<uint64_t>(st.st_size);
+#endif // ASMJIT_OS_WINDOWS
+}
+
+//! \internal
+//!
+//! Make sure the mapping can hold `size` more bytes.
+static Error codeCacheGrow(CodeCache* self, size_t size) noexcept {
+  size_t usedSize = static_cast<size_t>(codeCacheGetHeader(self)->usedSize);
+  size_t required = usedSize + size;
+
+  if (required <= self->_mappedSize)
+    return kErrorOk;
+
+  size_t newSize = self->_mappedSize;
+  while (newSize < required)
+    newSize *= 2;
+
+  return codeCacheMap(self, newSize);
+}
+
+// ============================================================================
+// [asmjit::CodeCache - Index]
+// ============================================================================
+
+//! \internal
+//!
+//! Find the slot of `hash` in the index, or an empty slot where it belongs.
+static ASMJIT_INLINE IndexEntry* codeCacheFindSlot(IndexEntry* index, size_t capacity, uint64_t hash) noexcept {
+  size_t mask = capacity - 1;
+  size_t i = static_cast<size_t>(hash) & mask;
+
+  while (index[i].offset != 0 && index[i].hash != hash)
+    i = (i + 1) & mask;
+
+  return &index[i];
+}
+
+//! \internal
+//!
+//! Insert or replace `hash` in the index.
+static Error codeCacheIndexInsert(CodeCache* self, uint64_t hash, size_t offset) noexcept {
+  // Keep the load factor below 50%.
+  if ((self->_indexCount + 1) * 2 > self->_indexCapacity) {
+    size_t capacity = self->_indexCapacity ? self->_indexCapacity * 2 : size_t(64);
+    IndexEntry* index = static_cast<IndexEntry*>(Internal::allocMemory(capacity * sizeof(IndexEntry)));
+
+    if (ASMJIT_UNLIKELY(!index))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    ::memset(index, 0, capacity * sizeof(IndexEntry));
+    for (size_t i = 0; i < self->_indexCapacity; i++) {
+      const IndexEntry& src = self->_index[i];
+      if (src.offset)
+        *codeCacheFindSlot(index, capacity, src.hash) = src;
+    }
+
+    Internal::releaseMemory(self->_index);
+    self->_index = index;
+    self->_indexCapacity = capacity;
+  }
+
+  IndexEntry* slot = codeCacheFindSlot(self->_index, self->_indexCapacity, hash);
+  if (!slot->offset)
+    self->_indexCount++;
+
+  slot->hash = hash;
+  slot->offset = offset;
+  return kErrorOk;
+}
+
+//! \internal
+//!
+//! Find an entry of `key`, returns null if not found.
+static CodeCacheEntry* codeCacheFind(CodeCache* self, uint64_t hash, const void* key, size_t keySize) noexcept {
+  if (!self->_indexCount)
+    return nullptr;
+
+  IndexEntry* slot = codeCacheFindSlot(self->_index, self->_indexCapacity, hash);
+  if (!slot->offset)
+    return nullptr;
+
+  CodeCacheEntry* entry = reinterpret_cast<CodeCacheEntry*>(self->_data + slot->offset);
+  if (entry->keySize != keySize || ::memcmp(codeCacheGetKey(entry), key, keySize) != 0)
+    return nullptr;
+
+  return entry;
+}
+
+//! \internal
+//!
+//! Build the index of all entries in the file. Entries that are not valid and
+//! all entries after them are discarded.
+static Error codeCacheBuildIndex(CodeCache* self) noexcept {
+  CodeCacheHeader* header = codeCacheGetHeader(self);
+
+  size_t offset = sizeof(CodeCacheHeader);
+  size_t end = static_cast<size_t>(header->usedSize);
+  uint64_t count = 0;
+
+  while (offset + sizeof(CodeCacheEntry) <= end) {
+    CodeCacheEntry* entry = reinterpret_cast<CodeCacheEntry*>(self->_data + offset);
+    size_t contentSize = sizeof(CodeCacheEntry) + entry->relocCount * sizeof(CodeCacheReloc) + entry->keySize + entry->codeSize;
+
+    if (entry->totalSize < contentSize || entry->totalSize > end - offset || (entry->totalSize & 7) != 0)
+      break;
+
+    if (!(entry->flags & kCodeCacheEntryReplaced))
+      ASMJIT_PROPAGATE(codeCacheIndexInsert(self, entry->keyHash, offset));
+
+    offset += entry->totalSize;
+    count++;
+  }
+
+  header->usedSize = offset;
+  header->entryCount = count;
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::CodeCache - Construction / Destruction]
+// ============================================================================
+
+CodeCache::CodeCache() noexcept
+  : _codeInfo(),
+    _fingerprint(0),
+    _data(nullptr),
+    _mappedSize(0),
+    _index(nullptr),
+    _indexCount(0),
+    _indexCapacity(0),
+#if ASMJIT_OS_WINDOWS
+    _hFile(INVALID_HANDLE_VALUE),
+    _hMapping(nullptr) {}
+#else
+    _fd(-1) {}
+#endif // ASMJIT_OS_WINDOWS
+
+CodeCache::~CodeCache() noexcept {
+  close();
+}
+
+// ============================================================================
+// [asmjit::CodeCache - Open / Close]
+// ============================================================================
+
+Error CodeCache::open(const char* path, const CodeInfo& codeInfo) noexcept {
+  AutoLock locked(_lock);
+
+  if (ASMJIT_UNLIKELY(_data))
+    return DebugUtils::errored(kErrorAlreadyInitialized);
+
+#if ASMJIT_OS_WINDOWS
+  _hFile = ::CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (ASMJIT_UNLIKELY(_hFile == INVALID_HANDLE_VALUE))
+    return DebugUtils::errored(kErrorInvalidState);
+#else
+  _fd = ::open(path, O_RDWR | O_CREAT, 0644);
+  if (ASMJIT_UNLIKELY(_fd < 0))
+    return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_WINDOWS
+
+  _codeInfo = codeInfo;
+  _fingerprint = codeCacheFingerprint(codeInfo);
+
+  uint64_t fileSize = codeCacheGetFileSize(this);
+  size_t mapSize = kCodeCacheInitialSize;
+
+  if (fileSize > static_cast<uint64_t>(mapSize) && fileSize <= static_cast<uint64_t>(~static_cast<size_t>(0)))
+    mapSize = static_cast<size_t>(fileSize);
+
+  Error err = codeCacheMap(this, mapSize);
+  if (ASMJIT_UNLIKELY(err)) {
+    close();
+    return err;
+  }
+
+  // Discard the content if the file was created by a different version of
+  // AsmJit, for different `CodeInfo`, or on a different CPU.
+  CodeCacheHeader* header = codeCacheGetHeader(this);
+  if (fileSize < sizeof(CodeCacheHeader) ||
+      header->magic != kCodeCacheMagic ||
+      header->version != kCodeCacheVersion ||
+      header->fingerprint != _fingerprint ||
+      header->usedSize < sizeof(CodeCacheHeader) ||
+      header->usedSize > fileSize) {
+    header->magic = kCodeCacheMagic;
+    header->version = kCodeCacheVersion;
+    header->fingerprint = _fingerprint;
+    header->usedSize = sizeof(CodeCacheHeader);
+    header->entryCount = 0;
+  }
+
+  err = codeCacheBuildIndex(this);
+  if (ASMJIT_UNLIKELY(err)) {
+    close();
+    return err;
+  }
+
+  return kErrorOk;
+}
+
+void CodeCache::close() noexcept {
+  AutoLock locked(_lock);
+  codeCacheUnmap(this);
+
+#if ASMJIT_OS_WINDOWS
+  if (_hFile != INVALID_HANDLE_VALUE) {
+    ::CloseHandle(_hFile);
+    _hFile = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (_fd >= 0) {
+    ::close(_fd);
+    _fd = -1;
+  }
+#endif // ASMJIT_OS_WINDOWS
+
+  Internal::releaseMemory(_index);
+  _index = nullptr;
+  _indexCount = 0;
+  _indexCapacity = 0;
+}
+
+// ============================================================================
+// [asmjit::CodeCache - Load / Store]
+// ============================================================================
+
+Error CodeCache::_load(JitRuntime* runtime, void** dst, const void* key, size_t keySize) noexcept {
+  *dst = nullptr;
+
+  AutoLock locked(_lock);
+  if (ASMJIT_UNLIKELY(!_data))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(runtime->getCodeInfo() != _codeInfo))
+    return DebugUtils::errored(kErrorInvalidArch);
+
+  uint64_t hash = codeCacheHash(kCodeCacheHashInit, key, keySize);
+  CodeCacheEntry* entry = codeCacheFind(this, hash, key, keySize);
+
+  // Treat a corrupted entry as a miss, it will be replaced by `store()`.
+  if (!entry || entry->contentHash != codeCacheHashContent(entry))
+    return kErrorOk;
+
+  // Rebuild the code and relocations in a `CodeHolder` and let the runtime
+  // relocate it as if it was just generated.
+  CodeHolder code;
+  ASMJIT_PROPAGATE(code.init(_codeInfo));
+
+  SectionEntry* text = code.getSectionEntry(0);
+  ASMJIT_PROPAGATE(code.reserveBuffer(&text->_buffer, entry->codeSize));
+
+  ::memcpy(text->_buffer._data, codeCacheGetCode(entry), entry->codeSize);
+  text->_buffer._length = entry->codeSize;
+
+  const CodeCacheReloc* relocs = codeCacheGetRelocs(entry);
+  for (uint32_t i = 0; i < entry->relocCount; i++) {
+    RelocEntry* re;
+    ASMJIT_PROPAGATE(code.newRelocEntry(&re, relocs[i].type, relocs[i].size));
+
+    re->_sourceSectionId = 0;
+    re->_targetSectionId = 0;
+    re->_sourceOffset = relocs[i].sourceOffset;
+    re->_data = relocs[i].data;
+  }
+  code._trampolinesSize = entry->trampolinesSize;
+
+  return runtime->_add(dst, &code);
+}
+
+Error CodeCache::store(const void* key, size_t keySize, CodeHolder* code) noexcept {
+  AutoLock locked(_lock);
+  if (ASMJIT_UNLIKELY(!_data))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(code->getCodeInfo().getArchType() != _codeInfo.getArchType()))
+    return DebugUtils::errored(kErrorInvalidArch);
+
+  // Only the code of a single section is stored.
+  if (ASMJIT_UNLIKELY(code->getSections().getLength() != 1))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  // Syncs the attached emitters.
+  size_t trampolinesSize = code->getCodeSize() - code->getSectionEntry(0)->getBuffer().getLength();
+  const CodeBuffer& buffer = code->getSectionEntry(0)->getBuffer();
+
+  const ZoneSegmentedVector<RelocEntry*>& relocations = code->_relocations;
+  size_t relocCount = 0;
+
+  // Only relocations relative to the start of the code are position-independent.
+  for (size_t i = 0; i < relocations.getLength(); i++) {
+    uint32_t type = relocations[i]->getType();
+    if (type == RelocEntry::kTypeNone)
+      continue;
+
+    if (type != RelocEntry::kTypeRelToAbs)
+      return DebugUtils::errored(kErrorInvalidState);
+    relocCount++;
+  }
+
+  size_t codeSize = buffer.getLength();
+  size_t contentSize = sizeof(CodeCacheEntry) + relocCount * sizeof(CodeCacheReloc) + keySize + codeSize;
+  size_t totalSize = Utils::alignTo<size_t>(contentSize, 8);
+
+  if (ASMJIT_UNLIKELY(codeSize == 0))
+    return DebugUtils::errored(kErrorNoCodeGenerated);
+
+  if (ASMJIT_UNLIKELY(totalSize > 0xFFFFFFFFU || keySize > 0xFFFFFFFFU))
+    return DebugUtils::errored(kErrorCodeTooLarge);
+
+  ASMJIT_PROPAGATE(codeCacheGrow(this, totalSize));
+
+  CodeCacheHeader* header = codeCacheGetHeader(this);
+  size_t offset = static_cast<size_t>(header->usedSize);
+
+  CodeCacheEntry* entry = reinterpret_cast<CodeCacheEntry*>(_data + offset);
+  entry->keyHash = codeCacheHash(kCodeCacheHashInit, key, keySize);
+  entry->totalSize = static_cast<uint32_t>(totalSize);
+  entry->flags = 0;
+  entry->keySize = static_cast<uint32_t>(keySize);
+  entry->codeSize = static_cast<uint32_t>(codeSize);
+  entry->relocCount = static_cast<uint32_t>(relocCount);
+  entry->trampolinesSize = static_cast<uint32_t>(trampolinesSize);
+
+  CodeCacheReloc* relocs = codeCacheGetRelocs(entry);
+  for (size_t i = 0; i < relocations.getLength(); i++) {
+    const RelocEntry* re = relocations[i];
+    if (re->getType() == RelocEntry::kTypeNone)
+      continue;
+
+    ::memset(relocs, 0, sizeof(CodeCacheReloc));
+    relocs->type = static_cast<uint8_t>(re->getType());
+    relocs->size = static_cast<uint8_t>(re->getSize());
+    relocs->sourceOffset = re->getSourceOffset();
+    relocs->data = re->getData();
+    relocs++;
+  }
+
+  ::memcpy(codeCacheGetKey(entry), key, keySize);
+  buffer.copyTo(codeCacheGetCode(entry));
+  ::memset(reinterpret_cast<uint8_t*>(entry) + contentSize, 0, totalSize - contentSize);
+  entry->contentHash = codeCacheHashContent(entry);
+
+  // Replace the previous entry of the same key.
+  CodeCacheEntry* previous = codeCacheFind(this, entry->keyHash, key, keySize);
+  if (previous)
+    previous->flags |= kCodeCacheEntryReplaced;
+
+  ASMJIT_PROPAGATE(codeCacheIndexInsert(this, entry->keyHash, offset));
+
+  // Publish the entry.
+  header->usedSize = offset + totalSize;
+  header->entryCount++;
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::CodeCache - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST) && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+static Error CodeCacheTest_generate(CodeHolder& code, int value) noexcept {
+  X86Assembler a(&code);
+
+  // The address of the data is relocated relative to the start of the code.
+  Label L_Data = a.newLabel();
+  a.mov(x86::eax, value);
+  a.ret();
+  a.align(kAlignData, 8);
+  a.bind(L_Data);
+  a.embedLabel(L_Data);
+
+  return a.getLastError();
+}
+
+UNIT(base_codecache) {
+  typedef int (*Func)(void);
+
+  char path[64];
+  ::snprintf(path, sizeof(path), "asmjit-test-%u.cache", static_cast<unsigned int>(OSUtils::getTickCount()));
+
+  const char kKeyA[] = "kernel-a";
+  const char kKeyB[] = "kernel-b";
+
+  {
+    JitRuntime rt;
+    CodeCache cache;
+
+    EXPECT(cache.open(path, rt.getCodeInfo()) == kErrorOk,
+      "CodeCache::open() failed");
+
+    Func fn;
+    EXPECT(cache.load(&rt, &fn, kKeyA, sizeof(kKeyA)) == kErrorOk && fn == nullptr,
+      "Empty cache should miss");
+
+    for (int i = 0; i < 2; i++) {
+      CodeHolder code;
+      code.init(rt.getCodeInfo());
+      EXPECT(CodeCacheTest_generate(code, i == 0 ? 1 : 2) == kErrorOk,
+        "Failed to generate code");
+      EXPECT(cache.store(i == 0 ? kKeyA : kKeyB, sizeof(kKeyA), &code) == kErrorOk,
+        "CodeCache::store() failed");
+    }
+
+    // Replace the code of `kKeyA`.
+    CodeHolder code;
+    code.init(rt.getCodeInfo());
+    CodeCacheTest_generate(code, 3);
+    EXPECT(cache.store(kKeyA, sizeof(kKeyA), &code) == kErrorOk,
+      "CodeCache::store() failed");
+    EXPECT(cache.getEntryCount() == 2,
+      "Invalid number of entries (%u)", static_cast<unsigned int>(cache.getEntryCount()));
+
+    // Code that calls an absolute address is not position-independent.
+    CodeHolder absCode;
+    absCode.init(rt.getCodeInfo());
+    X86Assembler a(&absCode);
+    a.call(static_cast<uint64_t>((uintptr_t)&CodeCacheTest_generate));
+    a.ret();
+    EXPECT(cache.store("abs", 3, &absCode) == kErrorInvalidState,
+      "Code with absolute relocations must not be cached");
+  }
+
+  INFO("Reopening the cache");
+  {
+    JitRuntime rt;
+    CodeCache cache;
+
+    EXPECT(cache.open(path, rt.getCodeInfo()) == kErrorOk,
+      "CodeCache::open() failed");
+    EXPECT(cache.getEntryCount() == 2,
+      "Invalid number of entries after reopening (%u)", static_cast<unsigned int>(cache.getEntryCount()));
+
+    Func fnA, fnB;
+    EXPECT(cache.load(&rt, &fnA, kKeyA, sizeof(kKeyA)) == kErrorOk && fnA != nullptr,
+      "Cached code of '%s' not found", kKeyA);
+    EXPECT(cache.load(&rt, &fnB, kKeyB, sizeof(kKeyB)) == kErrorOk && fnB != nullptr,
+      "Cached code of '%s' not found", kKeyB);
+
+    EXPECT(fnA() == 3 && fnB() == 2,
+      "Cached code returned invalid values");
+
+    // The embedded address of the data must be relocated to where it was loaded.
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(fnA);
+    uintptr_t embedded;
+    ::memcpy(&embedded, p + 8, sizeof(embedded));
+    EXPECT(embedded == (uintptr_t)(p + 8),
+      "Relocation of the cached code failed");
+
+    rt.release(fnA);
+    rt.release(fnB);
+  }
+
+  INFO("Changing CodeInfo invalidates the cache");
+  {
+    JitRuntime rt;
+    CodeInfo ci(rt.getCodeInfo());
+    ci.setStackAlignment(static_cast<uint8_t>(ci.getStackAlignment() * 2));
+
+    CodeCache cache;
+    EXPECT(cache.open(path, ci) == kErrorOk,
+      "CodeCache::open() failed");
+    EXPECT(cache.getEntryCount() == 0,
+      "Cache must be cleared when the fingerprint doesn't match");
+  }
+
+  ::remove(path);
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
@@ -0,0 +1,166 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_BASE_CODECACHE_H
+#define _ASMJIT_BASE_CODECACHE_H
+
+// [Dependencies]
+#include "../base/codeholder.h"
+#include "../base/osutils.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [Forward Declarations]
+// ============================================================================
+
+class JitRuntime;
+
+//! \addtogroup asmjit_base
+//! \{
+
+// ============================================================================
+// [asmjit::CodeCache]
+// ============================================================================
+
+//! Persistent cache of generated code stored in a memory-mapped file.
+//!
+//! Code is stored by `store()` under a key provided by the user - anything
+//! that identifies what was compiled, like a name of a kernel and parameters
+//! it was specialized for. `load()` looks the key up and adds the cached code
+//! to a \ref JitRuntime, which only copies the code and applies relocations,
+//! so no \ref CodeCompiler or register allocation is needed on a hit:
+//!
+//! ~~~
+//! JitRuntime rt;
+//! CodeCache cache;
+//! cache.open("kernels.cache", rt.getCodeInfo());
+//!
+//! Func fn;
+//! cache.load(&rt, &fn, key, keySize);
+//!
+//! if (!fn) {
+//!   CodeHolder code;
+//!   ... generate code ...
+//!   rt.add(&fn, &code);
+//!   cache.store(key, keySize, &code);
+//! }
+//! ~~~
+//!
+//! The file is tagged by a fingerprint of the library version, \ref CodeInfo
+//! passed to `open()`, and features of the host CPU. If the fingerprint
+//! doesn't match the file is discarded, so code generated for a different
+//! CPU or by a different version of AsmJit is never loaded. Each entry also
+//! stores a hash of its content, which is verified by `load()`.
+//!
+//! Only position-independent code can be cached - code that has relocations
+//! to absolute addresses (calls and jumps to host functions) is rejected by
+//! `store()`, because these addresses differ between processes. The code must
+//! also not embed such addresses as immediates.
+//!
+//! NOTE: The cache is thread-safe, but the file must not be opened by more
+//! processes at the same time.
+class CodeCache {
+public:
+  ASMJIT_NONCOPYABLE(CodeCache)
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `CodeCache` instance.
+  ASMJIT_API CodeCache() noexcept;
+  //! Destroy the `CodeCache` instance, closes the file.
+  ASMJIT_API ~CodeCache() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Open / Close]
+  // --------------------------------------------------------------------------
+
+  //! Open or create the cache file at `path` for code compatible with `codeInfo`.
+  //!
+  //! If the file was created by a different version of AsmJit, for different
+  //! `codeInfo`, or on a CPU that has different features, it's cleared.
+  ASMJIT_API Error open(const char* path, const CodeInfo& codeInfo) noexcept;
+  //! Close the cache file.
+  ASMJIT_API void close() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get whether the cache file is open.
+  ASMJIT_INLINE bool isOpen() const noexcept { return _data != nullptr; }
+  //! Get the fingerprint of the library version, `CodeInfo`, and host CPU.
+  ASMJIT_INLINE uint64_t getFingerprint() const noexcept { return _fingerprint; }
+  //! Get the number of cached entries.
+  ASMJIT_INLINE size_t getEntryCount() const noexcept { return _indexCount; }
+
+  // --------------------------------------------------------------------------
+  // [Load / Store]
+  // --------------------------------------------------------------------------
+
+  //! Add code cached under `key` of `keySize` bytes to `runtime`.
+  //!
+  //! If the key is not cached `dst` is set to null and `kErrorOk` is returned.
+  template<typename Func>
+  ASMJIT_INLINE Error load(JitRuntime* runtime, Func* dst, const void* key, size_t keySize) noexcept {
+    return _load(runtime, Internal::ptr_cast<void**, Func*>(dst), key, keySize);
+  }
+
+  //! \internal
+  ASMJIT_API Error _load(JitRuntime* runtime, void** dst, const void* key, size_t keySize) noexcept;
+
+  //! Store code held by `code` under `key` of `keySize` bytes.
+  //!
+  //! Replaces code already cached under the same key. Returns `kErrorInvalidState`
+  //! if the code is not position-independent.
+  ASMJIT_API Error store(const void* key, size_t keySize, CodeHolder* code) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  //! \internal
+  //!
+  //! Index entry, maps a hash of a key to the offset of its entry in the file.
+  struct IndexEntry {
+    uint64_t hash;
+    size_t offset;
+  };
+
+  Lock _lock;                            //!< Lock that protects the cache.
+  CodeInfo _codeInfo;                    //!< CodeInfo passed to `open()`.
+  uint64_t _fingerprint;                 //!< Fingerprint of the file.
+
+  uint8_t* _data;                        //!< Mapped file.
+  size_t _mappedSize;                    //!< Size of the mapping.
+
+  IndexEntry* _index;                    //!< Open-addressing hash table of entries.
+  size_t _indexCount;                    //!< Number of entries in `_index`.
+  size_t _indexCapacity;                 //!< Capacity of `_index` (power of 2).
+
+#if ASMJIT_OS_WINDOWS
+  HANDLE _hFile;                         //!< File handle.
+  HANDLE _hMapping;                      //!< File mapping handle.
+#else
+  int _fd;                               //!< File descriptor.
+#endif // ASMJIT_OS_WINDOWS
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // _ASMJIT_BASE_CODECACHE_H
@@ -61,7 +61,8 @@ CodeCompiler::CodeCompiler() noexcept
     _vRegZone(4096 - Zone::kZoneOverhead),
     _vRegArray(),
     _localConstPool(nullptr),
-    _globalConstPool(nullptr) {
+    _globalConstPool(nullptr),
+    _livenessMode(kLivenessAuto) {
 
   _type = kTypeCompiler;
 }
@@ -87,6 +88,46 @@ Error CodeCompiler::onDetach(CodeHolder* code) noexcept {
   return Base::onDetach(code);
 }
 
+// ============================================================================
+// [asmjit::CodeCompiler - Zone Statistics]
+// ============================================================================
+
+void CodeCompiler::getZoneStats(ZoneStats* out) const noexcept {
+  ZoneStats stats;
+
+  Base::getZoneStats(out);
+  _vRegZone.getStats(&stats);
+  out->add(stats);
+}
+
+// ============================================================================
+// [asmjit::CodeCompiler - Checkpoint]
+// ============================================================================
+
+Error CodeCompiler::saveCheckpoint(Checkpoint* out) noexcept {
+  ASMJIT_PROPAGATE(Base::saveCheckpoint(out));
+
+  out->vRegCount = _vRegArray.getLength();
+  _vRegZone.saveState(&out->vRegZone);
+
+  out->func = _func;
+  out->localConstPool = _localConstPool;
+  out->globalConstPool = _globalConstPool;
+  return kErrorOk;
+}
+
+Error CodeCompiler::rollback(const Checkpoint& cp) noexcept {
+  ASMJIT_PROPAGATE(Base::rollback(cp));
+
+  _vRegArray.truncate(cp.vRegCount);
+  _vRegZone.restoreState(cp.vRegZone);
+
+  _func = cp.func;
+  _localConstPool = cp.localConstPool;
+  _globalConstPool = cp.globalConstPool;
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CodeCompiler - Node-Factory]
 // ============================================================================
@@ -561,6 +561,28 @@ public:
   ASMJIT_NONCOPYABLE(CodeCompiler)
   typedef CodeBuilder Base;
 
+  //! Saved state of `CodeCompiler`, see `saveCheckpoint()` and `rollback()`.
+  struct Checkpoint : public CodeBuilder::Checkpoint {
+    size_t vRegCount;                    //!< Number of virtual registers.
+    Zone::State vRegZone;                //!< State of the zone of virtual registers.
+    CCFunc* func;                        //!< Current function.
+    CBConstPool* localConstPool;         //!< Local constant pool.
+    CBConstPool* globalConstPool;        //!< Global constant pool.
+  };
+
+  //! Representation of registers live at each node, used by liveness analysis.
+  ASMJIT_ENUM(LivenessMode) {
+    //! Use sorted arrays of register ids if only a small portion of registers
+    //! is live at a node and bit-arrays otherwise (default).
+    kLivenessAuto = 0,
+    //! Always use bit-arrays, which have a size proportional to the number of
+    //! virtual registers of the function.
+    kLivenessDense = 1,
+    //! Always use sorted arrays of register ids, which have a size proportional
+    //! to the number of registers live at a node.
+    kLivenessSparse = 2
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -577,6 +599,26 @@ public:
   ASMJIT_API virtual Error onAttach(CodeHolder* code) noexcept override;
   ASMJIT_API virtual Error onDetach(CodeHolder* code) noexcept override;
 
+  // --------------------------------------------------------------------------
+  // [Zone Statistics]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual void getZoneStats(ZoneStats* out) const noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Checkpoint]
+  // --------------------------------------------------------------------------
+
+  //! Save the state of the `CodeCompiler` and of the attached `CodeHolder`.
+  ASMJIT_API Error saveCheckpoint(Checkpoint* out) noexcept;
+
+  //! Rewind to the state saved by `saveCheckpoint()`.
+  //!
+  //! In addition to \ref CodeBuilder::rollback() it removes virtual registers
+  //! created after the checkpoint. Constants added to a constant pool that
+  //! existed before the checkpoint are kept.
+  ASMJIT_API Error rollback(const Checkpoint& cp) noexcept;
+
   // --------------------------------------------------------------------------
   // [Node-Factory]
   // --------------------------------------------------------------------------
@@ -634,6 +676,18 @@ public:
   //! Emit a new hint (purely informational node).
   ASMJIT_API Error _hint(Reg& reg, uint32_t hint, uint32_t value);
 
+  // --------------------------------------------------------------------------
+  // [Liveness]
+  // --------------------------------------------------------------------------
+
+  //! Get the representation of liveness used by the register allocator, see \ref LivenessMode.
+  ASMJIT_INLINE uint32_t getLivenessMode() const noexcept { return _livenessMode; }
+  //! Set the representation of liveness used by the register allocator, see \ref LivenessMode.
+  ASMJIT_INLINE void setLivenessMode(uint32_t mode) noexcept {
+    ASMJIT_ASSERT(mode <= kLivenessSparse);
+    _livenessMode = mode;
+  }
+
   // --------------------------------------------------------------------------
   // [VirtReg / Stack]
   // --------------------------------------------------------------------------
@@ -683,7 +737,7 @@ public:
   }
 
   //! Get an array of all virtual registers managed by CodeCompiler.
-  ASMJIT_INLINE const ZoneVector<VirtReg*>& getVirtRegArray() const noexcept { return _vRegArray; }
+  ASMJIT_INLINE const ZoneSegmentedVector<VirtReg*>& getVirtRegArray() const noexcept { return _vRegArray; }
 
   //! Alloc a virtual register `reg`.
   ASMJIT_API Error alloc(Reg& reg);
@@ -720,10 +774,12 @@ public:
   CCFunc* _func;                         //!< Current function.
 
   Zone _vRegZone;                        //!< Allocates \ref VirtReg objects.
-  ZoneVector<VirtReg*> _vRegArray;       //!< Stores array of \ref VirtReg pointers.
+  ZoneSegmentedVector<VirtReg*> _vRegArray; //!< Stores array of \ref VirtReg pointers.
 
   CBConstPool* _localConstPool;          //!< Local constant pool, flushed at the end of each function.
   CBConstPool* _globalConstPool;         //!< Global constant pool, flushed at the end of the compilation.
+
+  uint32_t _livenessMode;                //!< Representation of liveness, see \ref LivenessMode.
 };
 
 //! \}
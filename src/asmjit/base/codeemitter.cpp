@@ -108,6 +108,24 @@ Error CodeEmitter::_emitOpArray(uint32_t instId, const Operand_* opArray, size_t
   }
 }
 
+Error CodeEmitter::_emitStream(const InstRecord* records, size_t count, size_t* countOut) {
+  Error err = kErrorOk;
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    const InstRecord& record = records[i];
+
+    setOptions(record.options);
+    setExtraReg(record.extraReg);
+
+    err = _emitOpArray(record.instId, record.operands, record.getOpCount());
+    if (ASMJIT_UNLIKELY(err)) break;
+  }
+
+  if (countOut) *countOut = i;
+  return err;
+}
+
 // ============================================================================
 // [asmjit::CodeEmitter - Finalize]
 // ============================================================================
@@ -77,7 +77,38 @@ public:
     //! This feature is disabled by default, because the only processor that
     //! used to take into consideration prediction hints was P4. Newer processors
     //! implement heuristics for branch prediction that ignores any static hints.
-    kHintPredictedJumps = 0x00000002U
+    kHintPredictedJumps = 0x00000002U,
+
+    //! Emit position-independent code.
+    //!
+    //! Default `false`.
+    //!
+    //! X86/X64 Specific
+    //! ----------------
+    //!
+    //! In 64-bit mode jumps and calls to absolute addresses are emitted as
+    //! `jmp|call [rip + GOT]`, where GOT is an entry of the global offset table
+    //! created by \ref CodeHolder::addGotEntry(). Conditional jumps are emitted
+    //! as an inverted short jump over `jmp [rip + GOT]`. Memory operands can't
+    //! use absolute addresses (except FS|GS relative ones), emitting them fails
+    //! with `kErrorInvalidAddress` - the address has to be loaded to a register
+    //! first.
+    //!
+    //! Code relocated by \ref CodeHolder::relocate() then doesn't depend on its
+    //! base address, only the GOT holds absolute addresses. This hint has no
+    //! effect in 32-bit mode, which has no RIP-relative addressing.
+    kHintPositionIndependent = 0x00000004U,
+
+    //! Relax jumps to labels when the code is finalized by \ref CodeCompiler.
+    //!
+    //! Default `false`.
+    //!
+    //! Assembler emits a forward jump to a label that is not bound yet in its
+    //! long form, unless `short_()` was used, because the displacement is not
+    //! known. If this hint is enabled `CodeCompiler::finalize()` computes the
+    //! final layout first and uses the short form of each jump that has no
+    //! explicit form and whose displacement fits.
+    kHintRelaxJumps = 0x00000008U
   };
 
   //! CodeEmitter options that are merged with instruction options.
@@ -148,6 +179,32 @@ public:
     kOptionOverwrite = 0x00000020U
   };
 
+  //! Instruction record passed to `emitStream()`.
+  //!
+  //! Operands that are not used must be none, a zeroed record is an empty one.
+  struct InstRecord {
+    enum {
+      //! Maximum number of operands.
+      kMaxOperands = 6
+    };
+
+    //! Reset the record to no instruction and no operands.
+    ASMJIT_INLINE void reset() noexcept { ::memset(this, 0, sizeof(*this)); }
+
+    //! Get the number of operands used (operands after the last one that is not none are ignored).
+    ASMJIT_INLINE uint32_t getOpCount() const noexcept {
+      uint32_t n = kMaxOperands;
+      while (n && operands[n - 1].isNone())
+        n--;
+      return n;
+    }
+
+    uint32_t instId;                     //!< Instruction id.
+    uint32_t options;                    //!< Instruction options.
+    RegOnly extraReg;                    //!< Extra register (op-mask {k} on AVX-512).
+    Operand_ operands[kMaxOperands];     //!< Instruction operands.
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -174,6 +231,8 @@ public:
   virtual Error _emit(uint32_t instId, const Operand_& o0, const Operand_& o1, const Operand_& o2, const Operand_& o3, const Operand_& o4, const Operand_& o5) = 0;
   //! Emit instruction having operands stored in array.
   virtual Error _emitOpArray(uint32_t instId, const Operand_* opArray, size_t opCount);
+  //! Emit `count` instructions stored in `records`.
+  virtual Error _emitStream(const InstRecord* records, size_t count, size_t* countOut);
 
   //! Create a new label.
   virtual Label newLabel() = 0;
@@ -201,6 +260,11 @@ public:
   //! NOTE: Attempt to bind the same label multiple times will return an error.
   virtual Error bind(const Label& label) = 0;
 
+  //! Switch to `section`, the code that follows is emitted at its end.
+  //!
+  //! The `section` must have been created by the attached \ref CodeHolder.
+  virtual Error section(SectionEntry* section) = 0;
+
   //! Align to the `alignment` specified.
   //!
   //! The sequence that is used to fill the gap between the aligned location
@@ -461,6 +525,17 @@ public:
     return _emitOpArray(instId, opArray, opCount);
   }
 
+  //! Emit `count` instructions stored in `records`, see \ref InstRecord.
+  //!
+  //! Equivalent to emitting the records one by one with their options and
+  //! extra registers, but \ref Assembler encodes them in a single loop without
+  //! a virtual call and without copying operands per instruction. Stops at the
+  //! first instruction that fails and returns its error. The number of emitted
+  //! instructions is stored to `countOut`, if not null.
+  ASMJIT_INLINE Error emitStream(const InstRecord* records, size_t count, size_t* countOut = nullptr) {
+    return _emitStream(records, count, countOut);
+  }
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
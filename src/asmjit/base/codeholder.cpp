@@ -12,6 +12,12 @@
 #include "../base/utils.h"
 #include "../base/vmem.h"
 
+#if defined(ASMJIT_TEST) && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+# include <string.h>
+# include "../base/runtime.h"
+# include "../x86/x86assembler.h"
+#endif // ASMJIT_TEST
+
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
 
@@ -24,6 +30,27 @@ namespace asmjit {
 ErrorHandler::ErrorHandler() noexcept {}
 ErrorHandler::~ErrorHandler() noexcept {}
 
+// ============================================================================
+// [asmjit::CodeBuffer]
+// ============================================================================
+
+void CodeBuffer::copyTo(void* dst) const noexcept {
+  uint8_t* p = static_cast<uint8_t*>(dst);
+  size_t count = _chunkCount;
+
+  if (!count) {
+    if (_length) ::memcpy(p, _data, _length);
+    return;
+  }
+
+  // The end of a chunk is the offset of the next one.
+  for (size_t i = 0; i < count; i++) {
+    const Chunk* chunk = _chunks[i];
+    size_t end = i + 1 < count ? _chunks[i + 1]->offset : _length;
+    ::memcpy(p + chunk->offset, chunk->getData(), end - chunk->offset);
+  }
+}
+
 // ============================================================================
 // [asmjit::CodeHolder - Utilities]
 // ============================================================================
@@ -40,6 +67,29 @@ static void CodeHolder_setGlobalOption(CodeHolder* self, uint32_t clear, uint32_
   }
 }
 
+// Release the data of `cb`, which becomes empty, keeps its chunk size.
+static void CodeHolder_releaseBuffer(CodeBuffer* cb) noexcept {
+  if (cb->_chunkCount) {
+    for (size_t i = 0; i < cb->_chunkCount; i++)
+      Internal::releaseMemory(cb->_chunks[i]);
+  }
+  else if (cb->hasData() && !cb->isExternal()) {
+    Internal::releaseMemory(cb->_data);
+  }
+
+  if (cb->_chunks)
+    Internal::releaseMemory(cb->_chunks);
+
+  cb->_data = nullptr;
+  cb->_length = 0;
+  cb->_capacity = 0;
+  cb->_dataOffset = 0;
+  cb->_chunks = nullptr;
+  cb->_chunkCount = 0;
+  cb->_chunkCapacity = 0;
+  cb->_isExternal = false;
+}
+
 static void CodeHolder_resetInternal(CodeHolder* self, bool releaseMemory) noexcept {
   // Detach all `CodeEmitter`s.
   while (self->_emitters)
@@ -54,23 +104,26 @@ static void CodeHolder_resetInternal(CodeHolder* self, bool releaseMemory) noexc
 
   self->_unresolvedLabelsCount = 0;
   self->_trampolinesSize = 0;
+  self->_checkpointCount = 0;
 
   // Reset all sections.
   size_t numSections = self->_sections.getLength();
-  for (size_t i = 0; i < numSections; i++) {
-    SectionEntry* section = self->_sections[i];
-    if (section->_buffer.hasData() && !section->_buffer.isExternal())
-      Internal::releaseMemory(section->_buffer._data);
-    section->_buffer._data = nullptr;
-    section->_buffer._capacity = 0;
-  }
+  for (size_t i = 0; i < numSections; i++)
+    CodeHolder_releaseBuffer(&self->_sections[i]->_buffer);
+
+  self->_streamData = nullptr;
+  self->_streamCapacity = 0;
+  self->_streamAddress = 0;
 
   // Reset zone allocator and all containers using it.
   ZoneHeap* heap = &self->_baseHeap;
 
   self->_namedLabels.reset(heap);
+  self->_gotEntries.reset(heap);
+  self->_gotSection = nullptr;
   self->_relocations.reset();
   self->_labels.reset();
+  self->_labelJournal.reset();
   self->_sections.reset();
 
   heap->reset(&self->_baseZone);
@@ -91,10 +144,17 @@ CodeHolder::CodeHolder() noexcept
     _errorHandler(nullptr),
     _unresolvedLabelsCount(0),
     _trampolinesSize(0),
+    _checkpointStamp(0),
+    _checkpointCount(0),
     _baseZone(16384 - Zone::kZoneOverhead),
     _dataZone(16384 - Zone::kZoneOverhead),
     _baseHeap(&_baseZone),
-    _namedLabels(&_baseHeap) {}
+    _namedLabels(&_baseHeap),
+    _gotSection(nullptr),
+    _gotEntries(&_baseHeap),
+    _streamData(nullptr),
+    _streamCapacity(0),
+    _streamAddress(0) {}
 
 CodeHolder::~CodeHolder() noexcept {
   CodeHolder_resetInternal(this, true);
@@ -236,12 +296,51 @@ void CodeHolder::sync() noexcept {
 // [asmjit::CodeHolder - Result Information]
 // ============================================================================
 
+// Get the size of `section` in the flattened code, including its zeroed part.
+static ASMJIT_INLINE size_t CodeHolder_getSectionSize(const SectionEntry* section) noexcept {
+  return std::max<size_t>(section->_buffer._length, section->_virtualSize);
+}
+
+// Get the end of the last section, `flatten()` must have been called.
+static ASMJIT_INLINE size_t CodeHolder_getSectionsEnd(const CodeHolder* self) noexcept {
+  const SectionEntry* last = self->_sections[self->_sections.getLength() - 1];
+  return last->_offset + CodeHolder_getSectionSize(last);
+}
+
 size_t CodeHolder::getCodeSize() const noexcept {
   // Reflect all changes first.
-  const_cast<CodeHolder*>(this)->sync();
+  CodeHolder* self = const_cast<CodeHolder*>(this);
+  self->sync();
+
+  if (ASMJIT_UNLIKELY(self->flatten() != kErrorOk))
+    return 0;
+
+  return CodeHolder_getSectionsEnd(this) + getTrampolinesSize();
+}
+
+void CodeHolder::getZoneStats(ZoneStats* out) const noexcept {
+  ZoneStats stats;
+
+  _baseZone.getStats(out);
+  _dataZone.getStats(&stats);
+  out->add(stats);
+  _baseHeap.getStats(&stats);
+  out->add(stats);
+}
+
+// ============================================================================
+// [asmjit::CodeHolder - Global Information]
+// ============================================================================
+
+void CodeHolder::setGlobalHints(uint32_t hints) noexcept {
+  _globalHints = hints;
 
-  // TODO: Support sections.
-  return _sections[0]->_buffer._length + getTrampolinesSize();
+  // Modify global hints of all `CodeEmitter`s attached.
+  CodeEmitter* emitter = _emitters;
+  while (emitter) {
+    emitter->_globalHints = hints;
+    emitter = emitter->_nextEmitter;
+  }
 }
 
 // ============================================================================
@@ -267,36 +366,258 @@ Error CodeHolder::setErrorHandler(ErrorHandler* handler) noexcept {
 // [asmjit::CodeHolder - Sections]
 // ============================================================================
 
+// Update the `Assembler` pointers if attached. Maybe we should introduce an
+// event for this, but since only one Assembler can be attached at a time it
+// should not matter how these pointers are updated.
+static ASMJIT_INLINE void CodeHolder_onBufferChanged(CodeHolder* self, CodeBuffer* cb) noexcept {
+  Assembler* a = self->_cgAsm;
+  if (a && &a->_section->_buffer == cb)
+    a->_setBuffer(*cb, a->getOffset());
+}
+
 static Error CodeHolder_reserveInternal(CodeHolder* self, CodeBuffer* cb, size_t n) noexcept {
   uint8_t* oldData = cb->_data;
   uint8_t* newData;
 
-  if (oldData && !cb->isExternal())
+  if (oldData && !cb->isExternal()) {
     newData = static_cast<uint8_t*>(Internal::reallocMemory(oldData, n));
-  else
+  }
+  else {
     newData = static_cast<uint8_t*>(Internal::allocMemory(n));
 
+    // The content of an external buffer is copied, the buffer itself is kept.
+    if (newData && oldData)
+      ::memcpy(newData, oldData, cb->_length);
+  }
+
   if (ASMJIT_UNLIKELY(!newData))
     return DebugUtils::errored(kErrorNoHeapMemory);
 
   cb->_data = newData;
   cb->_capacity = n;
+  cb->_isExternal = false;
+
+  CodeHolder_onBufferChanged(self, cb);
+  return kErrorOk;
+}
+
+// Append a chunk of at least `n` bytes to a chunked buffer, it replaces the
+// last chunk if it's empty. Must be called after `Assembler::sync()`.
+static Error CodeHolder_appendChunk(CodeHolder* self, CodeBuffer* cb, size_t n) noexcept {
+  size_t length = cb->_length;
 
-  // Update the `Assembler` pointers if attached. Maybe we should introduce an
-  // event for this, but since only one Assembler can be attached at a time it
-  // should not matter how these pointers are updated.
+  // Code would be appended after a part that is being overwritten.
   Assembler* a = self->_cgAsm;
-  if (a && &a->_section->_buffer == cb) {
-    size_t offset = a->getOffset();
+  if (ASMJIT_UNLIKELY(a && &a->_section->_buffer == cb && a->getOffset() != length))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  size_t capacity = std::max<size_t>(cb->_chunkSize, n);
+  if (ASMJIT_UNLIKELY(capacity > IntTraits<size_t>::maxValue() - sizeof(CodeBuffer::Chunk)))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  CodeBuffer::Chunk* chunk = static_cast<CodeBuffer::Chunk*>(
+    Internal::allocMemory(sizeof(CodeBuffer::Chunk) + capacity));
+
+  if (ASMJIT_UNLIKELY(!chunk))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  size_t count = cb->_chunkCount;
+  if (count && cb->_chunks[count - 1]->offset == length) {
+    Internal::releaseMemory(cb->_chunks[--count]);
+  }
+  else if (count == cb->_chunkCapacity) {
+    size_t newCapacity = count ? count * 2 : size_t(16);
+    CodeBuffer::Chunk** chunks = nullptr;
+
+    if (ASMJIT_LIKELY(newCapacity <= IntTraits<size_t>::maxValue() / sizeof(CodeBuffer::Chunk*)))
+      chunks = static_cast<CodeBuffer::Chunk**>(
+        Internal::reallocMemory(cb->_chunks, newCapacity * sizeof(CodeBuffer::Chunk*)));
+
+    if (ASMJIT_UNLIKELY(!chunks)) {
+      Internal::releaseMemory(chunk);
+      return DebugUtils::errored(kErrorNoHeapMemory);
+    }
+
+    cb->_chunks = chunks;
+    cb->_chunkCapacity = newCapacity;
+  }
+
+  chunk->offset = length;
+  chunk->capacity = capacity;
+  cb->_chunks[count] = chunk;
+  cb->_chunkCount = count + 1;
+
+  cb->_data = chunk->getData();
+  cb->_capacity = capacity;
+  cb->_dataOffset = length;
+
+  CodeHolder_onBufferChanged(self, cb);
+  return kErrorOk;
+}
+
+// Release chunks after the length of a chunked buffer, after a rollback.
+static void CodeHolder_truncateChunks(CodeBuffer* cb) noexcept {
+  size_t count = cb->_chunkCount;
+  if (!count || cb->_chunks[count - 1]->offset <= cb->_length)
+    return;
+
+  do {
+    Internal::releaseMemory(cb->_chunks[--count]);
+  } while (cb->_chunks[count - 1]->offset > cb->_length);
+
+  CodeBuffer::Chunk* chunk = cb->_chunks[count - 1];
+  cb->_chunkCount = count;
+
+  cb->_data = chunk->getData();
+  cb->_capacity = chunk->capacity;
+  cb->_dataOffset = chunk->offset;
+}
+
+Error CodeHolder::newSection(SectionEntry** sectionOut, const char* name, size_t nameLength, uint32_t flags, uint32_t alignment) noexcept {
+  *sectionOut = nullptr;
+
+  if (nameLength == Globals::kInvalidIndex)
+    nameLength = ::strlen(name);
+
+  if (ASMJIT_UNLIKELY(nameLength == 0 || nameLength >= sizeof(SectionEntry::_name) || getSectionByName(name, nameLength)))
+    return DebugUtils::errored(kErrorInvalidSectionName);
+
+  if (ASMJIT_UNLIKELY(!Utils::isPowerOf2(alignment)))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  ASMJIT_PROPAGATE(_sections.willGrow(&_baseHeap));
+  SectionEntry* se = _baseZone.allocZeroedT<SectionEntry>();
+
+  if (ASMJIT_UNLIKELY(!se))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  se->_id = static_cast<uint32_t>(_sections.getLength());
+  se->_flags = flags;
+  se->_alignment = alignment;
+  ::memcpy(se->_name, name, nameLength);
+  _sections.appendUnsafe(se);
+
+  *sectionOut = se;
+  return kErrorOk;
+}
+
+SectionEntry* CodeHolder::getSectionByName(const char* name, size_t nameLength) const noexcept {
+  if (nameLength == Globals::kInvalidIndex)
+    nameLength = ::strlen(name);
+
+  for (size_t i = 0, len = _sections.getLength(); i < len; i++) {
+    SectionEntry* se = _sections[i];
+    if (::strlen(se->_name) == nameLength && ::memcmp(se->_name, name, nameLength) == 0)
+      return se;
+  }
+
+  return nullptr;
+}
 
-    a->_bufferData = newData;
-    a->_bufferEnd  = newData + n;
-    a->_bufferPtr  = newData + offset;
+Error CodeHolder::flatten() noexcept {
+  size_t offset = 0;
+
+  for (size_t i = 0, len = _sections.getLength(); i < len; i++) {
+    SectionEntry* se = _sections[i];
+    size_t size = CodeHolder_getSectionSize(se);
+
+    // Empty sections don't add any padding.
+    if (size != 0 && se->_alignment > 1) {
+      size_t aligned = Utils::alignTo<size_t>(offset, se->_alignment);
+      if (ASMJIT_UNLIKELY(aligned < offset))
+        return DebugUtils::errored(kErrorCodeTooLarge);
+      offset = aligned;
+    }
+
+    if (ASMJIT_UNLIKELY(size > IntTraits<size_t>::maxValue() - offset))
+      return DebugUtils::errored(kErrorCodeTooLarge);
+
+    se->_offset = offset;
+    offset += size;
   }
 
   return kErrorOk;
 }
 
+namespace {
+
+//! \internal
+//!
+//! Only used to lookup an entry from `_gotEntries`.
+class GotByAddress {
+public:
+  ASMJIT_INLINE GotByAddress(uint64_t address) noexcept
+    : address(address),
+      hVal(static_cast<uint32_t>(address ^ (address >> 32))) {}
+
+  ASMJIT_INLINE bool matches(const GotEntry* entry) const noexcept {
+    return entry->getAddress() == address;
+  }
+
+  uint64_t address;
+  uint32_t hVal;
+};
+
+} // anonymous namespace
+
+Error CodeHolder::addGotEntry(size_t* offsetOut, uint64_t address) noexcept {
+  uint32_t entrySize = getArchInfo().getGpSize();
+  SectionEntry* got = _gotSection;
+
+  if (!got) {
+    ASMJIT_PROPAGATE(newSection(&got, ".got", Globals::kInvalidIndex, SectionEntry::kFlagConst, entrySize));
+    _gotSection = got;
+  }
+
+  CodeBuffer& buf = got->_buffer;
+  GotByAddress key(address);
+  GotEntry* entry = _gotEntries.get(key);
+
+  if (entry) {
+    // `rollback()` truncates the GOT, but keeps its entries in `_gotEntries`,
+    // an entry is only valid if its slot still holds the address.
+    size_t offset = entry->_offset;
+    if (offset + entrySize <= buf._length) {
+      const uint8_t* p = buf.getDataAt(offset);
+      uint64_t value = entrySize == 8 ? Utils::readU64u(p)
+                                      : static_cast<uint64_t>(Utils::readU32u(p));
+      if (value == address) {
+        *offsetOut = offset;
+        return kErrorOk;
+      }
+    }
+  }
+  else {
+    entry = _baseHeap.allocZeroedT<GotEntry>();
+    if (ASMJIT_UNLIKELY(!entry))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    entry->_hVal = key.hVal;
+    entry->_address = address;
+    entry->_offset = Globals::kInvalidIndex;
+
+    if (ASMJIT_UNLIKELY(!_gotEntries.put(entry))) {
+      _baseHeap.release(entry, sizeof(GotEntry));
+      return DebugUtils::errored(kErrorNoHeapMemory);
+    }
+  }
+
+  if (buf._capacity - buf._length < entrySize)
+    ASMJIT_PROPAGATE(growBuffer(&buf, entrySize));
+
+  size_t offset = buf._length;
+  if (entrySize == 8)
+    Utils::writeU64u(buf.getDataAt(offset), address);
+  else
+    Utils::writeU32u(buf.getDataAt(offset), static_cast<uint32_t>(address & 0xFFFFFFFFU));
+
+  buf._length = offset + entrySize;
+  entry->_offset = offset;
+
+  *offsetOut = offset;
+  return kErrorOk;
+}
+
 Error CodeHolder::growBuffer(CodeBuffer* cb, size_t n) noexcept {
   // This is most likely called by `Assembler` so `sync()` shouldn't be needed,
   // however, if this is called by the user and the currently attached Assembler
@@ -312,12 +633,16 @@ Error CodeHolder::growBuffer(CodeBuffer* cb, size_t n) noexcept {
   // We can now check if growing the buffer is really necessary. It's unlikely
   // that this function is called while there is still room for `n` bytes.
   size_t capacity = cb->getCapacity();
-  size_t required = cb->getLength() + n;
+  size_t required = length - cb->_dataOffset + n;
   if (ASMJIT_UNLIKELY(required <= capacity)) return kErrorOk;
 
   if (cb->isFixedSize())
     return DebugUtils::errored(kErrorCodeTooLarge);
 
+  // A chunked buffer is never reallocated, `n` bytes go to a new chunk.
+  if (cb->isChunked())
+    return CodeHolder_appendChunk(this, cb, n);
+
   if (capacity < 8096)
     capacity = 8096;
   else
@@ -345,7 +670,7 @@ Error CodeHolder::growBuffer(CodeBuffer* cb, size_t n) noexcept {
 
 Error CodeHolder::reserveBuffer(CodeBuffer* cb, size_t n) noexcept {
   size_t capacity = cb->getCapacity();
-  if (n <= capacity) return kErrorOk;
+  if (n <= cb->_dataOffset + capacity) return kErrorOk;
 
   if (cb->isFixedSize())
     return DebugUtils::errored(kErrorCodeTooLarge);
@@ -353,9 +678,86 @@ Error CodeHolder::reserveBuffer(CodeBuffer* cb, size_t n) noexcept {
   // We must sync, as mentioned in `growBuffer()` as well.
   if (_cgAsm) _cgAsm->sync();
 
+  if (cb->isChunked())
+    return CodeHolder_appendChunk(this, cb, n - cb->_length);
+
   return CodeHolder_reserveInternal(this, cb, n);
 }
 
+Error CodeHolder::setBufferChunkSize(CodeBuffer* cb, size_t chunkSize) noexcept {
+  if (chunkSize == cb->_chunkSize)
+    return kErrorOk;
+
+  if (ASMJIT_UNLIKELY(chunkSize != 0 && chunkSize < CodeBuffer::kMinChunkSize))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (_cgAsm) _cgAsm->sync();
+
+  if (ASMJIT_UNLIKELY(cb->getLength() != 0 || cb->isExternal() || cb->isFixedSize()))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  CodeHolder_releaseBuffer(cb);
+  cb->_chunkSize = chunkSize;
+
+  CodeHolder_onBufferChanged(this, cb);
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::CodeHolder - Stream]
+// ============================================================================
+
+Error CodeHolder::setStream(void* data, size_t capacity, uint64_t address) noexcept {
+  if (ASMJIT_UNLIKELY(!isInitialized()))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(!data || !capacity || _streamData))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (_cgAsm) _cgAsm->sync();
+
+  CodeBuffer* cb = &_sections[0]->_buffer;
+  if (ASMJIT_UNLIKELY(cb->getLength() != 0 || cb->isChunked()))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  if (cb->hasData() && !cb->isExternal())
+    Internal::releaseMemory(cb->_data);
+
+  cb->_data = static_cast<uint8_t*>(data);
+  cb->_capacity = capacity;
+  cb->_isExternal = true;
+  CodeHolder_onBufferChanged(this, cb);
+
+  _streamData = static_cast<uint8_t*>(data);
+  _streamCapacity = capacity;
+  _streamAddress = address;
+
+  return kErrorOk;
+}
+
+Error CodeHolder::resetStream(bool moveCode) noexcept {
+  if (!_streamData)
+    return kErrorOk;
+
+  if (isStreaming()) {
+    if (_cgAsm) _cgAsm->sync();
+    CodeBuffer* cb = &_sections[0]->_buffer;
+
+    if (moveCode) {
+      ASMJIT_PROPAGATE(CodeHolder_reserveInternal(this, cb, std::max<size_t>(cb->_length, 1)));
+    }
+    else {
+      cb->_capacity = cb->_length;
+      CodeHolder_onBufferChanged(this, cb);
+    }
+  }
+
+  _streamData = nullptr;
+  _streamCapacity = 0;
+  _streamAddress = 0;
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::CodeHolder - Labels & Symbols]
 // ============================================================================
@@ -367,18 +769,22 @@ namespace {
 //! Only used to lookup a label from `_namedLabels`.
 class LabelByName {
 public:
-  ASMJIT_INLINE LabelByName(const char* name, size_t nameLength, uint32_t hVal) noexcept
+  ASMJIT_INLINE LabelByName(const char* name, size_t nameLength, uint32_t hVal, uint32_t parentId) noexcept
     : name(name),
-      nameLength(static_cast<uint32_t>(nameLength)) {}
+      nameLength(static_cast<uint32_t>(nameLength)),
+      hVal(hVal),
+      parentId(parentId) {}
 
   ASMJIT_INLINE bool matches(const LabelEntry* entry) const noexcept {
     return static_cast<uint32_t>(entry->getNameLength()) == nameLength &&
+           entry->getParentId() == parentId &&
            ::memcmp(entry->getName(), name, nameLength) == 0;
   }
 
   const char* name;
   uint32_t nameLength;
   uint32_t hVal;
+  uint32_t parentId;
 };
 
 // Returns a hash of `name` and fixes `nameLength` if it's `Globals::kInvalidIndex`.
@@ -407,6 +813,8 @@ static uint32_t CodeHolder_hashNameAndFixLen(const char* name, size_t& nameLengt
 } // anonymous namespace
 
 LabelLink* CodeHolder::newLabelLink(LabelEntry* le, uint32_t sectionId, size_t offset, intptr_t rel) noexcept {
+  if (ASMJIT_UNLIKELY(_journalLabel(le) != kErrorOk)) return nullptr;
+
   LabelLink* link = _baseHeap.allocT<LabelLink>();
   if (ASMJIT_UNLIKELY(!link)) return nullptr;
 
@@ -417,6 +825,7 @@ LabelLink* CodeHolder::newLabelLink(LabelEntry* le, uint32_t sectionId, size_t o
   link->relocId = RelocEntry::kInvalidId;
   link->offset = offset;
   link->rel = rel;
+  link->size = 0;
 
   _unresolvedLabelsCount++;
   return link;
@@ -439,6 +848,7 @@ Error CodeHolder::newLabelId(uint32_t& idOut) noexcept {
   le->_setId(id);
   le->_parentId = 0;
   le->_sectionId = SectionEntry::kInvalidId;
+  le->_stamp = _checkpointStamp;
   le->_offset = 0;
 
   _labels.appendUnsafe(le);
@@ -477,7 +887,7 @@ Error CodeHolder::newNamedLabelId(uint32_t& idOut, const char* name, size_t name
   // Don't allow to insert duplicates. Local labels allow duplicates that have
   // different id, this is already accomplished by having a different hashes
   // between the same label names having different parent labels.
-  LabelEntry* le = _namedLabels.get(LabelByName(name, nameLength, hVal));
+  LabelEntry* le = _namedLabels.get(LabelByName(name, nameLength, hVal, parentId));
   if (ASMJIT_UNLIKELY(le))
     return DebugUtils::errored(kErrorLabelAlreadyDefined);
 
@@ -497,8 +907,9 @@ Error CodeHolder::newNamedLabelId(uint32_t& idOut, const char* name, size_t name
   le->_hVal = hVal;
   le->_setId(id);
   le->_type = static_cast<uint8_t>(type);
-  le->_parentId = 0;
+  le->_parentId = parentId;
   le->_sectionId = SectionEntry::kInvalidId;
+  le->_stamp = _checkpointStamp;
   le->_offset = 0;
 
   if (le->_name.mustEmbed(nameLength)) {
@@ -511,8 +922,9 @@ Error CodeHolder::newNamedLabelId(uint32_t& idOut, const char* name, size_t name
     le->_name.setExternal(nameExternal, nameLength);
   }
 
+  if (ASMJIT_UNLIKELY(!_namedLabels.put(le)))
+    return DebugUtils::errored(kErrorNoHeapMemory);
   _labels.appendUnsafe(le);
-  _namedLabels.put(le);
 
   idOut = id;
   return err;
@@ -522,7 +934,7 @@ uint32_t CodeHolder::getLabelIdByName(const char* name, size_t nameLength, uint3
   uint32_t hVal = CodeHolder_hashNameAndFixLen(name, nameLength);
   if (ASMJIT_UNLIKELY(!nameLength)) return 0;
 
-  LabelEntry* le = _namedLabels.get(LabelByName(name, nameLength, hVal));
+  LabelEntry* le = _namedLabels.get(LabelByName(name, nameLength, hVal ^ parentId, parentId));
   return le ? le->getId() : static_cast<uint32_t>(0);
 }
 
@@ -557,13 +969,178 @@ Error CodeHolder::newRelocEntry(RelocEntry** dst, uint32_t type, uint32_t size)
   return kErrorOk;
 }
 
-// TODO: Support multiple sections, this only relocates the first.
+// ============================================================================
+// [asmjit::CodeHolder - Checkpoint]
+// ============================================================================
+
+static ASMJIT_INLINE bool CodeHolder_isAfterCheckpoint(const CodeHolder::Checkpoint& cp, const LabelLink* link) noexcept {
+  return link->sectionId >= cp.sectionCount || link->offset >= cp.sectionLengths[link->sectionId];
+}
+
+static void CodeHolder_releaseLinks(CodeHolder* self, LabelLink* link) noexcept {
+  while (link) {
+    LabelLink* prev = link->prev;
+    self->_baseHeap.release(link, sizeof(LabelLink));
+    link = prev;
+  }
+}
+
+// Undo changes of a label `le` that existed when `cp` was saved. Links that
+// refer to code emitted after `cp` are released. If the label was bound after
+// `cp` it's unbound and the displacements and relocations it resolved are
+// restored, their links are kept by `Assembler::bind()` for this purpose.
+static void CodeHolder_rollbackLabel(CodeHolder* self, LabelEntry* le, const CodeHolder::Checkpoint& cp) noexcept {
+  bool unbind = le->isBound();
+  if (unbind && le->_stamp < cp.stamp)
+    return;
+
+  LabelLink** pLink = &le->_links;
+  LabelLink* link = le->_links;
+
+  while (link) {
+    LabelLink* prev = link->prev;
+
+    if (CodeHolder_isAfterCheckpoint(cp, link)) {
+      *pLink = prev;
+      self->_baseHeap.release(link, sizeof(LabelLink));
+    }
+    else {
+      if (unbind) {
+        if (link->relocId != RelocEntry::kInvalidId) {
+          ASMJIT_ASSERT(link->relocId < cp.relocCount);
+          RelocEntry* re = self->_relocations[link->relocId];
+          re->_targetSectionId = SectionEntry::kInvalidId;
+          re->_data -= static_cast<uint64_t>(le->_offset);
+        }
+        else {
+          // Restore the dummy data emitted in place of the displacement.
+          uint8_t* p = self->_sections[link->sectionId]->_buffer.getDataAt(link->offset);
+          if (link->size == 4)
+            Utils::writeU32u(p, 0x04040404U);
+          else if (link->size == 1)
+            p[0] = 0x01;
+        }
+      }
+      pLink = &link->prev;
+    }
+
+    link = prev;
+  }
+
+  if (unbind) {
+    le->_sectionId = SectionEntry::kInvalidId;
+    le->_offset = 0;
+  }
+}
+
+Error CodeHolder::saveCheckpoint(Checkpoint* out) noexcept {
+  size_t sectionCount = _sections.getLength();
+  if (ASMJIT_UNLIKELY(sectionCount > Checkpoint::kMaxSections || _checkpointStamp == 0xFFFFFFFFU))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  // Reflect all changes first.
+  sync();
+
+  // Each checkpoint starts a new stamp, labels changed after it are journaled
+  // and labels bound after it keep their links, see `Assembler::bind()`.
+  out->stamp = ++_checkpointStamp;
+  out->depth = _checkpointCount++;
+  out->sectionCount = static_cast<uint32_t>(sectionCount);
+  out->unresolvedLabelsCount = _unresolvedLabelsCount;
+  out->trampolinesSize = _trampolinesSize;
+  out->labelCount = _labels.getLength();
+  out->relocCount = _relocations.getLength();
+  out->journalLength = _labelJournal.getLength();
+
+  for (size_t i = 0; i < sectionCount; i++)
+    out->sectionLengths[i] = _sections[i]->_buffer._length;
+
+  _dataZone.saveState(&out->dataZone);
+  return kErrorOk;
+}
+
+Error CodeHolder::rollback(const Checkpoint& cp) noexcept {
+  if (ASMJIT_UNLIKELY(cp.stamp == 0 || cp.stamp > _checkpointStamp ||
+                      cp.depth >= _checkpointCount ||
+                      cp.sectionCount > _sections.getLength() ||
+                      cp.labelCount > _labels.getLength() ||
+                      cp.relocCount > _relocations.getLength() ||
+                      cp.journalLength > _labelJournal.getLength()))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  // Reflect all changes first.
+  sync();
+
+  size_t i;
+  size_t len;
+
+  for (i = 0; i < cp.sectionCount; i++)
+    if (ASMJIT_UNLIKELY(_sections[i]->_buffer._length < cp.sectionLengths[i]))
+      return DebugUtils::errored(kErrorInvalidState);
+
+  // Undo changes of labels journaled after the checkpoint. A label can be
+  // journaled more than once, but undoing it twice doesn't change anything.
+  for (i = cp.journalLength, len = _labelJournal.getLength(); i < len; i++) {
+    LabelEntry* le = _labelJournal[i];
+    if (Operand::unpackId(le->getId()) < cp.labelCount)
+      CodeHolder_rollbackLabel(this, le, cp);
+  }
+  _labelJournal.truncate(cp.journalLength);
+
+  // Release labels and relocations created after the checkpoint.
+  for (i = cp.labelCount, len = _labels.getLength(); i < len; i++) {
+    LabelEntry* le = _labels[i];
+    if (le->hasName())
+      _namedLabels.del(le);
+
+    CodeHolder_releaseLinks(this, le->_links);
+    _baseHeap.release(le, sizeof(LabelEntry));
+  }
+  _labels.truncate(cp.labelCount);
+
+  for (i = cp.relocCount, len = _relocations.getLength(); i < len; i++)
+    _baseHeap.release(_relocations[i], sizeof(RelocEntry));
+  _relocations.truncate(cp.relocCount);
+
+  // Sections created after the checkpoint can't be deleted, they become empty.
+  for (i = 0, len = _sections.getLength(); i < len; i++) {
+    CodeBuffer* cb = &_sections[i]->_buffer;
+    cb->_length = i < cp.sectionCount ? cp.sectionLengths[i] : size_t(0);
+    CodeHolder_truncateChunks(cb);
+  }
+
+  _dataZone.restoreState(cp.dataZone);
+  _unresolvedLabelsCount = cp.unresolvedLabelsCount;
+  _trampolinesSize = cp.trampolinesSize;
+
+  // Labels journaled after the checkpoint must be journaled again if they
+  // change, as the checkpoint can be used for another rollback. Checkpoints
+  // saved after `cp` are not live anymore.
+  _checkpointStamp++;
+  _checkpointCount = cp.depth + 1;
+
+  if (_cgAsm)
+    _cgAsm->_setBuffer(_cgAsm->_section->_buffer, _cgAsm->_section->_buffer._length);
+
+  return kErrorOk;
+}
+
+Error CodeHolder::releaseCheckpoint(const Checkpoint& cp) noexcept {
+  if (ASMJIT_UNLIKELY(cp.stamp == 0 || cp.stamp > _checkpointStamp || cp.depth >= _checkpointCount))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  // The journal is only needed by live checkpoints, labels are journaled
+  // again under a new stamp when another checkpoint is saved.
+  _checkpointCount = cp.depth;
+  if (_checkpointCount == 0)
+    _labelJournal.truncate(0);
+
+  return kErrorOk;
+}
+
 // TODO: This should go to Runtime as it's responsible for relocating the
 //       code, CodeHolder should just hold it.
 size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
-  SectionEntry* section = _sections[0];
-  ASMJIT_ASSERT(section != nullptr);
-
   uint8_t* dst = static_cast<uint8_t*>(_dst);
   if (baseAddress == Globals::kNoBaseAddress)
     baseAddress = static_cast<uint64_t>((uintptr_t)dst);
@@ -572,34 +1149,66 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
   Logger* logger = getLogger();
 #endif // ASMJIT_DISABLE_LOGGING
 
-  size_t minCodeSize = section->getBuffer().getLength(); // Minimum code size.
-  size_t maxCodeSize = getCodeSize();                    // Includes all possible trampolines.
+  // The layout is the same as the one used by `getCodeSize()`.
+  Error err = const_cast<CodeHolder*>(this)->flatten();
+  if (ASMJIT_UNLIKELY(err))
+    return 0;
+
+  size_t numSections = _sections.getLength();
+  size_t minCodeSize = 0;                                // Minimum code size.
 
   // We will copy the exact size of the generated code. Extra code for trampolines
   // is generated on-the-fly by the relocator (this code doesn't exist at the moment).
-  ::memcpy(dst, section->_buffer._data, minCodeSize);
+  for (size_t i = 0; i < numSections; i++) {
+    const SectionEntry* section = _sections[i];
+    size_t offset = section->getOffset();
+    size_t length = section->_buffer._length;
+
+    // Zero the padding between sections and the virtual part of the section.
+    // The copy is skipped if the section is relocated in place (stream).
+    ::memset(dst + minCodeSize, 0, offset - minCodeSize);
+    if (dst + offset != section->_buffer._data)
+      section->_buffer.copyTo(dst + offset);
+
+    minCodeSize = offset + CodeHolder_getSectionSize(section);
+    ::memset(dst + offset + length, 0, minCodeSize - offset - length);
+  }
+
+  size_t maxCodeSize = minCodeSize + getTrampolinesSize(); // Includes all possible trampolines.
 
   // Trampoline offset from the beginning of dst/baseAddress.
   size_t trampOffset = minCodeSize;
 
   // Relocate all recorded locations.
   size_t numRelocs = _relocations.getLength();
-  const RelocEntry* const* reArray = _relocations.getData();
 
   for (size_t i = 0; i < numRelocs; i++) {
-    const RelocEntry* re = reArray[i];
+    const RelocEntry* re = _relocations[i];
 
     // Possibly deleted or optimized out relocation entry.
     if (re->getType() == RelocEntry::kTypeNone)
       continue;
 
+    uint32_t sourceSectionId = re->getSourceSectionId();
+    if (ASMJIT_UNLIKELY(sourceSectionId >= numSections))
+      return 0;
+
     uint64_t ptr = re->getData();
-    size_t codeOffset = static_cast<size_t>(re->getSourceOffset());
+    size_t codeOffset = _sections[sourceSectionId]->getOffset() + static_cast<size_t>(re->getSourceOffset());
 
     // Make sure that the `RelocEntry` is correct, we don't want to write
     // out of bounds in `dst`.
     if (ASMJIT_UNLIKELY(codeOffset + re->getSize() > maxCodeSize))
-      return DebugUtils::errored(kErrorInvalidRelocEntry);
+      return 0;
+
+    // Offset of the target section, only used by relocations relative to it.
+    uint64_t targetOffset = 0;
+    if (re->getType() == RelocEntry::kTypeRelToAbs || re->getType() == RelocEntry::kTypeRelToRel) {
+      uint32_t targetSectionId = re->getTargetSectionId();
+      if (ASMJIT_UNLIKELY(targetSectionId >= numSections))
+        return 0;
+      targetOffset = static_cast<uint64_t>(_sections[targetSectionId]->getOffset());
+    }
 
     // Whether to use trampoline, can be only used if relocation type is `kRelocTrampoline`.
     bool useTrampoline = false;
@@ -610,29 +1219,40 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
       }
 
       case RelocEntry::kTypeRelToAbs: {
-        ptr += baseAddress;
+        ptr += baseAddress + targetOffset;
         break;
       }
 
       case RelocEntry::kTypeAbsToRel: {
-        ptr -= baseAddress + re->getSourceOffset() + re->getSize();
+        ptr -= baseAddress + codeOffset + re->getSize();
         break;
       }
 
       case RelocEntry::kTypeTrampoline: {
         if (re->getSize() != 4)
-          return DebugUtils::errored(kErrorInvalidRelocEntry);
+          return 0;
 
-        ptr -= baseAddress + re->getSourceOffset() + re->getSize();
+        ptr -= baseAddress + codeOffset + re->getSize();
         if (!Utils::isInt32(static_cast<int64_t>(ptr))) {
-          ptr = (uint64_t)trampOffset - re->getSourceOffset() - re->getSize();
+          ptr = (uint64_t)trampOffset - codeOffset - re->getSize();
           useTrampoline = true;
         }
         break;
       }
 
+      case RelocEntry::kTypeRelToRel: {
+        // The data contains the target offset (relative to its section) and
+        // the displacement addend, the source is where the displacement is.
+        ptr += targetOffset - codeOffset;
+
+        int64_t disp = static_cast<int64_t>(ptr);
+        if (ASMJIT_UNLIKELY(re->getSize() == 1 ? !Utils::isInt8(disp) : !Utils::isInt32(disp)))
+          return 0;
+        break;
+      }
+
       default:
-        return DebugUtils::errored(kErrorInvalidRelocEntry);
+        return 0;
     }
 
     switch (re->getSize()) {
@@ -649,7 +1269,7 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
         break;
 
       default:
-        return DebugUtils::errored(kErrorInvalidRelocEntry);
+        return 0;
     }
 
     // Handle the trampoline case.
@@ -667,7 +1287,7 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
         byte1 = x86EncodeMod(0, 4, 5);
       }
       else {
-        return DebugUtils::errored(kErrorInvalidRelocEntry);
+        return 0;
       }
 
       // Patch `jmp/call` instruction.
@@ -690,6 +1310,493 @@ size_t CodeHolder::relocate(void* _dst, uint64_t baseAddress) const noexcept {
   return trampOffset;
 }
 
+// ============================================================================
+// [asmjit::CodeHolder - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST) && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+// Emits the code that is kept, `L_Exit` is bound by the caller.
+static void CodeHolderTest_emitPrologue(X86Assembler& a, const Label& L_Exit) noexcept {
+  a.mov(x86::eax, 1);
+  a.test(x86::ecx, x86::ecx);
+  a.jz(L_Exit);
+  a.short_().jnz(L_Exit);
+}
+
+// Emits the code that is kept after the rollback.
+static void CodeHolderTest_emitEpilogue(X86Assembler& a, const Label& L_Exit) noexcept {
+  a.add(x86::eax, 2);
+  a.bind(L_Exit);
+  a.ret();
+}
+
+UNIT(base_codeholder_checkpoint) {
+  CodeInfo ci(ArchInfo::kTypeHost);
+
+  // Reference code, which was never rolled back.
+  CodeHolder ref;
+  ref.init(ci);
+  {
+    X86Assembler a(&ref);
+    Label L_Exit = a.newLabel();
+    CodeHolderTest_emitPrologue(a, L_Exit);
+    CodeHolderTest_emitEpilogue(a, L_Exit);
+    EXPECT(a.getLastError() == kErrorOk);
+  }
+
+  CodeHolder code;
+  code.init(ci);
+  X86Assembler a(&code);
+
+  Label L_Exit = a.newLabel();
+  CodeHolderTest_emitPrologue(a, L_Exit);
+
+  CodeHolder::Checkpoint cp;
+  EXPECT(code.saveCheckpoint(&cp) == kErrorOk);
+
+  size_t offset = a.getOffset();
+  size_t labelsCount = code.getLabelsCount();
+  size_t unresolvedCount = code.getUnresolvedLabelsCount();
+
+  INFO("Rolling back speculative code several times");
+  for (uint32_t i = 0; i < 3; i++) {
+    Label L_Spec = a.newNamedLabel("spec");
+    Label L_Loop = a.newLabel();
+
+    a.bind(L_Loop);
+    a.bind(L_Spec);
+    a.mov(x86::eax, 3);
+    a.dec(x86::ecx);
+    a.jnz(L_Loop);
+    a.jmp(L_Exit);
+    a.jmp(L_Spec);
+    a.embedLabel(L_Loop);
+    a.bind(L_Exit);
+    a.ret();
+
+    EXPECT(a.getLastError() == kErrorOk);
+    EXPECT(code.isLabelBound(L_Exit));
+    EXPECT(code.getUnresolvedLabelsCount() == 0);
+
+    EXPECT(code.rollback(cp) == kErrorOk);
+    EXPECT(a.getOffset() == offset,
+      "Offset %u after rollback, expected %u", unsigned(a.getOffset()), unsigned(offset));
+    EXPECT(code.getLabelsCount() == labelsCount);
+    EXPECT(!code.hasRelocations());
+    EXPECT(code.getUnresolvedLabelsCount() == unresolvedCount);
+    EXPECT(!code.isLabelBound(L_Exit));
+    EXPECT(code.getLabelIdByName("spec") == 0);
+  }
+
+  INFO("Emitting the code that is kept after the rollback");
+  CodeHolderTest_emitEpilogue(a, L_Exit);
+  EXPECT(a.getLastError() == kErrorOk);
+
+  code.sync();
+  ref.sync();
+
+  const CodeBuffer& buf = code.getSectionEntry(0)->getBuffer();
+  const CodeBuffer& refBuf = ref.getSectionEntry(0)->getBuffer();
+  EXPECT(buf.getLength() == refBuf.getLength());
+  EXPECT(::memcmp(buf.getData(), refBuf.getData(), buf.getLength()) == 0);
+
+  INFO("Rolling back to a checkpoint invalidated by another rollback");
+  CodeHolder::Checkpoint cpInner;
+  EXPECT(code.saveCheckpoint(&cpInner) == kErrorOk);
+  EXPECT(code.rollback(cp) == kErrorOk);
+  EXPECT(code.rollback(cpInner) != kErrorOk);
+
+  INFO("Releasing the checkpoint");
+  EXPECT(code.releaseCheckpoint(cpInner) != kErrorOk);
+  EXPECT(code.releaseCheckpoint(cp) == kErrorOk);
+  EXPECT(!code.hasCheckpoints());
+  EXPECT(code.rollback(cp) != kErrorOk);
+
+  // Links of labels bound without live checkpoints are not kept.
+  Label L_Done = a.newLabel();
+  a.jmp(L_Done);
+  a.bind(L_Done);
+  EXPECT(a.getLastError() == kErrorOk);
+  EXPECT(code.getLabelEntry(L_Done)->_links == nullptr);
+
+  INFO("Rolling back a label embedded before the checkpoint");
+  {
+    CodeHolder c;
+    c.init(ci);
+    X86Assembler e(&c);
+
+    uint32_t gpSize = e.getGpSize();
+    Label L_Data = e.newLabel();
+    e.embedLabel(L_Data);
+
+    LabelLink* link = c.getLabelEntry(L_Data)->_links;
+    EXPECT(link != nullptr && link->size == gpSize,
+      "Link of an embedded label must know its size");
+
+    CodeHolder::Checkpoint ecp;
+    EXPECT(c.saveCheckpoint(&ecp) == kErrorOk);
+    e.nop();
+    e.bind(L_Data);
+    EXPECT(c.rollback(ecp) == kErrorOk);
+    EXPECT(!c.isLabelBound(L_Data));
+    EXPECT(c.getRelocEntries()[0]->getData() == 0);
+
+    e.int3();
+    e.int3();
+    e.bind(L_Data);
+    e.ret();
+    EXPECT(e.getLastError() == kErrorOk);
+    EXPECT(c.releaseCheckpoint(ecp) == kErrorOk);
+
+    uint8_t buf[32];
+    EXPECT(c.getCodeSize() == gpSize + 3);
+    EXPECT(c.relocate(buf, 0x10000) == gpSize + 3);
+
+    uint64_t addr = gpSize == 8 ? Utils::readU64u(buf) : static_cast<uint64_t>(Utils::readU32u(buf));
+    EXPECT(addr == 0x10000 + gpSize + 2,
+      "Embedded address must point to the label bound after the rollback");
+  }
+}
+
+// Emits `n` blocks with jumps patched across chunks and data larger than chunks.
+static void CodeHolderTest_emitBlocks(X86Assembler& a, uint32_t n) noexcept {
+  uint8_t data[200];
+  for (uint32_t i = 0; i < ASMJIT_ARRAY_SIZE(data); i++)
+    data[i] = static_cast<uint8_t>(i);
+
+  Label L_Exit = a.newLabel();
+  Label L_Prev = a.newLabel();
+  a.bind(L_Prev);
+
+  for (uint32_t i = 0; i < n; i++) {
+    Label L_Next = a.newLabel();
+    if (i % 16 == 15)
+      a.embed(data, sizeof(data));
+
+    a.mov(x86::eax, i);
+    a.jnz(L_Next);
+    a.short_().jz(L_Next);
+    a.jmp(L_Prev);
+    a.jmp(L_Exit);
+    a.bind(L_Next);
+    L_Prev = L_Next;
+  }
+
+  a.embedLabel(L_Exit);
+  a.bind(L_Exit);
+  a.ret();
+}
+
+
+UNIT(base_codeholder_chunks) {
+  CodeInfo ci(ArchInfo::kTypeHost);
+  ci.setBaseAddress(0x10000);
+
+  // Reference code in a contiguous buffer.
+  CodeHolder ref;
+  ref.init(ci);
+  {
+    X86Assembler a(&ref);
+    CodeHolderTest_emitBlocks(a, 100);
+    CodeHolderTest_emitBlocks(a, 100);
+    EXPECT(a.getLastError() == kErrorOk);
+  }
+
+  CodeHolder code;
+  code.init(ci);
+  X86Assembler a(&code);
+
+  CodeBuffer& buf = code.getSectionEntry(0)->getBuffer();
+  EXPECT(code.setBufferChunkSize(&buf, CodeBuffer::kMinChunkSize - 1) != kErrorOk);
+  EXPECT(code.setBufferChunkSize(&buf, CodeBuffer::kMinChunkSize) == kErrorOk);
+
+  INFO("Emitting code into chunks of %u bytes", unsigned(CodeBuffer::kMinChunkSize));
+  CodeHolderTest_emitBlocks(a, 100);
+  EXPECT(a.getLastError() == kErrorOk);
+  EXPECT(code.setBufferChunkSize(&buf, 0) != kErrorOk);
+
+  code.sync();
+  size_t chunkCount = buf.getChunkCount();
+  EXPECT(chunkCount > 1);
+  EXPECT(a.setOffset(0) != kErrorOk);
+  a.resetLastError();
+
+  INFO("Rolling back code of several chunks");
+  CodeHolder::Checkpoint cp;
+  EXPECT(code.saveCheckpoint(&cp) == kErrorOk);
+
+  size_t offset = a.getOffset();
+  CodeHolderTest_emitBlocks(a, 100);
+  EXPECT(a.getLastError() == kErrorOk);
+
+  EXPECT(code.rollback(cp) == kErrorOk);
+  EXPECT(a.getOffset() == offset);
+  EXPECT(buf.getChunkCount() == chunkCount);
+
+  CodeHolderTest_emitBlocks(a, 100);
+  EXPECT(a.getLastError() == kErrorOk);
+
+  INFO("Gathering chunks by relocate()");
+  size_t codeSize = code.getCodeSize();
+  EXPECT(codeSize == ref.getCodeSize(),
+    "Chunked code has %u bytes, expected %u", unsigned(codeSize), unsigned(ref.getCodeSize()));
+
+  uint8_t* p = static_cast<uint8_t*>(Internal::allocMemory(codeSize * 2));
+  EXPECT(p != nullptr);
+
+  EXPECT(code.relocate(p, ci.getBaseAddress()) == codeSize);
+  EXPECT(ref.relocate(p + codeSize, ci.getBaseAddress()) == codeSize);
+  EXPECT(::memcmp(p, p + codeSize, codeSize) == 0);
+
+  INFO("Looking up bytes in %u chunks", unsigned(buf.getChunkCount()));
+  for (size_t i = 1; i < buf.getChunkCount(); i++)
+    EXPECT(buf.getChunk(i - 1)->offset < buf.getChunk(i)->offset);
+
+  buf.copyTo(p);
+  for (size_t i = 0; i < buf.getLength(); i++)
+    EXPECT(*buf.getDataAt(i) == p[i], "Invalid byte at offset %u", unsigned(i));
+
+  Internal::releaseMemory(p);
+}
+
+UNIT(base_codeholder_sections) {
+  CodeInfo ci(ArchInfo::kTypeHost);
+  JitRuntime rt;
+
+  CodeHolder code;
+  code.init(ci);
+  X86Assembler a(&code);
+
+  INFO("Creating sections");
+  SectionEntry* text = code.getSectionEntry(0);
+  SectionEntry* data;
+  SectionEntry* cold;
+  SectionEntry* dummy;
+
+  EXPECT(code.newSection(&data, ".data", Globals::kInvalidIndex, SectionEntry::kFlagConst, 16) == kErrorOk);
+  EXPECT(code.newSection(&cold, ".text.cold", Globals::kInvalidIndex, SectionEntry::kFlagExec | SectionEntry::kFlagConst, 32) == kErrorOk);
+  EXPECT(code.newSection(&dummy, ".data") == DebugUtils::errored(kErrorInvalidSectionName));
+  EXPECT(code.newSection(&dummy, "") == DebugUtils::errored(kErrorInvalidSectionName));
+  EXPECT(code.newSection(&dummy, ".bss", Globals::kInvalidIndex, 0, 3) == DebugUtils::errored(kErrorInvalidArgument));
+  EXPECT(code.getSections().getLength() == 3);
+  EXPECT(code.getSectionByName(".data") == data);
+  EXPECT(code.getSectionByName(".text.cold") == cold);
+  EXPECT(code.getSectionByName(".bss") == nullptr);
+
+  INFO("Emitting code that references other sections");
+  Label L_Data = a.newLabel();
+  Label L_Ptr  = a.newLabel();
+  Label L_Cold = a.newLabel();
+  Label L_Back = a.newLabel();
+
+  a.mov(x86::eax, x86::dword_ptr(L_Data));
+  a.cmp(x86::eax, 42);
+  a.jne(L_Cold);
+  a.add(x86::eax, 1);
+  a.bind(L_Back);
+  a.ret();
+
+  EXPECT(a.section(data) == kErrorOk);
+  a.bind(L_Data);
+  a.dd(41);
+  a.dd(100);
+  a.align(kAlignZero, 8);
+  a.bind(L_Ptr);
+  a.embedLabel(L_Back);
+
+  EXPECT(a.section(cold) == kErrorOk);
+  a.bind(L_Cold);
+  a.add(x86::eax, x86::dword_ptr(L_Data, 4));
+  a.jmp(L_Back);
+
+  EXPECT(a.section(text) == kErrorOk);
+  EXPECT(a.getLastError() == kErrorOk);
+  EXPECT(code.getUnresolvedLabelsCount() == 0);
+
+  size_t codeSize = code.getCodeSize();
+  EXPECT(data->getOffset() % 16 == 0);
+  EXPECT(cold->getOffset() % 32 == 0);
+  EXPECT(data->getOffset() >= text->getBuffer().getLength());
+  EXPECT(cold->getOffset() >= data->getOffset() + data->getBuffer().getLength());
+  EXPECT(codeSize >= cold->getOffset() + cold->getBuffer().getLength());
+
+  typedef int (*Func)(void);
+  Func fn;
+  EXPECT(rt.add(&fn, &code) == kErrorOk);
+
+  INFO("Running code split into sections");
+  EXPECT(fn() == 141, "Returned %d, expected 141", fn());
+
+  uintptr_t base = (uintptr_t)fn;
+  uintptr_t* ptr = reinterpret_cast<uintptr_t*>(base + code.getLabelOffset(L_Ptr));
+  EXPECT(*ptr == base + code.getLabelOffset(L_Back));
+
+  rt.release(fn);
+
+  INFO("Failing to relocate a short jump to a distant section");
+  CodeHolder farCode;
+  farCode.init(ci);
+  X86Assembler b(&farCode);
+
+  SectionEntry* farSection;
+  EXPECT(farCode.newSection(&farSection, ".text.far", Globals::kInvalidIndex, SectionEntry::kFlagExec, 16) == kErrorOk);
+
+  Label L_Far = b.newLabel();
+  b.short_().jmp(L_Far);
+  for (uint32_t i = 0; i < 200; i++)
+    b.nop();
+
+  EXPECT(b.section(farSection) == kErrorOk);
+  b.bind(L_Far);
+  b.ret();
+  EXPECT(b.getLastError() == kErrorOk);
+  EXPECT(farCode.hasRelocations());
+
+  uint8_t* farBuf = static_cast<uint8_t*>(Internal::allocMemory(farCode.getCodeSize()));
+  EXPECT(farBuf != nullptr);
+  EXPECT(farCode.relocate(farBuf) == 0);
+  Internal::releaseMemory(farBuf);
+
+  EXPECT(rt.add(&fn, &farCode) != kErrorOk);
+  EXPECT(fn == nullptr);
+  EXPECT(rt.getMemMgr()->getUsedBytes() == 0);
+}
+
+#if ASMJIT_ARCH_X64
+static int CodeHolderTest_picHelperA() noexcept { return 42; }
+static int CodeHolderTest_picHelperB() noexcept { return 100; }
+
+UNIT(base_codeholder_pic) {
+  CodeInfo ci(ArchInfo::kTypeHost);
+  JitRuntime rt;
+
+  CodeHolder code;
+  code.init(ci);
+  code.setGlobalHints(CodeEmitter::kHintPositionIndependent);
+
+  X86Assembler a(&code);
+  EXPECT((a.getGlobalHints() & CodeEmitter::kHintPositionIndependent) != 0);
+
+  uint64_t addrA = (uint64_t)(uintptr_t)CodeHolderTest_picHelperA;
+  uint64_t addrB = (uint64_t)(uintptr_t)CodeHolderTest_picHelperB;
+
+  INFO("Rejecting memory operands with absolute addresses");
+  uint64_t addrData = (uint64_t)(uintptr_t)&addrA;
+  EXPECT(a.mov(x86::ecx, x86::dword_ptr(addrData)) == kErrorInvalidAddress);
+  EXPECT(a.mov(x86::ecx, x86::dword_ptr(0x1000)) == kErrorInvalidAddress);
+  EXPECT(a.mov(x86::ecx, x86::dword_ptr(0x1000, x86::rdx, 2)) == kErrorInvalidAddress);
+  EXPECT(a.mov(x86::eax, x86::dword_ptr(addrData)) == kErrorInvalidAddress);
+  EXPECT(a.long_().mov(x86::rax, x86::qword_ptr(0x1000)) == kErrorInvalidAddress);
+  EXPECT(a.mov(x86::dword_ptr(addrData), x86::eax) == kErrorInvalidAddress);
+  EXPECT(a.getOffset() == 0);
+  a.resetLastError();
+
+  INFO("Emitting calls and jumps to absolute addresses");
+  Label L_Data = a.newLabel();
+
+  X86Mem fsMem = x86::qword_ptr(0x28);
+  fsMem.setSegment(x86::fs);
+
+  a.sub(x86::rsp, 40);
+  a.call(imm(addrA));
+  a.mov(x86::ecx, x86::eax);
+  a.call(imm(addrA));
+  a.add(x86::eax, x86::ecx);
+  a.add(x86::eax, x86::dword_ptr(L_Data));
+  a.add(x86::rsp, 40);
+  a.cmp(x86::eax, 100);
+  a.je(imm(addrB));
+  a.ret();
+  a.mov(x86::rax, fsMem);
+  a.bind(L_Data);
+  a.dint32(16);
+  EXPECT(a.getLastError() == kErrorOk);
+
+  SectionEntry* got = code.getGotSection();
+  EXPECT(got != nullptr);
+  EXPECT(got->getBuffer().getLength() == 16,
+    "GOT has %u bytes, expected 16", unsigned(got->getBuffer().getLength()));
+  EXPECT(code.getTrampolinesSize() == 0);
+
+  INFO("Relocating to different base addresses");
+  size_t codeSize = code.getCodeSize();
+  uint8_t* bufA = static_cast<uint8_t*>(Internal::allocMemory(codeSize * 2));
+  EXPECT(bufA != nullptr);
+  uint8_t* bufB = bufA + codeSize;
+
+  code.relocate(bufA, 0x10000);
+  code.relocate(bufB, 0x7FFF00000000);
+  EXPECT(::memcmp(bufA, bufB, codeSize) == 0);
+  EXPECT(Utils::readU64u(bufA + got->getOffset()) == addrA);
+  EXPECT(Utils::readU64u(bufA + got->getOffset() + 8) == addrB);
+  Internal::releaseMemory(bufA);
+
+  typedef int (*Func)(void);
+  Func fn;
+  EXPECT(rt.add(&fn, &code) == kErrorOk);
+
+  INFO("Running position independent code");
+  EXPECT(fn() == 100, "Returned %d, expected 100", fn());
+
+  rt.release(fn);
+
+  INFO("Checking jcc/call/jmp that load the address from the GOT");
+  {
+    CodeHolder c;
+    c.init(ci);
+    c.setGlobalHints(CodeEmitter::kHintPositionIndependent);
+
+    X86Assembler e(&c);
+    e.jg(imm(addrA));
+    e.jne(imm(addrB));
+    e.call(imm(addrB));
+    e.jmp(imm(addrA));
+    EXPECT(e.getLastError() == kErrorOk);
+
+    uint8_t buf[64];
+    EXPECT(c.getCodeSize() <= sizeof(buf));
+    EXPECT(c.relocate(buf, 0x7FFF00001000) == c.getCodeSize());
+
+    size_t gotOffset = c.getGotSection()->getOffset();
+    EXPECT(Utils::readU64u(buf + gotOffset + 0) == addrA);
+    EXPECT(Utils::readU64u(buf + gotOffset + 8) == addrB);
+
+    // Jcc is an inverted short jcc that skips `FF /4 [RIP + DISP32]` (6 bytes).
+    static const struct {
+      uint32_t offset;                   // Offset of the instruction.
+      uint8_t jcc;                       // Inverted short jcc, zero if none.
+      uint8_t modrm;                     // ModR/M of FF /2 (call) or FF /4 (jmp).
+      uint32_t slot;                     // Offset of the GOT slot of the target.
+    } expected[] = {
+      { 0 , 0x7E, 0x25, 0 },             // jg   -> jle +6; jmp [rip + GOT[0]].
+      { 8 , 0x74, 0x25, 8 },             // jne  -> je  +6; jmp [rip + GOT[1]].
+      { 16, 0x00, 0x15, 8 },             // call [rip + GOT[1]].
+      { 22, 0x00, 0x25, 0 }              // jmp  [rip + GOT[0]].
+    };
+
+    for (uint32_t i = 0; i < ASMJIT_ARRAY_SIZE(expected); i++) {
+      const uint8_t* p = buf + expected[i].offset;
+
+      if (expected[i].jcc) {
+        EXPECT(p[0] == expected[i].jcc && p[1] == 6,
+          "Instruction #%u starts with %02X %02X, expected %02X 06", i, p[0], p[1], expected[i].jcc);
+        p += 2;
+      }
+
+      EXPECT(p[0] == 0xFF && p[1] == expected[i].modrm,
+        "Instruction #%u has opcode %02X %02X, expected FF %02X", i, p[0], p[1], expected[i].modrm);
+
+      // The displacement is relative to the end of the instruction.
+      intptr_t end = static_cast<intptr_t>(p + 6 - buf);
+      intptr_t slot = end + Utils::readI32u(p + 2);
+      EXPECT(slot == static_cast<intptr_t>(gotOffset + expected[i].slot),
+        "Instruction #%u refers to offset %d, expected GOT slot at %d", i, int(slot), int(gotOffset + expected[i].slot));
+    }
+  }
+}
+#endif // ASMJIT_ARCH_X64
+#endif // ASMJIT_TEST
+
 } // asmjit namespace
 
 // [Api-End]
@@ -225,21 +225,90 @@ public:
 // ============================================================================
 
 //! Code or data buffer.
+//!
+//! The buffer is contiguous by default and it's reallocated when it grows. A
+//! chunked buffer (see \ref CodeHolder::setBufferChunkSize()) is an array of
+//! chunks sorted by their offsets instead, and it grows by appending a new
+//! chunk, the content of old chunks is never copied. `_data` then points to
+//! the last chunk, which starts at `_dataOffset`, and `relocate()` gathers all
+//! chunks into the destination.
 struct CodeBuffer {
+  //! Chunk of a chunked buffer, followed by its data.
+  struct Chunk {
+    ASMJIT_INLINE uint8_t* getData() noexcept { return reinterpret_cast<uint8_t*>(this + 1); }
+    ASMJIT_INLINE const uint8_t* getData() const noexcept { return reinterpret_cast<const uint8_t*>(this + 1); }
+
+    size_t offset;                       //!< Offset of the chunk in the buffer.
+    size_t capacity;                     //!< Capacity of the chunk (in bytes).
+  };
+
+  ASMJIT_ENUM(Limits) {
+    kMinChunkSize = 64                   //!< Minimum size of a chunk.
+  };
+
   // --------------------------------------------------------------------------
   // [Accessors]
   // --------------------------------------------------------------------------
 
   ASMJIT_INLINE bool hasData() const noexcept { return _data != nullptr; }
+  //! Get the data of the buffer, or of the last chunk if the buffer is chunked.
   ASMJIT_INLINE uint8_t* getData() noexcept { return _data; }
+  //! \overload
   ASMJIT_INLINE const uint8_t* getData() const noexcept { return _data; }
+  //! Get the offset of `getData()` in the buffer, zero if not chunked.
+  ASMJIT_INLINE size_t getDataOffset() const noexcept { return _dataOffset; }
+
+  //! Get a pointer to the byte at `offset`.
+  //!
+  //! Instructions and data embedded by \ref Assembler never straddle chunks,
+  //! so the bytes of a single instruction can be accessed through the pointer.
+  ASMJIT_INLINE uint8_t* getDataAt(size_t offset) noexcept {
+    if (offset >= _dataOffset)
+      return _data + (offset - _dataOffset);
+
+    // Binary search of the last chunk that starts at or before `offset`, the
+    // last chunk starts at `_dataOffset`, so it's not searched.
+    Chunk* const* chunks = _chunks;
+    size_t n = _chunkCount - 1;
+
+    while (n > 1) {
+      size_t half = n / 2;
+      if (chunks[half]->offset <= offset) {
+        chunks += half;
+        n -= half;
+      }
+      else {
+        n = half;
+      }
+    }
+
+    return chunks[0]->getData() + (offset - chunks[0]->offset);
+  }
+
+  //! Copy `getLength()` bytes of the buffer to `dst`.
+  ASMJIT_API void copyTo(void* dst) const noexcept;
 
   ASMJIT_INLINE size_t getLength() const noexcept { return _length; }
+  //! Get the capacity of `getData()` (in bytes).
   ASMJIT_INLINE size_t getCapacity() const noexcept { return _capacity; }
 
   ASMJIT_INLINE bool isExternal() const noexcept { return _isExternal; }
   ASMJIT_INLINE bool isFixedSize() const noexcept { return _isFixedSize; }
 
+  //! Get whether the buffer grows by appending chunks.
+  ASMJIT_INLINE bool isChunked() const noexcept { return _chunkSize != 0; }
+  //! Get the size of chunks, zero if the buffer is contiguous.
+  ASMJIT_INLINE size_t getChunkSize() const noexcept { return _chunkSize; }
+  //! Get the count of chunks, zero if the buffer is contiguous or empty.
+  ASMJIT_INLINE size_t getChunkCount() const noexcept { return _chunkCount; }
+  //! Get the chunk at `index`, chunks are sorted by their offsets.
+  ASMJIT_INLINE const Chunk* getChunk(size_t index) const noexcept {
+    ASMJIT_ASSERT(index < _chunkCount);
+    return _chunks[index];
+  }
+  //! Get the last chunk, null if the buffer is contiguous or empty.
+  ASMJIT_INLINE const Chunk* getLastChunk() const noexcept { return _chunkCount ? _chunks[_chunkCount - 1] : nullptr; }
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
@@ -247,6 +316,11 @@ struct CodeBuffer {
   uint8_t* _data;                        //!< The content of the buffer (data).
   size_t _length;                        //!< Number of bytes of `data` used.
   size_t _capacity;                      //!< Buffer capacity (in bytes).
+  size_t _dataOffset;                    //!< Offset of `_data` (chunked buffer).
+  size_t _chunkSize;                     //!< Size of chunks, zero if contiguous.
+  Chunk** _chunks;                       //!< Chunks sorted by offset (chunked buffer).
+  size_t _chunkCount;                    //!< Count of chunks in `_chunks`.
+  size_t _chunkCapacity;                 //!< Capacity of `_chunks`.
   bool _isExternal;                      //!< True if this is external buffer.
   bool _isFixedSize;                     //!< True if this buffer cannot grow.
 };
@@ -293,6 +367,10 @@ public:
   ASMJIT_INLINE uint32_t getAlignment() const noexcept { return _alignment; }
   ASMJIT_INLINE void setAlignment(uint32_t alignment) noexcept { _alignment = alignment; }
 
+  //! Get the offset of the section from the start of the code, assigned by
+  //! \ref CodeHolder::flatten().
+  ASMJIT_INLINE size_t getOffset() const noexcept { return _offset; }
+
   ASMJIT_INLINE size_t getPhysicalSize() const noexcept { return _buffer.getLength(); }
 
   ASMJIT_INLINE size_t getVirtualSize() const noexcept { return _virtualSize; }
@@ -313,6 +391,7 @@ public:
     char _name[36];                      //!< Section name (max 35 characters, PE allows max 8).
     uint32_t _nameAsU32[36 / 4];         //!< Section name as `uint32_t[]` (only optimization).
   };
+  size_t _offset;                        //!< Offset from the start of the code, see \ref CodeHolder::flatten().
   CodeBuffer _buffer;                    //!< Code or data buffer.
 };
 
@@ -327,6 +406,7 @@ struct LabelLink {
   uint32_t relocId;                      //!< Relocation id or RelocEntry::kInvalidId.
   size_t offset;                         //!< Label offset relative to the start of the section.
   intptr_t rel;                          //!< Inlined rel8/rel32.
+  uint32_t size;                         //!< Size of the patched displacement or embedded address, zero if unknown.
 };
 
 // ============================================================================
@@ -412,12 +492,32 @@ public:
   uint16_t _reserved16;                  //!< Reserved.
   uint32_t _parentId;                    //!< Label parent id or zero.
   uint32_t _sectionId;                   //!< Section id or `SectionEntry::kInvalidId`.
-  uint32_t _reserved32;                  //!< Reserved.
+  uint32_t _stamp;                       //!< Checkpoint stamp of the last change (internal, see \ref CodeHolder::Checkpoint).
   intptr_t _offset;                      //!< Label offset.
   LabelLink* _links;                     //!< Label links.
   SmallString<kNameBytes> _name;         //!< Label name.
 };
 
+// ============================================================================
+// [asmjit::GotEntry]
+// ============================================================================
+
+//! Entry of the global offset table (GOT), see \ref CodeHolder::addGotEntry().
+class GotEntry : public ZoneHashNode {
+public:
+  //! Get the absolute address stored in the entry.
+  ASMJIT_INLINE uint64_t getAddress() const noexcept { return _address; }
+  //! Get the offset of the entry relative to the GOT section.
+  ASMJIT_INLINE size_t getOffset() const noexcept { return _offset; }
+
+  // ------------------------------------------------------------------------
+  // [Members]
+  // ------------------------------------------------------------------------
+
+  uint64_t _address;                     //!< Absolute address.
+  size_t _offset;                        //!< Offset in the GOT section.
+};
+
 // ============================================================================
 // [asmjit::RelocEntry]
 // ============================================================================
@@ -434,7 +534,8 @@ struct RelocEntry {
     kTypeAbsToAbs    = 1,                //!< Relocate absolute to absolute.
     kTypeRelToAbs    = 2,                //!< Relocate relative to absolute.
     kTypeAbsToRel    = 3,                //!< Relocate absolute to relative.
-    kTypeTrampoline  = 4                 //!< Relocate absolute to relative or use trampoline.
+    kTypeTrampoline  = 4,                //!< Relocate absolute to relative or use trampoline.
+    kTypeRelToRel    = 5                 //!< Relocate relative to relative (displacement to another section).
   };
 
   // ------------------------------------------------------------------------
@@ -482,6 +583,25 @@ class CodeHolder {
 public:
   ASMJIT_NONCOPYABLE(CodeHolder)
 
+  //! Saved state of `CodeHolder`, see `saveCheckpoint()` and `rollback()`.
+  struct Checkpoint {
+    enum {
+      //! Maximum number of sections a checkpoint can save.
+      kMaxSections = 8
+    };
+
+    uint32_t stamp;                      //!< Checkpoint stamp.
+    uint32_t depth;                      //!< Number of live checkpoints saved before this one.
+    uint32_t sectionCount;               //!< Number of sections.
+    uint32_t unresolvedLabelsCount;      //!< Count of unresolved label references.
+    uint32_t trampolinesSize;            //!< Size of all possible trampolines.
+    size_t labelCount;                   //!< Number of labels.
+    size_t relocCount;                   //!< Number of relocations.
+    size_t journalLength;                //!< Length of the label journal.
+    size_t sectionLengths[kMaxSections]; //!< Length of each section's buffer.
+    Zone::State dataZone;                //!< State of the data zone (label names).
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -550,11 +670,18 @@ public:
   //! Get global options, internally propagated to all `CodeEmitter`s attached.
   ASMJIT_INLINE uint32_t getGlobalOptions() const noexcept { return _globalOptions; }
 
+  //! Set global hints, see \ref CodeEmitter::Hints.
+  //!
+  //! Hints should be set before any code is emitted.
+  ASMJIT_API void setGlobalHints(uint32_t hints) noexcept;
+
   // --------------------------------------------------------------------------
   // [Result Information]
   // --------------------------------------------------------------------------
 
   //! Get the size code & data of all sections.
+  //!
+  //! Sections are laid out by `flatten()`, trampolines follow the last one.
   ASMJIT_API size_t getCodeSize() const noexcept;
 
   //! Get size of all possible trampolines.
@@ -565,6 +692,12 @@ public:
   //! address directly).
   ASMJIT_INLINE size_t getTrampolinesSize() const noexcept { return _trampolinesSize; }
 
+  //! Get memory usage of zones owned by the `CodeHolder`.
+  //!
+  //! Doesn't include memory used by attached `CodeBuilder` and `CodeCompiler`
+  //! emitters, which account their own zones.
+  ASMJIT_API void getZoneStats(ZoneStats* out) const noexcept;
+
   // --------------------------------------------------------------------------
   // [Logging & Error Handling]
   // --------------------------------------------------------------------------
@@ -599,9 +732,92 @@ public:
   //! Get a section entry of the given index.
   ASMJIT_INLINE SectionEntry* getSectionEntry(size_t index) const noexcept { return _sections[index]; }
 
+  //! Create a new section called `name` and return it in `sectionOut`.
+  //!
+  //! The name can have at most 35 characters. Sections are laid out in the
+  //! order they were created, each aligned to its `alignment` (power of 2).
+  ASMJIT_API Error newSection(SectionEntry** sectionOut, const char* name, size_t nameLength = Globals::kInvalidIndex, uint32_t flags = 0, uint32_t alignment = 1) noexcept;
+
+  //! Get a section by `name`, or null if there is no such section.
+  ASMJIT_API SectionEntry* getSectionByName(const char* name, size_t nameLength = Globals::kInvalidIndex) const noexcept;
+
+  //! Assign offsets to all sections, see \ref SectionEntry::getOffset().
+  //!
+  //! Sections are placed one after another in the order they were created,
+  //! each aligned to its alignment. Called by `getCodeSize()` and `relocate()`.
+  ASMJIT_API Error flatten() noexcept;
+
+  //! Get the section of the global offset table (GOT), null if no GOT entry
+  //! has been created yet.
+  ASMJIT_INLINE SectionEntry* getGotSection() const noexcept { return _gotSection; }
+
+  //! Get an entry of the global offset table that holds `address`, create it
+  //! if it doesn't exist, and return its offset (relative to the GOT section)
+  //! in `offsetOut`.
+  //!
+  //! The GOT is a ".got" section created by the first call. Its entries have
+  //! the size of a general purpose register and store absolute addresses
+  //! directly, so they don't need relocations - code that is shared between
+  //! processes only has to fill the GOT of each copy. Used by emitters when
+  //! \ref CodeEmitter::kHintPositionIndependent is set.
+  ASMJIT_API Error addGotEntry(size_t* offsetOut, uint64_t address) noexcept;
+
   ASMJIT_API Error growBuffer(CodeBuffer* cb, size_t n) noexcept;
   ASMJIT_API Error reserveBuffer(CodeBuffer* cb, size_t n) noexcept;
 
+  //! Make `cb` grow by appending chunks of `chunkSize` bytes instead of being
+  //! reallocated, or make it contiguous again if `chunkSize` is zero.
+  //!
+  //! Useful for very large code, as a growing contiguous buffer is copied each
+  //! time it's reallocated and needs both the old and new memory meanwhile. The
+  //! last few bytes of a chunk can stay unused, as instructions are never split
+  //! between chunks, and data larger than `chunkSize` gets a larger chunk. The
+  //! buffer must be empty and can't be external. The attached \ref Assembler
+  //! can only overwrite (see \ref Assembler::setOffset()) the last chunk.
+  ASMJIT_API Error setBufferChunkSize(CodeBuffer* cb, size_t chunkSize) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Stream]
+  // --------------------------------------------------------------------------
+
+  //! Get whether the first section is assembled into the memory set by `setStream()`.
+  ASMJIT_INLINE bool hasStream() const noexcept { return _streamData != nullptr; }
+  //! Get the memory set by `setStream()`, or null.
+  ASMJIT_INLINE uint8_t* getStreamData() const noexcept { return _streamData; }
+  //! Get the capacity of the memory set by `setStream()`.
+  ASMJIT_INLINE size_t getStreamCapacity() const noexcept { return _streamCapacity; }
+  //! Get the address the memory set by `setStream()` is executed at.
+  ASMJIT_INLINE uint64_t getStreamAddress() const noexcept { return _streamAddress; }
+
+  //! Get whether the code of the first section is still stored in the stream
+  //! memory (it's moved to heap memory if it doesn't fit).
+  ASMJIT_INLINE bool isStreaming() const noexcept {
+    return _streamData && !_sections.isEmpty() && _sections[0]->_buffer._data == _streamData;
+  }
+
+  //! Assemble the first section directly into `data` of `capacity` bytes,
+  //! which will be executed at `address`.
+  //!
+  //! The first section must be empty. The memory is not owned by `CodeHolder`,
+  //! it's used as an external buffer, and if the code outgrows it, it's moved
+  //! to heap memory like any other buffer. `relocate()` can then relocate the
+  //! code in place, with `data` passed as `dst` and `address` as the base
+  //! address. The base address of the code is not changed, as the code may
+  //! still be moved, so the code is emitted the same way regardless of when
+  //! an emitter is attached. See \ref JitRuntime::beginStream().
+  //!
+  //! NOTE: The memory must be released by its owner after `resetStream()`,
+  //! neither `reset()` nor the destructor of `CodeHolder` releases it.
+  ASMJIT_API Error setStream(void* data, size_t capacity, uint64_t address) noexcept;
+
+  //! Stop using the memory set by `setStream()`.
+  //!
+  //! If `moveCode` is true the code of the first section is moved to heap
+  //! memory, which is required before the stream memory is released. Otherwise
+  //! the section keeps the code in the stream memory, but it can't use more of
+  //! it - if more code is emitted it's moved to heap memory first.
+  ASMJIT_API Error resetStream(bool moveCode) noexcept;
+
   // --------------------------------------------------------------------------
   // [Labels & Symbols]
   // --------------------------------------------------------------------------
@@ -625,7 +841,7 @@ public:
   ASMJIT_API LabelLink* newLabelLink(LabelEntry* le, uint32_t sectionId, size_t offset, intptr_t rel) noexcept;
 
   //! Get array of `LabelEntry*` records.
-  ASMJIT_INLINE const ZoneVector<LabelEntry*>& getLabelEntries() const noexcept { return _labels; }
+  ASMJIT_INLINE const ZoneSegmentedVector<LabelEntry*>& getLabelEntries() const noexcept { return _labels; }
 
   //! Get number of labels created.
   ASMJIT_INLINE size_t getLabelsCount() const noexcept { return _labels.getLength(); }
@@ -656,13 +872,21 @@ public:
   }
 
   //! Get a `label` offset or -1 if the label is not yet bound.
+  //!
+  //! The offset is relative to the start of the code, which includes the
+  //! offset of the label's section assigned by `flatten()`.
   ASMJIT_INLINE intptr_t getLabelOffset(const Label& label) const noexcept {
     return getLabelOffset(label.getId());
   }
   //! \overload
   ASMJIT_INLINE intptr_t getLabelOffset(uint32_t id) const noexcept {
     ASMJIT_ASSERT(isLabelValid(id));
-    return _labels[Operand::unpackId(id)]->getOffset();
+    const LabelEntry* le = _labels[Operand::unpackId(id)];
+
+    intptr_t offset = le->getOffset();
+    if (le->isBound())
+      offset += static_cast<intptr_t>(_sections[le->getSectionId()]->getOffset());
+    return offset;
   }
 
   //! Get information about the given `label`.
@@ -687,23 +911,74 @@ public:
   //! Get if the code contains relocations.
   ASMJIT_INLINE bool hasRelocations() const noexcept { return !_relocations.isEmpty(); }
   //! Get array of `RelocEntry*` records.
-  ASMJIT_INLINE const ZoneVector<RelocEntry*>& getRelocEntries() const noexcept { return _relocations; }
+  ASMJIT_INLINE const ZoneSegmentedVector<RelocEntry*>& getRelocEntries() const noexcept { return _relocations; }
 
   ASMJIT_INLINE RelocEntry* getRelocEntry(uint32_t id) const noexcept { return _relocations[id]; }
 
+  // --------------------------------------------------------------------------
+  // [Checkpoint]
+  // --------------------------------------------------------------------------
+
+  //! Save the state of sections, labels, and relocations to `out`.
+  //!
+  //! The checkpoint can be passed to `rollback()` to discard everything that
+  //! has been emitted, created, or bound after it was saved. Checkpoints can
+  //! be nested, but rolling back to a checkpoint invalidates all checkpoints
+  //! saved after it.
+  //!
+  //! A checkpoint stays live until it's released by `releaseCheckpoint()`.
+  //! While any checkpoint is live label links are kept after labels are bound
+  //! and label changes are journaled, so checkpoints should be released as
+  //! soon as they are not needed anymore.
+  ASMJIT_API Error saveCheckpoint(Checkpoint* out) noexcept;
+
+  //! Rewind to the state saved by `saveCheckpoint()`.
+  //!
+  //! Buffer lengths, the data zone, and label and relocation tables are
+  //! restored in O(1) without releasing or reallocating their memory. Labels,
+  //! label links, and relocations created after the checkpoint are released
+  //! to the heap, labels bound after it become unbound again, and their links
+  //! to code preceding the checkpoint are restored. The attached \ref Assembler
+  //! continues at the restored offset.
+  ASMJIT_API Error rollback(const Checkpoint& cp) noexcept;
+
+  //! Release the checkpoint `cp` and all checkpoints saved after it, which
+  //! can't be passed to `rollback()` anymore.
+  ASMJIT_API Error releaseCheckpoint(const Checkpoint& cp) noexcept;
+
+  //! Get whether there is at least one checkpoint that was not released.
+  ASMJIT_INLINE bool hasCheckpoints() const noexcept { return _checkpointCount != 0; }
+
+  //! \internal
+  //!
+  //! Record a change of `le` so `rollback()` can undo it.
+  ASMJIT_INLINE Error _journalLabel(LabelEntry* le) noexcept {
+    if (ASMJIT_LIKELY(_checkpointCount == 0 || le->_stamp == _checkpointStamp))
+      return kErrorOk;
+
+    le->_stamp = _checkpointStamp;
+    return _labelJournal.append(&_baseHeap, le);
+  }
+
   //! Relocate the code to `baseAddress` and copy it to `dst`.
   //!
+  //! All sections are copied to `dst` at offsets assigned by `flatten()` and
+  //! the padding between them is zeroed.
+  //!
   //! \param dst Contains the location where the relocated code should be
   //! copied. The pointer can be address returned by virtual memory allocator
   //! or any other address that has sufficient space.
   //!
-  //! \param baseAddress Base address used for relocation. `JitRuntime` always
-  //! sets the `baseAddress` to be the same as `dst`.
+  //! \param baseAddress Base address used for relocation. `JitRuntime` sets
+  //! the `baseAddress` to the address where the code is executed, which is
+  //! different from `dst` if its `VMemMgr` uses dual mapping.
   //!
   //! \return The number bytes actually used. If the code emitter reserved
   //! space for possible trampolines, but didn't use it, the number of bytes
   //! used can actually be less than the expected worst case. Virtual memory
-  //! allocator can shrink the memory it allocated initially.
+  //! allocator can shrink the memory it allocated initially. Zero is returned
+  //! if the code can't be relocated, for example if a relocation doesn't fit
+  //! its displacement, and the content of `dst` is undefined in that case.
   //!
   //! A given buffer will be overwritten, to get the number of bytes required,
   //! use `getCodeSize()`.
@@ -726,15 +1001,25 @@ public:
 
   uint32_t _unresolvedLabelsCount;       //!< Count of label references which were not resolved.
   uint32_t _trampolinesSize;             //!< Size of all possible trampolines.
+  uint32_t _checkpointStamp;             //!< Stamp of the last checkpoint or rollback, zero if none.
+  uint32_t _checkpointCount;             //!< Number of live checkpoints.
 
   Zone _baseZone;                        //!< Base zone (used to allocate core structures).
   Zone _dataZone;                        //!< Data zone (used to allocate extra data like label names).
   ZoneHeap _baseHeap;                    //!< Zone allocator, used to manage internal containers.
 
   ZoneVector<SectionEntry*> _sections;   //!< Section entries.
-  ZoneVector<LabelEntry*> _labels;       //!< Label entries (each label is stored here).
-  ZoneVector<RelocEntry*> _relocations;  //!< Relocation entries.
-  ZoneHash<LabelEntry> _namedLabels;     //!< Label name -> LabelEntry (only named labels).
+  ZoneSegmentedVector<LabelEntry*> _labels; //!< Label entries (each label is stored here).
+  ZoneSegmentedVector<RelocEntry*> _relocations; //!< Relocation entries.
+  ZoneOpenHash<LabelEntry> _namedLabels; //!< Label name -> LabelEntry (only named labels).
+  ZoneSegmentedVector<LabelEntry*> _labelJournal; //!< Labels changed since checkpoints, see `rollback()`.
+
+  SectionEntry* _gotSection;             //!< Section of the global offset table or null.
+  ZoneOpenHash<GotEntry> _gotEntries;    //!< Address -> GotEntry.
+
+  uint8_t* _streamData;                  //!< Memory the first section is assembled into, see `setStream()`.
+  size_t _streamCapacity;                //!< Capacity of `_streamData`.
+  uint64_t _streamAddress;               //!< Address `_streamData` is executed at.
 };
 
 //! \}
@@ -42,6 +42,8 @@ static const char errorMessages[] =
   "Invalid label name\0"
   "Invalid parent label\0"
   "Non-local label can't have parent\0"
+  "Invalid section\0"
+  "Invalid section name\0"
   "Relocation index overflow\0"
   "Invalid relocation entry\0"
   "Invalid instruction\0"
@@ -143,6 +143,11 @@ ASMJIT_ENUM(ErrorCode) {
   //! Parent id specified for a non-local (global) label.
   kErrorNonLocalLabelCantHaveParent,
 
+  //! Invalid section.
+  kErrorInvalidSection,
+  //! Invalid section name (most probably too long).
+  kErrorInvalidSectionName,
+
   //! Relocation index overflow.
   kErrorRelocIndexOverflow,
   //! Invalid relocation entry.
@@ -246,8 +246,7 @@ Error Logging::formatInstruction(
   return kErrorInvalidArch;
 }
 
-#if !defined(ASMJIT_DISABLE_BUILDER)
-static Error formatTypeId(StringBuilder& sb, uint32_t typeId) noexcept {
+Error Logging::formatTypeId(StringBuilder& sb, uint32_t typeId) noexcept {
   if (typeId == TypeId::kVoid)
     return sb.appendString("void");
 
@@ -290,6 +289,7 @@ static Error formatTypeId(StringBuilder& sb, uint32_t typeId) noexcept {
   }
 }
 
+#if !defined(ASMJIT_DISABLE_BUILDER)
 static Error formatFuncDetailValue(
   StringBuilder& sb,
   uint32_t logOptions,
@@ -297,7 +297,7 @@ static Error formatFuncDetailValue(
   FuncDetail::Value value) noexcept {
 
   uint32_t typeId = value.getTypeId();
-  ASMJIT_PROPAGATE(formatTypeId(sb, typeId));
+  ASMJIT_PROPAGATE(Logging::formatTypeId(sb, typeId));
 
   if (value.byReg()) {
     ASMJIT_PROPAGATE(sb.appendChar(':'));
@@ -405,6 +405,12 @@ Error Logging::formatNode(
       break;
     }
 
+    case CBNode::kNodeSection: {
+      const CBSection* node = node_->as<CBSection>();
+      ASMJIT_PROPAGATE(sb.appendFormat(".section %s", cb->getCode()->getSectionEntry(node->getId())->getName()));
+      break;
+    }
+
 #if !defined(ASMJIT_DISABLE_COMPILER)
     case CBNode::kNodeFunc: {
       const CCFunc* node = node_->as<CCFunc>();
@@ -250,6 +250,11 @@ struct Logging {
     uint32_t archType,
     const Inst::Detail& detail, const Operand_* opArray, uint32_t opCount) noexcept;
 
+  //! Format a type-id, see \ref TypeId, like "i32" or "f32x4".
+  ASMJIT_API static Error formatTypeId(
+    StringBuilder& sb,
+    uint32_t typeId) noexcept;
+
 #if !defined(ASMJIT_DISABLE_BUILDER)
   ASMJIT_API static Error formatNode(
     StringBuilder& sb,
@@ -13,11 +13,17 @@
 
 #if ASMJIT_OS_POSIX
 # include <sys/types.h>
+# include <errno.h>
 # include <sys/mman.h>
+# include <fcntl.h>
 # include <time.h>
 # include <unistd.h>
 #endif // ASMJIT_OS_POSIX
 
+#if ASMJIT_OS_LINUX
+# include <sys/syscall.h>
+#endif // ASMJIT_OS_LINUX
+
 #if ASMJIT_OS_MAC
 # include <mach/mach_time.h>
 #endif // ASMJIT_OS_MAC
@@ -50,6 +56,7 @@ static ASMJIT_NOINLINE const VMemInfo& OSUtils_GetVMemInfo() noexcept {
 
     vmi.pageSize = Utils::alignToPowerOf2<uint32_t>(info.dwPageSize);
     vmi.pageGranularity = info.dwAllocationGranularity;
+    vmi.largePageSize = ::GetLargePageMinimum();
     vmi.hCurrentProcess = ::GetCurrentProcess();
   }
 
@@ -103,6 +110,107 @@ Error OSUtils::releaseProcessMemory(HANDLE hProcess, void* p, size_t size) noexc
 
   return kErrorOk;
 }
+
+static ASMJIT_INLINE DWORD OSUtils_protectFlags(uint32_t flags) noexcept {
+  if (flags & OSUtils::kVMExecutable)
+    return (flags & OSUtils::kVMWritable) ? PAGE_EXECUTE_READWRITE : PAGE_EXECUTE_READ;
+  else
+    return (flags & OSUtils::kVMWritable) ? PAGE_READWRITE : PAGE_READONLY;
+}
+
+void* OSUtils::reserveVirtualMemory(size_t size, size_t* reserved, const void* hint) noexcept {
+  if (size == 0)
+    return nullptr;
+
+  const VMemInfo& vmi = OSUtils_GetVMemInfo();
+  size_t alignedSize = Utils::alignTo(size, vmi.pageGranularity);
+
+  // `VirtualAlloc()` fails if the range at `hint` is not available.
+  LPVOID mBase = ::VirtualAlloc(const_cast<void*>(hint), alignedSize, MEM_RESERVE, PAGE_NOACCESS);
+  if (ASMJIT_UNLIKELY(!mBase)) return nullptr;
+
+  if (reserved) *reserved = alignedSize;
+  return mBase;
+}
+
+Error OSUtils::commitVirtualMemory(void* p, size_t size, uint32_t flags) noexcept {
+  if (ASMJIT_UNLIKELY(!::VirtualAlloc(p, size, MEM_COMMIT, OSUtils_protectFlags(flags))))
+    return DebugUtils::errored(kErrorNoVirtualMemory);
+
+  return kErrorOk;
+}
+
+Error OSUtils::decommitVirtualMemory(void* p, size_t size) noexcept {
+  if (ASMJIT_UNLIKELY(!::VirtualFree(p, size, MEM_DECOMMIT)))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  return kErrorOk;
+}
+
+void* OSUtils::allocDualMappedMemory(size_t size, size_t* allocated, void** rwPtr) noexcept {
+  if (size == 0)
+    return nullptr;
+
+  const VMemInfo& vmi = OSUtils_GetVMemInfo();
+  size_t alignedSize = Utils::alignTo(size, vmi.pageGranularity);
+
+  uint64_t size64 = static_cast<uint64_t>(alignedSize);
+  HANDLE hMap = ::CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_EXECUTE_READWRITE,
+    static_cast<DWORD>(size64 >> 32), static_cast<DWORD>(size64 & 0xFFFFFFFFU), nullptr);
+  if (ASMJIT_UNLIKELY(!hMap)) return nullptr;
+
+  void* rw = ::MapViewOfFile(hMap, FILE_MAP_WRITE, 0, 0, alignedSize);
+  void* rx = ::MapViewOfFile(hMap, FILE_MAP_READ | FILE_MAP_EXECUTE, 0, 0, alignedSize);
+
+  // Views keep the mapping alive, the handle is not needed anymore.
+  ::CloseHandle(hMap);
+
+  if (ASMJIT_UNLIKELY(!rw || !rx)) {
+    if (rw) ::UnmapViewOfFile(rw);
+    if (rx) ::UnmapViewOfFile(rx);
+    return nullptr;
+  }
+
+  if (allocated) *allocated = alignedSize;
+  *rwPtr = rw;
+  return rx;
+}
+
+void* OSUtils::allocLargePageMemory(size_t size, size_t* allocated, uint32_t flags, uint32_t* kind) noexcept {
+  const VMemInfo& vmi = OSUtils_GetVMemInfo();
+  *kind = kLargePageNone;
+
+  if (size == 0)
+    return nullptr;
+
+  // Large pages require `SeLockMemoryPrivilege`, use regular pages if the
+  // allocation fails.
+  if (vmi.largePageSize) {
+    size_t alignedSize = Utils::alignTo(size, vmi.largePageSize);
+    DWORD protectFlags = (flags & kVMExecutable) ? PAGE_EXECUTE_READWRITE : PAGE_READWRITE;
+
+    LPVOID mBase = ::VirtualAlloc(nullptr, alignedSize, MEM_COMMIT | MEM_RESERVE | MEM_LARGE_PAGES, protectFlags);
+    if (mBase) {
+      if (allocated) *allocated = alignedSize;
+      *kind = kLargePageExplicit;
+      return mBase;
+    }
+  }
+
+  return allocVirtualMemory(size, allocated, flags);
+}
+
+Error OSUtils::releaseDualMappedMemory(void* rxPtr, void* rwPtr, size_t size) noexcept {
+  ASMJIT_UNUSED(size);
+
+  BOOL rxOk = ::UnmapViewOfFile(rxPtr);
+  BOOL rwOk = ::UnmapViewOfFile(rwPtr);
+
+  if (ASMJIT_UNLIKELY(!rxOk || !rwOk))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  return kErrorOk;
+}
 #endif // ASMJIT_OS_WINDOWS
 
 // Posix specific implementation using `mmap()` and `munmap()`.
@@ -119,6 +227,10 @@ static const VMemInfo& OSUtils_GetVMemInfo() noexcept {
     size_t pageSize = ::getpagesize();
     vmi.pageSize = pageSize;
     vmi.pageGranularity = std::max<size_t>(pageSize, 65536);
+#if ASMJIT_OS_LINUX
+    // PMD size used by transparent huge pages on X64 and ARM64 (4kB pages).
+    vmi.largePageSize = 2 * 1024 * 1024;
+#endif // ASMJIT_OS_LINUX
   }
   return vmi;
 };
@@ -147,6 +259,171 @@ Error OSUtils::releaseVirtualMemory(void* p, size_t size) noexcept {
 
   return kErrorOk;
 }
+
+void* OSUtils::allocLargePageMemory(size_t size, size_t* allocated, uint32_t flags, uint32_t* kind) noexcept {
+  const VMemInfo& vmi = OSUtils_GetVMemInfo();
+  size_t largePageSize = vmi.largePageSize;
+
+  *kind = kLargePageNone;
+  if (!largePageSize)
+    return allocVirtualMemory(size, allocated, flags);
+
+  size_t alignedSize = Utils::alignTo<size_t>(size, largePageSize);
+  int protection = PROT_READ;
+
+  if (flags & kVMWritable  ) protection |= PROT_WRITE;
+  if (flags & kVMExecutable) protection |= PROT_EXEC;
+
+#if defined(MAP_HUGETLB)
+  // Explicit huge pages only work if the system has a pool of them reserved.
+  void* mbase = ::mmap(nullptr, alignedSize, protection, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+  if (mbase != MAP_FAILED) {
+    if (allocated) *allocated = alignedSize;
+    *kind = kLargePageExplicit;
+    return mbase;
+  }
+#endif // MAP_HUGETLB
+
+#if defined(MADV_HUGEPAGE)
+  // Transparent huge pages can only back regions aligned to the huge page
+  // size, so map more than needed and unmap the unaligned head and tail.
+  size_t mappedSize = alignedSize + largePageSize;
+  uint8_t* mapped = static_cast<uint8_t*>(
+    ::mmap(nullptr, mappedSize, protection, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+  if (ASMJIT_UNLIKELY(mapped == MAP_FAILED)) return nullptr;
+
+  uint8_t* aligned = Utils::alignTo<uint8_t*>(mapped, largePageSize);
+  size_t headSize = (size_t)(aligned - mapped);
+  size_t tailSize = mappedSize - headSize - alignedSize;
+
+  if (headSize) ::munmap(mapped, headSize);
+  if (tailSize) ::munmap(aligned + alignedSize, tailSize);
+
+  if (::madvise(aligned, alignedSize, MADV_HUGEPAGE) == 0)
+    *kind = kLargePageTransparent;
+
+  if (allocated) *allocated = alignedSize;
+  return aligned;
+#else
+  return allocVirtualMemory(size, allocated, flags);
+#endif // MADV_HUGEPAGE
+}
+
+#if !defined(MAP_NORESERVE)
+# define MAP_NORESERVE 0
+#endif // MAP_NORESERVE
+
+static ASMJIT_INLINE int OSUtils_protection(uint32_t flags) noexcept {
+  int protection = PROT_READ;
+
+  if (flags & OSUtils::kVMWritable  ) protection |= PROT_WRITE;
+  if (flags & OSUtils::kVMExecutable) protection |= PROT_EXEC;
+
+  return protection;
+}
+
+void* OSUtils::reserveVirtualMemory(size_t size, size_t* reserved, const void* hint) noexcept {
+  const VMemInfo& vmi = OSUtils_GetVMemInfo();
+  size_t alignedSize = Utils::alignTo<size_t>(size, vmi.pageGranularity);
+
+  // The `hint` is only a hint, the kernel is free to place the range elsewhere.
+  void* mbase = ::mmap(const_cast<void*>(hint), alignedSize, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+  if (ASMJIT_UNLIKELY(mbase == MAP_FAILED)) return nullptr;
+
+  if (reserved) *reserved = alignedSize;
+  return mbase;
+}
+
+Error OSUtils::commitVirtualMemory(void* p, size_t size, uint32_t flags) noexcept {
+  if (ASMJIT_UNLIKELY(::mprotect(p, size, OSUtils_protection(flags)) != 0))
+    return DebugUtils::errored(kErrorNoVirtualMemory);
+
+  return kErrorOk;
+}
+
+Error OSUtils::decommitVirtualMemory(void* p, size_t size) noexcept {
+  // Replacing the pages by a new inaccessible mapping discards their content.
+  void* mbase = ::mmap(p, size, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED, -1, 0);
+  if (ASMJIT_UNLIKELY(mbase == MAP_FAILED))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  return kErrorOk;
+}
+
+//! \internal
+//!
+//! Create an anonymous file that can be mapped multiple times, returns its
+//! file descriptor or -1 on failure.
+static int OSUtils_openAnonymousFile() noexcept {
+#if ASMJIT_OS_LINUX && defined(SYS_memfd_create)
+  // Linux 3.17+ - `memfd_create()` doesn't need any file-system and is not
+  // restricted by mount options of `/dev/shm`. The flag is `MFD_CLOEXEC`.
+  int fd = static_cast<int>(::syscall(SYS_memfd_create, "asmjit", 1U));
+  if (fd >= 0) return fd;
+#endif // ASMJIT_OS_LINUX
+
+  // Fallback to a POSIX shared memory object, which is unlinked immediately
+  // after it's created so it never outlives the process.
+  static uint32_t shmCounter;
+  char name[64];
+
+  for (uint32_t attempt = 0; attempt < 16; attempt++) {
+    snprintf(name, ASMJIT_ARRAY_SIZE(name), "/asmjit-%u-%u-%u",
+      static_cast<unsigned int>(::getpid()),
+      static_cast<unsigned int>(++shmCounter),
+      static_cast<unsigned int>(OSUtils::getTickCount()));
+
+    int fd = ::shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd >= 0) {
+      ::shm_unlink(name);
+      return fd;
+    }
+
+    if (errno != EEXIST)
+      break;
+  }
+
+  return -1;
+}
+
+void* OSUtils::allocDualMappedMemory(size_t size, size_t* allocated, void** rwPtr) noexcept {
+  const VMemInfo& vmi = OSUtils_GetVMemInfo();
+  size_t alignedSize = Utils::alignTo<size_t>(size, vmi.pageSize);
+
+  int fd = OSUtils_openAnonymousFile();
+  if (ASMJIT_UNLIKELY(fd < 0)) return nullptr;
+
+  void* rw = MAP_FAILED;
+  void* rx = MAP_FAILED;
+
+  if (::ftruncate(fd, static_cast<off_t>(alignedSize)) == 0) {
+    rw = ::mmap(nullptr, alignedSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (rw != MAP_FAILED)
+      rx = ::mmap(nullptr, alignedSize, PROT_READ | PROT_EXEC, MAP_SHARED, fd, 0);
+  }
+
+  // Mappings keep the file alive, the descriptor is not needed anymore.
+  ::close(fd);
+
+  if (ASMJIT_UNLIKELY(rx == MAP_FAILED)) {
+    if (rw != MAP_FAILED) ::munmap(rw, alignedSize);
+    return nullptr;
+  }
+
+  if (allocated) *allocated = alignedSize;
+  *rwPtr = rw;
+  return rx;
+}
+
+Error OSUtils::releaseDualMappedMemory(void* rxPtr, void* rwPtr, size_t size) noexcept {
+  int rxResult = ::munmap(rxPtr, size);
+  int rwResult = ::munmap(rwPtr, size);
+
+  if (ASMJIT_UNLIKELY(rxResult != 0 || rwResult != 0))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  return kErrorOk;
+}
 #endif // ASMJIT_OS_POSIX
 
 // ============================================================================
@@ -222,6 +499,49 @@ uint32_t OSUtils::getTickCount() noexcept {
 uint32_t OSUtils::getTickCount() noexcept { return 0; }
 #endif
 
+#if ASMJIT_OS_WINDOWS
+uint64_t OSUtils::getTickCountNs() noexcept {
+  static volatile LONGLONG _qpf;
+
+  LARGE_INTEGER now;
+  LONGLONG freq = _qpf;
+
+  if (ASMJIT_UNLIKELY(freq == 0)) {
+    LARGE_INTEGER qpf;
+    if (!::QueryPerformanceFrequency(&qpf) || qpf.QuadPart == 0)
+      return static_cast<uint64_t>(::GetTickCount()) * 1000000;
+    freq = qpf.QuadPart;
+    _qpf = freq;
+  }
+
+  if (!::QueryPerformanceCounter(&now))
+    return static_cast<uint64_t>(::GetTickCount()) * 1000000;
+
+  // Split to avoid overflow of `now * 1e9`.
+  uint64_t t = static_cast<uint64_t>(now.QuadPart);
+  uint64_t f = static_cast<uint64_t>(freq);
+  return (t / f) * 1000000000 + ((t % f) * 1000000000) / f;
+}
+#elif ASMJIT_OS_MAC
+uint64_t OSUtils::getTickCountNs() noexcept {
+  static mach_timebase_info_data_t _machTime;
+
+  if (ASMJIT_UNLIKELY(_machTime.denom == 0) && mach_timebase_info(&_machTime) != KERN_SUCCESS)
+    return 0;
+
+  return mach_absolute_time() * _machTime.numer / _machTime.denom;
+}
+#else
+uint64_t OSUtils::getTickCountNs() noexcept {
+  struct timespec ts;
+
+  if (ASMJIT_UNLIKELY(clock_gettime(CLOCK_MONOTONIC, &ts) != 0))
+    return 0;
+
+  return (uint64_t(ts.tv_sec) * 1000000000) + uint64_t(ts.tv_nsec);
+}
+#endif
+
 } // asmjit namespace
 
 // [Api-End]
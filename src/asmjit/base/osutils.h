@@ -30,6 +30,7 @@ struct VMemInfo {
 #endif // ASMJIT_OS_WINDOWS
   size_t pageSize;                       //!< Virtual memory page size.
   size_t pageGranularity;                //!< Virtual memory page granularity.
+  size_t largePageSize;                  //!< Large (huge) page size or zero if not supported.
 };
 
 // ============================================================================
@@ -72,6 +73,45 @@ struct OSUtils {
   //! Release virtual memory previously allocated by \ref allocVirtualMemory().
   ASMJIT_API static Error releaseVirtualMemory(void* p, size_t size) noexcept;
 
+  //! Reserve `size` bytes of address space without committing any memory.
+  //!
+  //! If `hint` is not null the OS is asked to place the range at `hint`, the
+  //! caller must check where the range was actually placed. The range is made
+  //! accessible by \ref commitVirtualMemory() and released as a whole by
+  //! \ref releaseVirtualMemory().
+  ASMJIT_API static void* reserveVirtualMemory(size_t size, size_t* reserved, const void* hint) noexcept;
+  //! Commit a part of the address space reserved by \ref reserveVirtualMemory().
+  ASMJIT_API static Error commitVirtualMemory(void* p, size_t size, uint32_t flags) noexcept;
+  //! Decommit memory committed by \ref commitVirtualMemory(), the address
+  //! space stays reserved.
+  ASMJIT_API static Error decommitVirtualMemory(void* p, size_t size) noexcept;
+
+  //! Allocate virtual memory that is mapped twice.
+  //!
+  //! The returned pointer is a read+execute view of the memory and `rwPtr`
+  //! receives a read+write view of the same physical pages. Code written
+  //! through `rwPtr` is visible at the returned address without changing
+  //! the page protection, so no page is ever writable and executable at once.
+  ASMJIT_API static void* allocDualMappedMemory(size_t size, size_t* allocated, void** rwPtr) noexcept;
+  //! Release virtual memory previously allocated by \ref allocDualMappedMemory().
+  ASMJIT_API static Error releaseDualMappedMemory(void* rxPtr, void* rwPtr, size_t size) noexcept;
+
+  //! Kind of pages backing memory allocated by \ref allocLargePageMemory().
+  ASMJIT_ENUM(LargePageKind) {
+    kLargePageNone        = 0,           //!< Regular pages (large pages not available).
+    kLargePageExplicit    = 1,           //!< Explicit large pages (`MAP_HUGETLB`, `MEM_LARGE_PAGES`).
+    kLargePageTransparent = 2            //!< Transparent huge pages (`madvise(MADV_HUGEPAGE)`).
+  };
+
+  //! Allocate virtual memory backed by large pages, if possible.
+  //!
+  //! The size is aligned to `VMemInfo::largePageSize`. Explicit large pages are
+  //! tried first, then transparent huge pages (Linux), and if none of them is
+  //! available the memory is backed by regular pages. The kind of pages used is
+  //! stored to `kind`, see \ref LargePageKind. The memory is released by \ref
+  //! releaseVirtualMemory().
+  ASMJIT_API static void* allocLargePageMemory(size_t size, size_t* allocated, uint32_t flags, uint32_t* kind) noexcept;
+
 #if ASMJIT_OS_WINDOWS
   //! Allocate virtual memory of `hProcess` (Windows).
   ASMJIT_API static void* allocProcessMemory(HANDLE hProcess, size_t size, size_t* allocated, uint32_t flags) noexcept;
@@ -86,6 +126,9 @@ struct OSUtils {
 
   //! Get the current CPU tick count, used for benchmarking (1ms resolution).
   ASMJIT_API static uint32_t getTickCount() noexcept;
+  //! Get the current time of a monotonic clock in nanoseconds, used to measure
+  //! short intervals (the resolution depends on the OS).
+  ASMJIT_API static uint64_t getTickCountNs() noexcept;
 };
 
 // ============================================================================
@@ -112,6 +155,8 @@ struct Lock {
 
   //! Lock.
   ASMJIT_INLINE void lock() noexcept { EnterCriticalSection(&_handle); }
+  //! Try to lock, returns true if the lock has been acquired.
+  ASMJIT_INLINE bool tryLock() noexcept { return TryEnterCriticalSection(&_handle) != 0; }
   //! Unlock.
   ASMJIT_INLINE void unlock() noexcept { LeaveCriticalSection(&_handle); }
 #endif // ASMJIT_OS_WINDOWS
@@ -130,6 +175,8 @@ struct Lock {
 
   //! Lock.
   ASMJIT_INLINE void lock() noexcept { pthread_mutex_lock(&_handle); }
+  //! Try to lock, returns true if the lock has been acquired.
+  ASMJIT_INLINE bool tryLock() noexcept { return pthread_mutex_trylock(&_handle) == 0; }
   //! Unlock.
   ASMJIT_INLINE void unlock() noexcept { pthread_mutex_unlock(&_handle); }
 #endif // ASMJIT_OS_POSIX
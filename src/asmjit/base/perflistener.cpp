@@ -0,0 +1,654 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Dependencies]
+#include "../base/func.h"
+#include "../base/logging.h"
+#include "../base/perflistener.h"
+#include "../base/string.h"
+
+#if ASMJIT_OS_POSIX
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <time.h>
+# include <unistd.h>
+#endif // ASMJIT_OS_POSIX
+
+#if ASMJIT_OS_LINUX
+# include <sys/syscall.h>
+#endif // ASMJIT_OS_LINUX
+
+#if defined(ASMJIT_TEST) && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+# include <stdio.h>
+# include "../x86/x86assembler.h"
+#endif // ASMJIT_TEST
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::PerfListener - JitDump]
+// ============================================================================
+
+// Structures of the jitdump format, see `tools/perf/Documentation/jitdump-specification.txt`
+// in the Linux kernel source tree.
+
+enum {
+  kPerfJitMagic = 0x4A695444U,           //!< 'JiTD'.
+  kPerfJitVersion = 1,                   //!< Version of the format.
+  kPerfJitCodeLoad = 0,                  //!< Record that describes loaded code.
+  kPerfJitCodeClose = 3                  //!< Record that marks the end of the file.
+};
+
+//! \internal
+//!
+//! JitDump file header.
+struct PerfJitHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t totalSize;
+  uint32_t elfMach;
+  uint32_t pad1;
+  uint32_t pid;
+  uint64_t timestamp;
+  uint64_t flags;
+};
+
+//! \internal
+//!
+//! JitDump record header.
+struct PerfJitRecord {
+  uint32_t id;
+  uint32_t totalSize;
+  uint64_t timestamp;
+};
+
+//! \internal
+//!
+//! JitDump code load record, followed by a null terminated name and code bytes.
+struct PerfJitCodeLoad {
+  PerfJitRecord record;
+  uint32_t pid;
+  uint32_t tid;
+  uint64_t vma;
+  uint64_t codeAddr;
+  uint64_t codeSize;
+  uint64_t codeIndex;
+};
+
+//! \internal
+//!
+//! ELF machine of the host.
+static const uint32_t kPerfJitElfMach =
+  ASMJIT_ARCH_X64   ? 62  : // EM_X86_64.
+  ASMJIT_ARCH_X86   ? 3   : // EM_386.
+  ASMJIT_ARCH_ARM64 ? 183 : // EM_AARCH64.
+  ASMJIT_ARCH_ARM32 ? 40  : // EM_ARM.
+                      0   ;
+
+// ============================================================================
+// [asmjit::PerfListener - Helpers]
+// ============================================================================
+
+//! \internal
+//!
+//! Records are written by the caller of `onCodeAdded()` if the writer thread
+//! doesn't keep up, which bounds the memory used by the buffer.
+static const size_t kPerfFlushThreshold = 4 * 1024 * 1024;
+
+//! \internal
+//!
+//! Granularity of checking whether the writer thread should stop.
+static const uint32_t kPerfSleepSlice = 10;
+
+//! \internal
+//!
+//! A symbol within the code passed to `onCodeAdded()`.
+struct PerfSymbol {
+  const char* name;
+  size_t start;
+  size_t end;
+};
+
+static ASMJIT_INLINE uint32_t perfGetPid() noexcept {
+#if ASMJIT_OS_POSIX
+  return static_cast<uint32_t>(::getpid());
+#else
+  return 0;
+#endif // ASMJIT_OS_POSIX
+}
+
+static ASMJIT_INLINE uint32_t perfGetTid() noexcept {
+#if ASMJIT_OS_LINUX
+  return static_cast<uint32_t>(::syscall(SYS_gettid));
+#else
+  return perfGetPid();
+#endif // ASMJIT_OS_LINUX
+}
+
+static void perfSleep(uint32_t ms) noexcept {
+#if ASMJIT_OS_POSIX
+  struct timespec ts;
+  ts.tv_sec = static_cast<time_t>(ms / 1000);
+  ts.tv_nsec = static_cast<long>(ms % 1000) * 1000000;
+  ::nanosleep(&ts, nullptr);
+#else
+  ASMJIT_UNUSED(ms);
+#endif // ASMJIT_OS_POSIX
+}
+
+//! \internal
+//!
+//! Write `size` bytes of `data` to `fd`.
+static Error perfWriteAll(int fd, const void* data, size_t size) noexcept {
+#if ASMJIT_OS_POSIX
+  const uint8_t* p = static_cast<const uint8_t*>(data);
+  while (size) {
+    ssize_t n = ::write(fd, p, size);
+    if (n <= 0)
+      return DebugUtils::errored(kErrorInvalidState);
+
+    p += n;
+    size -= static_cast<size_t>(n);
+  }
+  return kErrorOk;
+#else
+  ASMJIT_UNUSED(fd);
+  ASMJIT_UNUSED(data);
+  ASMJIT_UNUSED(size);
+  return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_POSIX
+}
+
+//! \internal
+//!
+//! Make sure the buffer can hold `size` more bytes, must be called with the
+//! `_lock` held.
+static bool perfReserve(PerfListener* self, size_t size) noexcept {
+  size_t required = self->_length + size;
+  if (required <= self->_capacity)
+    return true;
+
+  size_t capacity = self->_capacity ? self->_capacity : size_t(4096);
+  while (capacity < required)
+    capacity *= 2;
+
+  uint8_t* buffer = static_cast<uint8_t*>(Internal::reallocMemory(self->_buffer, capacity));
+  if (ASMJIT_UNLIKELY(!buffer))
+    return false;
+
+  self->_buffer = buffer;
+  self->_capacity = capacity;
+  return true;
+}
+
+//! \internal
+//!
+//! Append `size` bytes of `data` to the buffer, must be called with the `_lock`
+//! held and after the space has been reserved by `perfReserve()`.
+static ASMJIT_INLINE void perfAppend(PerfListener* self, const void* data, size_t size) noexcept {
+  ::memcpy(self->_buffer + self->_length, data, size);
+  self->_length += size;
+}
+
+// ============================================================================
+// [asmjit::PerfListener - Construction / Destruction]
+// ============================================================================
+
+PerfListener::PerfListener() noexcept
+  : _buffer(nullptr),
+    _length(0),
+    _capacity(0),
+    _spare(nullptr),
+    _spareCapacity(0),
+    _fd(-1),
+    _format(kFormatPerfMap),
+    _marker(nullptr),
+    _markerSize(0),
+    _codeIndex(0),
+    _recordCount(0),
+    _running(false),
+    _stopRequested(false),
+    _flushIntervalMs(0) {}
+
+PerfListener::~PerfListener() noexcept {
+  reset();
+}
+
+// ============================================================================
+// [asmjit::PerfListener - Writer Thread]
+// ============================================================================
+
+static void perfWriterRun(PerfListener* self) noexcept {
+  while (!self->_stopRequested) {
+    self->flush();
+
+    uint32_t remaining = self->_flushIntervalMs;
+    while (remaining && !self->_stopRequested) {
+      uint32_t slice = remaining < kPerfSleepSlice ? remaining : kPerfSleepSlice;
+      perfSleep(slice);
+      remaining -= slice;
+    }
+  }
+}
+
+#if ASMJIT_OS_POSIX
+static void* perfWriterEntry(void* arg) {
+  perfWriterRun(static_cast<PerfListener*>(arg));
+  return nullptr;
+}
+#endif // ASMJIT_OS_POSIX
+
+// ============================================================================
+// [asmjit::PerfListener - Init / Reset]
+// ============================================================================
+
+Error PerfListener::init(uint32_t format, const char* path, uint32_t flushIntervalMs) noexcept {
+  if (ASMJIT_UNLIKELY(format > kFormatJitDump))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  if (ASMJIT_UNLIKELY(_fd >= 0))
+    return DebugUtils::errored(kErrorInvalidState);
+
+#if ASMJIT_OS_LINUX
+  StringBuilderTmp<64> defaultPath;
+  if (!path) {
+    if (format == kFormatPerfMap)
+      ASMJIT_PROPAGATE(defaultPath.appendFormat("/tmp/perf-%u.map", perfGetPid()));
+    else
+      ASMJIT_PROPAGATE(defaultPath.appendFormat("/tmp/jit-%u.dump", perfGetPid()));
+    path = defaultPath.getData();
+  }
+
+  int fd = ::open(path, format == kFormatPerfMap ? O_WRONLY | O_CREAT | O_TRUNC : O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (ASMJIT_UNLIKELY(fd < 0))
+    return DebugUtils::errored(kErrorInvalidState);
+
+  if (format == kFormatJitDump) {
+    PerfJitHeader header;
+    header.magic = kPerfJitMagic;
+    header.version = kPerfJitVersion;
+    header.totalSize = static_cast<uint32_t>(sizeof(PerfJitHeader));
+    header.elfMach = kPerfJitElfMach;
+    header.pad1 = 0;
+    header.pid = perfGetPid();
+    header.timestamp = OSUtils::getTickCountNs();
+    header.flags = 0;
+
+    // `perf record` only learns about the file when it's mapped as executable.
+    size_t markerSize = OSUtils::getVirtualMemoryInfo().pageSize;
+    void* marker = MAP_FAILED;
+
+    if (perfWriteAll(fd, &header, sizeof(header)) == kErrorOk)
+      marker = ::mmap(nullptr, markerSize, PROT_READ | PROT_EXEC, MAP_PRIVATE, fd, 0);
+
+    if (ASMJIT_UNLIKELY(marker == MAP_FAILED)) {
+      ::close(fd);
+      return DebugUtils::errored(kErrorInvalidState);
+    }
+
+    _marker = marker;
+    _markerSize = markerSize;
+  }
+
+  _fd = fd;
+  _format = format;
+  _codeIndex = 0;
+  _recordCount = 0;
+  _flushIntervalMs = flushIntervalMs;
+  _stopRequested = false;
+
+  if (ASMJIT_UNLIKELY(::pthread_create(&_thread, nullptr, perfWriterEntry, this) != 0)) {
+    reset();
+    return DebugUtils::errored(kErrorInvalidState);
+  }
+
+  _running = true;
+  return kErrorOk;
+#else
+  ASMJIT_UNUSED(path);
+  ASMJIT_UNUSED(flushIntervalMs);
+  return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_LINUX
+}
+
+void PerfListener::reset() noexcept {
+#if ASMJIT_OS_POSIX
+  if (_running) {
+    _stopRequested = true;
+    ::pthread_join(_thread, nullptr);
+    _running = false;
+  }
+
+  if (_fd >= 0) {
+    if (_format == kFormatJitDump) {
+      PerfJitRecord record;
+      record.id = kPerfJitCodeClose;
+      record.totalSize = static_cast<uint32_t>(sizeof(PerfJitRecord));
+      record.timestamp = OSUtils::getTickCountNs();
+
+      AutoLock locked(_lock);
+      if (perfReserve(this, sizeof(record)))
+        perfAppend(this, &record, sizeof(record));
+    }
+
+    flush();
+
+    if (_marker)
+      ::munmap(_marker, _markerSize);
+    ::close(_fd);
+  }
+#endif // ASMJIT_OS_POSIX
+
+  _fd = -1;
+  _marker = nullptr;
+  _markerSize = 0;
+
+  Internal::releaseMemory(_buffer);
+  Internal::releaseMemory(_spare);
+
+  _buffer = nullptr;
+  _length = 0;
+  _capacity = 0;
+  _spare = nullptr;
+  _spareCapacity = 0;
+}
+
+// ============================================================================
+// [asmjit::PerfListener - Flush]
+// ============================================================================
+
+Error PerfListener::flush() noexcept {
+  AutoLock writeLocked(_writeLock);
+  if (_fd < 0) return kErrorOk;
+
+  size_t length;
+  {
+    // Swap buffers so `onCodeAdded()` can continue while the data is written.
+    AutoLock locked(_lock);
+    if (!_length) return kErrorOk;
+
+    uint8_t* spare = _spare;
+    size_t spareCapacity = _spareCapacity;
+
+    _spare = _buffer;
+    _spareCapacity = _capacity;
+    length = _length;
+
+    _buffer = spare;
+    _capacity = spareCapacity;
+    _length = 0;
+  }
+
+  return perfWriteAll(_fd, _spare, length);
+}
+
+// ============================================================================
+// [asmjit::PerfListener - Symbols]
+// ============================================================================
+
+Error PerfListener::formatSymbol(StringBuilder& sb, const char* name, const FuncSignature& sign) noexcept {
+  ASMJIT_PROPAGATE(sb.appendString(name));
+
+#if !defined(ASMJIT_DISABLE_LOGGING)
+  ASMJIT_PROPAGATE(sb.appendChar('('));
+  for (uint32_t i = 0; i < sign.getArgCount(); i++) {
+    if (i) ASMJIT_PROPAGATE(sb.appendString(", "));
+    ASMJIT_PROPAGATE(Logging::formatTypeId(sb, sign.getArg(i)));
+  }
+  ASMJIT_PROPAGATE(sb.appendChar(')'));
+
+  if (sign.hasRet()) {
+    ASMJIT_PROPAGATE(sb.appendString(" -> "));
+    ASMJIT_PROPAGATE(Logging::formatTypeId(sb, sign.getRet()));
+  }
+#else
+  ASMJIT_UNUSED(sign);
+#endif // !ASMJIT_DISABLE_LOGGING
+
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::PerfListener - Interface]
+// ============================================================================
+
+void PerfListener::onCodeAdded(const void* p, size_t size, const CodeHolder* code) noexcept {
+  if (_fd < 0 || !size) return;
+
+  // Collect named global labels bound in the code, each one starts a symbol.
+  enum { kMaxSymbols = 64 };
+
+  PerfSymbol symbols[kMaxSymbols];
+  size_t symbolCount = 0;
+
+  const ZoneSegmentedVector<LabelEntry*>& labels = code->getLabelEntries();
+  for (size_t i = 0; i < labels.getLength() && symbolCount < kMaxSymbols; i++) {
+    const LabelEntry* le = labels[i];
+    if (le->getType() != Label::kTypeGlobal || !le->hasName() || !le->isBound() || le->getSectionId() != 0)
+      continue;
+
+    size_t offset = static_cast<size_t>(le->getOffset());
+    if (offset >= size)
+      continue;
+
+    // Keep symbols sorted by their offset.
+    size_t j = symbolCount++;
+    while (j > 0 && symbols[j - 1].start > offset) {
+      symbols[j] = symbols[j - 1];
+      j--;
+    }
+
+    symbols[j].name = le->getName();
+    symbols[j].start = offset;
+  }
+
+  for (size_t i = 0; i < symbolCount; i++)
+    symbols[i].end = i + 1 < symbolCount ? symbols[i + 1].start : size;
+
+  StringBuilderTmp<32> anonymous;
+  if (!symbolCount || symbols[0].start != 0) {
+    // The code before the first symbol (or the whole code) is anonymous.
+    if (anonymous.appendFormat("asmjit_%llx", static_cast<unsigned long long>((uintptr_t)p)) != kErrorOk)
+      return;
+
+    size_t i = symbolCount++;
+    if (symbolCount > kMaxSymbols) {
+      symbolCount--;
+      i--;
+    }
+
+    while (i > 0) {
+      symbols[i] = symbols[i - 1];
+      i--;
+    }
+
+    symbols[0].name = anonymous.getData();
+    symbols[0].start = 0;
+    symbols[0].end = symbolCount > 1 ? symbols[1].start : size;
+  }
+
+  const uint8_t* base = static_cast<const uint8_t*>(p);
+  bool needsFlush = false;
+
+  if (_format == kFormatPerfMap) {
+    StringBuilderTmp<256> sb;
+    for (size_t i = 0; i < symbolCount; i++) {
+      if (sb.appendFormat("%llx %llx %s\n",
+          static_cast<unsigned long long>((uintptr_t)(base + symbols[i].start)),
+          static_cast<unsigned long long>(symbols[i].end - symbols[i].start),
+          symbols[i].name) != kErrorOk)
+        return;
+    }
+
+    AutoLock locked(_lock);
+    if (!perfReserve(this, sb.getLength()))
+      return;
+
+    perfAppend(this, sb.getData(), sb.getLength());
+    _recordCount += symbolCount;
+    needsFlush = _length >= kPerfFlushThreshold;
+  }
+  else {
+    uint32_t pid = perfGetPid();
+    uint32_t tid = perfGetTid();
+    uint64_t timestamp = OSUtils::getTickCountNs();
+
+    AutoLock locked(_lock);
+    for (size_t i = 0; i < symbolCount; i++) {
+      size_t nameSize = ::strlen(symbols[i].name) + 1;
+      size_t codeSize = symbols[i].end - symbols[i].start;
+      size_t totalSize = sizeof(PerfJitCodeLoad) + nameSize + codeSize;
+
+      if (!perfReserve(this, totalSize))
+        return;
+
+      PerfJitCodeLoad load;
+      load.record.id = kPerfJitCodeLoad;
+      load.record.totalSize = static_cast<uint32_t>(totalSize);
+      load.record.timestamp = timestamp;
+      load.pid = pid;
+      load.tid = tid;
+      load.vma = static_cast<uint64_t>((uintptr_t)(base + symbols[i].start));
+      load.codeAddr = load.vma;
+      load.codeSize = static_cast<uint64_t>(codeSize);
+      load.codeIndex = _codeIndex++;
+
+      perfAppend(this, &load, sizeof(load));
+      perfAppend(this, symbols[i].name, nameSize);
+      perfAppend(this, base + symbols[i].start, codeSize);
+    }
+
+    _recordCount += symbolCount;
+    needsFlush = _length >= kPerfFlushThreshold;
+  }
+
+  if (needsFlush)
+    flush();
+}
+
+// ============================================================================
+// [asmjit::PerfListener - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST) && ASMJIT_OS_LINUX && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+static long PerfListenerTest_readFile(const char* path, char* buf, size_t capacity) noexcept {
+  FILE* f = ::fopen(path, "rb");
+  if (!f) return -1;
+
+  size_t n = ::fread(buf, 1, capacity - 1, f);
+  ::fclose(f);
+
+  buf[n] = '\0';
+  return static_cast<long>(n);
+}
+
+static Error PerfListenerTest_addFunc(JitRuntime& rt, void** func) noexcept {
+  CodeHolder code;
+  code.init(rt.getCodeInfo());
+
+  StringBuilderTmp<64> name;
+  PerfListener::formatSymbol(name, "perf_test_func", FuncSignature0<int>());
+
+  X86Assembler a(&code);
+  a.bind(a.newNamedLabel(name.getData()));
+  a.mov(x86::eax, 42);
+  a.ret();
+
+  Label second = a.newNamedLabel("perf_test_second");
+  a.bind(second);
+  a.xor_(x86::eax, x86::eax);
+  a.ret();
+
+  return rt.add(func, &code);
+}
+
+UNIT(base_perflistener) {
+  char path[64];
+  char buf[4096];
+
+  StringBuilderTmp<64> sign;
+  EXPECT(PerfListener::formatSymbol(sign, "f", FuncSignature2<int, int, double>()) == kErrorOk,
+    "PerfListener::formatSymbol() failed");
+  EXPECT(::strcmp(sign.getData(), "f(i32, f64) -> i32") == 0,
+    "PerfListener::formatSymbol() returned '%s'", sign.getData());
+
+  INFO("Writing perf map");
+  ::snprintf(path, sizeof(path), "/tmp/asmjit-test-%u.map", perfGetPid());
+  {
+    JitRuntime rt;
+    PerfListener perf;
+
+    EXPECT(perf.init(PerfListener::kFormatPerfMap, path) == kErrorOk,
+      "PerfListener::init() failed");
+    rt.setListener(&perf);
+
+    void* func;
+    EXPECT(PerfListenerTest_addFunc(rt, &func) == kErrorOk,
+      "JitRuntime::add() failed");
+    EXPECT(perf.getRecordCount() == 2,
+      "Invalid number of records (%u)", static_cast<unsigned int>(perf.getRecordCount()));
+
+    perf.reset();
+    rt.resetListener();
+
+    EXPECT(PerfListenerTest_readFile(path, buf, sizeof(buf)) > 0,
+      "Couldn't read '%s'", path);
+    EXPECT(::strstr(buf, " perf_test_func() -> i32\n") != nullptr,
+      "Perf map doesn't contain the first symbol");
+    EXPECT(::strstr(buf, " perf_test_second\n") != nullptr,
+      "Perf map doesn't contain the second symbol");
+    INFO("%s", buf);
+  }
+  ::unlink(path);
+
+  INFO("Writing jitdump");
+  ::snprintf(path, sizeof(path), "/tmp/asmjit-test-%u.dump", perfGetPid());
+  {
+    JitRuntime rt;
+    PerfListener perf;
+
+    EXPECT(perf.init(PerfListener::kFormatJitDump, path) == kErrorOk,
+      "PerfListener::init() failed");
+    rt.setListener(&perf);
+
+    void* func;
+    EXPECT(PerfListenerTest_addFunc(rt, &func) == kErrorOk,
+      "JitRuntime::add() failed");
+
+    perf.reset();
+    rt.resetListener();
+
+    long size = PerfListenerTest_readFile(path, buf, sizeof(buf));
+    size_t expected = sizeof(PerfJitHeader) + sizeof(PerfJitRecord) +
+                      sizeof(PerfJitCodeLoad) * 2 + ::strlen("perf_test_func() -> i32") + ::strlen("perf_test_second") + 2;
+
+    EXPECT(size > static_cast<long>(expected),
+      "JitDump file is too small (%ld bytes)", size);
+
+    PerfJitHeader header;
+    ::memcpy(&header, buf, sizeof(header));
+    EXPECT(header.magic == kPerfJitMagic && header.pid == perfGetPid(),
+      "Invalid jitdump header");
+
+    PerfJitCodeLoad load;
+    ::memcpy(&load, buf + sizeof(header), sizeof(load));
+    EXPECT(load.record.id == kPerfJitCodeLoad && load.codeAddr == (uint64_t)(uintptr_t)func,
+      "Invalid jitdump code load record");
+  }
+  ::unlink(path);
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
@@ -0,0 +1,169 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_BASE_PERFLISTENER_H
+#define _ASMJIT_BASE_PERFLISTENER_H
+
+// [Dependencies]
+#include "../base/osutils.h"
+#include "../base/runtime.h"
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [Forward Declarations]
+// ============================================================================
+
+struct FuncSignature;
+class StringBuilder;
+
+//! \addtogroup asmjit_base
+//! \{
+
+// ============================================================================
+// [asmjit::PerfListener]
+// ============================================================================
+
+//! JIT listener that makes code added to \ref JitRuntime visible to Linux `perf`.
+//!
+//! Two output formats are supported:
+//!
+//!   - `kFormatPerfMap` - Writes `/tmp/perf-<pid>.map`, which `perf report`
+//!     reads to resolve symbols of samples in anonymous memory.
+//!
+//!   - `kFormatJitDump` - Writes `jit-<pid>.dump` in the jitdump format that
+//!     also contains code bytes, so `perf inject --jit` can annotate the code
+//!     even after it was released. The file is mapped as executable to make
+//!     `perf record` aware of it, and records are timestamped by the monotonic
+//!     clock, which requires `perf record -k mono`.
+//!
+//! Each bound global label that has a name becomes a symbol that spans up to
+//! the next one or up to the end of the code. Code without named labels is
+//! reported as `asmjit_<address>`. `formatSymbol()` can be used to create a
+//! label name that contains a function signature.
+//!
+//! `onCodeAdded()` only copies the record into a buffer, which is written to
+//! the file by a background thread every `flushIntervalMs` (or by `flush()`),
+//! so it doesn't slow `JitRuntime::add()` down by a file I/O.
+//!
+//! Usage:
+//!
+//! ~~~
+//! JitRuntime rt;
+//! PerfListener perf;
+//!
+//! if (perf.init(PerfListener::kFormatJitDump) == kErrorOk)
+//!   rt.setListener(&perf);
+//! ~~~
+//!
+//! NOTE: Only available on Linux, `init()` fails on other platforms.
+class ASMJIT_VIRTAPI PerfListener : public JitListener {
+public:
+  ASMJIT_NONCOPYABLE(PerfListener)
+
+  //! Output format.
+  ASMJIT_ENUM(Format) {
+    kFormatPerfMap = 0,                  //!< `/tmp/perf-<pid>.map` symbol map.
+    kFormatJitDump = 1                   //!< `jit-<pid>.dump` jitdump file.
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `PerfListener` instance.
+  ASMJIT_API PerfListener() noexcept;
+  //! Destroy the `PerfListener` instance, flushes and closes the file.
+  ASMJIT_API virtual ~PerfListener() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Init / Reset]
+  // --------------------------------------------------------------------------
+
+  //! Create the output file of `format` and start the writer thread.
+  //!
+  //! If `path` is null the file is `/tmp/perf-<pid>.map` or `/tmp/jit-<pid>.dump`
+  //! depending on `format`.
+  ASMJIT_API Error init(uint32_t format, const char* path = nullptr, uint32_t flushIntervalMs = 100) noexcept;
+  //! Stop the writer thread, flush all buffered records, and close the file.
+  ASMJIT_API void reset() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get whether the listener has been initialized.
+  ASMJIT_INLINE bool isInitialized() const noexcept { return _fd >= 0; }
+  //! Get the output format, see \ref Format.
+  ASMJIT_INLINE uint32_t getFormat() const noexcept { return _format; }
+  //! Get how many records have been written or buffered.
+  ASMJIT_INLINE size_t getRecordCount() const noexcept { return _recordCount; }
+
+  // --------------------------------------------------------------------------
+  // [Flush]
+  // --------------------------------------------------------------------------
+
+  //! Write all buffered records to the file.
+  ASMJIT_API Error flush() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Symbols]
+  // --------------------------------------------------------------------------
+
+  //! Format a symbol name like `name(i32, f64) -> i32` from `name` and `sign`.
+  //!
+  //! The result can be used as a name of a global label bound at the start of
+  //! the function, see \ref CodeEmitter::newNamedLabel().
+  ASMJIT_API static Error formatSymbol(StringBuilder& sb, const char* name, const FuncSignature& sign) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API virtual void onCodeAdded(const void* p, size_t size, const CodeHolder* code) noexcept override;
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  Lock _lock;                            //!< Lock that protects the buffer.
+  uint8_t* _buffer;                      //!< Buffered records.
+  size_t _length;                        //!< Length of buffered records.
+  size_t _capacity;                      //!< Capacity of `_buffer`.
+
+  Lock _writeLock;                       //!< Lock that serializes writes to the file.
+  uint8_t* _spare;                       //!< Buffer being written (swapped with `_buffer`).
+  size_t _spareCapacity;                 //!< Capacity of `_spare`.
+
+  int _fd;                               //!< File descriptor or -1.
+  uint32_t _format;                      //!< Output format.
+  void* _marker;                         //!< Executable mapping of the jitdump file.
+  size_t _markerSize;                    //!< Size of `_marker`.
+  uint64_t _codeIndex;                   //!< Index of the next jitdump code load record.
+  size_t _recordCount;                   //!< Number of records.
+
+  volatile bool _running;                //!< Writer thread is running.
+  volatile bool _stopRequested;          //!< Writer thread should stop.
+  uint32_t _flushIntervalMs;             //!< Interval of the writer thread.
+
+#if ASMJIT_OS_POSIX
+  pthread_t _thread;                     //!< Writer thread.
+#endif // ASMJIT_OS_POSIX
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // _ASMJIT_BASE_PERFLISTENER_H
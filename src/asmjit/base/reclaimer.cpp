@@ -0,0 +1,381 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Export]
+#define ASMJIT_EXPORTS
+
+// [Dependencies]
+#include "../base/reclaimer.h"
+#include "../base/runtime.h"
+
+#if ASMJIT_OS_POSIX
+# include <time.h>
+#endif // ASMJIT_OS_POSIX
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [asmjit::CodeReclaimer - Helpers]
+// ============================================================================
+
+typedef CodeReclaimer::Reader Reader;
+typedef CodeReclaimer::Retired Retired;
+
+//! \internal
+//!
+//! Full memory barrier.
+static ASMJIT_INLINE void reclaimerFullBarrier() noexcept {
+#if ASMJIT_CC_MSC
+  ::MemoryBarrier();
+#else
+  __sync_synchronize();
+#endif
+}
+
+//! \internal
+//!
+//! Push `item` to a lock-free stack at `pHead`.
+static ASMJIT_INLINE void reclaimerAtomicPush(Retired* volatile* pHead, Retired* item) noexcept {
+  for (;;) {
+    Retired* head = *pHead;
+    item->next = head;
+#if ASMJIT_CC_MSC
+    if (_InterlockedCompareExchangePointer((void* volatile*)pHead, item, head) == head)
+      break;
+#else
+    if (__sync_bool_compare_and_swap(pHead, head, item))
+      break;
+#endif
+  }
+}
+
+//! \internal
+//!
+//! Take all items from a lock-free stack at `pHead`.
+static ASMJIT_INLINE Retired* reclaimerAtomicTakeAll(Retired* volatile* pHead) noexcept {
+#if ASMJIT_CC_MSC
+  return static_cast<Retired*>(_InterlockedExchangePointer((void* volatile*)pHead, nullptr));
+#else
+  for (;;) {
+    Retired* head = *pHead;
+    if (__sync_bool_compare_and_swap(pHead, head, static_cast<Retired*>(nullptr)))
+      return head;
+  }
+#endif
+}
+
+//! \internal
+//!
+//! Release all items of the list `item` through `runtime`.
+static size_t reclaimerReleaseAll(Runtime* runtime, Retired* item) noexcept {
+  size_t count = 0;
+  while (item) {
+    Retired* next = item->next;
+    runtime->_release(item->p);
+    Internal::releaseMemory(item);
+
+    count++;
+    item = next;
+  }
+  return count;
+}
+
+//! \internal
+//!
+//! Sleep for `ms` milliseconds.
+static void reclaimerSleep(uint32_t ms) noexcept {
+#if ASMJIT_OS_WINDOWS
+  ::Sleep(ms);
+#else
+  struct timespec ts;
+  ts.tv_sec = static_cast<time_t>(ms / 1000);
+  ts.tv_nsec = static_cast<long>(ms % 1000) * 1000000;
+  ::nanosleep(&ts, nullptr);
+#endif // ASMJIT_OS_WINDOWS
+}
+
+// ============================================================================
+// [asmjit::CodeReclaimer - Construction / Destruction]
+// ============================================================================
+
+CodeReclaimer::CodeReclaimer(Runtime* runtime) noexcept
+  : _runtime(runtime),
+    _epoch(1),
+    _retired(nullptr),
+    _pending(nullptr),
+    _readers(nullptr),
+    _running(false),
+    _stopRequested(false),
+    _intervalMs(0) {}
+
+CodeReclaimer::~CodeReclaimer() noexcept {
+  stop();
+
+  reclaimerReleaseAll(_runtime, _pending);
+  reclaimerReleaseAll(_runtime, reclaimerAtomicTakeAll(&_retired));
+
+  Reader* reader = _readers;
+  while (reader) {
+    Reader* next = reader->_next;
+    Internal::releaseMemory(reader);
+    reader = next;
+  }
+}
+
+// ============================================================================
+// [asmjit::CodeReclaimer - Readers]
+// ============================================================================
+
+Reader* CodeReclaimer::attachReader() noexcept {
+  Reader* reader = static_cast<Reader*>(Internal::allocMemory(sizeof(Reader)));
+  if (ASMJIT_UNLIKELY(!reader)) return nullptr;
+
+  reader->_reclaimer = this;
+  reader->_epoch = _epoch;
+
+  AutoLock locked(_readersLock);
+  reader->_next = _readers;
+  _readers = reader;
+  return reader;
+}
+
+void CodeReclaimer::detachReader(Reader* reader) noexcept {
+  if (!reader) return;
+
+  {
+    AutoLock locked(_readersLock);
+    Reader** pPrev = &_readers;
+
+    while (*pPrev != reader) {
+      ASMJIT_ASSERT(*pPrev != nullptr);
+      pPrev = &(*pPrev)->_next;
+    }
+    *pPrev = reader->_next;
+  }
+
+  Internal::releaseMemory(reader);
+}
+
+// ============================================================================
+// [asmjit::CodeReclaimer - Retire / Reclaim]
+// ============================================================================
+
+Error CodeReclaimer::_retire(void* p) noexcept {
+  if (!p) return kErrorOk;
+
+  Retired* item = static_cast<Retired*>(Internal::allocMemory(sizeof(Retired)));
+  if (ASMJIT_UNLIKELY(!item))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  // The code must have been unpublished before it's retired, the barrier makes
+  // sure that a reader that observes the new epoch can't observe the old code.
+  reclaimerFullBarrier();
+
+  item->p = p;
+  item->epoch = _epoch;
+  reclaimerAtomicPush(&_retired, item);
+  return kErrorOk;
+}
+
+size_t CodeReclaimer::reclaim() noexcept {
+  AutoLock sweepLocked(_sweepLock);
+
+  // Move newly retired code to the pending list, which is only accessed here.
+  Retired* item = reclaimerAtomicTakeAll(&_retired);
+  if (item) {
+    Retired* last = item;
+    while (last->next)
+      last = last->next;
+    last->next = _pending;
+    _pending = item;
+  }
+
+  if (!_pending)
+    return 0;
+
+  // Advance the epoch - readers that observe it have passed a quiescent state
+  // after everything in `_pending` was retired.
+  reclaimerFullBarrier();
+  _epoch = _epoch + 1;
+  reclaimerFullBarrier();
+
+  uintptr_t minEpoch = kEpochOffline;
+  {
+    AutoLock readersLocked(_readersLock);
+    for (Reader* reader = _readers; reader; reader = reader->_next) {
+      uintptr_t epoch = reader->_epoch;
+      if (epoch < minEpoch)
+        minEpoch = epoch;
+    }
+  }
+  reclaimerFullBarrier();
+
+  // Release everything retired before the oldest epoch announced by readers.
+  Retired* released = nullptr;
+  Retired** pPrev = &_pending;
+
+  while ((item = *pPrev) != nullptr) {
+    if (item->epoch < minEpoch) {
+      *pPrev = item->next;
+      item->next = released;
+      released = item;
+    }
+    else {
+      pPrev = &item->next;
+    }
+  }
+
+  return reclaimerReleaseAll(_runtime, released);
+}
+
+// ============================================================================
+// [asmjit::CodeReclaimer - Background Sweeper]
+// ============================================================================
+
+//! \internal
+//!
+//! Granularity of checking whether the background sweeper should stop.
+static const uint32_t kReclaimerSleepSlice = 10;
+
+static void reclaimerSweeperRun(CodeReclaimer* self) noexcept {
+  while (!self->_stopRequested) {
+    self->reclaim();
+
+    uint32_t remaining = self->_intervalMs;
+    while (remaining && !self->_stopRequested) {
+      uint32_t slice = remaining < kReclaimerSleepSlice ? remaining : kReclaimerSleepSlice;
+      reclaimerSleep(slice);
+      remaining -= slice;
+    }
+  }
+}
+
+#if ASMJIT_OS_WINDOWS
+static DWORD WINAPI reclaimerSweeperEntry(LPVOID arg) {
+  reclaimerSweeperRun(static_cast<CodeReclaimer*>(arg));
+  return 0;
+}
+#else
+static void* reclaimerSweeperEntry(void* arg) {
+  reclaimerSweeperRun(static_cast<CodeReclaimer*>(arg));
+  return nullptr;
+}
+#endif // ASMJIT_OS_WINDOWS
+
+Error CodeReclaimer::start(uint32_t intervalMs) noexcept {
+  if (_running)
+    return DebugUtils::errored(kErrorInvalidState);
+
+  _intervalMs = intervalMs;
+  _stopRequested = false;
+
+#if ASMJIT_OS_WINDOWS
+  _thread = ::CreateThread(nullptr, 0, reclaimerSweeperEntry, this, 0, nullptr);
+  if (!_thread)
+    return DebugUtils::errored(kErrorInvalidState);
+#else
+  if (::pthread_create(&_thread, nullptr, reclaimerSweeperEntry, this) != 0)
+    return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_WINDOWS
+
+  _running = true;
+  return kErrorOk;
+}
+
+void CodeReclaimer::stop() noexcept {
+  if (!_running)
+    return;
+
+  _stopRequested = true;
+
+#if ASMJIT_OS_WINDOWS
+  ::WaitForSingleObject(_thread, INFINITE);
+  ::CloseHandle(_thread);
+#else
+  ::pthread_join(_thread, nullptr);
+#endif // ASMJIT_OS_WINDOWS
+
+  _running = false;
+}
+
+// ============================================================================
+// [asmjit::CodeReclaimer - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(base_reclaimer) {
+  JitRuntime rt;
+  VMemMgr* mgr = rt.getMemMgr();
+
+  CodeReclaimer reclaimer(&rt);
+  CodeReclaimer::Reader* reader = reclaimer.attachReader();
+  EXPECT(reader != nullptr,
+    "Couldn't attach a reader");
+
+  void* p = mgr->alloc(64);
+  EXPECT(p != nullptr,
+    "Couldn't allocate virtual memory");
+  size_t used = mgr->getUsedBytes();
+
+  INFO("Retired code must not be released before the reader is quiescent");
+  EXPECT(reclaimer.retire(p) == kErrorOk,
+    "CodeReclaimer::retire() failed");
+  EXPECT(reclaimer.reclaim() == 0,
+    "Code released while a reader could still execute it");
+  EXPECT(reclaimer.reclaim() == 0,
+    "Code released while a reader could still execute it");
+  EXPECT(mgr->getUsedBytes() == used,
+    "Code released while a reader could still execute it");
+
+  INFO("Retired code must be released after the reader is quiescent");
+  reader->quiescent();
+  EXPECT(reclaimer.reclaim() == 1,
+    "Code not released after the reader has been quiescent");
+  EXPECT(mgr->getUsedBytes() == used - 64,
+    "Code not released after the reader has been quiescent");
+
+  INFO("Offline readers must not block reclamation");
+  p = mgr->alloc(64);
+  EXPECT(reclaimer.retire(p) == kErrorOk,
+    "CodeReclaimer::retire() failed");
+  reader->offline();
+  EXPECT(reclaimer.reclaim() == 1,
+    "Code not released while the reader was offline");
+  reader->online();
+
+  INFO("Background sweeper must release retired code");
+  EXPECT(reclaimer.start(1) == kErrorOk,
+    "CodeReclaimer::start() failed");
+
+  for (uint32_t i = 0; i < 100; i++) {
+    p = mgr->alloc(64);
+    EXPECT(reclaimer.retire(p) == kErrorOk,
+      "CodeReclaimer::retire() failed");
+    reader->quiescent();
+  }
+
+  for (uint32_t i = 0; i < 1000 && mgr->getUsedBytes() != used - 64; i++) {
+    reader->quiescent();
+    reclaimerSleep(1);
+  }
+
+  reclaimer.stop();
+  EXPECT(!reclaimer.isRunning(),
+    "CodeReclaimer::stop() failed");
+  EXPECT(mgr->getUsedBytes() == used - 64,
+    "Background sweeper didn't release retired code");
+
+  reclaimer.detachReader(reader);
+}
+#endif // ASMJIT_TEST
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
@@ -0,0 +1,218 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Guard]
+#ifndef _ASMJIT_BASE_RECLAIMER_H
+#define _ASMJIT_BASE_RECLAIMER_H
+
+// [Dependencies]
+#include "../base/globals.h"
+#include "../base/osutils.h"
+
+#if ASMJIT_CC_MSC
+# include <intrin.h>
+#endif // ASMJIT_CC_MSC
+
+// [Api-Begin]
+#include "../asmjit_apibegin.h"
+
+namespace asmjit {
+
+// ============================================================================
+// [Forward Declarations]
+// ============================================================================
+
+class Runtime;
+
+//! \addtogroup asmjit_base
+//! \{
+
+// ============================================================================
+// [asmjit::CodeReclaimer]
+// ============================================================================
+
+//! Epoch-based reclamation of code that other threads may still execute.
+//!
+//! Code that was replaced by a newer version can't be released while other
+//! threads may still run it. Instead of releasing it, the code is passed to
+//! `retire()` and released later by `reclaim()`, once all reader threads have
+//! announced a quiescent state - a point at which they don't execute and don't
+//! hold any pointer to retired code.
+//!
+//! Each thread that executes code managed by the reclaimer attaches a `Reader`
+//! and calls `Reader::quiescent()` periodically (for example between requests
+//! it processes). Neither `retire()` nor `Reader::quiescent()` take any lock,
+//! `reclaim()` can be called by any thread or by a background sweeper started
+//! by `start()`.
+//!
+//! Usage:
+//!
+//! ~~~
+//! JitRuntime rt;
+//! CodeReclaimer reclaimer(&rt);
+//! reclaimer.start(10);
+//!
+//! // Reader thread.
+//! CodeReclaimer::Reader* reader = reclaimer.attachReader();
+//! for (;;) {
+//!   currentFunc();
+//!   reader->quiescent();
+//! }
+//! reclaimer.detachReader(reader);
+//!
+//! // Writer thread - swap the function and retire the old one.
+//! Func oldFunc = currentFunc;
+//! currentFunc = newFunc;
+//! reclaimer.retire(oldFunc);
+//! ~~~
+class CodeReclaimer {
+public:
+  ASMJIT_NONCOPYABLE(CodeReclaimer)
+
+  //! Epoch of a reader that is offline.
+  static const uintptr_t kEpochOffline = ~static_cast<uintptr_t>(0);
+
+  //! State of a thread that executes code managed by `CodeReclaimer`.
+  struct Reader {
+    //! Announce a quiescent state.
+    //!
+    //! The thread must not execute or hold a pointer to any code that was
+    //! retired before this call.
+    ASMJIT_INLINE void quiescent() noexcept { _storeRelease(&_epoch, _reclaimer->_epoch); }
+
+    //! Make the reader offline, for example before the thread blocks.
+    //!
+    //! An offline reader doesn't block reclamation, but it must not execute
+    //! or hold a pointer to any retired code until it's back online.
+    ASMJIT_INLINE void offline() noexcept { _storeRelease(&_epoch, kEpochOffline); }
+    //! Make the reader online again.
+    ASMJIT_INLINE void online() noexcept { quiescent(); }
+
+    //! \internal
+    static ASMJIT_INLINE void _storeRelease(volatile uintptr_t* p, uintptr_t value) noexcept {
+#if ASMJIT_CC_MSC
+      _ReadWriteBarrier();
+      *p = value;
+#elif ASMJIT_CC_GCC_GE(4, 7, 0) || ASMJIT_CC_CLANG
+      __atomic_store_n(p, value, __ATOMIC_RELEASE);
+#else
+      __sync_synchronize();
+      *p = value;
+#endif
+    }
+
+    CodeReclaimer* _reclaimer;           //!< Reclaimer the reader is attached to.
+    Reader* _next;                       //!< Next reader.
+    volatile uintptr_t _epoch;           //!< Epoch observed by the last quiescent state.
+  };
+
+  //! \internal
+  //!
+  //! Code that was retired, but not released yet.
+  struct Retired {
+    Retired* next;                       //!< Next retired item.
+    void* p;                             //!< Code to release.
+    uintptr_t epoch;                     //!< Epoch at which the code was retired.
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a `CodeReclaimer` that releases code through `runtime`.
+  ASMJIT_API CodeReclaimer(Runtime* runtime) noexcept;
+  //! Destroy the `CodeReclaimer`.
+  //!
+  //! Stops the background sweeper and releases all retired code, even if it
+  //! has not been reclaimed yet - no reader can execute it at this point.
+  ASMJIT_API ~CodeReclaimer() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get the runtime the reclaimer releases code through.
+  ASMJIT_INLINE Runtime* getRuntime() const noexcept { return _runtime; }
+  //! Get the current epoch.
+  ASMJIT_INLINE uintptr_t getEpoch() const noexcept { return _epoch; }
+  //! Get whether the background sweeper is running.
+  ASMJIT_INLINE bool isRunning() const noexcept { return _running; }
+
+  // --------------------------------------------------------------------------
+  // [Readers]
+  // --------------------------------------------------------------------------
+
+  //! Attach a new reader, called by a thread that will execute code.
+  //!
+  //! Returns null if out of memory.
+  ASMJIT_API Reader* attachReader() noexcept;
+  //! Detach a reader previously returned by `attachReader()`.
+  ASMJIT_API void detachReader(Reader* reader) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Retire / Reclaim]
+  // --------------------------------------------------------------------------
+
+  //! Retire code `p` previously added to the runtime.
+  //!
+  //! The code is released when no reader can execute it anymore.
+  template<typename Func>
+  ASMJIT_INLINE Error retire(Func p) noexcept {
+    return _retire(Internal::ptr_cast<void*, Func>(p));
+  }
+
+  //! \internal
+  ASMJIT_API Error _retire(void* p) noexcept;
+
+  //! Advance the epoch and release all retired code that no reader can
+  //! execute anymore.
+  //!
+  //! Returns the number of functions released.
+  ASMJIT_API size_t reclaim() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Background Sweeper]
+  // --------------------------------------------------------------------------
+
+  //! Start a background thread that calls `reclaim()` every `intervalMs`.
+  ASMJIT_API Error start(uint32_t intervalMs) noexcept;
+  //! Stop the background thread started by `start()`.
+  ASMJIT_API void stop() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  Runtime* _runtime;                     //!< Runtime used to release the code.
+  volatile uintptr_t _epoch;             //!< Global epoch.
+
+  Retired* volatile _retired;            //!< Retired code (lock-free stack).
+  Retired* _pending;                     //!< Retired code waiting for readers (sweeper only).
+
+  Lock _readersLock;                     //!< Lock that protects `_readers`.
+  Reader* _readers;                      //!< Attached readers.
+  Lock _sweepLock;                       //!< Lock that serializes `reclaim()`.
+
+  volatile bool _running;                //!< Background sweeper is running.
+  volatile bool _stopRequested;          //!< Background sweeper should stop.
+  uint32_t _intervalMs;                  //!< Interval of the background sweeper.
+
+#if ASMJIT_OS_WINDOWS
+  HANDLE _thread;                        //!< Background sweeper thread.
+#else
+  pthread_t _thread;                     //!< Background sweeper thread.
+#endif // ASMJIT_OS_WINDOWS
+};
+
+//! \}
+
+} // asmjit namespace
+
+// [Api-End]
+#include "../asmjit_apiend.h"
+
+// [Guard]
+#endif // _ASMJIT_BASE_RECLAIMER_H
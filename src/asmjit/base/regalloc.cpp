@@ -37,6 +37,7 @@ Error RAPass::process(Zone* zone) noexcept {
   _zone = zone;
   _heap.reset(zone);
   _emitComments = (cb()->getGlobalOptions() & CodeEmitter::kOptionLoggingEnabled) != 0;
+  _livenessMode = static_cast<uint8_t>(cc()->getLivenessMode());
 
   Error err = kErrorOk;
   CBNode* node = cc()->getFirstNode();
@@ -57,6 +58,11 @@ Error RAPass::process(Zone* zone) noexcept {
     } while (node && node->getType() != CBNode::kNodeFunc);
   } while (node);
 
+  // Account dynamic blocks of `_heap`, its slots are accounted by `zone`.
+  ZoneStats heapStats;
+  _heap.getStats(&heapStats);
+  _zoneStats.add(heapStats);
+
   _heap.reset(nullptr);
   _zone = nullptr;
   return err;
@@ -347,6 +353,155 @@ Error RAPass::removeUnreachableCode() {
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::RAPass - Live Sets]
+// ============================================================================
+
+static ASMJIT_INLINE size_t RAPass_sparseLiveSetSize(size_t capacity) noexcept {
+  return RALiveSet::kHeaderSize + capacity * sizeof(uint32_t);
+}
+
+//! \internal
+//!
+//! Allocate a sparse live set that can hold at least `count` ids.
+static RALiveSet* RAPass_allocSparseLiveSet(ZoneHeap* heap, size_t count) noexcept {
+  size_t capacity = Utils::alignTo<size_t>(count ? count : 1, 8);
+  RALiveSet* set = static_cast<RALiveSet*>(heap->alloc(RAPass_sparseLiveSetSize(capacity)));
+
+  if (ASMJIT_UNLIKELY(!set))
+    return nullptr;
+
+  set->type = RALiveSet::kTypeSparse;
+  set->length = 0;
+  set->capacity = static_cast<uint32_t>(capacity);
+  set->reserved = 0;
+  return set;
+}
+
+//! \internal
+//!
+//! Allocate a dense live set of `bLen` words, all bits are cleared.
+static RALiveSet* RAPass_allocDenseLiveSet(Zone* zone, uint32_t bLen) noexcept {
+  RALiveSet* set = static_cast<RALiveSet*>(
+    zone->allocZeroed(RALiveSet::kHeaderSize + static_cast<size_t>(bLen) * RABits::kEntitySize));
+
+  if (ASMJIT_UNLIKELY(!set))
+    return nullptr;
+
+  set->type = RALiveSet::kTypeDense;
+  set->length = bLen;
+  set->capacity = bLen;
+  return set;
+}
+
+RALiveSet* RAPass::newLiveSet(const RABits* bits, uint32_t bLen) {
+  size_t count = BitOps::popcount(bits->data, bLen);
+
+  if (!shouldBeSparse(count, bLen)) {
+    RALiveSet* set = RAPass_allocDenseLiveSet(_zone, bLen);
+    if (ASMJIT_UNLIKELY(!set)) return nullptr;
+
+    set->getBits()->copyBits(bits, bLen);
+    return set;
+  }
+
+  RALiveSet* set = RAPass_allocSparseLiveSet(&_heap, count);
+  if (ASMJIT_UNLIKELY(!set)) return nullptr;
+
+  uint32_t* ids = set->getIds();
+  uint32_t n = 0;
+
+  for (uint32_t i = 0; i < bLen; i++) {
+    uintptr_t word = bits->data[i];
+    while (word) {
+      ids[n++] = i * RABits::kEntityBits + BitOps::_findFirstBitWord(word);
+      word &= word - 1;
+    }
+  }
+
+  set->length = n;
+  return set;
+}
+
+Error RAPass::mergeLiveSet(RALiveSet** pSet, RABits* bits, uint32_t bLen, bool& changed) {
+  RALiveSet* set = *pSet;
+
+  if (set->isDense()) {
+    changed = set->getBits()->_addBitsDelSource(bits, bLen);
+    return kErrorOk;
+  }
+
+  // Clear bits that are already in the set, the remaining ones are new.
+  uint32_t* ids = set->getIds();
+  uint32_t n = set->length;
+
+  for (uint32_t i = 0; i < n; i++)
+    bits->delBit(ids[i]);
+
+  size_t count = BitOps::popcount(bits->data, bLen);
+  changed = count != 0;
+
+  if (!count)
+    return kErrorOk;
+
+  size_t total = n + count;
+  if (!shouldBeSparse(total, bLen)) {
+    // Too many registers are live, convert to a dense set.
+    RALiveSet* dense = RAPass_allocDenseLiveSet(_zone, bLen);
+    if (ASMJIT_UNLIKELY(!dense))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    RABits* denseBits = dense->getBits();
+    for (uint32_t i = 0; i < n; i++)
+      denseBits->setBit(ids[i]);
+    denseBits->addBits(bits, bLen);
+
+    _heap.release(set, RAPass_sparseLiveSetSize(set->capacity));
+    *pSet = dense;
+    return kErrorOk;
+  }
+
+  if (total > set->capacity) {
+    RALiveSet* grown = RAPass_allocSparseLiveSet(&_heap, total + total / 2);
+    if (ASMJIT_UNLIKELY(!grown))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    ::memcpy(grown->getIds(), ids, n * sizeof(uint32_t));
+    _heap.release(set, RAPass_sparseLiveSetSize(set->capacity));
+
+    set = grown;
+    ids = set->getIds();
+    *pSet = set;
+  }
+
+  // Move existing ids to the end of the set and merge them with new ids from
+  // the beginning. The merge never overwrites ids that weren't read yet.
+  uint32_t* oldIds = ids + set->capacity - n;
+  ::memmove(oldIds, ids, n * sizeof(uint32_t));
+
+  uint32_t oldIndex = 0;
+  uint32_t dstIndex = 0;
+
+  for (uint32_t i = 0; i < bLen; i++) {
+    uintptr_t word = bits->data[i];
+    while (word) {
+      uint32_t id = i * RABits::kEntityBits + BitOps::_findFirstBitWord(word);
+      word &= word - 1;
+
+      while (oldIndex < n && oldIds[oldIndex] < id)
+        ids[dstIndex++] = oldIds[oldIndex++];
+      ids[dstIndex++] = id;
+    }
+  }
+
+  while (oldIndex < n)
+    ids[dstIndex++] = oldIds[oldIndex++];
+
+  ASMJIT_ASSERT(dstIndex == total);
+  set->length = static_cast<uint32_t>(total);
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::RAPass - Liveness Analysis]
 // ============================================================================
@@ -387,38 +542,31 @@ Visit:
   for (;;) {
     wd = node->getPassData<RAData>();
     if (wd->liveness) {
-      if (bCur->_addBitsDelSource(wd->liveness, bCur, bLen))
+      if (wd->liveness->delFrom(bCur, bLen))
         goto Patch;
       else
         goto Done;
     }
 
-    RABits* bTmp = copyBits(bCur, bLen);
-    if (!bTmp) goto NoMem;
-
-    wd = node->getPassData<RAData>();
-    wd->liveness = bTmp;
-
     uint32_t tiedTotal = wd->tiedTotal;
     TiedReg* tiedArray = reinterpret_cast<TiedReg*>(((uint8_t*)wd) + varMapToVaListOffset);
 
-    for (uint32_t i = 0; i < tiedTotal; i++) {
-      TiedReg* tied = &tiedArray[i];
-      VirtReg* vreg = tied->vreg;
+    // All registers used by the node are live at the node.
+    uint32_t i;
+    for (i = 0; i < tiedTotal; i++)
+      bCur->setBit(tiedArray[i].vreg->_raId);
+
+    RALiveSet* liveness = newLiveSet(bCur, bLen);
+    if (!liveness) goto NoMem;
+    wd->liveness = liveness;
 
+    // Write-Only registers are not live before the node.
+    for (i = 0; i < tiedTotal; i++) {
+      TiedReg* tied = &tiedArray[i];
       uint32_t flags = tied->flags;
-      uint32_t raId = vreg->_raId;
 
-      if ((flags & TiedReg::kWAll) && !(flags & TiedReg::kRAll)) {
-        // Write-Only.
-        bTmp->setBit(raId);
-        bCur->delBit(raId);
-      }
-      else {
-        // Read-Only or Read/Write.
-        bTmp->setBit(raId);
-        bCur->setBit(raId);
-      }
+      if ((flags & TiedReg::kWAll) && !(flags & TiedReg::kRAll))
+        bCur->delBit(tied->vreg->_raId);
     }
 
     if (node->getType() == CBNode::kNodeLabel)
@@ -437,8 +585,9 @@ Patch:
     ASMJIT_ASSERT(node->hasPassData());
     ASMJIT_ASSERT(node->getPassData<RAData>()->liveness != nullptr);
 
-    RABits* bNode = node->getPassData<RAData>()->liveness;
-    if (!bNode->_addBitsDelSource(bCur, bLen)) goto Done;
+    bool changed;
+    if (mergeLiveSet(&node->getPassData<RAData>()->liveness, bCur, bLen, changed) != kErrorOk) goto NoMem;
+    if (!changed) goto Done;
     if (node->getType() == CBNode::kNodeLabel) goto Target;
 
     if (node == func) goto Done;
@@ -477,7 +626,7 @@ Target:
     // Visit/Patch.
     do {
       ltCur->from = from;
-      bCur->copyBits(node->getPassData<RAData>()->liveness, bLen);
+      node->getPassData<RAData>()->liveness->copyTo(bCur, bLen);
 
       if (!from->getPassData<RAData>()->liveness) {
         node = from;
@@ -487,7 +636,7 @@ Target:
       // Issue #25: Moved 'JumpNext' here since it's important to patch
       // code again if there are more live variables than before.
 JumpNext:
-      if (bCur->delBits(from->getPassData<RAData>()->liveness, bLen)) {
+      if (from->getPassData<RAData>()->liveness->delFrom(bCur, bLen)) {
         node = from;
         goto Patch;
       }
@@ -504,13 +653,13 @@ JumpNext:
     }
   }
 
-  bCur->copyBits(node->getPassData<RAData>()->liveness, bLen);
+  node->getPassData<RAData>()->liveness->copyTo(bCur, bLen);
   node = node->getPrev();
   if (node->isJmp() || !node->hasPassData()) goto Done;
 
   wd = node->getPassData<RAData>();
   if (!wd->liveness) goto Visit;
-  if (bCur->delBits(wd->liveness, bLen)) goto Patch;
+  if (wd->liveness->delFrom(bCur, bLen)) goto Patch;
 
 Done:
   if (ltCur) {
@@ -553,7 +702,7 @@ Error RAPass::formatInlineComment(StringBuilder& dst, CBNode* node) {
     dst.appendChar('[');
     dst.appendChars(' ', vdCount);
     dst.appendChar(']');
-    RABits* liveness = wd->liveness;
+    RALiveSet* liveness = wd->liveness;
 
     uint32_t i;
     for (i = 0; i < vdCount; i++) {
@@ -12,6 +12,7 @@
 #if !defined(ASMJIT_DISABLE_COMPILER)
 
 // [Dependencies]
+#include "../base/bitops.h"
 #include "../base/codecompiler.h"
 #include "../base/zone.h"
 
@@ -198,13 +199,7 @@ struct RABits {
 
   //! Copy bits from `s0`, returns `true` if at least one bit is set in `s0`.
   ASMJIT_INLINE bool copyBits(const RABits* s0, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::copy(data, s0->data, len) != 0;
   }
 
   ASMJIT_INLINE bool addBits(const RABits* s0, uint32_t len) noexcept {
@@ -212,13 +207,7 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool addBits(const RABits* s0, const RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i] | s1->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::or_(data, s0->data, s1->data, len) != 0;
   }
 
   ASMJIT_INLINE bool andBits(const RABits* s1, uint32_t len) noexcept {
@@ -226,13 +215,7 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool andBits(const RABits* s0, const RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i] & s1->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::and_(data, s0->data, s1->data, len) != 0;
   }
 
   ASMJIT_INLINE bool delBits(const RABits* s1, uint32_t len) noexcept {
@@ -240,13 +223,7 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool delBits(const RABits* s0, const RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t t = s0->data[i] & ~s1->data[i];
-      data[i] = t;
-      r |= t;
-    }
-    return r != 0;
+    return BitOps::andNot(data, s0->data, s1->data, len) != 0;
   }
 
   ASMJIT_INLINE bool _addBitsDelSource(RABits* s1, uint32_t len) noexcept {
@@ -254,25 +231,119 @@ struct RABits {
   }
 
   ASMJIT_INLINE bool _addBitsDelSource(const RABits* s0, RABits* s1, uint32_t len) noexcept {
-    uintptr_t r = 0;
-    for (uint32_t i = 0; i < len; i++) {
-      uintptr_t a = s0->data[i];
-      uintptr_t b = s1->data[i];
+    return BitOps::orAndNotSrc(data, s0->data, s1->data, len) != 0;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  uintptr_t data[1];
+};
+
+// ============================================================================
+// [asmjit::RALiveSet]
+// ============================================================================
+
+//! Registers live at a node (populated by liveness-analysis).
+//!
+//! The set is either dense, storing `RABits` of all registers of the function,
+//! or sparse, storing a sorted array of ids of live registers. Sparse sets are
+//! used by large functions where only a small portion of registers is live at
+//! each node, as their size is proportional to the number of live registers.
+struct RALiveSet {
+  // --------------------------------------------------------------------------
+  // [Enums]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_ENUM(Type) {
+    kTypeDense = 0,                      //!< Bit-array, see \ref RABits.
+    kTypeSparse = 1                      //!< Sorted array of register ids.
+  };
+
+  enum {
+    //! Size of the header that precedes `data`.
+    kHeaderSize = static_cast<int>(sizeof(uint32_t) * 4),
+    //! Minimum number of words of a function that uses sparse sets (in auto mode).
+    kMinSparseWords = 8
+  };
 
-      this->data[i] = a | b;
-      b &= ~a;
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_INLINE bool isDense() const noexcept { return type == kTypeDense; }
+  ASMJIT_INLINE bool isSparse() const noexcept { return type == kTypeSparse; }
 
-      s1->data[i] = b;
-      r |= b;
+  ASMJIT_INLINE RABits* getBits() noexcept { return reinterpret_cast<RABits*>(data); }
+  ASMJIT_INLINE const RABits* getBits() const noexcept { return reinterpret_cast<const RABits*>(data); }
+
+  ASMJIT_INLINE uint32_t* getIds() noexcept { return reinterpret_cast<uint32_t*>(data); }
+  ASMJIT_INLINE const uint32_t* getIds() const noexcept { return reinterpret_cast<const uint32_t*>(data); }
+
+  //! Get whether the register `index` is live.
+  ASMJIT_INLINE uintptr_t getBit(uint32_t index) const noexcept {
+    if (isDense())
+      return getBits()->getBit(index);
+
+    // Binary search.
+    const uint32_t* ids = getIds();
+    uint32_t lo = 0;
+    uint32_t hi = length;
+
+    while (lo < hi) {
+      uint32_t mid = (lo + hi) / 2;
+      if (ids[mid] < index)
+        lo = mid + 1;
+      else
+        hi = mid;
     }
-    return r != 0;
+
+    return lo < length && ids[lo] == index;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  //! Copy registers to `dst` (`bLen` words), which is overwritten.
+  ASMJIT_INLINE void copyTo(RABits* dst, uint32_t bLen) const noexcept {
+    if (isDense()) {
+      dst->copyBits(getBits(), bLen);
+      return;
+    }
+
+    BitOps::fill(dst->data, 0, bLen);
+    const uint32_t* ids = getIds();
+    for (uint32_t i = 0; i < length; i++)
+      dst->setBit(ids[i]);
+  }
+
+  //! Remove registers from `dst` (`bLen` words), returns `true` if at least
+  //! one bit is still set in `dst`.
+  ASMJIT_INLINE bool delFrom(RABits* dst, uint32_t bLen) const noexcept {
+    if (isDense())
+      return dst->delBits(getBits(), bLen);
+
+    const uint32_t* ids = getIds();
+    for (uint32_t i = 0; i < length; i++)
+      dst->delBit(ids[i]);
+
+    for (uint32_t i = 0; i < bLen; i++)
+      if (dst->data[i])
+        return true;
+    return false;
   }
 
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
 
-  uintptr_t data[1];
+  uint32_t type;                         //!< Type of the set, see \ref Type.
+  uint32_t length;                       //!< Number of ids (sparse) or words (dense).
+  uint32_t capacity;                     //!< Capacity of ids (sparse) or words (dense).
+  uint32_t reserved;                     //!< Reserved for future use (alignment).
+  uintptr_t data[1];                     //!< Bits or ids.
 };
 
 // ============================================================================
@@ -298,7 +369,7 @@ struct RAData {
       state(nullptr),
       tiedTotal(tiedTotal) {}
 
-  RABits* liveness;                      //!< Liveness bits (populated by liveness-analysis).
+  RALiveSet* liveness;                   //!< Live registers (populated by liveness-analysis).
   RAState* state;                        //!< Optional saved \ref RAState.
   uint32_t tiedTotal;                    //!< Total count of \ref TiedReg regs.
 };
@@ -424,6 +495,27 @@ public:
       _zone->dup(src, static_cast<size_t>(len) * RABits::kEntitySize));
   }
 
+  //! Get whether a set of `count` registers should be sparse in a function
+  //! that needs `bLen` words to store all of them.
+  ASMJIT_INLINE bool shouldBeSparse(size_t count, uint32_t bLen) const noexcept {
+    if (_livenessMode == CodeCompiler::kLivenessDense) return false;
+    if (_livenessMode == CodeCompiler::kLivenessSparse) return true;
+
+    // Sparse sets must be at most half the size of dense ones, so a set that
+    // grows doesn't flip between both forms, and it doesn't pay off to make
+    // sets of small functions sparse at all.
+    return bLen >= RALiveSet::kMinSparseWords &&
+           count * sizeof(uint32_t) * 2 <= static_cast<size_t>(bLen) * RABits::kEntitySize;
+  }
+
+  //! Create a new live set from `bits`.
+  RALiveSet* newLiveSet(const RABits* bits, uint32_t bLen);
+
+  //! Merge `bits` to the live set at `pSet`, which can be reallocated, and
+  //! clear bits that were already in the set. Sets `changed` to `true` if any
+  //! bit that was not in the set remains in `bits`.
+  Error mergeLiveSet(RALiveSet** pSet, RABits* bits, uint32_t bLen, bool& changed);
+
   // --------------------------------------------------------------------------
   // [Fetch]
   // --------------------------------------------------------------------------
@@ -529,6 +621,7 @@ public:
   uint32_t _varMapToVaListOffset;
 
   uint8_t _emitComments;                 //!< Whether to emit comments.
+  uint8_t _livenessMode;                 //!< Representation of liveness, see \ref CodeCompiler::LivenessMode.
 
   ZoneList<CBNode*> _unreachableList;     //!< Unreachable nodes.
   ZoneList<CBNode*> _returningList;       //!< Returning nodes.
@@ -12,6 +12,10 @@
 #include "../base/cpuinfo.h"
 #include "../base/runtime.h"
 
+#if defined(ASMJIT_TEST) && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+# include "../x86/x86assembler.h"
+#endif // ASMJIT_TEST
+
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
 
@@ -96,17 +100,98 @@ void HostRuntime::flush(const void* p, size_t size) noexcept {
   hostFlushInstructionCache(p, size);
 }
 
+// ============================================================================
+// [asmjit::JitListener - Construction / Destruction]
+// ============================================================================
+
+JitListener::JitListener() noexcept {}
+JitListener::~JitListener() noexcept {}
+
+// ============================================================================
+// [asmjit::JitListener - Interface]
+// ============================================================================
+
+void JitListener::onCodeReleased(const void* p) noexcept {
+  ASMJIT_UNUSED(p);
+}
+
 // ============================================================================
 // [asmjit::JitRuntime - Construction / Destruction]
 // ============================================================================
 
-JitRuntime::JitRuntime() noexcept {}
+JitRuntime::JitRuntime() noexcept
+  : _listener(nullptr),
+    _groupCount(0),
+    _groupZone(4096 - Zone::kZoneOverhead),
+    _groupHeap(&_groupZone),
+    _groups(&_groupHeap) {}
 JitRuntime::~JitRuntime() noexcept {}
 
 // ============================================================================
 // [asmjit::JitRuntime - Interface]
 // ============================================================================
 
+namespace {
+
+//! \internal
+//!
+//! Only used to lookup an entry from `_groups`.
+class GroupByAddress {
+public:
+  ASMJIT_INLINE GroupByAddress(uintptr_t address) noexcept
+    : address(address),
+      hVal(static_cast<uint32_t>(static_cast<uint64_t>(address) ^ (static_cast<uint64_t>(address) >> 32))) {}
+
+  ASMJIT_INLINE bool matches(const JitRuntime::GroupEntry* entry) const noexcept {
+    return entry->_address == address;
+  }
+
+  uintptr_t address;
+  uint32_t hVal;
+};
+
+} // anonymous namespace
+
+// Remove `count` entries of a group starting at `entries` from `_groups`.
+static void JitRuntime_deleteGroup(JitRuntime* self, JitRuntime::GroupEntry* entries, size_t count) noexcept {
+  for (size_t i = 0; i < count; i++)
+    self->_groups.del(&entries[i]);
+  self->_groupHeap.release(entries, count * sizeof(JitRuntime::GroupEntry));
+}
+
+// Forget the group that starts at `p`, if any. Pointers to other functions
+// of a group are not allocations, releasing them would corrupt `VMemMgr`.
+static Error JitRuntime_removeGroup(JitRuntime* self, void* p) noexcept {
+  // A thread that releases a function of a group must have received it from
+  // `addBatch()`, so it also sees the count that was incremented there.
+  if (!self->_groupCount)
+    return kErrorOk;
+
+  AutoLock locked(self->_groupLock);
+  JitRuntime::GroupEntry* entry = self->_groups.get(GroupByAddress((uintptr_t)p));
+
+  if (!entry)
+    return kErrorOk;
+
+  if (ASMJIT_UNLIKELY(entry->_count == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  JitRuntime_deleteGroup(self, entry, entry->_count);
+  self->_groupCount--;
+  return kErrorOk;
+}
+
+// Release the memory of a stream that was not used to add the code in place.
+static Error JitRuntime_releaseStream(JitRuntime* self, CodeHolder* code) noexcept {
+  if (!code->hasStream())
+    return kErrorOk;
+
+  void* p = (void*)static_cast<uintptr_t>(code->getStreamAddress());
+  ASMJIT_PROPAGATE(code->resetStream(true));
+
+  return self->_memMgr.release(p);
+}
+
 Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
   size_t codeSize = code->getCodeSize();
   if (ASMJIT_UNLIKELY(codeSize == 0)) {
@@ -114,33 +199,477 @@ Error JitRuntime::_add(void** dst, CodeHolder* code) noexcept {
     return DebugUtils::errored(kErrorNoCodeGenerated);
   }
 
-  void* p = _memMgr.alloc(codeSize, getAllocType());
-  if (ASMJIT_UNLIKELY(!p)) {
-    *dst = nullptr;
-    return DebugUtils::errored(kErrorNoVirtualMemory);
+  void* rw;
+  void* p;
+
+  // Code assembled by `beginStream()` is relocated in place if it fits.
+  bool inPlace = code->isStreaming() && codeSize <= code->getStreamCapacity();
+  size_t allocSize = codeSize;
+
+  if (inPlace) {
+    rw = code->getStreamData();
+    p = (void*)static_cast<uintptr_t>(code->getStreamAddress());
+    allocSize = code->getStreamCapacity();
+  }
+  else {
+    Error err = JitRuntime_releaseStream(this, code);
+    if (ASMJIT_UNLIKELY(err)) {
+      *dst = nullptr;
+      return err;
+    }
+
+    p = _memMgr.alloc(codeSize, getAllocType(), &rw);
+    if (ASMJIT_UNLIKELY(!p)) {
+      *dst = nullptr;
+      return DebugUtils::errored(kErrorNoVirtualMemory);
+    }
   }
 
-  // Relocate the code and release the unused memory back to `VMemMgr`.
-  size_t relocSize = code->relocate(p);
+  // Relocate the code and release the unused memory back to `VMemMgr`. The
+  // code is written through `rw`, which differs from `p` if `VMemMgr` uses
+  // dual mapping, but it's relocated to run at `p`.
+  size_t relocSize = code->relocate(rw, static_cast<uint64_t>((uintptr_t)p));
   if (ASMJIT_UNLIKELY(relocSize == 0)) {
     *dst = nullptr;
-    _memMgr.release(p);
+    if (inPlace)
+      JitRuntime_releaseStream(this, code);
+    else
+      _memMgr.release(p);
     return DebugUtils::errored(kErrorInvalidState);
   }
 
-  if (relocSize < codeSize)
+  // The first section keeps the code, but can't grow into released memory.
+  if (inPlace)
+    code->resetStream(false);
+
+  if (relocSize < allocSize)
     _memMgr.shrink(p, relocSize);
 
   flush(p, relocSize);
   *dst = p;
 
+  if (_listener)
+    _listener->onCodeAdded(p, relocSize, code);
+
+  return kErrorOk;
+}
+
+Error JitRuntime::addBatch(void** dst, CodeHolder* const* codes, size_t count, void** group) noexcept {
+  // Each function starts at a 16-byte boundary within the group.
+  static const size_t kFuncAlignment = 16;
+
+  size_t i;
+  size_t totalSize = 0;
+
+  *group = nullptr;
+  for (i = 0; i < count; i++)
+    dst[i] = nullptr;
+
+  if (ASMJIT_UNLIKELY(count == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  for (i = 0; i < count; i++) {
+    size_t codeSize = codes[i]->getCodeSize();
+    if (ASMJIT_UNLIKELY(codeSize == 0))
+      return DebugUtils::errored(kErrorNoCodeGenerated);
+    totalSize = Utils::alignTo<size_t>(totalSize, kFuncAlignment) + codeSize;
+  }
+
+  void* rw;
+  void* p = _memMgr.alloc(totalSize, getAllocType(), &rw);
+  if (ASMJIT_UNLIKELY(!p))
+    return DebugUtils::errored(kErrorNoVirtualMemory);
+
+  // Relocate all functions. Offsets are based on the worst case code sizes
+  // as the code cannot be moved once it has been relocated.
+  size_t offset = 0;
+  size_t usedSize = 0;
+
+  for (i = 0; i < count; i++) {
+    offset = Utils::alignTo<size_t>(offset, kFuncAlignment);
+
+    uint8_t* funcRW = static_cast<uint8_t*>(rw) + offset;
+    uint8_t* funcRX = static_cast<uint8_t*>(p) + offset;
+
+    size_t relocSize = codes[i]->relocate(funcRW, static_cast<uint64_t>((uintptr_t)funcRX));
+    if (ASMJIT_UNLIKELY(relocSize == 0)) {
+      for (size_t j = 0; j < i; j++)
+        dst[j] = nullptr;
+      _memMgr.release(p);
+      return DebugUtils::errored(kErrorInvalidState);
+    }
+
+    dst[i] = funcRX;
+    usedSize = offset + relocSize;
+    offset += codes[i]->getCodeSize();
+  }
+
+  // Remember the group so `release()` can reject its other functions.
+  {
+    AutoLock locked(_groupLock);
+
+    GroupEntry* entries = static_cast<GroupEntry*>(_groupHeap.alloc(count * sizeof(GroupEntry)));
+    size_t added = 0;
+
+    if (ASMJIT_LIKELY(entries)) {
+      for (i = 0; i < count; i++) {
+        GroupByAddress key((uintptr_t)dst[i]);
+
+        entries[i]._hashNext = nullptr;
+        entries[i]._hVal = key.hVal;
+        entries[i]._address = key.address;
+        entries[i]._count = i == 0 ? count : size_t(0);
+
+        if (ASMJIT_UNLIKELY(!_groups.put(&entries[i])))
+          break;
+        added++;
+      }
+    }
+
+    if (ASMJIT_UNLIKELY(added != count)) {
+      if (entries) {
+        for (i = 0; i < added; i++)
+          _groups.del(&entries[i]);
+        _groupHeap.release(entries, count * sizeof(GroupEntry));
+      }
+      for (i = 0; i < count; i++)
+        dst[i] = nullptr;
+      _memMgr.release(p);
+      return DebugUtils::errored(kErrorNoHeapMemory);
+    }
+
+    _groupCount++;
+  }
+
+  if (usedSize < totalSize)
+    _memMgr.shrink(p, usedSize);
+
+  flush(p, usedSize);
+  *group = p;
+
+  // Functions assembled by `beginStream()` were copied, release their memory.
+  for (i = 0; i < count; i++)
+    JitRuntime_releaseStream(this, codes[i]);
+
+  // Each function spans up to the beginning of the next one.
+  if (_listener) {
+    for (i = 0; i < count; i++) {
+      uint8_t* funcEnd = i + 1 < count ? static_cast<uint8_t*>(dst[i + 1]) : static_cast<uint8_t*>(p) + usedSize;
+      _listener->onCodeAdded(dst[i], (size_t)(funcEnd - static_cast<uint8_t*>(dst[i])), codes[i]);
+    }
+  }
+
+  return kErrorOk;
+}
+
+Error JitRuntime::beginStream(CodeHolder* code, size_t capacity) noexcept {
+  if (ASMJIT_UNLIKELY(!code->isInitialized()))
+    return DebugUtils::errored(kErrorNotInitialized);
+
+  if (ASMJIT_UNLIKELY(capacity == 0 || code->hasStream()))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+  void* rw;
+  void* p = _memMgr.alloc(capacity, getAllocType(), &rw);
+  if (ASMJIT_UNLIKELY(!p))
+    return DebugUtils::errored(kErrorNoVirtualMemory);
+
+  Error err = code->setStream(rw, capacity, static_cast<uint64_t>((uintptr_t)p));
+  if (ASMJIT_UNLIKELY(err)) {
+    _memMgr.release(p);
+    return err;
+  }
+
   return kErrorOk;
 }
 
+Error JitRuntime::abortStream(CodeHolder* code) noexcept {
+  return JitRuntime_releaseStream(this, code);
+}
+
 Error JitRuntime::_release(void* p) noexcept {
+  if (!p) return kErrorOk;
+  ASMJIT_PROPAGATE(JitRuntime_removeGroup(this, p));
+
+  if (_listener)
+    _listener->onCodeReleased(p);
+
   return _memMgr.release(p);
 }
 
+// ============================================================================
+// [asmjit::JitRuntime - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST) && defined(ASMJIT_BUILD_X86) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_X64)
+UNIT(base_jitruntime_batch) {
+  typedef int (*Func)(void);
+
+  enum { kCount = 64 };
+
+  JitRuntime rt;
+  CodeHolder codes[kCount];
+  CodeHolder* codePtrs[kCount];
+  void* funcs[kCount];
+  void* group;
+
+  INFO("Adding %d functions as a batch", static_cast<int>(kCount));
+  for (int i = 0; i < kCount; i++) {
+    codes[i].init(rt.getCodeInfo());
+    X86Assembler a(&codes[i]);
+
+    // Jump over padding of different size so each function has a different
+    // length and requires the label to be bound within its own code.
+    Label L = a.newLabel();
+    a.mov(x86::eax, i * 3);
+    a.jmp(L);
+    for (int j = 0; j < (i % 7); j++)
+      a.int3();
+    a.bind(L);
+    a.ret();
+
+    codePtrs[i] = &codes[i];
+  }
+
+  EXPECT(rt.addBatch(funcs, codePtrs, kCount, &group) == kErrorOk,
+    "JitRuntime::addBatch() failed");
+  EXPECT(group == funcs[0],
+    "The group should start with the first function");
+
+  for (int i = 0; i < kCount; i++) {
+    Func fn = ptr_as_func<Func>(funcs[i]);
+    EXPECT(fn() == i * 3,
+      "Function %d returned an invalid value", i);
+  }
+
+  INFO("Releasing functions of the group individually");
+  for (int i = 1; i < kCount; i++) {
+    EXPECT(rt.release(funcs[i]) == kErrorInvalidArgument,
+      "Function %d shouldn't be released without its group", i);
+  }
+  EXPECT(ptr_as_func<Func>(funcs[kCount - 1])() == (kCount - 1) * 3,
+    "The group should be intact");
+
+  INFO("Releasing groups in a different order than they were added");
+  void* funcs2[kCount];
+  void* group2;
+
+  EXPECT(rt.addBatch(funcs2, codePtrs, kCount, &group2) == kErrorOk,
+    "JitRuntime::addBatch() failed");
+  EXPECT(rt.release(group) == kErrorOk,
+    "Failed to release the group");
+  EXPECT(rt.release(funcs2[kCount / 2]) == kErrorInvalidArgument,
+    "Functions of the second group shouldn't be released without it");
+  EXPECT(ptr_as_func<Func>(funcs2[1])() == 3,
+    "The second group should be intact");
+  EXPECT(rt.release(group2) == kErrorOk,
+    "Failed to release the second group");
+
+  EXPECT(rt._groupCount == 0 && rt._groups.getSize() == 0,
+    "All groups should be forgotten");
+  EXPECT(rt.getMemMgr()->getUsedBytes() == 0,
+    "All memory should be released");
+}
+
+UNIT(base_jitruntime_stream) {
+  typedef int (*Func)(int);
+
+  JitRuntime rt;
+  Func fn;
+
+  INFO("Assembling directly into executable memory");
+  {
+    CodeHolder code;
+    code.init(rt.getCodeInfo());
+    X86Assembler a(&code);
+
+    EXPECT(rt.beginStream(&code, 4096) == kErrorOk,
+      "JitRuntime::beginStream() failed");
+    EXPECT(code.isStreaming(),
+      "The first section should use the stream memory");
+
+    uint64_t streamAddress = code.getStreamAddress();
+    uint8_t* streamData = code.getStreamData();
+
+    // Sum 1..n, the loop and the early exit are resolved by label links.
+    Label L_Loop = a.newLabel();
+    Label L_Done = a.newLabel();
+    X86Gp n = x86::ecx;
+
+#if ASMJIT_ARCH_X86
+    a.mov(n, x86::dword_ptr(x86::esp, 4));
+#elif !ASMJIT_OS_WINDOWS
+    a.mov(n, x86::edi);
+#endif
+
+    a.xor_(x86::eax, x86::eax);
+    a.test(n, n);
+    a.jle(L_Done);
+    a.bind(L_Loop);
+    a.add(x86::eax, n);
+    a.dec(n);
+    a.jnz(L_Loop);
+    a.bind(L_Done);
+    a.ret();
+
+    EXPECT(code.getSectionEntry(0)->getBuffer().getData() == streamData,
+      "The code should be assembled into the stream memory");
+    EXPECT(rt.add(&fn, &code) == kErrorOk,
+      "JitRuntime::add() failed");
+    EXPECT((uint64_t)(uintptr_t)func_as_ptr(fn) == streamAddress,
+      "The code should be added in place");
+    EXPECT(!code.hasStream(),
+      "The stream should be consumed by add()");
+    EXPECT(fn(10) == 55,
+      "The function returned an invalid value");
+
+    rt.release(fn);
+  }
+
+  INFO("Moving code that doesn't fit into the stream memory");
+  {
+    CodeHolder code;
+    code.init(rt.getCodeInfo());
+    X86Assembler a(&code);
+
+    EXPECT(rt.beginStream(&code, 64) == kErrorOk,
+      "JitRuntime::beginStream() failed");
+
+    for (int i = 0; i < 100; i++)
+      a.nop();
+    a.mov(x86::eax, 7);
+    a.ret();
+
+    EXPECT(!code.isStreaming(),
+      "The code should be moved to heap memory");
+    EXPECT(rt.add(&fn, &code) == kErrorOk,
+      "JitRuntime::add() failed");
+    EXPECT(fn(0) == 7,
+      "The function returned an invalid value");
+
+    rt.release(fn);
+  }
+
+  INFO("Aborting the stream");
+  {
+    CodeHolder code;
+    code.init(rt.getCodeInfo());
+    X86Assembler a(&code);
+
+    EXPECT(rt.beginStream(&code, 4096) == kErrorOk,
+      "JitRuntime::beginStream() failed");
+
+    a.mov(x86::eax, 3);
+    a.ret();
+
+    EXPECT(rt.abortStream(&code) == kErrorOk,
+      "JitRuntime::abortStream() failed");
+    EXPECT(!code.hasStream() && code.getCodeSize() == 6,
+      "The code should be kept in heap memory");
+    EXPECT(rt.add(&fn, &code) == kErrorOk,
+      "JitRuntime::add() failed");
+    EXPECT(fn(0) == 3,
+      "The function returned an invalid value");
+
+    rt.release(fn);
+  }
+
+  INFO("Calling a nearby absolute address from the stream");
+  {
+    typedef int (*HelperFunc)(void);
+    HelperFunc helper;
+
+    CodeHolder helperCode;
+    helperCode.init(rt.getCodeInfo());
+    X86Assembler ha(&helperCode);
+    ha.mov(x86::eax, 42);
+    ha.ret();
+    EXPECT(rt.add(&helper, &helperCode) == kErrorOk,
+      "JitRuntime::add() failed");
+
+    // Added in place, moved to heap memory as it outgrows the stream, and
+    // added after the stream has been aborted. The assembler is attached
+    // after `beginStream()`, the stream address must not be used to encode
+    // the call.
+    for (uint32_t i = 0; i < 3; i++) {
+      CodeHolder code;
+      code.init(rt.getCodeInfo());
+
+      EXPECT(rt.beginStream(&code, i == 1 ? 64 : 4096) == kErrorOk,
+        "JitRuntime::beginStream() failed");
+      EXPECT(code.getBaseAddress() == Globals::kNoBaseAddress,
+        "The stream address shouldn't be used as the base address");
+
+      X86Assembler a(&code);
+      a.call(imm_ptr(func_as_ptr(helper)));
+      if (i == 1) {
+        for (int j = 0; j < 100; j++)
+          a.nop();
+      }
+      a.add(x86::eax, 1);
+      a.ret();
+
+      EXPECT(code.hasRelocations(),
+        "The call should be relocated");
+
+      if (i == 2) {
+        EXPECT(rt.abortStream(&code) == kErrorOk,
+          "JitRuntime::abortStream() failed");
+      }
+
+      EXPECT(rt.add(&fn, &code) == kErrorOk,
+        "JitRuntime::add() failed");
+      EXPECT(fn(0) == 43,
+        "The function returned an invalid value");
+
+      rt.release(fn);
+    }
+
+    rt.release(helper);
+  }
+
+  EXPECT(rt.getMemMgr()->getUsedBytes() == 0,
+    "All memory should be released");
+}
+#if ASMJIT_ARCH_X64
+static int JitRuntimeTest_helper(void) { return 42; }
+
+UNIT(base_jitruntime_reserve) {
+  typedef int (*Func)(void);
+
+  JitRuntime rt;
+  const void* helper = func_as_ptr(&JitRuntimeTest_helper);
+
+  EXPECT(rt.getMemMgr()->reserve(64 * 1024 * 1024, helper) == kErrorOk,
+    "Couldn't reserve memory near %p", helper);
+
+  CodeHolder code;
+  code.init(rt.getCodeInfo());
+  X86Assembler a(&code);
+
+  // Calls to absolute addresses need a trampoline if the target is too far.
+  a.sub(x86::rsp, 8);
+  a.call(imm_ptr(helper));
+  a.add(x86::rsp, 8);
+  a.ret();
+
+  Func fn;
+  EXPECT(rt.add(&fn, &code) == kErrorOk,
+    "JitRuntime::add() failed");
+  EXPECT(fn() == 42,
+    "The function returned an invalid value");
+
+  // The call follows `sub rsp, 8` (4 bytes) and must stay `call rel32`, it
+  // would be patched to `call [rip + trampoline]` (FF 15) otherwise.
+  const uint8_t* p = static_cast<const uint8_t*>(func_as_ptr(fn));
+  EXPECT(!(p[4] == 0xFF && p[5] == 0x15),
+    "The call should not use a trampoline");
+
+  rt.release(fn);
+}
+#endif // ASMJIT_ARCH_X64
+#endif // ASMJIT_TEST
+
 } // asmjit namespace
 
 // [Api-End]
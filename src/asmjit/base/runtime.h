@@ -142,6 +142,41 @@ public:
   ASMJIT_API virtual void flush(const void* p, size_t size) noexcept;
 };
 
+// ============================================================================
+// [asmjit::JitListener]
+// ============================================================================
+
+//! Listener notified by \ref JitRuntime about code it adds and releases.
+//!
+//! Listeners make JIT code visible to profilers and debuggers, see for example
+//! \ref PerfListener. Callbacks are called by the thread that calls `add()` or
+//! `release()`, so they should only record what they need and return.
+class ASMJIT_VIRTAPI JitListener {
+public:
+  ASMJIT_NONCOPYABLE(JitListener)
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new `JitListener` instance.
+  ASMJIT_API JitListener() noexcept;
+  //! Destroy the `JitListener` instance.
+  ASMJIT_API virtual ~JitListener() noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Interface]
+  // --------------------------------------------------------------------------
+
+  //! Called after `size` bytes of code generated by `code` were added at `p`.
+  //!
+  //! The code has already been relocated and it's executable at this point.
+  virtual void onCodeAdded(const void* p, size_t size, const CodeHolder* code) noexcept = 0;
+
+  //! Called before code at `p` is released, does nothing by default.
+  ASMJIT_API virtual void onCodeReleased(const void* p) noexcept;
+};
+
 // ============================================================================
 // [asmjit::JitRuntime]
 // ============================================================================
@@ -151,6 +186,16 @@ class ASMJIT_VIRTAPI JitRuntime : public HostRuntime {
 public:
   ASMJIT_NONCOPYABLE(JitRuntime)
 
+  //! \internal
+  //!
+  //! Entry point of a function added by `addBatch()`. Entries of a group are
+  //! allocated together, the first one is the entry of the group itself.
+  class GroupEntry : public ZoneHashNode {
+  public:
+    uintptr_t _address;                  //!< Entry point of the function.
+    size_t _count;                       //!< Count of functions of the group, zero if it's not the first entry.
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -172,6 +217,16 @@ public:
   //! Get the virtual memory manager.
   ASMJIT_INLINE VMemMgr* getMemMgr() const noexcept { return const_cast<VMemMgr*>(&_memMgr); }
 
+  //! Get the listener notified about added and released code (or null).
+  ASMJIT_INLINE JitListener* getListener() const noexcept { return _listener; }
+  //! Set the listener notified about added and released code, see \ref JitListener.
+  //!
+  //! NOTE: The listener must be set before the runtime is shared between threads
+  //! and it must outlive the runtime or be reset before it's destroyed.
+  ASMJIT_INLINE void setListener(JitListener* listener) noexcept { _listener = listener; }
+  //! Reset the listener.
+  ASMJIT_INLINE void resetListener() noexcept { _listener = nullptr; }
+
   // --------------------------------------------------------------------------
   // [Interface]
   // --------------------------------------------------------------------------
@@ -179,12 +234,69 @@ public:
   ASMJIT_API Error _add(void** dst, CodeHolder* code) noexcept override;
   ASMJIT_API Error _release(void* p) noexcept override;
 
+  //! Add code of `count` functions stored in `codes` at once.
+  //!
+  //! All functions are relocated into a single memory region that is allocated
+  //! by one call to `VMemMgr::alloc()` and the instruction cache is flushed
+  //! only once, which amortizes the cost of `add()` when many small functions
+  //! are generated together. The entry point of each function is stored to
+  //! `dst[i]` and the whole group is represented by `group`, which has to be
+  //! passed to `release()` to free all functions at once. Functions of the
+  //! group cannot be released individually, `release()` fails with
+  //! `kErrorInvalidArgument` if it's called with an entry point of another
+  //! function of the group than the first one, which is `group`.
+  //!
+  //! If failed the \ref Error code is returned, `group` and all `dst` entries
+  //! are set to null, and no memory is kept allocated.
+  ASMJIT_API Error addBatch(void** dst, CodeHolder* const* codes, size_t count, void** group) noexcept;
+
+  //! Assemble the code of `code` directly into executable memory.
+  //!
+  //! Allocates `capacity` bytes from `VMemMgr` and uses them as the buffer of
+  //! the first section of `code`, which must be initialized and empty, see
+  //! \ref CodeHolder::setStream(). The code is written through the RW view
+  //! of the memory. Its base address is not set, so calls, jumps, and memory
+  //! operands that refer to absolute addresses are emitted with relocations,
+  //! which are resolved by `add()` wherever the code ends up.
+  //!
+  //! `add()` then only resolves relocations in place, without allocating
+  //! another buffer and copying the code, if the code (all sections and
+  //! trampolines) still fits into `capacity`. Otherwise the code has been moved
+  //! to heap memory and `add()` falls back to the regular path. Either way the
+  //! unused part of the memory is released. After the code has been added in
+  //! place the first section of `code` points to the executable memory, which
+  //! is only valid until the function is released.
+  //!
+  //! NOTE: Either `add()` or `abortStream()` must be called before `code` is
+  //! reset or destroyed, otherwise the memory allocated by `beginStream()` is
+  //! never released.
+  ASMJIT_API Error beginStream(CodeHolder* code, size_t capacity) noexcept;
+
+  //! Release the memory allocated by `beginStream()` without adding the code.
+  //!
+  //! The code assembled so far is moved to heap memory first, so `code` can
+  //! still be used.
+  ASMJIT_API Error abortStream(CodeHolder* code) noexcept;
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
 
   //! Virtual memory manager.
   VMemMgr _memMgr;
+  //! Listener notified about added and released code.
+  JitListener* _listener;
+
+  //! Lock that protects `_groups`.
+  Lock _groupLock;
+  //! Count of groups, `release()` doesn't lock `_groupLock` if it's zero.
+  volatile size_t _groupCount;
+  //! Zone used by `_groupHeap`.
+  Zone _groupZone;
+  //! Heap used by `_groups` and its entries.
+  ZoneHeap _groupHeap;
+  //! Entry points of all functions added by `addBatch()`.
+  ZoneOpenHash<GroupEntry> _groups;
 };
 
 //! \}
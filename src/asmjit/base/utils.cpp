@@ -134,6 +134,15 @@ UNIT(base_utils) {
       "Utils::findFirstBit(%X) should return %u", (1 << i), i);
   }
 
+  INFO("Utils::findLastBit()");
+  for (i = 0; i < 32; i++) {
+    uint32_t mask = (1U << i) | 1U;
+    EXPECT(Utils::findLastBit(mask) == i,
+      "Utils::findLastBit(%X) should return %u", mask, i);
+    EXPECT(Utils::findLastBitSlow(mask) == i,
+      "Utils::findLastBitSlow(%X) should return %u", mask, i);
+  }
+
   INFO("Utils::keepNOnesFromRight()");
   EXPECT(Utils::keepNOnesFromRight(0xF, 1) == 0x1, "");
   EXPECT(Utils::keepNOnesFromRight(0xF, 2) == 0x3, "");
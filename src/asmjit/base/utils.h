@@ -487,6 +487,42 @@ namespace Utils {
 #endif
   }
 
+  // --------------------------------------------------------------------------
+  // [FindLastBit]
+  // --------------------------------------------------------------------------
+
+  //! \internal
+  static ASMJIT_INLINE uint32_t findLastBitSlow(uint32_t mask) noexcept {
+    // This is a reference (slow) implementation of `findLastBit()`, used when
+    // we don't have a C++ compiler support.
+    if (mask == 0)
+      return 0xFFFFFFFFU;
+
+    uint32_t i = 0;
+    while (mask >>= 1)
+      i++;
+    return i;
+  }
+
+  //! Find a last (most significant) bit in `mask`.
+  static ASMJIT_INLINE uint32_t findLastBit(uint32_t mask) noexcept {
+#if ASMJIT_CC_MSC_GE(14, 0, 0) && (ASMJIT_ARCH_X86 || ASMJIT_ARCH_ARM32 || \
+                                   ASMJIT_ARCH_X64 || ASMJIT_ARCH_ARM64)
+    DWORD i;
+    if (_BitScanReverse(&i, mask))
+      return static_cast<uint32_t>(i);
+    else
+      return 0xFFFFFFFFU;
+#elif ASMJIT_CC_GCC_GE(3, 4, 6) || ASMJIT_CC_CLANG
+    if (mask)
+      return 31 - __builtin_clz(mask);
+    else
+      return 0xFFFFFFFFU;
+#else
+    return findLastBitSlow(mask);
+#endif
+  }
+
   // --------------------------------------------------------------------------
   // [Misc]
   // --------------------------------------------------------------------------
@@ -9,9 +9,18 @@
 
 // [Dependencies]
 #include "../base/osutils.h"
+#include "../base/string.h"
 #include "../base/utils.h"
 #include "../base/vmem.h"
 
+#if ASMJIT_CC_MSC
+# include <intrin.h>
+#endif
+
+#if defined(ASMJIT_TEST) && !ASMJIT_OS_WINDOWS
+# include <sys/mman.h>
+#endif
+
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
 
@@ -94,6 +103,194 @@ static void _SetBits(size_t* buf, size_t index, size_t len) noexcept {
     *buf |= ((~(size_t)0) >> (kBitsPerEntity - len));
 }
 
+//! \internal
+//!
+//! Find a first bit in `x`, which must not be zero.
+static ASMJIT_INLINE size_t _FindFirstBit(size_t x) noexcept {
+#if ASMJIT_ARCH_64BIT
+  uint32_t lo = static_cast<uint32_t>(x);
+  if (lo) return Utils::findFirstBit(lo);
+  return 32 + Utils::findFirstBit(static_cast<uint32_t>(static_cast<uint64_t>(x) >> 32));
+#else
+  return Utils::findFirstBit(static_cast<uint32_t>(x));
+#endif
+}
+
+//! \internal
+//!
+//! Find a last bit in `x`, which must not be zero.
+static ASMJIT_INLINE size_t _FindLastBit(size_t x) noexcept {
+#if ASMJIT_ARCH_64BIT
+  uint32_t hi = static_cast<uint32_t>(static_cast<uint64_t>(x) >> 32);
+  if (hi) return 32 + Utils::findLastBit(hi);
+  return Utils::findLastBit(static_cast<uint32_t>(x));
+#else
+  return Utils::findLastBit(static_cast<uint32_t>(x));
+#endif
+}
+
+//! \internal
+//!
+//! Get a mask of bits in `x` that start a run of at least `n` set bits.
+static ASMJIT_INLINE size_t _RunMask(size_t x, size_t n) noexcept {
+  size_t len = 1;
+  while (len < n && x) {
+    size_t shift = std::min<size_t>(len, n - len);
+    x &= x >> shift;
+    len += shift;
+  }
+  return x;
+}
+
+//! \internal
+//!
+//! Clear `len` bits in `buf` starting at `index` bit index.
+static void _ClearBits(size_t* buf, size_t index, size_t len) noexcept {
+  if (len == 0)
+    return;
+
+  size_t i = index / kBitsPerEntity; // size_t[]
+  size_t j = index % kBitsPerEntity; // size_t[][] bit index
+
+  // How many bytes process in the first group.
+  size_t c = kBitsPerEntity - j;
+  if (c > len)
+    c = len;
+
+  // Offset.
+  buf += i;
+
+  *buf++ &= ~(((~(size_t)0) >> (kBitsPerEntity - c)) << j);
+  len -= c;
+
+  while (len >= kBitsPerEntity) {
+    *buf++ = 0;
+    len -= kBitsPerEntity;
+  }
+
+  if (len)
+    *buf &= ~((~(size_t)0) >> (kBitsPerEntity - len));
+}
+
+//! \internal
+//!
+//! Update bits of `full` (one per word of `used`, set if the word is all ones)
+//! of words of `used` that contain `count` bits starting at `index`.
+static void _UpdateFull(const size_t* used, size_t* full, size_t index, size_t count) noexcept {
+  if (count == 0)
+    return;
+
+  size_t w = index / kBitsPerEntity;
+  size_t wEnd = (index + count - 1) / kBitsPerEntity;
+
+  for (; w <= wEnd; w++) {
+    size_t* fp = full + w / kBitsPerEntity;
+    size_t bit = (size_t)1 << (w % kBitsPerEntity);
+
+    if (used[w] == ~(size_t)0)
+      *fp |= bit;
+    else
+      *fp &= ~bit;
+  }
+}
+
+//! \internal
+//!
+//! Find a run of `need` zero bits in `used`, which has `count` bits, where
+//! `need` is greater than `kBitsPerEntity`. Such a run always contains a whole
+//! zero word, so the run is measured a word at a time - by the zero bits at
+//! both ends of other words and by whole zero words between them. Words that
+//! are all ones are skipped by `full`.
+static size_t _FindUnusedWords(const size_t* used, const size_t* full, size_t count, size_t need) noexcept {
+  size_t numWords = (count + kBitsPerEntity - 1) / kBitsPerEntity;
+  size_t cont = 0;                      // Zero bits that end at word `w`.
+
+  for (size_t w = 0; w < numWords; w++) {
+    // Skip `kBitsPerEntity` words that are all ones at once.
+    if ((w % kBitsPerEntity) == 0 && full[w / kBitsPerEntity] == ~(size_t)0) {
+      cont = 0;
+      w += kBitsPerEntity - 1;
+      continue;
+    }
+
+    // Bits after the end are never zero.
+    size_t x = used[w];
+    if (w == numWords - 1 && (count % kBitsPerEntity) != 0)
+      x |= ~(((size_t)1 << (count % kBitsPerEntity)) - 1);
+
+    if (!x) {
+      cont += kBitsPerEntity;
+      if (cont >= need)
+        return (w + 1) * kBitsPerEntity - cont;
+      continue;
+    }
+
+    if (cont + _FindFirstBit(x) >= need)
+      return w * kBitsPerEntity - cont;
+    cont = kBitsPerEntity - 1 - _FindLastBit(x);
+  }
+
+  return Globals::kInvalidIndex;
+}
+
+//! \internal
+//!
+//! Find the first run of `need` zero bits in `used`, which has `count` bits,
+//! by using `full` to skip words that are all ones and word-wide bit operations
+//! to find a run of zeros within and across words.
+//!
+//! Returns the index of the first bit or `Globals::kInvalidIndex`.
+static size_t _FindUnusedRun(const size_t* used, const size_t* full, size_t count, size_t need) noexcept {
+  if (need > kBitsPerEntity)
+    return _FindUnusedWords(used, full, count, need);
+
+  size_t numWords = (count + kBitsPerEntity - 1) / kBitsPerEntity;
+  size_t numFull = (numWords + kBitsPerEntity - 1) / kBitsPerEntity;
+
+  size_t prev = Globals::kInvalidIndex; // Index of the previous word checked.
+  size_t carry = 0;                     // Zero bits at the end of `prev`.
+
+  for (size_t fi = 0; fi < numFull; fi++) {
+    size_t candidates = ~full[fi];
+
+    while (candidates) {
+      size_t w = fi * kBitsPerEntity + _FindFirstBit(candidates);
+      candidates &= candidates - 1;
+
+      if (w >= numWords)
+        break;
+
+      size_t unused = ~used[w];
+      if (w == numWords - 1 && (count % kBitsPerEntity) != 0)
+        unused &= ((size_t)1 << (count % kBitsPerEntity)) - 1;
+
+      // A run that starts in the previous word and continues in this one.
+      if (w != prev + 1)
+        carry = 0;
+
+      if (carry) {
+        size_t low = ~unused ? _FindFirstBit(~unused) : size_t(kBitsPerEntity);
+        if (carry + low >= need)
+          return w * kBitsPerEntity - carry;
+      }
+
+      // A run within this word.
+      size_t runs = _RunMask(unused, need);
+      if (runs)
+        return w * kBitsPerEntity + _FindFirstBit(runs);
+
+      // Zero bits at the end of this word.
+      carry = 0;
+      while (carry < need && ((unused >> (kBitsPerEntity - 1 - carry)) & 1))
+        carry++;
+
+      prev = w;
+    }
+  }
+
+  return Globals::kInvalidIndex;
+}
+
 // ============================================================================
 // [asmjit::VMemMgr::TypeDefs]
 // ============================================================================
@@ -101,6 +298,10 @@ static void _SetBits(size_t* buf, size_t index, size_t len) noexcept {
 typedef VMemMgr::RbNode RbNode;
 typedef VMemMgr::MemNode MemNode;
 typedef VMemMgr::PermanentNode PermanentNode;
+typedef VMemMgr::Arena Arena;
+typedef VMemMgr::RemoteRelease RemoteRelease;
+typedef VMemMgr::SizeClassCache SizeClassCache;
+typedef VMemMgr::Counters Counters;
 
 // ============================================================================
 // [asmjit::VMemMgr::RbNode]
@@ -115,6 +316,7 @@ struct VMemMgr::RbNode {
 
   RbNode* node[2];                       //!< Left[0] and right[1] nodes.
   uint8_t* mem;                          //!< Virtual memory address.
+  uint8_t* memRW;                        //!< Read+write view of `mem` (the same as `mem` if not dual-mapped).
   uint32_t red;                          //!< Node color (red vs. black).
 };
 
@@ -182,33 +384,26 @@ static ASMJIT_INLINE RbNode* rbRotateDouble(RbNode* root, int dir) noexcept {
 // ============================================================================
 
 struct VMemMgr::MemNode : public RbNode {
-  ASMJIT_INLINE void init(MemNode* other) noexcept {
-    mem = other->mem;
-
-    size = other->size;
-    used = other->used;
-    blocks = other->blocks;
-    density = other->density;
-    largestBlock = other->largestBlock;
-
-    baUsed = other->baUsed;
-    baCont = other->baCont;
-  }
-
   // Get available space.
   ASMJIT_INLINE size_t getAvailable() const noexcept { return size - used; }
 
   MemNode* prev;         // Prev node in list.
   MemNode* next;         // Next node in list.
+  Arena* arena;          // Arena that owns this node or null if shared.
 
   size_t size;           // How many bytes contain this node.
   size_t used;           // How many bytes are used in this node.
+  size_t cached;         // How many of `used` bytes are held by the size class cache.
   size_t blocks;         // How many blocks are here.
   size_t density;        // Minimum count of allocated bytes in this node (also alignment).
   size_t largestBlock;   // Contains largest block that can be allocated.
 
+  bool largePageRequested; // Large pages were requested for this node.
+  uint8_t largePageKind; // Kind of pages backing this node, see `OSUtils::LargePageKind`.
+
   size_t* baUsed;        // Contains bits about used blocks       (0 = unused, 1 = used).
   size_t* baCont;        // Contains bits about continuous blocks (0 = stop  , 1 = continue).
+  size_t* baFull;        // Contains bits about `baUsed` words    (0 = has unused, 1 = full).
 };
 
 // ============================================================================
@@ -224,10 +419,329 @@ struct VMemMgr::PermanentNode {
 
   PermanentNode* prev;   // Pointer to prev chunk or nullptr.
   uint8_t* mem;          // Base pointer (virtual memory address).
+  uint8_t* memRW;        // Read+write view of `mem`.
   size_t size;           // Count of bytes allocated.
   size_t used;           // Count of bytes used.
 };
 
+// ============================================================================
+// [asmjit::VMemMgr::Arena]
+// ============================================================================
+
+//! \internal
+//!
+//! Release of an arena allocation requested by a thread that doesn't own the
+//! arena. These are pushed to `Arena::remote` and processed by the owner.
+struct VMemMgr::RemoteRelease {
+  RemoteRelease* next;   // Next pending release.
+  void* p;               // Pointer to release.
+};
+
+//! \internal
+//!
+//! Per-thread arena.
+//!
+//! Nodes that belong to the arena are inserted into the shared RB-tree (so any
+//! thread can find them), but they are linked only in the arena's own list. The
+//! list and bit arrays of these nodes are only accessed by the owning thread
+//! without any lock, the tree is only accessed when holding `VMemMgr::_lock`,
+//! which the owner only takes to insert or remove a node. Other threads only
+//! push releases to `remote` and read `usedBytes` and `counters`, which are
+//! written by the owner only, to collect statistics.
+struct VMemMgr::Arena {
+  VMemMgr* mgr;          // Memory manager that owns this arena.
+  Arena* next;           // Next arena in `VMemMgr::_arenas` list.
+  MemNode* first;        // First node in arena's list.
+  MemNode* spare;        // Empty node kept for the next allocation or null.
+  RemoteRelease* volatile remote; // Releases requested by other threads.
+  volatile size_t usedBytes; // How many bytes are used by this arena.
+  Counters counters;     // Counters of allocations served by this arena.
+  bool orphaned;         // True if the thread that owned the arena has exited.
+};
+
+//! \internal
+//!
+//! Minimum size of nodes of arenas, allocations of up to a quarter of it are
+//! served by arenas.
+static const size_t kArenaNodeSize = 256 * 1024;
+
+// ============================================================================
+// [asmjit::VMemMgr::SizeClassCache]
+// ============================================================================
+
+enum {
+  kSizeClassCount = 16,  //!< Allocations of up to 16 blocks are cached.
+  kSizeClassCapacity = 16 //!< Maximum count of cached allocations per size class.
+};
+
+//! \internal
+//!
+//! Free lists of released allocations, indexed by the number of blocks they
+//! span, used by `VMemMgr::kStrategyBitmap`. Cached allocations are still
+//! marked as used in their node's bit arrays and counted by `MemNode::cached`.
+//! A node is never kept alive only by cached allocations - its cached items
+//! are released together with its last allocation.
+struct VMemMgr::SizeClassCache {
+  uint32_t count[kSizeClassCount];
+  void* items[kSizeClassCount][kSizeClassCapacity];
+};
+
+// ============================================================================
+// [asmjit::VMemMgr - Atomics]
+// ============================================================================
+
+//! \internal
+//!
+//! Push `item` to a lock-free stack at `pHead`.
+static ASMJIT_INLINE void vMemMgrAtomicPush(RemoteRelease* volatile* pHead, RemoteRelease* item) noexcept {
+  for (;;) {
+    RemoteRelease* head = *pHead;
+    item->next = head;
+#if ASMJIT_CC_MSC
+    if (_InterlockedCompareExchangePointer((void* volatile*)pHead, item, head) == head)
+      break;
+#else
+    if (__sync_bool_compare_and_swap(pHead, head, item))
+      break;
+#endif
+  }
+}
+
+//! \internal
+//!
+//! Take all items from a lock-free stack at `pHead`.
+static ASMJIT_INLINE RemoteRelease* vMemMgrAtomicTakeAll(RemoteRelease* volatile* pHead) noexcept {
+#if ASMJIT_CC_MSC
+  return static_cast<RemoteRelease*>(_InterlockedExchangePointer((void* volatile*)pHead, nullptr));
+#else
+  for (;;) {
+    RemoteRelease* head = *pHead;
+    if (__sync_bool_compare_and_swap(pHead, head, static_cast<RemoteRelease*>(nullptr)))
+      return head;
+  }
+#endif
+}
+
+// ============================================================================
+// [asmjit::VMemMgr - Reservation]
+// ============================================================================
+
+#if ASMJIT_ARCH_64BIT
+//! \internal
+//!
+//! Maximum distance between a reserved range and its hint (rel32 reach).
+static const uint64_t kReservedMaxDistance = 0x7FFFFFFFU;
+#endif // ASMJIT_ARCH_64BIT
+
+//! \internal
+//!
+//! Get whether every address in `[base, base + size)` is within the reach of
+//! rel32 from `hint`.
+static ASMJIT_INLINE bool vMemMgrIsNear(const uint8_t* base, size_t size, const void* hint) noexcept {
+#if ASMJIT_ARCH_64BIT
+  uint64_t lo = static_cast<uint64_t>((uintptr_t)base);
+  uint64_t hi = lo + size;
+  uint64_t h = static_cast<uint64_t>((uintptr_t)hint);
+
+  uint64_t farthest = std::max<uint64_t>(hi > h ? hi - h : h - hi,
+                                         lo > h ? lo - h : h - lo);
+  return farthest <= kReservedMaxDistance;
+#else
+  ASMJIT_UNUSED(base);
+  ASMJIT_UNUSED(size);
+  ASMJIT_UNUSED(hint);
+  return true;
+#endif
+}
+
+//! \internal
+//!
+//! Reserve an address range of `size` bytes near `hint`.
+static uint8_t* vMemMgrReserveRange(size_t size, size_t granularity, size_t* reserved, const void* hint) noexcept {
+  uint8_t* base = static_cast<uint8_t*>(OSUtils::reserveVirtualMemory(size, reserved, hint));
+  if (!hint || (base && vMemMgrIsNear(base, *reserved, hint)))
+    return base;
+
+  if (base)
+    OSUtils::releaseVirtualMemory(base, *reserved);
+
+#if ASMJIT_ARCH_64BIT
+  // The OS placed the range too far, so try ranges below and above the hint,
+  // the closest first.
+  uint64_t h = Utils::alignTo<uint64_t>(static_cast<uint64_t>((uintptr_t)hint), granularity);
+  uint64_t step = std::max<uint64_t>(size, 16 * 1024 * 1024);
+
+  for (uint64_t distance = 0; distance + size <= kReservedMaxDistance; distance += step) {
+    for (uint32_t dir = 0; dir < 2; dir++) {
+      uint64_t candidate;
+
+      if (dir == 0) {
+        if (h < distance + size + granularity) continue;
+        candidate = h - distance - size - granularity;
+      }
+      else {
+        candidate = h + distance + granularity;
+      }
+
+      base = static_cast<uint8_t*>(OSUtils::reserveVirtualMemory(size, reserved, (void*)(uintptr_t)candidate));
+      if (!base)
+        continue;
+
+      if (vMemMgrIsNear(base, *reserved, hint))
+        return base;
+
+      OSUtils::releaseVirtualMemory(base, *reserved);
+    }
+  }
+#else
+  ASMJIT_UNUSED(granularity);
+#endif // ASMJIT_ARCH_64BIT
+
+  return nullptr;
+}
+
+//! \internal
+//!
+//! Allocate `size` bytes from the reserved address range.
+//!
+//! Granules of the range are managed by the same bit arrays as blocks of a
+//! `MemNode` with `kStrategyBitmap` - `_reservedMap` has a bit per granule and
+//! `_reservedFull` has a bit per word of `_reservedMap` that is all used.
+static uint8_t* vMemMgrAllocReserved(VMemMgr* self, size_t size, size_t* vSize) noexcept {
+  size_t granularity = self->_reservedGranularity;
+  size_t need = (size + granularity - 1) / granularity;
+  size_t count = self->_reservedSize / granularity;
+
+  AutoLock locked(self->_reservedLock);
+  size_t first = _FindUnusedRun(self->_reservedMap, self->_reservedFull, count, need);
+
+  if (first == Globals::kInvalidIndex)
+    return nullptr;
+
+  uint8_t* p = self->_reservedBase + first * granularity;
+  if (OSUtils::commitVirtualMemory(p, need * granularity, OSUtils::kVMWritable | OSUtils::kVMExecutable) != kErrorOk)
+    return nullptr;
+
+  _SetBits(self->_reservedMap, first, need);
+  _UpdateFull(self->_reservedMap, self->_reservedFull, first, need);
+
+  *vSize = need * granularity;
+  return p;
+}
+
+//! \internal
+//!
+//! Release memory at `p` allocated from the reserved address range.
+static Error vMemMgrReleaseReserved(VMemMgr* self, uint8_t* p, size_t vSize) noexcept {
+  size_t granularity = self->_reservedGranularity;
+  size_t first = (size_t)(p - self->_reservedBase) / granularity;
+  size_t count = vSize / granularity;
+
+  AutoLock locked(self->_reservedLock);
+  _ClearBits(self->_reservedMap, first, count);
+  _UpdateFull(self->_reservedMap, self->_reservedFull, first, count);
+
+  return OSUtils::decommitVirtualMemory(p, vSize);
+}
+
+//! \internal
+//!
+//! Release the reserved address range when the `VMemMgr` is destroyed.
+//!
+//! Permanent memory is never released, so granules that are still marked as
+//! used (only permanent nodes are left) are kept and only runs of unused ones
+//! are released. Windows can only release a reservation as a whole, so there
+//! the range is kept if it contains permanent memory, its unused granules are
+//! already decommitted.
+static void vMemMgrReleaseReservedRange(VMemMgr* self) noexcept {
+  uint8_t* base = self->_reservedBase;
+
+  if (!self->_permanent) {
+    OSUtils::releaseVirtualMemory(base, self->_reservedSize);
+    return;
+  }
+
+#if !ASMJIT_OS_WINDOWS
+  size_t granularity = self->_reservedGranularity;
+  size_t count = self->_reservedSize / granularity;
+  const size_t* map = self->_reservedMap;
+
+  size_t i = 0;
+  while (i < count) {
+    if (map[i / kBitsPerEntity] & ((size_t)1 << (i % kBitsPerEntity))) {
+      i++;
+      continue;
+    }
+
+    size_t first = i;
+    while (i < count && !(map[i / kBitsPerEntity] & ((size_t)1 << (i % kBitsPerEntity))))
+      i++;
+
+    OSUtils::releaseVirtualMemory(base + first * granularity, (i - first) * granularity);
+  }
+#endif // !ASMJIT_OS_WINDOWS
+}
+
+// ============================================================================
+// [asmjit::VMemMgr - Statistics]
+// ============================================================================
+
+//! \internal
+//!
+//! Like `AutoLock`, but also measures how long `VMemMgr::_lock` was contended.
+struct VMemMgrAutoLock {
+  ASMJIT_NONCOPYABLE(VMemMgrAutoLock)
+
+  ASMJIT_INLINE VMemMgrAutoLock(const VMemMgr* self) noexcept : _self(self) {
+    if (ASMJIT_LIKELY(self->_lock.tryLock()))
+      return;
+
+    uint64_t start = OSUtils::getTickCountNs();
+    self->_lock.lock();
+
+    self->_lockContentions++;
+    self->_lockWaitNs += OSUtils::getTickCountNs() - start;
+  }
+  ASMJIT_INLINE ~VMemMgrAutoLock() noexcept { _self->_lock.unlock(); }
+
+  const VMemMgr* _self;
+};
+
+//! \internal
+//!
+//! Count an allocation of `vSize` bytes.
+static ASMJIT_INLINE void vMemMgrCountAlloc(Counters& counters, size_t vSize) noexcept {
+  uint32_t sizeClass = 0;
+  while (sizeClass < VMemStats::kSizeClassCount - 1 && vSize > VMemStats::getSizeClassLimit(sizeClass))
+    sizeClass++;
+
+  counters.allocCount++;
+  counters.sizeClassAllocs[sizeClass]++;
+}
+
+//! \internal
+//!
+//! Count a shrink that released `released` bytes.
+static ASMJIT_INLINE void vMemMgrCountShrink(Counters& counters, size_t released) noexcept {
+  if (!released) return;
+
+  counters.shrinkCount++;
+  counters.shrinkBytes += released;
+}
+
+//! \internal
+//!
+//! Add `src` counters to `dst` statistics.
+static void vMemMgrAddCounters(VMemStats* dst, const Counters& src) noexcept {
+  dst->allocCount += src.allocCount;
+  dst->releaseCount += src.releaseCount;
+  dst->shrinkCount += src.shrinkCount;
+  dst->shrinkBytes += src.shrinkBytes;
+
+  for (uint32_t i = 0; i < VMemStats::kSizeClassCount; i++)
+    dst->sizeClassAllocs[i] += src.sizeClassAllocs[i];
+}
+
 // ============================================================================
 // [asmjit::VMemMgr - Private]
 // ============================================================================
@@ -235,19 +749,43 @@ struct VMemMgr::PermanentNode {
 //! \internal
 //!
 //! Helper to avoid `#ifdef`s in the code.
-ASMJIT_INLINE uint8_t* vMemMgrAllocVMem(VMemMgr* self, size_t size, size_t* vSize) noexcept {
+ASMJIT_INLINE uint8_t* vMemMgrAllocVMem(VMemMgr* self, size_t size, size_t* vSize, uint8_t** rw) noexcept {
+  if (self->_reservedBase) {
+    uint8_t* p = vMemMgrAllocReserved(self, size, vSize);
+    *rw = p;
+    return p;
+  }
+
+  if (self->_dualMapping) {
+    void* rwPtr = nullptr;
+    uint8_t* rxPtr = static_cast<uint8_t*>(OSUtils::allocDualMappedMemory(size, vSize, &rwPtr));
+
+    *rw = static_cast<uint8_t*>(rwPtr);
+    return rxPtr;
+  }
+
   uint32_t flags = OSUtils::kVMWritable | OSUtils::kVMExecutable;
 #if !ASMJIT_OS_WINDOWS
-  return static_cast<uint8_t*>(OSUtils::allocVirtualMemory(size, vSize, flags));
+  uint8_t* p = static_cast<uint8_t*>(OSUtils::allocVirtualMemory(size, vSize, flags));
 #else
-  return static_cast<uint8_t*>(OSUtils::allocProcessMemory(self->_hProcess, size, vSize, flags));
+  uint8_t* p = static_cast<uint8_t*>(OSUtils::allocProcessMemory(self->_hProcess, size, vSize, flags));
 #endif
+
+  *rw = p;
+  return p;
 }
 
 //! \internal
 //!
 //! Helper to avoid `#ifdef`s in the code.
-ASMJIT_INLINE Error vMemMgrReleaseVMem(VMemMgr* self, void* p, size_t vSize) noexcept {
+ASMJIT_INLINE Error vMemMgrReleaseVMem(VMemMgr* self, void* p, void* rw, size_t vSize) noexcept {
+  uint8_t* mem = static_cast<uint8_t*>(p);
+  if (mem >= self->_reservedBase && mem < self->_reservedBase + self->_reservedSize)
+    return vMemMgrReleaseReserved(self, mem, vSize);
+
+  if (p != rw)
+    return OSUtils::releaseDualMappedMemory(p, rw, vSize);
+
 #if !ASMJIT_OS_WINDOWS
   return OSUtils::releaseVirtualMemory(p, vSize);
 #else
@@ -269,18 +807,33 @@ static bool vMemMgrCheckTree(VMemMgr* self) noexcept {
 //! Returns set-up `MemNode*` or nullptr if allocation failed.
 static MemNode* vMemMgrCreateNode(VMemMgr* self, size_t size, size_t density) noexcept {
   size_t vSize;
-  uint8_t* vmem = vMemMgrAllocVMem(self, size, &vSize);
+  uint8_t* vmemRW;
+  uint8_t* vmem;
+
+  // Large pages and dual mapping are exclusive, see `setLargePages()`.
+  bool largePageRequested = self->_largePages;
+  uint32_t largePageKind = OSUtils::kLargePageNone;
+
+  if (largePageRequested) {
+    uint32_t flags = OSUtils::kVMWritable | OSUtils::kVMExecutable;
+    vmem = static_cast<uint8_t*>(OSUtils::allocLargePageMemory(size, &vSize, flags, &largePageKind));
+    vmemRW = vmem;
+  }
+  else {
+    vmem = vMemMgrAllocVMem(self, size, &vSize, &vmemRW);
+  }
   if (!vmem) return nullptr;
 
   size_t blocks = (vSize / density);
   size_t bsize = (((blocks + 7) >> 3) + sizeof(size_t) - 1) & ~(size_t)(sizeof(size_t) - 1);
+  size_t fsize = ((bsize / sizeof(size_t) + kBitsPerEntity - 1) / kBitsPerEntity) * sizeof(size_t);
 
   MemNode* node = static_cast<MemNode*>(Internal::allocMemory(sizeof(MemNode)));
-  uint8_t* data = static_cast<uint8_t*>(Internal::allocMemory(bsize * 2));
+  uint8_t* data = static_cast<uint8_t*>(Internal::allocMemory(bsize * 2 + fsize));
 
   // Out of memory.
   if (!node || !data) {
-    vMemMgrReleaseVMem(self, vmem, vSize);
+    vMemMgrReleaseVMem(self, vmem, vmemRW, vSize);
     if (node) Internal::releaseMemory(node);
     if (data) Internal::releaseMemory(data);
     return nullptr;
@@ -290,37 +843,139 @@ static MemNode* vMemMgrCreateNode(VMemMgr* self, size_t size, size_t density) no
   node->node[0] = nullptr;
   node->node[1] = nullptr;
   node->mem = vmem;
+  node->memRW = vmemRW;
   node->red = 1;
 
   // Initialize MemNode data.
   node->prev = nullptr;
   node->next = nullptr;
+  node->arena = nullptr;
 
   node->size = vSize;
   node->used = 0;
+  node->cached = 0;
   node->blocks = blocks;
   node->density = density;
   node->largestBlock = vSize;
 
-  ::memset(data, 0, bsize * 2);
+  node->largePageRequested = largePageRequested;
+  node->largePageKind = static_cast<uint8_t>(largePageKind);
+
+  ::memset(data, 0, bsize * 2 + fsize);
   node->baUsed = reinterpret_cast<size_t*>(data);
   node->baCont = reinterpret_cast<size_t*>(data + bsize);
+  node->baFull = reinterpret_cast<size_t*>(data + bsize * 2);
 
   return node;
 }
 
-static void vMemMgrInsertNode(VMemMgr* self, MemNode* node) noexcept {
-  if (!self->_root) {
-    // Empty tree case.
-    self->_root = node;
+//! \internal
+//!
+//! Release virtual memory and heap memory associated with `node`.
+static void vMemMgrDestroyNode(VMemMgr* self, MemNode* node, bool keepVirtualMemory) noexcept {
+  if (!keepVirtualMemory)
+    vMemMgrReleaseVMem(self, node->mem, node->memRW, node->size);
+
+  Internal::releaseMemory(node->baUsed);
+  Internal::releaseMemory(node);
+}
+
+//! \internal
+//!
+//! Update statistics of a `node` that was inserted to the tree.
+static ASMJIT_INLINE void vMemMgrNodeInserted(VMemMgr* self, MemNode* node) noexcept {
+  self->_allocatedBytes += node->size;
+  if (!node->largePageRequested)
+    return;
+
+  if (node->largePageKind != OSUtils::kLargePageNone) {
+    self->_largePageHits++;
+    self->_largePageBytes += node->size;
   }
   else {
-    // False tree root.
-    RbNode head = { { nullptr, nullptr }, 0, 0 };
+    self->_largePageMisses++;
+  }
+}
 
-    // Grandparent & parent.
-    RbNode* g = nullptr;
-    RbNode* t = &head;
+//! \internal
+//!
+//! Update statistics of a `node` that was removed from the tree.
+static ASMJIT_INLINE void vMemMgrNodeRemoved(VMemMgr* self, MemNode* node) noexcept {
+  self->_allocatedBytes -= node->size;
+  if (node->largePageKind != OSUtils::kLargePageNone)
+    self->_largePageBytes -= node->size;
+}
+
+//! \internal
+//!
+//! Link `node` to either the shared list or to the list of its arena.
+static void vMemMgrLinkNode(VMemMgr* self, MemNode* node) noexcept {
+  Arena* arena = node->arena;
+
+  if (arena) {
+    MemNode* first = arena->first;
+
+    node->prev = nullptr;
+    node->next = first;
+
+    if (first) first->prev = node;
+    arena->first = node;
+    return;
+  }
+
+  node->prev = self->_last;
+  node->next = nullptr;
+
+  if (!self->_first) {
+    self->_first = node;
+    self->_last = node;
+    self->_optimal = node;
+  }
+  else {
+    self->_last->next = node;
+    self->_last = node;
+  }
+}
+
+//! \internal
+//!
+//! Unlink `node` from either the shared list or from the list of its arena.
+static void vMemMgrUnlinkNode(VMemMgr* self, MemNode* node) noexcept {
+  MemNode* next = node->next;
+  MemNode* prev = node->prev;
+  Arena* arena = node->arena;
+
+  if (prev)
+    prev->next = next;
+  else if (arena)
+    arena->first = next;
+  else
+    self->_first = next;
+
+  if (next)
+    next->prev = prev;
+  else if (!arena)
+    self->_last = prev;
+
+  if (!arena && self->_optimal == node)
+    self->_optimal = prev ? prev : next;
+
+  node->prev = nullptr;
+  node->next = nullptr;
+}
+
+static void vMemMgrInsertNode(VMemMgr* self, MemNode* node) noexcept {
+  if (!self->_root) {
+    // Empty tree case.
+    self->_root = node;
+  }
+  else {
+    // False tree root.
+    RbNode head = { { nullptr, nullptr }, 0, 0, 0 };
+
+    // Grandparent & parent.
+    RbNode* g = nullptr;
+    RbNode* t = &head;
 
     // Iterator & parent.
     RbNode* p = nullptr;
@@ -372,29 +1027,19 @@ static void vMemMgrInsertNode(VMemMgr* self, MemNode* node) noexcept {
   self->_root->red = 0;
 
   // Link with others.
-  node->prev = self->_last;
-
-  if (!self->_first) {
-    self->_first = node;
-    self->_last = node;
-    self->_optimal = node;
-  }
-  else {
-    node->prev = self->_last;
-    self->_last->next = node;
-    self->_last = node;
-  }
+  vMemMgrLinkNode(self, node);
 }
 
 //! \internal
 //!
-//! Remove node from Red-Black tree.
+//! Remove node from Red-Black tree and unlink it from its list.
 //!
-//! Returns node that should be freed, but it doesn't have to be necessarily
-//! the `node` passed.
-static MemNode* vMemMgrRemoveNode(VMemMgr* self, MemNode* node) noexcept {
+//! NOTE: Nodes are never copied, the `node` passed is always the node that
+//! is removed, so pointers to other nodes (which can be held by arenas) stay
+//! valid.
+static void vMemMgrRemoveNode(VMemMgr* self, MemNode* node) noexcept {
   // False tree root.
-  RbNode head = { { nullptr, nullptr }, 0, 0 };
+  RbNode head = { { nullptr, nullptr }, 0, 0, 0 };
 
   // Helpers.
   RbNode* q = &head;
@@ -460,35 +1105,32 @@ static MemNode* vMemMgrRemoveNode(VMemMgr* self, MemNode* node) noexcept {
   ASMJIT_ASSERT(f != &head);
   ASMJIT_ASSERT(q != &head);
 
+  // Unlink `q` (the in-order neighbor of `f`, or `f` itself) from the tree.
+  p->node[p->node[1] == q] = q->node[q->node[0] == nullptr];
+
+  // If `f` and `q` differ, `q` takes the position (and color) of `f` instead
+  // of copying its content to `f`, which would invalidate node pointers.
   if (f != q) {
-    ASMJIT_ASSERT(f != &head);
-    static_cast<MemNode*>(f)->init(static_cast<MemNode*>(q));
-  }
+    RbNode* fp = &head;
+    int fdir = 1;
 
-  p->node[p->node[1] == q] = q->node[q->node[0] == nullptr];
+    while (fp->node[fdir] != f) {
+      fp = fp->node[fdir];
+      fdir = fp->mem < f->mem;
+    }
+
+    q->node[0] = f->node[0];
+    q->node[1] = f->node[1];
+    q->red = f->red;
+    fp->node[fdir] = q;
+  }
 
   // Update root and make it black.
   self->_root = static_cast<MemNode*>(head.node[1]);
   if (self->_root) self->_root->red = 0;
 
   // Unlink.
-  MemNode* next = static_cast<MemNode*>(q)->next;
-  MemNode* prev = static_cast<MemNode*>(q)->prev;
-
-  if (prev)
-    prev->next = next;
-  else
-    self->_first = next;
-
-  if (next)
-    next->prev = prev;
-  else
-    self->_last  = prev;
-
-  if (self->_optimal == q)
-    self->_optimal = prev ? prev : next;
-
-  return static_cast<MemNode*>(q);
+  vMemMgrUnlinkNode(self, node);
 }
 
 static MemNode* vMemMgrFindNodeByPtr(VMemMgr* self, uint8_t* mem) noexcept {
@@ -515,209 +1157,784 @@ static MemNode* vMemMgrFindNodeByPtr(VMemMgr* self, uint8_t* mem) noexcept {
   return node;
 }
 
-static void* vMemMgrAllocPermanent(VMemMgr* self, size_t vSize) noexcept {
-  static const size_t permanentAlignment = 32;
-  static const size_t permanentNodeSize  = 32768;
-
-  vSize = Utils::alignTo<size_t>(vSize, permanentAlignment);
-
-  AutoLock locked(self->_lock);
-  PermanentNode* node = self->_permanent;
-
-  // Try to find space in allocated chunks.
-  while (node && vSize > node->getAvailable())
-    node = node->prev;
-
-  // Or allocate new node.
-  if (!node) {
-    size_t nodeSize = permanentNodeSize;
-    if (nodeSize < vSize) nodeSize = vSize;
-
-    node = static_cast<PermanentNode*>(Internal::allocMemory(sizeof(PermanentNode)));
-    if (!node) return nullptr;
-
-    node->mem = vMemMgrAllocVMem(self, nodeSize, &node->size);
-    if (!node->mem) {
-      Internal::releaseMemory(node);
-      return nullptr;
-    }
-
-    node->used = 0;
-    node->prev = self->_permanent;
-    self->_permanent = node;
-  }
-
-  // Finally, copy function code to our space we reserved for.
-  uint8_t* result = node->mem + node->used;
-
-  // Update Statistics.
-  node->used += vSize;
-  self->_usedBytes += vSize;
-
-  // Code can be null to only reserve space for code.
-  return static_cast<void*>(result);
-}
-
-static void* vMemMgrAllocFreeable(VMemMgr* self, size_t vSize) noexcept {
-  // Current index.
-  size_t i;
-
-  // How many we need to be freed.
-  size_t need;
-  size_t minVSize;
-
-  // Align to 32 bytes by default.
-  vSize = Utils::alignTo<size_t>(vSize, 32);
-  if (vSize == 0)
-    return nullptr;
-
-  AutoLock locked(self->_lock);
-  MemNode* node = self->_optimal;
-  minVSize = self->_blockSize;
-
-  // Try to find memory block in existing nodes.
-  while (node) {
-    // Skip this node?
-    if ((node->getAvailable() < vSize) || (node->largestBlock < vSize && node->largestBlock != 0)) {
-      MemNode* next = node->next;
-
-      if (node->getAvailable() < minVSize && node == self->_optimal && next)
-        self->_optimal = next;
+//! \internal
+//!
+//! Find `need` continuous unused blocks in `node`.
+//!
+//! Returns the index of the first block or `Globals::kInvalidIndex` if there
+//! is no such space, in which case `node->largestBlock` is updated.
+static size_t vMemMgrFindUnusedBlocks(MemNode* node, size_t need) noexcept {
+  size_t* up = node->baUsed;     // Current ubits address.
+  size_t ubits;                  // Current ubits[0] value.
+  size_t bit;                    // Current bit mask.
+  size_t blocks = node->blocks;  // Count of blocks in node.
+  size_t cont = 0;               // How many bits are currently freed in find loop.
+  size_t maxCont = 0;            // Largest continuous block (bits count).
+  size_t i = 0;
+  size_t j;
+
+  // Try to find node that is large enough.
+  while (i < blocks) {
+    ubits = *up++;
+
+    // Fast skip used blocks.
+    if (ubits == ~(size_t)0) {
+      if (cont > maxCont)
+        maxCont = cont;
+      cont = 0;
 
-      node = next;
+      i += kBitsPerEntity;
       continue;
     }
 
-    size_t* up = node->baUsed;     // Current ubits address.
-    size_t ubits;                  // Current ubits[0] value.
-    size_t bit;                    // Current bit mask.
-    size_t blocks = node->blocks;  // Count of blocks in node.
-    size_t cont = 0;               // How many bits are currently freed in find loop.
-    size_t maxCont = 0;            // Largest continuous block (bits count).
-    size_t j;
-
-    need = M_DIV((vSize + node->density - 1), node->density);
-    i = 0;
-
-    // Try to find node that is large enough.
-    while (i < blocks) {
-      ubits = *up++;
+    size_t max = kBitsPerEntity;
+    if (i + max > blocks)
+      max = blocks - i;
 
-      // Fast skip used blocks.
-      if (ubits == ~(size_t)0) {
-        if (cont > maxCont)
-          maxCont = cont;
-        cont = 0;
-
-        i += kBitsPerEntity;
+    for (j = 0, bit = 1; j < max; bit <<= 1) {
+      j++;
+      if ((ubits & bit) == 0) {
+        if (++cont == need)
+          return i + j - cont;
         continue;
       }
 
-      size_t max = kBitsPerEntity;
-      if (i + max > blocks)
-        max = blocks - i;
-
-      for (j = 0, bit = 1; j < max; bit <<= 1) {
-        j++;
-        if ((ubits & bit) == 0) {
-          if (++cont == need) {
-            i += j;
-            i -= cont;
-            goto L_Found;
-          }
-
-          continue;
-        }
-
-        if (cont > maxCont) maxCont = cont;
-        cont = 0;
-      }
-
-      i += kBitsPerEntity;
+      if (cont > maxCont) maxCont = cont;
+      cont = 0;
     }
 
-    // Because we traversed the entire node, we can set largest node size that
-    // will be used to cache next traversing.
-    node->largestBlock = maxCont * node->density;
-
-    node = node->next;
+    i += kBitsPerEntity;
   }
 
-  // If we are here, we failed to find existing memory block and we must
-  // allocate a new one.
-  {
-    size_t blockSize = self->_blockSize;
-    if (blockSize < vSize) blockSize = vSize;
+  // Because we traversed the entire node, we can set largest node size that
+  // will be used to cache next traversing.
+  node->largestBlock = maxCont * node->density;
+  return Globals::kInvalidIndex;
+}
 
-    node = vMemMgrCreateNode(self, blockSize, self->_blockDensity);
-    if (!node) return nullptr;
+//! \internal
+//!
+//! Find `need` continuous unused blocks in `node` by using `baFull` to skip
+//! full words of `baUsed`, see `VMemMgr::kStrategyBitmap` and `_FindUnusedRun()`.
+//!
+//! Returns the index of the first block or `Globals::kInvalidIndex` if there
+//! is no such space, in which case `node->largestBlock` is updated.
+static size_t vMemMgrFindUnusedBlocksBitmap(MemNode* node, size_t need) noexcept {
+  size_t i = _FindUnusedRun(node->baUsed, node->baFull, node->blocks, need);
+
+  // There is no run of `need` blocks, so the largest one is smaller.
+  if (i == Globals::kInvalidIndex)
+    node->largestBlock = (need - 1) * node->density;
+  return i;
+}
 
-    // Update binary tree.
-    vMemMgrInsertNode(self, node);
-    ASMJIT_ASSERT(vMemMgrCheckTree(self));
+//! \internal
+//!
+//! Find `need` continuous unused blocks in `node` by using the strategy of
+//! the memory manager.
+static ASMJIT_INLINE size_t vMemMgrFindBlocks(VMemMgr* self, MemNode* node, size_t need) noexcept {
+  if (self->_strategy == VMemMgr::kStrategyBitmap)
+    return vMemMgrFindUnusedBlocksBitmap(node, need);
+  else
+    return vMemMgrFindUnusedBlocks(node, need);
+}
 
-    // Alloc first node at start.
-    i = 0;
-    need = (vSize + node->density - 1) / node->density;
+//! \internal
+//!
+//! Update `baFull` bits of `baUsed` words that contain `count` blocks starting
+//! at `index`.
+static ASMJIT_INLINE void vMemMgrUpdateFull(MemNode* node, size_t index, size_t count) noexcept {
+  _UpdateFull(node->baUsed, node->baFull, index, count);
+}
 
-    // Update statistics.
-    self->_allocatedBytes += node->size;
+//! \internal
+//!
+//! Get how many blocks are used by the allocation at `p`.
+static size_t vMemMgrGetBlockCount(MemNode* node, uint8_t* p) noexcept {
+  size_t bitpos = M_DIV((size_t)(p - node->mem), node->density);
+  size_t count = 1;
+
+  while (node->baCont[bitpos / kBitsPerEntity] & ((size_t)1 << (bitpos % kBitsPerEntity))) {
+    bitpos++;
+    count++;
   }
 
-L_Found:
+  return count;
+}
+
+//! \internal
+//!
+//! Mark `need` blocks starting at `i` as used and return their address.
+static uint8_t* vMemMgrMarkUsed(MemNode* node, size_t i, size_t need) noexcept {
   // Update bits.
   _SetBits(node->baUsed, i, need);
   _SetBits(node->baCont, i, need - 1);
+  vMemMgrUpdateFull(node, i, need);
 
   // Update statistics.
-  {
-    size_t u = need * node->density;
-    node->used += u;
-    node->largestBlock = 0;
-    self->_usedBytes += u;
-  }
+  node->used += need * node->density;
+  node->largestBlock = 0;
 
-  // And return pointer to allocated memory.
-  uint8_t* result = node->mem + i * node->density;
-  ASMJIT_ASSERT(result >= node->mem && result <= node->mem + node->size - vSize);
-  return result;
+  return node->mem + i * node->density;
 }
 
 //! \internal
 //!
-//! Reset the whole `VMemMgr` instance, freeing all heap memory allocated an
-//! virtual memory allocated unless `keepVirtualMemory` is true (and this is
-//! only used when writing data to a remote process).
-static void vMemMgrReset(VMemMgr* self, bool keepVirtualMemory) noexcept {
-  MemNode* node = self->_first;
+//! Mark all blocks of the allocation at `p` as unused.
+//!
+//! Returns the number of bytes released.
+static size_t vMemMgrMarkUnused(MemNode* node, uint8_t* p) noexcept {
+  size_t offset = (size_t)(p - node->mem);
+  size_t bitpos = M_DIV(offset, node->density);
+  size_t i = (bitpos / kBitsPerEntity);
 
-  while (node) {
-    MemNode* next = node->next;
+  size_t* up = node->baUsed + i;  // Current ubits address.
+  size_t* cp = node->baCont + i;  // Current cbits address.
+  size_t ubits = *up;             // Current ubits[0] value.
+  size_t cbits = *cp;             // Current cbits[0] value.
+  size_t bit = (size_t)1 << (bitpos % kBitsPerEntity);
 
-    if (!keepVirtualMemory)
-      vMemMgrReleaseVMem(self, node->mem, node->size);
+  size_t cont = 0;
+  bool stop;
 
-    Internal::releaseMemory(node->baUsed);
-    Internal::releaseMemory(node);
+  for (;;) {
+    stop = (cbits & bit) == 0;
+    ubits &= ~bit;
+    cbits &= ~bit;
 
-    node = next;
+    bit <<= 1;
+    cont++;
+
+    if (stop || bit == 0) {
+      *up = ubits;
+      *cp = cbits;
+      if (stop)
+        break;
+
+      ubits = *++up;
+      cbits = *++cp;
+      bit = 1;
+    }
   }
+  vMemMgrUpdateFull(node, bitpos, cont);
 
-  self->_allocatedBytes = 0;
-  self->_usedBytes = 0;
+  // Statistics.
+  cont *= node->density;
+  if (node->largestBlock < cont)
+    node->largestBlock = cont;
 
-  self->_root = nullptr;
-  self->_first = nullptr;
-  self->_last = nullptr;
-  self->_optimal = nullptr;
+  node->used -= cont;
+  return cont;
 }
 
-// ============================================================================
-// [asmjit::VMemMgr - Construction / Destruction]
-// ============================================================================
+//! \internal
+//!
+//! Mark the tail blocks of the allocation at `p` that are not needed to hold
+//! `used` bytes as unused.
+//!
+//! Returns the number of bytes released.
+static size_t vMemMgrMarkShrunk(MemNode* node, uint8_t* p, size_t used) noexcept {
+  size_t offset = (size_t)(p - node->mem);
+  size_t bitpos = M_DIV(offset, node->density);
+  size_t i = (bitpos / kBitsPerEntity);
 
-#if !ASMJIT_OS_WINDOWS
-VMemMgr::VMemMgr() noexcept {
+  size_t* up = node->baUsed + i;  // Current ubits address.
+  size_t* cp = node->baCont + i;  // Current cbits address.
+  size_t ubits = *up;             // Current ubits[0] value.
+  size_t cbits = *cp;             // Current cbits[0] value.
+  size_t bit = (size_t)1 << (bitpos % kBitsPerEntity);
+
+  size_t cont = 0;
+  size_t usedBlocks = (used + node->density - 1) / node->density;
+
+  bool stop;
+
+  // Find the first block we can mark as free.
+  for (;;) {
+    stop = (cbits & bit) == 0;
+    if (stop)
+      return 0;
+
+    if (++cont == usedBlocks)
+      break;
+
+    bit <<= 1;
+    if (bit == 0) {
+      ubits = *++up;
+      cbits = *++cp;
+      bit = 1;
+    }
+  }
+
+  // Free the tail blocks.
+  cont = ~(size_t)0;
+  goto _EnterFreeLoop;
+
+  for (;;) {
+    stop = (cbits & bit) == 0;
+    ubits &= ~bit;
+
+_EnterFreeLoop:
+    cbits &= ~bit;
+
+    bit <<= 1;
+    cont++;
+
+    if (stop || bit == 0) {
+      *up = ubits;
+      *cp = cbits;
+      if (stop)
+        break;
+
+      ubits = *++up;
+      cbits = *++cp;
+      bit = 1;
+    }
+  }
+  vMemMgrUpdateFull(node, bitpos + usedBlocks, cont);
+
+  // Statistics.
+  cont *= node->density;
+  if (node->largestBlock < cont)
+    node->largestBlock = cont;
+
+  node->used -= cont;
+  return cont;
+}
+
+//! \internal
+//!
+//! Mark the allocation at `p` of a shared `node` as unused and release the
+//! node if it became empty.
+//!
+//! Returns the number of bytes released.
+static size_t vMemMgrReleaseShared(VMemMgr* self, MemNode* node, uint8_t* p) noexcept {
+  // If the freed block is fully allocated node then it's needed to
+  // update 'optimal' pointer in memory manager.
+  if (node->used == node->size) {
+    MemNode* cur = self->_optimal;
+
+    do {
+      cur = cur->prev;
+      if (cur == node) {
+        self->_optimal = node;
+        break;
+      }
+    } while (cur);
+  }
+
+  size_t released = vMemMgrMarkUnused(node, p);
+
+  // If page is empty, we can free it. The last block backed by large pages
+  // is kept as mapping large pages is expensive.
+  if (node->used == 0 && !(node->largePageRequested && self->_first == node && self->_last == node)) {
+    // Statistics.
+    vMemMgrNodeRemoved(self, node);
+
+    // Remove node and free memory associated with it (this memory is not
+    // accessed anymore so it's safe).
+    vMemMgrRemoveNode(self, node);
+    ASMJIT_ASSERT(vMemMgrCheckTree(self));
+
+    vMemMgrDestroyNode(self, node, false);
+  }
+
+  return released;
+}
+
+//! \internal
+//!
+//! Release all allocations cached by size classes.
+//!
+//! Returns true if there was at least one allocation released.
+static bool vMemMgrFlushSizeClasses(VMemMgr* self) noexcept {
+  SizeClassCache* cache = self->_sizeClasses;
+  if (!cache) return false;
+
+  bool released = false;
+  for (uint32_t c = 0; c < kSizeClassCount; c++) {
+    uint32_t count = cache->count[c];
+
+    for (uint32_t j = 0; j < count; j++) {
+      uint8_t* p = static_cast<uint8_t*>(cache->items[c][j]);
+      MemNode* node = vMemMgrFindNodeByPtr(self, p);
+
+      ASMJIT_ASSERT(node != nullptr);
+      node->cached -= (c + 1) * node->density;
+      vMemMgrReleaseShared(self, node, p);
+    }
+
+    cache->count[c] = 0;
+    released |= count != 0;
+  }
+
+  return released;
+}
+
+//! \internal
+//!
+//! Release all allocations of `node` cached by size classes.
+//!
+//! The caller must hold another allocation of `node` so the node is not
+//! destroyed while its cached items are being released.
+static void vMemMgrFlushNodeSizeClasses(VMemMgr* self, MemNode* node) noexcept {
+  SizeClassCache* cache = self->_sizeClasses;
+  ASMJIT_ASSERT(cache != nullptr);
+
+  uint8_t* nodeStart = node->mem;
+  uint8_t* nodeEnd = node->mem + node->size;
+
+  for (uint32_t c = 0; c < kSizeClassCount && node->cached != 0; c++) {
+    uint32_t count = cache->count[c];
+    uint32_t kept = 0;
+
+    for (uint32_t j = 0; j < count; j++) {
+      uint8_t* p = static_cast<uint8_t*>(cache->items[c][j]);
+      if (p >= nodeStart && p < nodeEnd) {
+        node->cached -= (c + 1) * node->density;
+        vMemMgrReleaseShared(self, node, p);
+      }
+      else {
+        cache->items[c][kept++] = p;
+      }
+    }
+
+    cache->count[c] = kept;
+  }
+
+  ASMJIT_ASSERT(node->cached == 0);
+  ASMJIT_ASSERT(node->used != 0);
+}
+
+static void* vMemMgrAllocPermanent(VMemMgr* self, size_t vSize, void** rwPtr) noexcept {
+  static const size_t permanentAlignment = 32;
+  static const size_t permanentNodeSize  = 32768;
+
+  vSize = Utils::alignTo<size_t>(vSize, permanentAlignment);
+
+  VMemMgrAutoLock locked(self);
+  PermanentNode* node = self->_permanent;
+
+  // Try to find space in allocated chunks.
+  while (node && vSize > node->getAvailable())
+    node = node->prev;
+
+  // Or allocate new node.
+  if (!node) {
+    size_t nodeSize = permanentNodeSize;
+    if (nodeSize < vSize) nodeSize = vSize;
+
+    node = static_cast<PermanentNode*>(Internal::allocMemory(sizeof(PermanentNode)));
+    if (!node) return nullptr;
+
+    node->mem = vMemMgrAllocVMem(self, nodeSize, &node->size, &node->memRW);
+    if (!node->mem) {
+      Internal::releaseMemory(node);
+      return nullptr;
+    }
+
+    node->used = 0;
+    node->prev = self->_permanent;
+    self->_permanent = node;
+  }
+
+  // Finally, copy function code to our space we reserved for.
+  uint8_t* result = node->mem + node->used;
+
+  *rwPtr = node->memRW + node->used;
+
+  // Update Statistics.
+  node->used += vSize;
+  self->_usedBytes += vSize;
+  vMemMgrCountAlloc(self->_counters, vSize);
+
+  // Code can be null to only reserve space for code.
+  return static_cast<void*>(result);
+}
+
+static void* vMemMgrAllocFreeable(VMemMgr* self, size_t vSize, void** rwPtr) noexcept {
+  // Current index.
+  size_t i;
+
+  // How many we need to be freed.
+  size_t need;
+  size_t minVSize;
+
+  // Align to 32 bytes by default.
+  vSize = Utils::alignTo<size_t>(vSize, 32);
+  if (vSize == 0)
+    return nullptr;
+
+  VMemMgrAutoLock locked(self);
+  MemNode* node;
+  minVSize = self->_blockSize;
+
+  // Reuse a cached allocation of the same size class.
+  SizeClassCache* cache = self->_sizeClasses;
+  if (cache) {
+    need = M_DIV((vSize + self->_blockDensity - 1), self->_blockDensity);
+    if (need <= kSizeClassCount && cache->count[need - 1] != 0) {
+      uint8_t* result = static_cast<uint8_t*>(cache->items[need - 1][--cache->count[need - 1]]);
+
+      node = vMemMgrFindNodeByPtr(self, result);
+      ASMJIT_ASSERT(node != nullptr);
+
+      node->cached -= need * node->density;
+      self->_usedBytes += need * node->density;
+      vMemMgrCountAlloc(self->_counters, vSize);
+
+      *rwPtr = node->memRW + (size_t)(result - node->mem);
+      return result;
+    }
+  }
+
+L_Retry:
+  node = self->_optimal;
+
+  // Try to find memory block in existing nodes.
+  while (node) {
+    // Skip this node?
+    if ((node->getAvailable() < vSize) || (node->largestBlock < vSize && node->largestBlock != 0)) {
+      MemNode* next = node->next;
+
+      if (node->getAvailable() < minVSize && node == self->_optimal && next)
+        self->_optimal = next;
+
+      node = next;
+      continue;
+    }
+
+    need = M_DIV((vSize + node->density - 1), node->density);
+    i = vMemMgrFindBlocks(self, node, need);
+
+    if (i != Globals::kInvalidIndex)
+      goto L_Found;
+
+    node = node->next;
+  }
+
+  // Cached allocations may be what prevents the allocation from succeeding.
+  if (vMemMgrFlushSizeClasses(self))
+    goto L_Retry;
+
+  // If we are here, we failed to find existing memory block and we must
+  // allocate a new one.
+  {
+    size_t blockSize = self->_blockSize;
+    if (blockSize < vSize) blockSize = vSize;
+
+    node = vMemMgrCreateNode(self, blockSize, self->_blockDensity);
+    if (!node) return nullptr;
+
+    // Update binary tree.
+    vMemMgrInsertNode(self, node);
+    ASMJIT_ASSERT(vMemMgrCheckTree(self));
+
+    // Alloc first node at start.
+    i = 0;
+    need = (vSize + node->density - 1) / node->density;
+
+    // Update statistics.
+    vMemMgrNodeInserted(self, node);
+  }
+
+L_Found:
+  {
+    // And return pointer to allocated memory.
+    uint8_t* result = vMemMgrMarkUsed(node, i, need);
+    self->_usedBytes += need * node->density;
+    vMemMgrCountAlloc(self->_counters, vSize);
+
+    ASMJIT_ASSERT(result >= node->mem && result <= node->mem + node->size - vSize);
+    *rwPtr = node->memRW + (size_t)(result - node->mem);
+    return result;
+  }
+}
+
+// ============================================================================
+// [asmjit::VMemMgr - Arenas]
+// ============================================================================
+
+static ASMJIT_INLINE Arena* vMemMgrGetArenaTls(VMemMgr* self) noexcept {
+#if ASMJIT_OS_WINDOWS
+  return static_cast<Arena*>(::TlsGetValue(self->_arenaKey));
+#else
+  return static_cast<Arena*>(::pthread_getspecific(self->_arenaKey));
+#endif
+}
+
+static ASMJIT_INLINE void vMemMgrSetArenaTls(VMemMgr* self, Arena* arena) noexcept {
+#if ASMJIT_OS_WINDOWS
+  ::TlsSetValue(self->_arenaKey, arena);
+#else
+  ::pthread_setspecific(self->_arenaKey, arena);
+#endif
+}
+
+#if !ASMJIT_OS_WINDOWS
+//! \internal
+//!
+//! Called by pthreads when a thread that has an arena exits.
+static void vMemMgrArenaThreadExit(void* p) noexcept {
+  Arena* arena = static_cast<Arena*>(p);
+  VMemMgrAutoLock locked(arena->mgr);
+  arena->orphaned = true;
+}
+#endif // !ASMJIT_OS_WINDOWS
+
+static Error vMemMgrCreateArenaKey(VMemMgr* self) noexcept {
+  if (self->_arenaKeyValid)
+    return kErrorOk;
+
+#if ASMJIT_OS_WINDOWS
+  DWORD key = ::TlsAlloc();
+  if (ASMJIT_UNLIKELY(key == TLS_OUT_OF_INDEXES))
+    return DebugUtils::errored(kErrorInvalidState);
+  self->_arenaKey = key;
+#else
+  if (ASMJIT_UNLIKELY(::pthread_key_create(&self->_arenaKey, vMemMgrArenaThreadExit) != 0))
+    return DebugUtils::errored(kErrorInvalidState);
+#endif
+
+  self->_arenaKeyValid = true;
+  return kErrorOk;
+}
+
+static void vMemMgrDeleteArenaKey(VMemMgr* self) noexcept {
+  if (!self->_arenaKeyValid)
+    return;
+
+#if ASMJIT_OS_WINDOWS
+  ::TlsFree(self->_arenaKey);
+#else
+  ::pthread_key_delete(self->_arenaKey);
+#endif
+
+  self->_arenaKeyValid = false;
+}
+
+//! \internal
+//!
+//! Get the arena of the current thread, creates a new one or adopts an arena
+//! of an exited thread if `create` is true.
+static Arena* vMemMgrGetArena(VMemMgr* self, bool create) noexcept {
+  if (!self->_arenaKeyValid)
+    return nullptr;
+
+  Arena* arena = vMemMgrGetArenaTls(self);
+  if (arena || !create)
+    return arena;
+
+  VMemMgrAutoLock locked(self);
+
+  // Prefer an arena of a thread that has already exited.
+  for (arena = self->_arenas; arena; arena = arena->next) {
+    if (arena->orphaned) {
+      arena->orphaned = false;
+      break;
+    }
+  }
+
+  if (!arena) {
+    void* arenaData = Internal::allocMemory(sizeof(Arena));
+    if (ASMJIT_UNLIKELY(!arenaData))
+      return nullptr;
+
+    arena = new(arenaData) Arena();
+    arena->mgr = self;
+    arena->next = self->_arenas;
+    arena->first = nullptr;
+    arena->spare = nullptr;
+    arena->remote = nullptr;
+    arena->usedBytes = 0;
+    arena->orphaned = false;
+    ::memset(&arena->counters, 0, sizeof(Counters));
+    self->_arenas = arena;
+  }
+
+  vMemMgrSetArenaTls(self, arena);
+  return arena;
+}
+
+static MemNode* vMemMgrFindArenaNode(Arena* arena, uint8_t* p) noexcept {
+  MemNode* node = arena->first;
+  while (node) {
+    if (p >= node->mem && p < node->mem + node->size)
+      break;
+    node = node->next;
+  }
+  return node;
+}
+
+//! \internal
+//!
+//! Get the size of nodes of arenas.
+static ASMJIT_INLINE size_t vMemMgrGetArenaNodeSize(const VMemMgr* self) noexcept {
+  return std::max<size_t>(self->_blockSize, kArenaNodeSize);
+}
+
+//! \internal
+//!
+//! Release `node` if it's empty, unless the arena has no spare node, in which
+//! case it becomes the spare node. Keeping one empty node avoids mapping and
+//! unmapping a node (and taking `VMemMgr::_lock`) when the thread repeatedly
+//! allocates and releases all of its memory.
+static void vMemMgrArenaCompact(VMemMgr* self, Arena* arena, MemNode* node) noexcept {
+  if (node->used != 0 || arena->spare == node)
+    return;
+
+  if (!arena->spare) {
+    arena->spare = node;
+    return;
+  }
+
+  {
+    VMemMgrAutoLock locked(self);
+    vMemMgrRemoveNode(self, node);
+    ASMJIT_ASSERT(vMemMgrCheckTree(self));
+
+    vMemMgrNodeRemoved(self, node);
+  }
+
+  vMemMgrDestroyNode(self, node, false);
+}
+
+//! \internal
+//!
+//! Process all releases requested by other threads, must be called by the
+//! thread that owns `arena`.
+static void vMemMgrArenaProcessRemote(VMemMgr* self, Arena* arena) noexcept {
+  if (!arena->remote)
+    return;
+
+  RemoteRelease* item = vMemMgrAtomicTakeAll(&arena->remote);
+  while (item) {
+    RemoteRelease* next = item->next;
+    uint8_t* p = static_cast<uint8_t*>(item->p);
+
+    MemNode* node = vMemMgrFindArenaNode(arena, p);
+    ASMJIT_ASSERT(node != nullptr);
+
+    arena->usedBytes -= vMemMgrMarkUnused(node, p);
+    vMemMgrArenaCompact(self, arena, node);
+
+    Internal::releaseMemory(item);
+    item = next;
+  }
+}
+
+static void* vMemMgrAllocArena(VMemMgr* self, Arena* arena, size_t vSize, void** rwPtr) noexcept {
+  vMemMgrArenaProcessRemote(self, arena);
+
+  MemNode* node;
+  size_t i = Globals::kInvalidIndex;
+  size_t need = 0;
+
+  for (node = arena->first; node; node = node->next) {
+    if ((node->getAvailable() < vSize) || (node->largestBlock < vSize && node->largestBlock != 0))
+      continue;
+
+    need = M_DIV((vSize + node->density - 1), node->density);
+    i = vMemMgrFindBlocks(self, node, need);
+
+    if (i != Globals::kInvalidIndex)
+      break;
+  }
+
+  if (!node) {
+    node = vMemMgrCreateNode(self, vMemMgrGetArenaNodeSize(self), self->_blockDensity);
+    if (!node) return nullptr;
+
+    node->arena = arena;
+    {
+      VMemMgrAutoLock locked(self);
+      vMemMgrInsertNode(self, node);
+      ASMJIT_ASSERT(vMemMgrCheckTree(self));
+
+      vMemMgrNodeInserted(self, node);
+    }
+
+    i = 0;
+    need = (vSize + node->density - 1) / node->density;
+  }
+
+  if (node == arena->spare)
+    arena->spare = nullptr;
+
+  uint8_t* result = vMemMgrMarkUsed(node, i, need);
+  arena->usedBytes += need * node->density;
+  vMemMgrCountAlloc(arena->counters, vSize);
+
+  ASMJIT_ASSERT(result >= node->mem && result <= node->mem + node->size - vSize);
+  *rwPtr = node->memRW + (size_t)(result - node->mem);
+  return result;
+}
+
+//! \internal
+//!
+//! Reset the whole `VMemMgr` instance, freeing all heap memory allocated an
+//! virtual memory allocated unless `keepVirtualMemory` is true (and this is
+//! only used when writing data to a remote process).
+static void vMemMgrReset(VMemMgr* self, bool keepVirtualMemory) noexcept {
+  MemNode* node = self->_first;
+
+  while (node) {
+    MemNode* next = node->next;
+    vMemMgrDestroyNode(self, node, keepVirtualMemory);
+    node = next;
+  }
+
+  Arena* arena = self->_arenas;
+  while (arena) {
+    Arena* nextArena = arena->next;
+
+    node = arena->first;
+    while (node) {
+      MemNode* next = node->next;
+      vMemMgrDestroyNode(self, node, keepVirtualMemory);
+      node = next;
+    }
+
+    RemoteRelease* item = arena->remote;
+    while (item) {
+      RemoteRelease* next = item->next;
+      Internal::releaseMemory(item);
+      item = next;
+    }
+
+    arena->~Arena();
+    Internal::releaseMemory(arena);
+    arena = nextArena;
+  }
+
+  // Threads can still refer to destroyed arenas through their thread-local
+  // storage, so the key has to be recreated.
+  if (self->_arenaKeyValid) {
+    vMemMgrDeleteArenaKey(self);
+    if (self->_threadArenas && vMemMgrCreateArenaKey(self) != kErrorOk)
+      self->_threadArenas = false;
+  }
+
+  if (self->_sizeClasses)
+    ::memset(self->_sizeClasses->count, 0, sizeof(self->_sizeClasses->count));
+
+  self->_allocatedBytes = 0;
+  self->_usedBytes = 0;
+  self->_largePageBytes = 0;
+
+  self->_root = nullptr;
+  self->_first = nullptr;
+  self->_last = nullptr;
+  self->_optimal = nullptr;
+  self->_arenas = nullptr;
+}
+
+// ============================================================================
+// [asmjit::VMemMgr - Construction / Destruction]
+// ============================================================================
+
+#if !ASMJIT_OS_WINDOWS
+VMemMgr::VMemMgr() noexcept {
 #else
 VMemMgr::VMemMgr(HANDLE hProcess) noexcept {
 #endif
@@ -734,19 +1951,54 @@ VMemMgr::VMemMgr(HANDLE hProcess) noexcept {
   _allocatedBytes = 0;
   _usedBytes = 0;
 
+  _largePageBytes = 0;
+  _largePageHits = 0;
+  _largePageMisses = 0;
+
+  ::memset(&_counters, 0, sizeof(Counters));
+  _lockContentions = 0;
+  _lockWaitNs = 0;
+
+  _reservedBase = nullptr;
+  _reservedSize = 0;
+  _reservedGranularity = 0;
+  _reservedMap = nullptr;
+  _reservedFull = nullptr;
+
   _root = nullptr;
   _first = nullptr;
   _last = nullptr;
   _optimal = nullptr;
 
   _permanent = nullptr;
+  _arenas = nullptr;
+  _sizeClasses = nullptr;
+
   _keepVirtualMemory = false;
+  _threadArenas = false;
+  _arenaKeyValid = false;
+  _dualMapping = false;
+  _largePages = false;
+  _strategy = kStrategyFirstFit;
 }
 
 VMemMgr::~VMemMgr() noexcept {
+  // Thread arenas are not used anymore.
+  _threadArenas = false;
+
   // Freeable memory cleanup - Also frees the virtual memory if configured to.
   vMemMgrReset(this, _keepVirtualMemory);
 
+  if (_sizeClasses)
+    Internal::releaseMemory(_sizeClasses);
+
+  // The reserved range can contain permanent memory, which is kept.
+  if (_reservedBase) {
+    if (!_keepVirtualMemory)
+      vMemMgrReleaseReservedRange(this);
+    Internal::releaseMemory(_reservedMap);
+  }
+
   // Permanent memory cleanup - Never frees the virtual memory.
   PermanentNode* node = _permanent;
   while (node) {
@@ -765,176 +2017,466 @@ void VMemMgr::reset() noexcept {
 }
 
 // ============================================================================
-// [asmjit::VMemMgr - Alloc / Release]
+// [asmjit::VMemMgr - Accessors]
 // ============================================================================
 
-void* VMemMgr::alloc(size_t size, uint32_t type) noexcept {
-  if (type == kAllocPermanent)
-    return vMemMgrAllocPermanent(this, size);
-  else
-    return vMemMgrAllocFreeable(this, size);
+size_t VMemMgr::getUsedBytes() const noexcept {
+  size_t usedBytes;
+  Arena* arenas;
+
+  {
+    VMemMgrAutoLock locked(this);
+    usedBytes = _usedBytes;
+    arenas = _arenas;
+  }
+
+  // Arenas are only prepended and released by `reset()`, so the list can be
+  // walked. Their used bytes are only written by their threads.
+  for (Arena* arena = arenas; arena; arena = arena->next)
+    usedBytes += arena->usedBytes;
+
+  return usedBytes;
 }
 
-Error VMemMgr::release(void* p) noexcept {
-  if (!p) return kErrorOk;
+Error VMemMgr::setThreadArenas(bool val) noexcept {
+  if (val)
+    ASMJIT_PROPAGATE(vMemMgrCreateArenaKey(this));
 
-  AutoLock locked(_lock);
-  MemNode* node = vMemMgrFindNodeByPtr(this, static_cast<uint8_t*>(p));
-  if (!node) return DebugUtils::errored(kErrorInvalidArgument);
+  _threadArenas = val;
+  return kErrorOk;
+}
 
-  size_t offset = (size_t)((uint8_t*)p - (uint8_t*)node->mem);
-  size_t bitpos = M_DIV(offset, node->density);
-  size_t i = (bitpos / kBitsPerEntity);
+Error VMemMgr::setDualMapping(bool val) noexcept {
+  if (val == _dualMapping)
+    return kErrorOk;
 
-  size_t* up = node->baUsed + i;  // Current ubits address.
-  size_t* cp = node->baCont + i;  // Current cbits address.
-  size_t ubits = *up;             // Current ubits[0] value.
-  size_t cbits = *cp;             // Current cbits[0] value.
-  size_t bit = (size_t)1 << (bitpos % kBitsPerEntity);
+  // Blocks can't be mixed, the mode can only be changed if nothing has been
+  // allocated yet.
+  if (_allocatedBytes != 0 || _permanent != nullptr || _reservedBase != nullptr)
+    return DebugUtils::errored(kErrorInvalidState);
 
-  size_t cont = 0;
-  bool stop;
+  // Dual-mapped blocks are backed by regular pages only.
+  if (val && _largePages)
+    return DebugUtils::errored(kErrorInvalidState);
 
-  for (;;) {
-    stop = (cbits & bit) == 0;
-    ubits &= ~bit;
-    cbits &= ~bit;
+#if ASMJIT_OS_WINDOWS
+  // Views of the same section can only be mapped into the current process.
+  if (_hProcess != OSUtils::getVirtualMemoryInfo().hCurrentProcess)
+    return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_WINDOWS
 
-    bit <<= 1;
-    cont++;
+  _dualMapping = val;
+  return kErrorOk;
+}
 
-    if (stop || bit == 0) {
-      *up = ubits;
-      *cp = cbits;
-      if (stop)
-        break;
+Error VMemMgr::setStrategy(uint32_t strategy) noexcept {
+  if (ASMJIT_UNLIKELY(strategy > kStrategyBitmap))
+    return DebugUtils::errored(kErrorInvalidArgument);
 
-      ubits = *++up;
-      cbits = *++cp;
-      bit = 1;
-    }
+  VMemMgrAutoLock locked(this);
+  if (strategy == _strategy)
+    return kErrorOk;
+
+  if (strategy == kStrategyBitmap) {
+    SizeClassCache* cache = static_cast<SizeClassCache*>(Internal::allocMemory(sizeof(SizeClassCache)));
+    if (ASMJIT_UNLIKELY(!cache))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    ::memset(cache->count, 0, sizeof(cache->count));
+    _sizeClasses = cache;
+  }
+  else {
+    vMemMgrFlushSizeClasses(this);
+    Internal::releaseMemory(_sizeClasses);
+    _sizeClasses = nullptr;
   }
 
-  // If the freed block is fully allocated node then it's needed to
-  // update 'optimal' pointer in memory manager.
-  if (node->used == node->size) {
-    MemNode* cur = _optimal;
+  _strategy = static_cast<uint8_t>(strategy);
+  return kErrorOk;
+}
 
-    do {
-      cur = cur->prev;
-      if (cur == node) {
-        _optimal = node;
-        break;
+Error VMemMgr::reserve(size_t size, const void* hint) noexcept {
+  VMemMgrAutoLock locked(this);
+
+  if (_reservedBase || _allocatedBytes != 0 || _permanent != nullptr || _dualMapping || _largePages)
+    return DebugUtils::errored(kErrorInvalidState);
+
+  VMemInfo vm = OSUtils::getVirtualMemoryInfo();
+
+#if ASMJIT_OS_WINDOWS
+  // The range can only be reserved in the current process.
+  if (_hProcess != vm.hCurrentProcess)
+    return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_WINDOWS
+
+  size_t granularity = vm.pageGranularity;
+  size = Utils::alignTo<size_t>(size, granularity);
+
+  if (ASMJIT_UNLIKELY(size == 0))
+    return DebugUtils::errored(kErrorInvalidArgument);
+
+#if ASMJIT_ARCH_64BIT
+  if (ASMJIT_UNLIKELY(hint && static_cast<uint64_t>(size) >= kReservedMaxDistance))
+    return DebugUtils::errored(kErrorInvalidArgument);
+#endif // ASMJIT_ARCH_64BIT
+
+  size_t mapWords = (size / granularity + kBitsPerEntity - 1) / kBitsPerEntity;
+  size_t fullWords = (mapWords + kBitsPerEntity - 1) / kBitsPerEntity;
+
+  size_t mapSize = (mapWords + fullWords) * sizeof(size_t);
+  size_t* map = static_cast<size_t*>(Internal::allocMemory(mapSize));
+
+  if (ASMJIT_UNLIKELY(!map))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  size_t reserved = 0;
+  uint8_t* base = vMemMgrReserveRange(size, granularity, &reserved, hint);
+
+  if (ASMJIT_UNLIKELY(!base)) {
+    Internal::releaseMemory(map);
+    return DebugUtils::errored(kErrorNoVirtualMemory);
+  }
+
+  ::memset(map, 0, mapSize);
+
+  _reservedBase = base;
+  _reservedSize = std::min<size_t>(reserved, size);
+  _reservedGranularity = granularity;
+  _reservedMap = map;
+  _reservedFull = map + mapWords;
+
+  return kErrorOk;
+}
+
+Error VMemMgr::setLargePages(bool val) noexcept {
+  if (val == _largePages)
+    return kErrorOk;
+
+  VMemInfo vm = OSUtils::getVirtualMemoryInfo();
+
+  if (val) {
+    if (!vm.largePageSize || _reservedBase || _dualMapping)
+      return DebugUtils::errored(kErrorInvalidState);
+
+#if ASMJIT_OS_WINDOWS
+    // Large pages can only be allocated in the current process.
+    if (_hProcess != vm.hCurrentProcess)
+      return DebugUtils::errored(kErrorInvalidState);
+#endif // ASMJIT_OS_WINDOWS
+
+    // Blocks are as large as a large page and all allocations that fit are
+    // packed into them.
+    _blockSize = std::max<size_t>(vm.largePageSize, vm.pageGranularity);
+  }
+  else {
+    _blockSize = vm.pageGranularity;
+  }
+
+  _largePages = val;
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::VMemMgr - Statistics]
+// ============================================================================
+
+//! \internal
+//!
+//! Get the largest run of unused bytes in `node`.
+static size_t vMemMgrGetLargestFreeRun(MemNode* node) noexcept {
+  size_t largest = 0;
+  size_t run = 0;
+  size_t blocks = node->blocks;
+
+  for (size_t i = 0; i < blocks; i += kBitsPerEntity) {
+    size_t ubits = node->baUsed[i / kBitsPerEntity];
+    size_t n = std::min<size_t>(blocks - i, kBitsPerEntity);
+
+    if (ubits == 0) {
+      run += n;
+      continue;
+    }
+
+    for (size_t j = 0; j < n; j++) {
+      if (ubits & ((size_t)1 << j)) {
+        if (largest < run) largest = run;
+        run = 0;
       }
-    } while (cur);
+      else {
+        run++;
+      }
+    }
   }
 
-  // Statistics.
-  cont *= node->density;
-  if (node->largestBlock < cont)
-    node->largestBlock = cont;
+  if (largest < run) largest = run;
+  return largest * node->density;
+}
 
-  node->used -= cont;
-  _usedBytes -= cont;
+//! \internal
+//!
+//! Add statistics of `node` to `out`.
+static void vMemMgrCollectNodeStats(VMemStats* out, MemNode* node) noexcept {
+  out->blockCount++;
+  out->freeBytes += node->getAvailable();
+
+  size_t largestFreeRun = vMemMgrGetLargestFreeRun(node);
+  if (out->largestFreeRun < largestFreeRun)
+    out->largestFreeRun = largestFreeRun;
+}
 
-  // If page is empty, we can free it.
-  if (node->used == 0) {
-    // Free memory associated with node (this memory is not accessed
-    // anymore so it's safe).
-    vMemMgrReleaseVMem(this, node->mem, node->size);
-    Internal::releaseMemory(node->baUsed);
+//! \internal
+//!
+//! Add statistics of all shared nodes of the tree at `rbNode` to `out`. Bit
+//! arrays of nodes of arenas are modified by their threads without a lock, so
+//! these nodes are only counted and their sizes are added to `arenaBytes`.
+static void vMemMgrCollectTreeStats(VMemStats* out, size_t* arenaBytes, RbNode* rbNode) noexcept {
+  while (rbNode) {
+    MemNode* node = static_cast<MemNode*>(rbNode);
+    if (!node->arena) {
+      vMemMgrCollectNodeStats(out, node);
+    }
+    else {
+      out->blockCount++;
+      *arenaBytes += node->size;
+    }
 
-    node->baUsed = nullptr;
-    node->baCont = nullptr;
+    vMemMgrCollectTreeStats(out, arenaBytes, rbNode->node[0]);
+    rbNode = rbNode->node[1];
+  }
+}
 
-    // Statistics.
-    _allocatedBytes -= node->size;
+void VMemMgr::getStats(VMemStats* out) noexcept {
+  ::memset(out, 0, sizeof(VMemStats));
+
+  Arena* arenas;
+  size_t arenaBytes = 0;
+  {
+    VMemMgrAutoLock locked(this);
+    arenas = _arenas;
+
+    out->blockSize = _blockSize;
+    out->blockDensity = _blockDensity;
+
+    out->allocatedBytes = _allocatedBytes;
+    out->usedBytes = _usedBytes;
+    out->largePageBytes = _largePageBytes;
+    vMemMgrAddCounters(out, _counters);
+    vMemMgrCollectTreeStats(out, &arenaBytes, _root);
+
+    for (PermanentNode* node = _permanent; node; node = node->prev) {
+      out->permanentBytes += node->size;
+      out->permanentBlockCount++;
+    }
+
+    // Cached allocations are still marked as used in their nodes.
+    SizeClassCache* cache = _sizeClasses;
+    if (cache) {
+      for (uint32_t c = 0; c < kSizeClassCount; c++)
+        out->cachedBytes += cache->count[c] * (c + 1) * _blockDensity;
+    }
+
+    out->lockContentions = _lockContentions;
+    out->lockWaitNs = _lockWaitNs;
+  }
+
+  // Arenas are read without synchronization with their threads, see
+  // `getUsedBytes()`. Their unused bytes are only known in total.
+  size_t arenaUsedBytes = 0;
+  for (Arena* arena = arenas; arena; arena = arena->next) {
+    arenaUsedBytes += arena->usedBytes;
+    out->arenaCount++;
+    vMemMgrAddCounters(out, arena->counters);
+  }
+
+  out->usedBytes += arenaUsedBytes;
+  out->freeBytes += arenaBytes - std::min(arenaBytes, arenaUsedBytes);
+}
 
-    // Remove node. This function can return different node than
-    // passed into, but data is copied into previous node if needed.
-    Internal::releaseMemory(vMemMgrRemoveNode(this, node));
-    ASMJIT_ASSERT(vMemMgrCheckTree(this));
+Error VMemMgr::dumpStats(StringBuilder& sb) noexcept {
+  VMemStats stats;
+  getStats(&stats);
+
+  ASMJIT_PROPAGATE(sb.appendFormat(
+    "Block size      : %llu (density %llu)\n"
+    "Blocks          : %llu freeable, %llu permanent, %llu arenas\n"
+    "Allocated       : %llu freeable, %llu permanent, %llu large pages\n"
+    "Used            : %llu\n"
+    "Free            : %llu (largest run %llu, fragmentation %.1f%%)\n"
+    "Cached          : %llu\n"
+    "Alloc / Release : %llu / %llu\n"
+    "Shrink          : %llu (%llu bytes released)\n"
+    "Lock contention : %llu (%llu ns waiting)\n",
+    static_cast<unsigned long long>(stats.blockSize),
+    static_cast<unsigned long long>(stats.blockDensity),
+    static_cast<unsigned long long>(stats.blockCount),
+    static_cast<unsigned long long>(stats.permanentBlockCount),
+    static_cast<unsigned long long>(stats.arenaCount),
+    static_cast<unsigned long long>(stats.allocatedBytes),
+    static_cast<unsigned long long>(stats.permanentBytes),
+    static_cast<unsigned long long>(stats.largePageBytes),
+    static_cast<unsigned long long>(stats.usedBytes),
+    static_cast<unsigned long long>(stats.freeBytes),
+    static_cast<unsigned long long>(stats.largestFreeRun),
+    stats.getFragmentation() * 100.0,
+    static_cast<unsigned long long>(stats.cachedBytes),
+    static_cast<unsigned long long>(stats.allocCount),
+    static_cast<unsigned long long>(stats.releaseCount),
+    static_cast<unsigned long long>(stats.shrinkCount),
+    static_cast<unsigned long long>(stats.shrinkBytes),
+    static_cast<unsigned long long>(stats.lockContentions),
+    static_cast<unsigned long long>(stats.lockWaitNs)));
+
+  for (uint32_t i = 0; i < VMemStats::kSizeClassCount; i++) {
+    size_t limit = VMemStats::getSizeClassLimit(i);
+    if (limit)
+      ASMJIT_PROPAGATE(sb.appendFormat("Size <= %-7llu : %llu\n",
+        static_cast<unsigned long long>(limit),
+        static_cast<unsigned long long>(stats.sizeClassAllocs[i])));
+    else
+      ASMJIT_PROPAGATE(sb.appendFormat("Size >  %-7llu : %llu\n",
+        static_cast<unsigned long long>(VMemStats::getSizeClassLimit(i - 1)),
+        static_cast<unsigned long long>(stats.sizeClassAllocs[i])));
   }
 
   return kErrorOk;
 }
 
-Error VMemMgr::shrink(void* p, size_t used) noexcept {
+// ============================================================================
+// [asmjit::VMemMgr - Alloc / Release]
+// ============================================================================
+
+void* VMemMgr::alloc(size_t size, uint32_t type) noexcept {
+  void* rwPtr;
+  return alloc(size, type, &rwPtr);
+}
+
+void* VMemMgr::alloc(size_t size, uint32_t type, void** rwPtr) noexcept {
+  if (type == kAllocPermanent)
+    return vMemMgrAllocPermanent(this, size, rwPtr);
+
+  // Small allocations are served by the arena of the current thread.
+  if (_threadArenas) {
+    size_t vSize = Utils::alignTo<size_t>(size, 32);
+    if (vSize != 0 && vSize <= vMemMgrGetArenaNodeSize(this) / 4) {
+      Arena* arena = vMemMgrGetArena(this, true);
+      if (ASMJIT_LIKELY(arena))
+        return vMemMgrAllocArena(this, arena, vSize, rwPtr);
+    }
+  }
+
+  return vMemMgrAllocFreeable(this, size, rwPtr);
+}
+
+Error VMemMgr::release(void* p) noexcept {
   if (!p) return kErrorOk;
-  if (used == 0)
-    return release(p);
 
-  AutoLock locked(_lock);
-  MemNode* node = vMemMgrFindNodeByPtr(this, (uint8_t*)p);
-  if (!node) return DebugUtils::errored(kErrorInvalidArgument);
+  // Releasing memory of the current thread's arena doesn't need the lock.
+  Arena* arena = vMemMgrGetArena(this, false);
+  if (arena) {
+    vMemMgrArenaProcessRemote(this, arena);
 
-  size_t offset = (size_t)((uint8_t*)p - (uint8_t*)node->mem);
-  size_t bitpos = M_DIV(offset, node->density);
-  size_t i = (bitpos / kBitsPerEntity);
+    MemNode* node = vMemMgrFindArenaNode(arena, static_cast<uint8_t*>(p));
+    if (node) {
+      arena->usedBytes -= vMemMgrMarkUnused(node, static_cast<uint8_t*>(p));
+      arena->counters.releaseCount++;
 
-  size_t* up = node->baUsed + i;  // Current ubits address.
-  size_t* cp = node->baCont + i;  // Current cbits address.
-  size_t ubits = *up;             // Current ubits[0] value.
-  size_t cbits = *cp;             // Current cbits[0] value.
-  size_t bit = (size_t)1 << (bitpos % kBitsPerEntity);
+      vMemMgrArenaCompact(this, arena, node);
+      return kErrorOk;
+    }
+  }
 
-  size_t cont = 0;
-  size_t usedBlocks = (used + node->density - 1) / node->density;
+  VMemMgrAutoLock locked(this);
+  MemNode* node = vMemMgrFindNodeByPtr(this, static_cast<uint8_t*>(p));
+  if (!node) return DebugUtils::errored(kErrorInvalidArgument);
 
-  bool stop;
+  _counters.releaseCount++;
 
-  // Find the first block we can mark as free.
-  for (;;) {
-    stop = (cbits & bit) == 0;
-    if (stop)
+  // The memory belongs to an arena of a different thread, defer the release
+  // to the thread that owns it.
+  if (node->arena) {
+    RemoteRelease* item = static_cast<RemoteRelease*>(Internal::allocMemory(sizeof(RemoteRelease)));
+    if (ASMJIT_UNLIKELY(!item))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    item->p = p;
+    vMemMgrAtomicPush(&node->arena->remote, item);
+    return kErrorOk;
+  }
+
+  // Keep small allocations in size class free lists to reuse them without
+  // searching the bit arrays.
+  SizeClassCache* cache = _sizeClasses;
+  if (cache) {
+    size_t count = vMemMgrGetBlockCount(node, static_cast<uint8_t*>(p));
+    size_t bytes = count * node->density;
+
+    // The last allocation that isn't cached releases the cached ones too so
+    // the node can be returned to the system.
+    if (node->used - node->cached == bytes) {
+      if (node->cached != 0)
+        vMemMgrFlushNodeSizeClasses(this, node);
+    }
+    else if (count <= kSizeClassCount && cache->count[count - 1] < kSizeClassCapacity) {
+      cache->items[count - 1][cache->count[count - 1]++] = p;
+      node->cached += bytes;
+      _usedBytes -= bytes;
       return kErrorOk;
+    }
+  }
 
-    if (++cont == usedBlocks)
-      break;
+  // Statistics.
+  _usedBytes -= vMemMgrReleaseShared(this, node, static_cast<uint8_t*>(p));
+  return kErrorOk;
+}
 
-    bit <<= 1;
-    if (bit == 0) {
-      ubits = *++up;
-      cbits = *++cp;
-      bit = 1;
+Error VMemMgr::shrink(void* p, size_t used) noexcept {
+  if (!p) return kErrorOk;
+  if (used == 0)
+    return release(p);
+
+  Arena* arena = vMemMgrGetArena(this, false);
+  if (arena) {
+    MemNode* node = vMemMgrFindArenaNode(arena, static_cast<uint8_t*>(p));
+    if (node) {
+      size_t released = vMemMgrMarkShrunk(node, static_cast<uint8_t*>(p), used);
+      arena->usedBytes -= released;
+      vMemMgrCountShrink(arena->counters, released);
+      return kErrorOk;
     }
   }
 
-  // Free the tail blocks.
-  cont = ~(size_t)0;
-  goto _EnterFreeLoop;
+  VMemMgrAutoLock locked(this);
+  MemNode* node = vMemMgrFindNodeByPtr(this, (uint8_t*)p);
+  if (!node) return DebugUtils::errored(kErrorInvalidArgument);
 
-  for (;;) {
-    stop = (cbits & bit) == 0;
-    ubits &= ~bit;
+  // Shrinking is only an optimization, the memory of other thread's arena
+  // cannot be modified from here.
+  if (node->arena)
+    return kErrorOk;
 
-_EnterFreeLoop:
-    cbits &= ~bit;
+  size_t released = vMemMgrMarkShrunk(node, static_cast<uint8_t*>(p), used);
+  _usedBytes -= released;
+  vMemMgrCountShrink(_counters, released);
+  return kErrorOk;
+}
 
-    bit <<= 1;
-    cont++;
+void* VMemMgr::getRWAddress(void* p) noexcept {
+  uint8_t* mem = static_cast<uint8_t*>(p);
+  if (!_dualMapping) return mem;
 
-    if (stop || bit == 0) {
-      *up = ubits;
-      *cp = cbits;
-      if (stop)
-        break;
+  VMemMgrAutoLock locked(this);
+  MemNode* node = vMemMgrFindNodeByPtr(this, mem);
+  if (node)
+    return node->memRW + (size_t)(mem - node->mem);
 
-      ubits = *++up;
-      cbits = *++cp;
-      bit = 1;
-    }
+  PermanentNode* permanent = _permanent;
+  while (permanent) {
+    if (mem >= permanent->mem && mem < permanent->mem + permanent->size)
+      return permanent->memRW + (size_t)(mem - permanent->mem);
+    permanent = permanent->prev;
   }
 
-  // Statistics.
-  cont *= node->density;
-  if (node->largestBlock < cont)
-    node->largestBlock = cont;
-
-  node->used -= cont;
-  _usedBytes -= cont;
-
-  return kErrorOk;
+  return nullptr;
 }
 
 // ============================================================================
@@ -961,7 +2503,7 @@ static void VMemTest_verify(void* a, void* b) noexcept {
     "Pattern (%p) doesn't match", a);
 }
 
-static void VMemTest_stats(VMemMgr& memmgr) noexcept {
+static void VMemTest_stats(const VMemMgr& memmgr) noexcept {
   INFO("Used     : %u", static_cast<unsigned int>(memmgr.getUsedBytes()));
   INFO("Allocated: %u", static_cast<unsigned int>(memmgr.getAllocatedBytes()));
 }
@@ -1072,6 +2614,479 @@ UNIT(base_vmem) {
   Internal::releaseMemory(a);
   Internal::releaseMemory(b);
 }
+UNIT(base_vmem_arenas) {
+  VMemMgr memmgr;
+  EXPECT(memmgr.setThreadArenas(true) == kErrorOk,
+    "Couldn't enable thread arenas");
+
+  srand(100);
+
+  int i;
+  int kCount = 20000;
+
+  INFO("Thread arenas alloc/free test - %d allocations", static_cast<int>(kCount));
+
+  void** a = (void**)Internal::allocMemory(sizeof(void*) * kCount);
+  void** b = (void**)Internal::allocMemory(sizeof(void*) * kCount);
+
+  EXPECT(a != nullptr && b != nullptr,
+    "Couldn't allocate %u bytes on heap", kCount * 2);
+
+  for (i = 0; i < kCount; i++) {
+    // Mix small (arena) and large (shared) allocations.
+    int r = (i % 16 == 0) ? (rand() % 65536) + 4 : (rand() % 1000) + 4;
+
+    a[i] = memmgr.alloc(r);
+    EXPECT(a[i] != nullptr,
+      "Couldn't allocate %d bytes of virtual memory", r);
+
+    b[i] = Internal::allocMemory(r);
+    EXPECT(b[i] != nullptr,
+      "Couldn't allocate %d bytes on heap", r);
+
+    VMemTest_fill(a[i], b[i], r);
+  }
+  VMemTest_stats(memmgr);
+
+  INFO("Shuffling...");
+  VMemTest_shuffle(a, b, kCount);
+
+  INFO("Verify and free...");
+  for (i = 0; i < kCount; i++) {
+    VMemTest_verify(a[i], b[i]);
+    EXPECT(memmgr.release(a[i]) == kErrorOk,
+      "Failed to free %p", a[i]);
+    Internal::releaseMemory(b[i]);
+  }
+  VMemTest_stats(memmgr);
+
+  EXPECT(memmgr.getUsedBytes() == 0,
+    "All memory should be released");
+
+  INFO("Keeping one empty block in the arena");
+  size_t arenaNodeSize = vMemMgrGetArenaNodeSize(&memmgr);
+  EXPECT(memmgr.getAllocatedBytes() == arenaNodeSize,
+    "The arena should keep a single empty block of %u bytes", static_cast<unsigned int>(arenaNodeSize));
+
+  for (i = 0; i < 100; i++) {
+    void* p = memmgr.alloc(arenaNodeSize / 4);
+    EXPECT(p != nullptr);
+    EXPECT(memmgr.release(p) == kErrorOk);
+  }
+  EXPECT(memmgr.getAllocatedBytes() == arenaNodeSize,
+    "The empty block should be reused");
+
+  Internal::releaseMemory(a);
+  Internal::releaseMemory(b);
+}
+
+struct VMemTestThread {
+  VMemMgr* memmgr;
+  void** p;
+  int count;
+};
+
+static void VMemTest_threadRun(VMemTestThread* t) noexcept {
+  for (int i = 0; i < t->count; i++)
+    t->p[i] = t->memmgr->alloc((i % 200) + 4);
+}
+
+#if ASMJIT_OS_WINDOWS
+static DWORD WINAPI VMemTest_threadEntry(LPVOID arg) {
+  VMemTest_threadRun(static_cast<VMemTestThread*>(arg));
+  return 0;
+}
+#else
+static void* VMemTest_threadEntry(void* arg) {
+  VMemTest_threadRun(static_cast<VMemTestThread*>(arg));
+  return nullptr;
+}
+#endif
+
+UNIT(base_vmem_arenas_remote) {
+  VMemMgr memmgr;
+  EXPECT(memmgr.setThreadArenas(true) == kErrorOk,
+    "Couldn't enable thread arenas");
+
+  int i;
+  const int kCount = 1000;
+  void* a[kCount];
+
+  INFO("Allocating %d blocks by another thread while reading statistics", kCount);
+  VMemTestThread t;
+  t.memmgr = &memmgr;
+  t.p = a;
+  t.count = kCount;
+
+#if ASMJIT_OS_WINDOWS
+  HANDLE handle = ::CreateThread(nullptr, 0, VMemTest_threadEntry, &t, 0, nullptr);
+  EXPECT(handle != nullptr, "Couldn't create a thread");
+#else
+  pthread_t handle;
+  EXPECT(::pthread_create(&handle, nullptr, VMemTest_threadEntry, &t) == 0, "Couldn't create a thread");
+#endif
+
+  VMemStats stats;
+  for (i = 0; i < 100; i++) {
+    memmgr.getStats(&stats);
+    EXPECT(stats.arenaCount <= 1);
+    EXPECT(memmgr.getUsedBytes() <= static_cast<size_t>(kCount) * 256);
+  }
+
+#if ASMJIT_OS_WINDOWS
+  ::WaitForSingleObject(handle, INFINITE);
+  ::CloseHandle(handle);
+#else
+  ::pthread_join(handle, nullptr);
+#endif
+
+  for (i = 0; i < kCount; i++)
+    EXPECT(a[i] != nullptr, "Couldn't allocate block #%d", i);
+
+  memmgr.getStats(&stats);
+  size_t usedBytes = memmgr.getUsedBytes();
+
+  EXPECT(stats.arenaCount == 1);
+  EXPECT(stats.usedBytes == usedBytes);
+  EXPECT(usedBytes >= static_cast<size_t>(kCount) * 32);
+
+  INFO("Releasing the blocks by the main thread");
+  for (i = 0; i < kCount; i++)
+    EXPECT(memmgr.release(a[i]) == kErrorOk, "Failed to free %p", a[i]);
+
+  // Releases are deferred to the arena that owns the memory.
+  EXPECT(memmgr.getUsedBytes() == usedBytes);
+
+#if ASMJIT_OS_POSIX
+  // The arena of the exited thread is adopted and processes the releases.
+  void* p = memmgr.alloc(64);
+  EXPECT(p != nullptr);
+
+  memmgr.getStats(&stats);
+  EXPECT(stats.arenaCount == 1);
+  EXPECT(stats.usedBytes == 64);
+
+  EXPECT(memmgr.release(p) == kErrorOk);
+  EXPECT(memmgr.getUsedBytes() == 0,
+    "All memory should be released");
+#endif // ASMJIT_OS_POSIX
+}
+
+UNIT(base_vmem_dual_mapping) {
+  VMemMgr memmgr;
+  EXPECT(memmgr.setDualMapping(true) == kErrorOk,
+    "Couldn't enable dual mapping");
+
+  INFO("Dual mapping test");
+
+  int i;
+  int kCount = 1000;
+
+  void** a = (void**)Internal::allocMemory(sizeof(void*) * kCount);
+  EXPECT(a != nullptr,
+    "Couldn't allocate %u bytes on heap", kCount);
+
+  for (i = 0; i < kCount; i++) {
+    int r = (i % 100 == 0) ? 100000 : (i % 64) + 4;
+    void* rw;
+
+    a[i] = memmgr.alloc(r, (i & 1) ? VMemMgr::kAllocFreeable : VMemMgr::kAllocPermanent, &rw);
+    EXPECT(a[i] != nullptr,
+      "Couldn't allocate %d bytes of virtual memory", r);
+    EXPECT(a[i] != rw,
+      "Read+write view should differ from the read+execute view");
+    EXPECT(memmgr.getRWAddress(a[i]) == rw,
+      "Couldn't find read+write view of %p", a[i]);
+
+    ::memset(rw, i & 0xFF, r);
+    EXPECT(static_cast<uint8_t*>(a[i])[r - 1] == static_cast<uint8_t>(i & 0xFF),
+      "Memory written through read+write view is not visible at %p", a[i]);
+  }
+
+  EXPECT(memmgr.setDualMapping(false) == kErrorInvalidState,
+    "Dual mapping can't be changed after memory has been allocated");
+  EXPECT(memmgr.setLargePages(true) == kErrorInvalidState,
+    "Large pages can't be enabled together with dual mapping");
+  EXPECT(!memmgr.getLargePages());
+
+  for (i = 1; i < kCount; i += 2) {
+    EXPECT(memmgr.release(a[i]) == kErrorOk,
+      "Failed to free %p", a[i]);
+  }
+
+  Internal::releaseMemory(a);
+}
+UNIT(base_vmem_large_pages) {
+  VMemMgr memmgr;
+  if (memmgr.setLargePages(true) != kErrorOk) {
+    INFO("Large pages are not supported, skipping...");
+    return;
+  }
+
+  EXPECT(memmgr.setDualMapping(true) == kErrorInvalidState,
+    "Dual mapping can't be enabled together with large pages");
+
+  int i;
+  int kCount = 1000;
+
+  void* a[1000];
+  INFO("Large pages test - %d allocations", kCount);
+
+  for (i = 0; i < kCount; i++) {
+    int r = (i % 256) + 4;
+
+    a[i] = memmgr.alloc(r);
+    EXPECT(a[i] != nullptr,
+      "Couldn't allocate %d bytes of virtual memory", r);
+    ::memset(a[i], 0xCC, r);
+  }
+
+  // All allocations should fit into a single large block.
+  EXPECT(memmgr.getLargePageHits() + memmgr.getLargePageMisses() == 1,
+    "All allocations should be packed into a single block");
+  EXPECT(memmgr.getLargePageBytes() == memmgr.getLargePageHits() * memmgr.getAllocatedBytes(),
+    "Large page bytes don't match the allocated bytes");
+
+  INFO("Large page hits: %u, misses: %u",
+    static_cast<unsigned int>(memmgr.getLargePageHits()),
+    static_cast<unsigned int>(memmgr.getLargePageMisses()));
+
+  for (i = 0; i < kCount; i++) {
+    EXPECT(memmgr.release(a[i]) == kErrorOk,
+      "Failed to free %p", a[i]);
+  }
+
+  EXPECT(memmgr.getUsedBytes() == 0,
+    "All memory should be released");
+
+  memmgr.reset();
+  EXPECT(memmgr.getLargePageBytes() == 0,
+    "Large page bytes should be zero after reset");
+}
+UNIT(base_vmem_bitmap) {
+  VMemMgr memmgr;
+  EXPECT(memmgr.setStrategy(VMemMgr::kStrategyBitmap) == kErrorOk,
+    "Couldn't set bitmap strategy");
+
+  srand(100);
+
+  int i;
+  int kCount = 50000;
+
+  INFO("Bitmap strategy alloc/free test - %d allocations", static_cast<int>(kCount));
+
+  void** a = (void**)Internal::allocMemory(sizeof(void*) * kCount);
+  void** b = (void**)Internal::allocMemory(sizeof(void*) * kCount);
+
+  EXPECT(a != nullptr && b != nullptr,
+    "Couldn't allocate %u bytes on heap", kCount * 2);
+
+  for (i = 0; i < kCount; i++) {
+    // Mostly small allocations, some larger than a word of blocks.
+    int r = (i % 32 == 0) ? (rand() % 16384) + 4 : (rand() % 1000) + 4;
+
+    a[i] = memmgr.alloc(r);
+    EXPECT(a[i] != nullptr,
+      "Couldn't allocate %d bytes of virtual memory", r);
+
+    b[i] = Internal::allocMemory(r);
+    EXPECT(b[i] != nullptr,
+      "Couldn't allocate %d bytes on heap", r);
+
+    VMemTest_fill(a[i], b[i], r);
+  }
+  VMemTest_stats(memmgr);
+
+  INFO("Shuffling...");
+  VMemTest_shuffle(a, b, kCount);
+
+  INFO("Verify and free half...");
+  for (i = 0; i < kCount / 2; i++) {
+    VMemTest_verify(a[i], b[i]);
+    EXPECT(memmgr.release(a[i]) == kErrorOk,
+      "Failed to free %p", a[i]);
+    Internal::releaseMemory(b[i]);
+  }
+  VMemTest_stats(memmgr);
+
+  INFO("Alloc again");
+  for (i = 0; i < kCount / 2; i++) {
+    int r = (rand() % 1000) + 4;
+
+    a[i] = memmgr.alloc(r);
+    EXPECT(a[i] != nullptr,
+      "Couldn't allocate %d bytes of virtual memory", r);
+
+    b[i] = Internal::allocMemory(r);
+    EXPECT(b[i] != nullptr,
+      "Couldn't allocate %d bytes on heap", r);
+
+    VMemTest_fill(a[i], b[i], r);
+  }
+  VMemTest_stats(memmgr);
+
+  INFO("Verify and free...");
+  for (i = 0; i < kCount; i++) {
+    VMemTest_verify(a[i], b[i]);
+    EXPECT(memmgr.release(a[i]) == kErrorOk,
+      "Failed to free %p", a[i]);
+    Internal::releaseMemory(b[i]);
+  }
+  VMemTest_stats(memmgr);
+
+  EXPECT(memmgr.getUsedBytes() == 0,
+    "All memory should be released");
+  EXPECT(memmgr.getAllocatedBytes() == 0,
+    "Cached allocations shouldn't keep blocks alive");
+
+  INFO("Finding runs of unused blocks longer than a word");
+  {
+    size_t density = memmgr._blockDensity;
+
+    uint8_t* p0 = static_cast<uint8_t*>(memmgr.alloc(density));
+    uint8_t* p1 = static_cast<uint8_t*>(memmgr.alloc(density * 200));
+    uint8_t* p2 = static_cast<uint8_t*>(memmgr.alloc(density));
+    EXPECT(p1 == p0 + density && p2 == p1 + density * 200,
+      "Allocations should be adjacent");
+
+    EXPECT(memmgr.release(p1) == kErrorOk);
+    EXPECT(memmgr.alloc(density * 150) == p1,
+      "The run released by the previous allocation should be reused");
+    EXPECT(memmgr.alloc(density * 50) == p1 + density * 150,
+      "The rest of the run should be reused");
+    EXPECT(memmgr.alloc(density * 100) == p2 + density,
+      "The allocation should follow the last one");
+
+    memmgr.reset();
+  }
+
+  // Switching the strategy releases all cached allocations.
+  EXPECT(memmgr.setStrategy(VMemMgr::kStrategyFirstFit) == kErrorOk,
+    "Couldn't set first-fit strategy");
+  EXPECT(memmgr.getAllocatedBytes() == 0,
+    "All blocks should be released");
+
+  Internal::releaseMemory(a);
+  Internal::releaseMemory(b);
+}
+UNIT(base_vmem_reserve) {
+  VMemMgr memmgr;
+
+  // Use an address of this function as a hint, it's in the host's text segment.
+  const void* hint = Internal::ptr_cast<const void*>(&VMemTest_stats);
+  size_t kReserveSize = 32 * 1024 * 1024;
+
+  EXPECT(memmgr.reserve(kReserveSize, hint) == kErrorOk,
+    "Couldn't reserve %u bytes near %p", static_cast<unsigned int>(kReserveSize), hint);
+  EXPECT(memmgr.reserve(kReserveSize, hint) == kErrorInvalidState,
+    "Reserving twice should fail");
+
+  uint8_t* base = static_cast<uint8_t*>(memmgr.getReservedBase());
+  size_t size = memmgr.getReservedSize();
+
+  INFO("Reserved %u bytes at %p (hint %p)", static_cast<unsigned int>(size), base, hint);
+  EXPECT(vMemMgrIsNear(base, size, hint),
+    "The reserved range is not within the reach of rel32");
+
+  int i;
+  int kCount = 10000;
+  void* a[10000];
+
+  for (i = 0; i < kCount; i++) {
+    int r = (i % 100 == 0) ? 200000 : (i % 1000) + 4;
+
+    a[i] = memmgr.alloc(r, (i % 500 == 0) ? VMemMgr::kAllocPermanent : VMemMgr::kAllocFreeable);
+    EXPECT(a[i] != nullptr,
+      "Couldn't allocate %d bytes of virtual memory", r);
+    EXPECT(static_cast<uint8_t*>(a[i]) >= base && static_cast<uint8_t*>(a[i]) + r <= base + size,
+      "Memory at %p is not within the reserved range", a[i]);
+    ::memset(a[i], 0xCC, r);
+  }
+
+  for (i = 0; i < kCount; i++) {
+    if (i % 500 == 0) continue;
+    EXPECT(memmgr.release(a[i]) == kErrorOk,
+      "Failed to free %p", a[i]);
+  }
+
+  // The range is exhausted, nothing can be allocated outside of it.
+  EXPECT(memmgr.alloc(size) == nullptr,
+    "Allocation larger than the reserved range should fail");
+
+  INFO("Releasing the reserved range, but not its permanent memory");
+  uint8_t* permanent;
+  {
+    VMemMgr other;
+    EXPECT(other.reserve(kReserveSize, hint) == kErrorOk);
+    base = static_cast<uint8_t*>(other.getReservedBase());
+    size = other.getReservedSize();
+
+    permanent = static_cast<uint8_t*>(other.alloc(64, VMemMgr::kAllocPermanent));
+    EXPECT(permanent != nullptr);
+    EXPECT(other.alloc(size / 2) != nullptr);
+  }
+  ::memset(permanent, 0xCC, 64);
+
+#if !ASMJIT_OS_WINDOWS
+  // `msync()` fails with `ENOMEM` if the range is not mapped.
+  size_t pageSize = OSUtils::getVirtualMemoryInfo().pageSize;
+  EXPECT(::msync(base + size - pageSize, pageSize, MS_ASYNC) != 0,
+    "The unused part of the reserved range should be released");
+  EXPECT(::msync((void*)((uintptr_t)permanent & ~(uintptr_t)(pageSize - 1)), pageSize, MS_ASYNC) == 0,
+    "Permanent memory should be kept");
+#endif // !ASMJIT_OS_WINDOWS
+}
+
+UNIT(base_vmem_stats) {
+  VMemMgr memmgr;
+  VMemStats stats;
+
+  memmgr.getStats(&stats);
+  EXPECT(stats.allocCount == 0 && stats.blockCount == 0 && stats.freeBytes == 0,
+    "Statistics of an empty VMemMgr should be zero");
+
+  void* a = memmgr.alloc(32);
+  void* b = memmgr.alloc(1000);
+  void* c = memmgr.alloc(64, VMemMgr::kAllocPermanent);
+
+  EXPECT(a != nullptr && b != nullptr && c != nullptr,
+    "Couldn't allocate virtual memory");
+
+  EXPECT(memmgr.shrink(b, 100) == kErrorOk,
+    "VMemMgr::shrink() failed");
+  EXPECT(memmgr.release(a) == kErrorOk,
+    "VMemMgr::release() failed");
+
+  memmgr.getStats(&stats);
+  EXPECT(stats.allocCount == 3,
+    "Invalid allocation count (%u)", static_cast<unsigned int>(stats.allocCount));
+  EXPECT(stats.releaseCount == 1,
+    "Invalid release count (%u)", static_cast<unsigned int>(stats.releaseCount));
+  EXPECT(stats.shrinkCount == 1 && stats.shrinkBytes == 1024 - 128,
+    "Invalid shrink statistics (%u bytes)", static_cast<unsigned int>(stats.shrinkBytes));
+  EXPECT(stats.sizeClassAllocs[0] == 2 && stats.sizeClassAllocs[4] == 1,
+    "Invalid size class statistics");
+  EXPECT(stats.blockCount == 1 && stats.permanentBlockCount == 1,
+    "Invalid block count");
+  EXPECT(stats.usedBytes == memmgr.getUsedBytes(),
+    "Used bytes don't match VMemMgr::getUsedBytes()");
+  EXPECT(stats.freeBytes == stats.allocatedBytes - 128,
+    "Invalid free bytes (%u)", static_cast<unsigned int>(stats.freeBytes));
+
+  // The released allocation at the start of the block is separated from the
+  // rest of unused memory by `b`.
+  EXPECT(stats.largestFreeRun == stats.freeBytes - 64,
+    "Invalid largest free run (%u)", static_cast<unsigned int>(stats.largestFreeRun));
+  EXPECT(stats.getFragmentation() > 0.0 && stats.getFragmentation() < 0.1,
+    "Invalid fragmentation");
+
+  StringBuilder sb;
+  EXPECT(memmgr.dumpStats(sb) == kErrorOk,
+    "VMemMgr::dumpStats() failed");
+  INFO("%s", sb.getData());
+
+  memmgr.release(b);
+}
 #endif // ASMJIT_TEST
 
 } // asmjit namespace
@@ -17,9 +17,66 @@
 
 namespace asmjit {
 
+// ============================================================================
+// [Forward Declarations]
+// ============================================================================
+
+class StringBuilder;
+
 //! \addtogroup asmjit_base
 //! \{
 
+// ============================================================================
+// [asmjit::VMemStats]
+// ============================================================================
+
+//! Snapshot of `VMemMgr` statistics, see \ref VMemMgr::getStats().
+struct VMemStats {
+  ASMJIT_ENUM(Limits) {
+    //! Number of size classes tracked by `sizeClassAllocs`.
+    kSizeClassCount = 8
+  };
+
+  //! Get the maximum size of allocations counted by `sizeClassAllocs[index]`,
+  //! the last size class counts all larger allocations and returns zero.
+  static ASMJIT_INLINE size_t getSizeClassLimit(uint32_t index) noexcept {
+    return index < kSizeClassCount - 1 ? static_cast<size_t>(64) << index : size_t(0);
+  }
+
+  //! Get the fragmentation of unused memory in blocks.
+  //!
+  //! Returns 0.0 if all unused memory forms a single run and approaches 1.0 as
+  //! the unused memory is split into many small runs.
+  ASMJIT_INLINE double getFragmentation() const noexcept {
+    if (!freeBytes) return 0.0;
+    return 1.0 - static_cast<double>(largestFreeRun) / static_cast<double>(freeBytes);
+  }
+
+  size_t blockSize;                      //!< Default block size (`VMemMgr::_blockSize`).
+  size_t blockDensity;                   //!< Default block density (`VMemMgr::_blockDensity`).
+
+  size_t allocatedBytes;                 //!< Bytes allocated by freeable blocks.
+  size_t usedBytes;                      //!< Bytes used, see `VMemMgr::getUsedBytes()`.
+  size_t freeBytes;                      //!< Bytes not used in freeable blocks.
+  size_t cachedBytes;                    //!< Bytes released, but kept in size class free lists.
+  size_t largestFreeRun;                 //!< The largest run of unused bytes in a single block.
+  size_t largePageBytes;                 //!< Bytes allocated in blocks backed by large pages.
+  size_t permanentBytes;                 //!< Bytes allocated by permanent blocks.
+
+  size_t blockCount;                     //!< Number of freeable blocks.
+  size_t permanentBlockCount;            //!< Number of permanent blocks.
+  size_t arenaCount;                     //!< Number of thread arenas.
+
+  uint64_t allocCount;                   //!< Number of successful `alloc()` calls.
+  uint64_t releaseCount;                 //!< Number of successful `release()` calls.
+  uint64_t shrinkCount;                  //!< Number of `shrink()` calls that released memory.
+  uint64_t shrinkBytes;                  //!< Bytes released by `shrink()`.
+  uint64_t sizeClassAllocs[kSizeClassCount]; //!< Allocations per size class, see \ref getSizeClassLimit().
+
+  uint64_t lockContentions;              //!< How many times `VMemMgr::_lock` was contended.
+  uint64_t lockWaitNs;                   //!< Nanoseconds spent waiting for the contended lock.
+};
+
 // ============================================================================
 // [asmjit::VMemMgr]
 // ============================================================================
@@ -36,6 +93,14 @@ public:
     kAllocPermanent = 1
   };
 
+  //! Strategy used to find unused memory, see `VMemMgr::setStrategy()`.
+  ASMJIT_ENUM(Strategy) {
+    //! Scan bit arrays of blocks linearly and use the first fit (default).
+    kStrategyFirstFit = 0,
+    //! Use hierarchical bit arrays and size class free lists.
+    kStrategyBitmap = 1
+  };
+
   // --------------------------------------------------------------------------
   // [Construction / Destruction]
   // --------------------------------------------------------------------------
@@ -74,7 +139,10 @@ public:
   //! Get how many bytes are currently allocated.
   ASMJIT_INLINE size_t getAllocatedBytes() const noexcept { return _allocatedBytes; }
   //! Get how many bytes are currently used.
-  ASMJIT_INLINE size_t getUsedBytes() const noexcept { return _usedBytes; }
+  //!
+  //! NOTE: If thread arenas are used the result also includes bytes used by
+  //! all arenas, which are read while their threads can still allocate.
+  ASMJIT_API size_t getUsedBytes() const noexcept;
 
   //! Get whether to keep allocated memory after the `VMemMgr` is destroyed.
   //!
@@ -93,6 +161,131 @@ public:
   //! \sa \ref getKeepVirtualMemory.
   ASMJIT_INLINE void setKeepVirtualMemory(bool val) noexcept { _keepVirtualMemory = val; }
 
+  //! Get whether per-thread arenas are used.
+  //!
+  //! \sa \ref setThreadArenas.
+  ASMJIT_INLINE bool getThreadArenas() const noexcept { return _threadArenas; }
+  //! Set whether to use per-thread arenas.
+  //!
+  //! If enabled, each thread that calls `alloc()` gets its own arena of memory
+  //! blocks. Allocations of up to 64kB are served from the arena of the calling
+  //! thread and released back to it without taking any lock. Arenas allocate
+  //! blocks of at least 256kB and keep one empty block instead of releasing it,
+  //! so the `VMemMgr` lock is only taken when an arena needs another block.
+  //! Permanent and larger allocations still use the shared blocks. Releasing
+  //! memory that was allocated by a different thread takes the lock and defers
+  //! the release to the owning arena through a lock-free list, which the arena
+  //! processes during its next `alloc()` or `release()`.
+  //!
+  //! Arenas of threads that have exited are reused by new threads (POSIX only).
+  //!
+  //! NOTE: This must be set before the `VMemMgr` is shared between threads.
+  ASMJIT_API Error setThreadArenas(bool val) noexcept;
+
+  //! Get the allocation strategy, see \ref Strategy.
+  ASMJIT_INLINE uint32_t getStrategy() const noexcept { return _strategy; }
+  //! Set the allocation strategy, see \ref Strategy.
+  //!
+  //! `kStrategyBitmap` keeps a summary bit array of fully used words of each
+  //! block, so the search skips used memory a word at a time and finds a run
+  //! of unused blocks by word-wide bit operations instead of testing each bit,
+  //! runs longer than a word are measured a whole word at a time. The search
+  //! is still linear in the count of words of a block and blocks are visited
+  //! one by one, only those with too little available space or too short known
+  //! runs are skipped without searching. In addition, released allocations of up to 16 blocks are kept in free
+  //! lists of their size class and reused by `alloc()` without searching at
+  //! all. Cached allocations are released when an allocation would otherwise
+  //! need a new block. This keeps `alloc()` and `release()` fast when many
+  //! small functions fragment the memory.
+  ASMJIT_API Error setStrategy(uint32_t strategy) noexcept;
+
+  //! Get the beginning of the reserved address range or null if there is none.
+  //!
+  //! \sa \ref reserve.
+  ASMJIT_INLINE void* getReservedBase() const noexcept { return _reservedBase; }
+  //! Get the size of the reserved address range.
+  ASMJIT_INLINE size_t getReservedSize() const noexcept { return _reservedSize; }
+
+  //! Reserve an address range of `size` bytes that all blocks are allocated from.
+  //!
+  //! If `hint` is not null the whole range is placed within +/-2GB of `hint`,
+  //! which should be an address the generated code calls, like an address of
+  //! a function in the host's text segment. Calls and jumps between functions
+  //! allocated by this `VMemMgr` and to `hint` then always fit into rel32 and
+  //! `CodeHolder::relocate()` never needs trampolines for them.
+  //!
+  //! When the range is exhausted `alloc()` fails, it never allocates memory
+  //! outside of the range.
+  //!
+  //! Returns `kErrorInvalidState` if the `VMemMgr` has already allocated memory,
+  //! if a range has already been reserved, if dual mapping or large pages are
+  //! used, or if the `VMemMgr` is bound to a remote process (Windows). Returns
+  //! `kErrorNoVirtualMemory` if no range near `hint` could be reserved.
+  ASMJIT_API Error reserve(size_t size, const void* hint = nullptr) noexcept;
+
+  //! Get whether the memory is dual-mapped.
+  //!
+  //! \sa \ref setDualMapping.
+  ASMJIT_INLINE bool getDualMapping() const noexcept { return _dualMapping; }
+  //! Set whether to dual-map the memory.
+  //!
+  //! If enabled, each block is backed by an anonymous file (`memfd_create()`
+  //! or a shared memory object on POSIX, a pagefile-backed section on Windows)
+  //! that is mapped twice - as read+execute and as read+write. `alloc()` returns
+  //! the read+execute address and the read+write address of the same memory
+  //! can be obtained by `alloc(size, type, &rwPtr)` or `getRWAddress()`. No page
+  //! is ever mapped as writable and executable at the same time, which is
+  //! required by hardened kernels (W^X), and the code can be written without
+  //! calling `mprotect()` (and causing TLB shootdowns) per function.
+  //!
+  //! Returns `kErrorInvalidState` if the `VMemMgr` has already allocated memory,
+  //! if large pages are enabled, or if it's bound to a remote process (Windows).
+  ASMJIT_API Error setDualMapping(bool val) noexcept;
+
+  //! Get whether the memory is backed by large pages.
+  //!
+  //! \sa \ref setLargePages.
+  ASMJIT_INLINE bool getLargePages() const noexcept { return _largePages; }
+  //! Set whether to back the memory by large pages.
+  //!
+  //! If enabled, blocks are allocated as large as a large page (2MB on Linux)
+  //! and backed by explicit large pages (`MAP_HUGETLB` or `MEM_LARGE_PAGES`),
+  //! or by transparent huge pages (`madvise(MADV_HUGEPAGE)`) if there are no
+  //! explicit large pages available. Functions are packed densely into these
+  //! blocks, which reduces iTLB misses when a lot of code is generated. If the
+  //! OS provides no large pages the block is backed by regular pages, which is
+  //! reported by \ref getLargePageMisses().
+  //!
+  //! The last shared block backed by large pages is not released when it
+  //! becomes empty, because mapping large pages is expensive.
+  //!
+  //! Returns `kErrorInvalidState` if large pages are not supported by the OS,
+  //! if dual mapping is enabled, or if the `VMemMgr` is bound to a remote
+  //! process (Windows).
+  ASMJIT_API Error setLargePages(bool val) noexcept;
+
+  //! Get how many bytes are currently allocated in blocks backed by large pages.
+  ASMJIT_INLINE size_t getLargePageBytes() const noexcept { return _largePageBytes; }
+  //! Get how many blocks have been backed by large pages.
+  ASMJIT_INLINE size_t getLargePageHits() const noexcept { return _largePageHits; }
+  //! Get how many blocks requested large pages, but were backed by regular pages.
+  ASMJIT_INLINE size_t getLargePageMisses() const noexcept { return _largePageMisses; }
+
+  // --------------------------------------------------------------------------
+  // [Statistics]
+  // --------------------------------------------------------------------------
+
+  //! Get a snapshot of statistics of the `VMemMgr`.
+  //!
+  //! Counters are maintained by `alloc()`, `release()`, and `shrink()`, the
+  //! remaining values are computed from blocks, which requires a scan of their
+  //! bit arrays. Thread arenas are read without synchronization with their
+  //! threads, so the snapshot is not atomic while other threads allocate, and
+  //! `largestFreeRun` only covers shared blocks.
+  ASMJIT_API void getStats(VMemStats* out) noexcept;
+  //! Take a snapshot of statistics and dump it as a human readable text to `sb`.
+  ASMJIT_API Error dumpStats(StringBuilder& sb) noexcept;
+
   // --------------------------------------------------------------------------
   // [Alloc / Release]
   // --------------------------------------------------------------------------
@@ -103,11 +296,23 @@ public:
   //! can quitly ignore type of allocation. This is mainly for AsmJit to memory
   //! manager that allocated memory will be never freed.
   ASMJIT_API void* alloc(size_t size, uint32_t type = kAllocFreeable) noexcept;
+  //! Allocate a `size` bytes of virtual memory and store the address through
+  //! which the memory can be written to `rwPtr`.
+  //!
+  //! The returned address (where the code is executed) and `rwPtr` are the
+  //! same, unless dual mapping is enabled, see \ref setDualMapping.
+  ASMJIT_API void* alloc(size_t size, uint32_t type, void** rwPtr) noexcept;
   //! Free previously allocated memory at a given `address`.
   ASMJIT_API Error release(void* p) noexcept;
   //! Free extra memory allocated with `p`.
   ASMJIT_API Error shrink(void* p, size_t used) noexcept;
 
+  //! Get the read+write address of memory at `p` returned by `alloc()`.
+  //!
+  //! Returns `p` if dual mapping is disabled, or null if `p` was not allocated
+  //! by this `VMemMgr`.
+  ASMJIT_API void* getRWAddress(void* p) noexcept;
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
@@ -115,21 +320,61 @@ public:
 #if ASMJIT_OS_WINDOWS
   HANDLE _hProcess;                      //!< Process passed to `VirtualAllocEx` and `VirtualFree`.
 #endif // ASMJIT_OS_WINDOWS
-  Lock _lock;                            //!< Lock to enable thread-safe functionality.
+  mutable Lock _lock;                    //!< Lock to enable thread-safe functionality.
 
   size_t _blockSize;                     //!< Default block size.
   size_t _blockDensity;                  //!< Default block density.
   bool _keepVirtualMemory;               //!< Keep virtual memory after destroyed.
+  bool _threadArenas;                    //!< Use per-thread arenas.
+  bool _arenaKeyValid;                   //!< True if `_arenaKey` has been created.
+  bool _dualMapping;                     //!< Map blocks twice, as RX and RW.
+  bool _largePages;                      //!< Back blocks by large pages.
+  uint8_t _strategy;                     //!< Allocation strategy, see \ref Strategy.
 
   size_t _allocatedBytes;                //!< How many bytes are currently allocated.
   size_t _usedBytes;                     //!< How many bytes are currently used.
 
+  size_t _largePageBytes;                //!< How many bytes are allocated in large pages.
+  size_t _largePageHits;                 //!< How many blocks were backed by large pages.
+  size_t _largePageMisses;               //!< How many blocks fell back to regular pages.
+
+  Lock _reservedLock;                    //!< Lock that protects `_reservedMap`.
+  uint8_t* _reservedBase;                //!< Reserved address range or null.
+  size_t _reservedSize;                  //!< Size of the reserved address range.
+  size_t _reservedGranularity;           //!< Granularity of blocks allocated from the range.
+  size_t* _reservedMap;                  //!< Bits of used granules of the reserved range.
+  size_t* _reservedFull;                 //!< Bits of words of `_reservedMap` that are all used.
+
+  //! \internal
+  //!
+  //! Counters of allocations, kept by `VMemMgr` and by each thread arena.
+  struct Counters {
+    uint64_t allocCount;
+    uint64_t releaseCount;
+    uint64_t shrinkCount;
+    uint64_t shrinkBytes;
+    uint64_t sizeClassAllocs[VMemStats::kSizeClassCount];
+  };
+
+  Counters _counters;                    //!< Counters of the shared blocks.
+  mutable uint64_t _lockContentions;     //!< How many times `_lock` was contended.
+  mutable uint64_t _lockWaitNs;          //!< Nanoseconds spent waiting for `_lock`.
+
   //! \internal
   //! \{
 
   struct RbNode;
   struct MemNode;
   struct PermanentNode;
+  struct Arena;
+  struct RemoteRelease;
+  struct SizeClassCache;
+
+#if ASMJIT_OS_WINDOWS
+  typedef DWORD ArenaKey;
+#else
+  typedef pthread_key_t ArenaKey;
+#endif // ASMJIT_OS_WINDOWS
 
   // Memory nodes root.
   MemNode* _root;
@@ -139,6 +384,12 @@ public:
   MemNode* _optimal;
   // Permanent memory.
   PermanentNode* _permanent;
+  // Thread arenas.
+  Arena* _arenas;
+  // Size class free lists (only used by `kStrategyBitmap`).
+  SizeClassCache* _sizeClasses;
+  // Thread-local storage key that maps the current thread to its arena.
+  ArenaKey _arenaKey;
 
   //! \}
 };
@@ -8,6 +8,7 @@
 #define ASMJIT_EXPORTS
 
 // [Dependencies]
+#include "../base/osutils.h"
 #include "../base/utils.h"
 #include "../base/zone.h"
 
@@ -33,6 +34,223 @@ static ASMJIT_INLINE uint32_t Zone_getAlignmentOffsetFromAlignment(uint32_t x) n
   }
 }
 
+// ============================================================================
+// [asmjit::Zone - Block Pool]
+// ============================================================================
+
+enum {
+  //! Default limit of the block pool.
+  kZonePoolDefaultLimit = 1024 * 1024,
+  //! Maximum size of a block that can be pooled.
+  kZonePoolMaxBlockSize = 65536,
+  //! Number of distinct block sizes the pool can keep.
+  kZonePoolSlotCount = 8
+};
+
+//! \internal
+//!
+//! Process-wide pool of blocks released by `Zone`. Blocks are pooled by their
+//! size, which is usually the default block size of the zone they belong to,
+//! so a block can always be reused by a zone of the same block size without
+//! checking its capacity.
+struct ZonePool {
+  //! Pooled blocks of the same size.
+  struct Slot {
+    size_t size;                         //!< Size of blocks in this slot (0 if unused).
+    size_t count;                        //!< Number of blocks in this slot.
+    Zone::Block* blocks;                 //!< Single-linked list of blocks (by `next`).
+  };
+
+  ASMJIT_INLINE ZonePool() noexcept
+    : limit(kZonePoolDefaultLimit),
+      cachedBytes(0),
+      cachedBlocks(0),
+      allocCount(0),
+      releaseCount(0),
+      reuseCount(0) { ::memset(slots, 0, sizeof(slots)); }
+
+  Lock lock;                             //!< Lock that protects the pool.
+  size_t limit;                          //!< Maximum number of bytes kept.
+  size_t cachedBytes;                    //!< Number of bytes kept.
+  size_t cachedBlocks;                   //!< Number of blocks kept.
+  uint64_t allocCount;                   //!< Number of blocks allocated.
+  uint64_t releaseCount;                 //!< Number of blocks released.
+  uint64_t reuseCount;                   //!< Number of blocks reused.
+  Slot slots[kZonePoolSlotCount];        //!< Pooled blocks by size.
+};
+
+//! \internal
+//!
+//! Get the block pool. It's never destroyed as zones can be destroyed by
+//! static destructors that run after it.
+static ZonePool* Zone_getPool() noexcept {
+  static union {
+    uint64_t alignment;
+    uint8_t data[sizeof(ZonePool)];
+  } storage;
+
+  static ZonePool* pool = new(storage.data) ZonePool();
+  return pool;
+}
+
+//! \internal
+//!
+//! Allocate a block of `size` bytes (including `Zone::Block` header).
+static Zone::Block* Zone_allocBlock(size_t size) noexcept {
+  ZonePool* pool = Zone_getPool();
+
+  {
+    AutoLock locked(pool->lock);
+    for (uint32_t i = 0; i < kZonePoolSlotCount; i++) {
+      ZonePool::Slot& slot = pool->slots[i];
+      if (slot.size != size || !slot.blocks)
+        continue;
+
+      Zone::Block* block = slot.blocks;
+      slot.blocks = block->next;
+      slot.count--;
+
+      pool->cachedBytes -= size;
+      pool->cachedBlocks--;
+      pool->reuseCount++;
+      return block;
+    }
+    pool->allocCount++;
+  }
+
+  return static_cast<Zone::Block*>(Internal::allocMemory(size));
+}
+
+//! \internal
+//!
+//! Release a list of blocks linked by `next` to the pool or to the system.
+static void Zone_releaseBlocks(Zone::Block* block) noexcept {
+  ZonePool* pool = Zone_getPool();
+  Zone::Block* unpooled = nullptr;
+
+  {
+    AutoLock locked(pool->lock);
+    while (block) {
+      Zone::Block* next = block->next;
+      size_t size = sizeof(Zone::Block) + block->size;
+
+      ZonePool::Slot* dst = nullptr;
+      if (block->size <= kZonePoolMaxBlockSize && pool->cachedBytes + size <= pool->limit) {
+        for (uint32_t i = 0; i < kZonePoolSlotCount; i++) {
+          ZonePool::Slot& slot = pool->slots[i];
+          if (slot.size == size) {
+            dst = &slot;
+            break;
+          }
+          if (!slot.count && !dst)
+            dst = &slot;
+        }
+      }
+
+      if (dst) {
+        dst->size = size;
+        dst->count++;
+        block->next = dst->blocks;
+        dst->blocks = block;
+
+        pool->cachedBytes += size;
+        pool->cachedBlocks++;
+      }
+      else {
+        block->next = unpooled;
+        unpooled = block;
+        pool->releaseCount++;
+      }
+
+      block = next;
+    }
+  }
+
+  // Release outside of the lock.
+  while (unpooled) {
+    Zone::Block* next = unpooled->next;
+    Internal::releaseMemory(unpooled);
+    unpooled = next;
+  }
+}
+
+//! \internal
+//!
+//! Trim the pool to `limit`, must be called with the lock held. Returns a list
+//! of blocks that must be released.
+static Zone::Block* Zone_trimPool(ZonePool* pool, size_t limit) noexcept {
+  Zone::Block* unpooled = nullptr;
+
+  for (uint32_t i = 0; i < kZonePoolSlotCount && pool->cachedBytes > limit; i++) {
+    ZonePool::Slot& slot = pool->slots[i];
+    while (slot.blocks && pool->cachedBytes > limit) {
+      Zone::Block* block = slot.blocks;
+      slot.blocks = block->next;
+      slot.count--;
+
+      block->next = unpooled;
+      unpooled = block;
+
+      pool->cachedBytes -= slot.size;
+      pool->cachedBlocks--;
+      pool->releaseCount++;
+    }
+  }
+
+  return unpooled;
+}
+
+void Zone::setPoolLimit(size_t limit) noexcept {
+  ZonePool* pool = Zone_getPool();
+  Block* unpooled;
+
+  {
+    AutoLock locked(pool->lock);
+    pool->limit = limit;
+    unpooled = Zone_trimPool(pool, limit);
+  }
+
+  while (unpooled) {
+    Block* next = unpooled->next;
+    Internal::releaseMemory(unpooled);
+    unpooled = next;
+  }
+}
+
+size_t Zone::getPoolLimit() noexcept {
+  ZonePool* pool = Zone_getPool();
+  AutoLock locked(pool->lock);
+  return pool->limit;
+}
+
+void Zone::getPoolStats(PoolStats* out) noexcept {
+  ZonePool* pool = Zone_getPool();
+  AutoLock locked(pool->lock);
+
+  out->limit = pool->limit;
+  out->cachedBytes = pool->cachedBytes;
+  out->cachedBlocks = pool->cachedBlocks;
+  out->allocCount = pool->allocCount;
+  out->releaseCount = pool->releaseCount;
+  out->reuseCount = pool->reuseCount;
+}
+
+void Zone::releasePool() noexcept {
+  ZonePool* pool = Zone_getPool();
+  Block* unpooled;
+
+  {
+    AutoLock locked(pool->lock);
+    unpooled = Zone_trimPool(pool, 0);
+  }
+
+  while (unpooled) {
+    Block* next = unpooled->next;
+    Internal::releaseMemory(unpooled);
+    unpooled = next;
+  }
+}
+
 // ============================================================================
 // [asmjit::Zone - Construction / Destruction]
 // ============================================================================
@@ -41,6 +259,10 @@ Zone::Zone(uint32_t blockSize, uint32_t blockAlignment) noexcept
   : _ptr(nullptr),
     _end(nullptr),
     _block(const_cast<Zone::Block*>(&Zone_zeroBlock)),
+    _retiredSize(0),
+    _peakUsedSize(0),
+    _reservedSize(0),
+    _blockCount(0),
     _blockSize(blockSize),
     _blockAlignmentShift(Zone_getAlignmentOffsetFromAlignment(blockAlignment)) {}
 
@@ -59,26 +281,23 @@ void Zone::reset(bool releaseMemory) noexcept {
   if (cur == &Zone_zeroBlock)
     return;
 
+  size_t usedSize = getUsedSize();
+  if (_peakUsedSize < usedSize)
+    _peakUsedSize = usedSize;
+  _retiredSize = 0;
+
   if (releaseMemory) {
     // Since cur can be in the middle of the double-linked list, we have to
-    // traverse to both directions `prev` and `next` separately.
-    Block* next = cur->next;
-    do {
-      Block* prev = cur->prev;
-      Internal::releaseMemory(cur);
-      cur = prev;
-    } while (cur);
-
-    cur = next;
-    while (cur) {
-      next = cur->next;
-      Internal::releaseMemory(cur);
-      cur = next;
-    }
+    // find the first block, all blocks are then reachable through `next`.
+    while (cur->prev)
+      cur = cur->prev;
+    Zone_releaseBlocks(cur);
 
     _ptr = nullptr;
     _end = nullptr;
     _block = const_cast<Zone::Block*>(&Zone_zeroBlock);
+    _reservedSize = 0;
+    _blockCount = 0;
   }
   else {
     while (cur->prev)
@@ -90,6 +309,28 @@ void Zone::reset(bool releaseMemory) noexcept {
   }
 }
 
+// ============================================================================
+// [asmjit::Zone - State]
+// ============================================================================
+
+void Zone::restoreState(const State& state) noexcept {
+  // The state has been saved before the first block was allocated, which is
+  // the same as resetting the zone without releasing its blocks.
+  if (state.block == &Zone_zeroBlock) {
+    reset(false);
+    return;
+  }
+
+  size_t usedSize = getUsedSize();
+  if (_peakUsedSize < usedSize)
+    _peakUsedSize = usedSize;
+
+  _ptr = state.ptr;
+  _end = state.end;
+  _block = state.block;
+  _retiredSize = state.retiredSize;
+}
+
 // ============================================================================
 // [asmjit::Zone - Alloc]
 // ============================================================================
@@ -105,6 +346,14 @@ void* Zone::_alloc(size_t size) noexcept {
   // in the current block, see `alloc()` implementation for more details.
   ASMJIT_ASSERT(curBlock == &Zone_zeroBlock || getRemainingSize() < size);
 
+  // Bytes used by the current block are retired as it won't be used anymore.
+  if (curBlock != &Zone_zeroBlock) {
+    size_t usedSize = getUsedSize();
+    if (_peakUsedSize < usedSize)
+      _peakUsedSize = usedSize;
+    _retiredSize = usedSize;
+  }
+
   // If the `Zone` has been cleared the current block doesn't have to be the
   // last one. Check if there is a block that can be used instead of allocating
   // a new one. If there is a `next` block it's completely unused, we don't have
@@ -125,7 +374,7 @@ void* Zone::_alloc(size_t size) noexcept {
     return nullptr;
 
   blockSize += blockAlignment;
-  Block* newBlock = static_cast<Block*>(Internal::allocMemory(sizeof(Block) + blockSize));
+  Block* newBlock = Zone_allocBlock(sizeof(Block) + blockSize);
 
   if (ASMJIT_UNLIKELY(!newBlock))
     return nullptr;
@@ -138,6 +387,9 @@ void* Zone::_alloc(size_t size) noexcept {
   newBlock->next = nullptr;
   newBlock->size = blockSize;
 
+  _reservedSize += sizeof(Block) + blockSize;
+  _blockCount++;
+
   if (curBlock != &Zone_zeroBlock) {
     newBlock->prev = curBlock;
     curBlock->next = newBlock;
@@ -158,6 +410,15 @@ void* Zone::_alloc(size_t size) noexcept {
   return static_cast<void*>(p);
 }
 
+void Zone::getStats(ZoneStats* out) const noexcept {
+  size_t usedSize = getUsedSize();
+
+  out->reservedBytes = _reservedSize;
+  out->usedBytes = usedSize;
+  out->peakUsedBytes = std::max<size_t>(_peakUsedSize, usedSize);
+  out->blockCount = _blockCount;
+}
+
 void* Zone::allocZeroed(size_t size) noexcept {
   void* p = alloc(size);
   if (ASMJIT_UNLIKELY(!p)) return p;
@@ -197,14 +458,30 @@ char* Zone::sformat(const char* fmt, ...) noexcept {
 // [asmjit::ZoneHeap - Helpers]
 // ============================================================================
 
-static bool ZoneHeap_hasDynamicBlock(ZoneHeap* self, ZoneHeap::DynamicBlock* block) noexcept {
-  ZoneHeap::DynamicBlock* cur = self->_dynamicBlocks;
-  while (cur) {
-    if (cur == block)
-      return true;
-    cur = cur->next;
+//! \internal
+//!
+//! Get the number of bytes allocated from the system for a dynamic block that
+//! provides `size` bytes to the user.
+static ASMJIT_INLINE size_t ZoneHeap_getDynamicOverhead() noexcept {
+  return sizeof(ZoneHeap::DynamicBlock) + sizeof(ZoneHeap::DynamicBlock*) + ZoneHeap::kBlockAlignment;
+}
+
+static void ZoneHeap_releaseDynamicList(ZoneHeap::DynamicBlock* block) noexcept {
+  while (block) {
+    ZoneHeap::DynamicBlock* next = block->next;
+    Internal::releaseMemory(block);
+    block = next;
   }
-  return false;
+}
+
+//! \internal
+//!
+//! Get the memory returned to the user of a dynamic `block`.
+static ASMJIT_INLINE void* ZoneHeap_getDynamicData(ZoneHeap::DynamicBlock* block) noexcept {
+  typedef ZoneHeap::DynamicBlock DynamicBlock;
+
+  uint8_t* p = reinterpret_cast<uint8_t*>(block) + sizeof(DynamicBlock) + sizeof(DynamicBlock*);
+  return Utils::alignTo(p, ZoneHeap::kBlockAlignment);
 }
 
 // ============================================================================
@@ -212,13 +489,10 @@ static bool ZoneHeap_hasDynamicBlock(ZoneHeap* self, ZoneHeap::DynamicBlock* blo
 // ============================================================================
 
 void ZoneHeap::reset(Zone* zone) noexcept {
-  // Free dynamic blocks.
-  DynamicBlock* block = _dynamicBlocks;
-  while (block) {
-    DynamicBlock* next = block->next;
-    Internal::releaseMemory(block);
-    block = next;
-  }
+  // Free dynamic blocks, including the cached ones.
+  ZoneHeap_releaseDynamicList(_dynamicBlocks);
+  for (uint32_t i = 0; i < kDynamicClassCount; i++)
+    ZoneHeap_releaseDynamicList(_magazines[i]);
 
   // Zero the entire class and initialize to the given `zone`.
   ::memset(this, 0, sizeof(*this));
@@ -285,21 +559,53 @@ void* ZoneHeap::_alloc(size_t size, size_t& allocatedSize) noexcept {
     }
   }
   else {
-    // Allocate a dynamic block.
-    size_t overhead = sizeof(DynamicBlock) + sizeof(DynamicBlock*) + kBlockAlignment;
+    // Allocate a dynamic block. Blocks of cacheable sizes are rounded up to
+    // their size-class so they can be reused by any request of that class.
+    DynamicBlock* block;
+    uint32_t sizeClass;
+
+    if (_getDynamicClass(size, sizeClass, allocatedSize)) {
+      size = allocatedSize;
+      block = _magazines[sizeClass];
+
+      if (block) {
+        _magazines[sizeClass] = block->next;
+        _magazineCounts[sizeClass]--;
+      }
+    }
+    else {
+      sizeClass = kDynamicClassCount;
+      block = nullptr;
+    }
 
-    // Handle a possible overflow.
-    if (ASMJIT_UNLIKELY(overhead >= ~static_cast<size_t>(0) - size))
-      return nullptr;
+    if (!block) {
+      size_t overhead = ZoneHeap_getDynamicOverhead();
 
-    void* p = Internal::allocMemory(size + overhead);
-    if (ASMJIT_UNLIKELY(!p)) {
-      allocatedSize = 0;
-      return nullptr;
+      // Handle a possible overflow.
+      if (ASMJIT_UNLIKELY(overhead >= ~static_cast<size_t>(0) - size)) {
+        allocatedSize = 0;
+        return nullptr;
+      }
+
+      block = static_cast<DynamicBlock*>(Internal::allocMemory(size + overhead));
+      if (ASMJIT_UNLIKELY(!block)) {
+        allocatedSize = 0;
+        return nullptr;
+      }
+
+      block->heap = this;
+      block->size = size;
+      block->sizeClass = sizeClass;
+
+      _dynamicReservedSize += size + overhead;
+      _dynamicBlockCount++;
     }
 
+    _dynamicUsedSize += size;
+    if (_dynamicPeakSize < _dynamicUsedSize)
+      _dynamicPeakSize = _dynamicUsedSize;
+
     // Link as first in `_dynamicBlocks` double-linked list.
-    DynamicBlock* block = static_cast<DynamicBlock*>(p);
     DynamicBlock* next = _dynamicBlocks;
 
     if (next)
@@ -311,7 +617,7 @@ void* ZoneHeap::_alloc(size_t size, size_t& allocatedSize) noexcept {
 
     // Align the pointer to the guaranteed alignment and store `DynamicBlock`
     // at the end of the memory block, so `_releaseDynamic()` can find it.
-    p = Utils::alignTo(static_cast<uint8_t*>(p) + sizeof(DynamicBlock) + sizeof(DynamicBlock*), kBlockAlignment);
+    void* p = ZoneHeap_getDynamicData(block);
     reinterpret_cast<DynamicBlock**>(p)[-1] = block;
 
     allocatedSize = size;
@@ -334,9 +640,9 @@ void ZoneHeap::_releaseDynamic(void* p, size_t size) noexcept {
 
   // Pointer to `DynamicBlock` is stored at [-1].
   DynamicBlock* block = reinterpret_cast<DynamicBlock**>(p)[-1];
-  ASMJIT_ASSERT(ZoneHeap_hasDynamicBlock(this, block));
+  ASMJIT_ASSERT(block->heap == this);
 
-  // Unlink and free.
+  // Unlink.
   DynamicBlock* prev = block->prev;
   DynamicBlock* next = block->next;
 
@@ -348,7 +654,21 @@ void ZoneHeap::_releaseDynamic(void* p, size_t size) noexcept {
   if (next)
     next->prev = prev;
 
-  Internal::releaseMemory(block);
+  ASMJIT_ASSERT(_dynamicUsedSize >= block->size);
+  _dynamicUsedSize -= block->size;
+
+  // Cache the block in its magazine if it's not full, free it otherwise.
+  uint32_t sizeClass = block->sizeClass;
+  if (sizeClass < kDynamicClassCount && _magazineCounts[sizeClass] < kMagazineCapacity) {
+    block->next = _magazines[sizeClass];
+    _magazines[sizeClass] = block;
+    _magazineCounts[sizeClass]++;
+  }
+  else {
+    _dynamicReservedSize -= block->size + ZoneHeap_getDynamicOverhead();
+    _dynamicBlockCount--;
+    Internal::releaseMemory(block);
+  }
 }
 
 // ============================================================================
@@ -434,6 +754,49 @@ Error ZoneVectorBase::_resize(ZoneHeap* heap, size_t sizeOfT, size_t n) noexcept
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::ZoneSegmentedVectorBase - Memory Management]
+// ============================================================================
+
+void ZoneSegmentedVectorBase::_release(ZoneHeap* heap, size_t sizeOfT) noexcept {
+  for (uint32_t i = 0; i < _segmentCount; i++)
+    heap->release(_segments[i], getSegmentLength(i) * sizeOfT);
+  reset();
+}
+
+Error ZoneSegmentedVectorBase::_grow(ZoneHeap* heap, size_t sizeOfT, size_t n) noexcept {
+  size_t capacity = _capacity;
+  size_t after = _length;
+
+  if (ASMJIT_UNLIKELY(IntTraits<size_t>::maxValue() - n < after))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  after += n;
+  while (capacity < after) {
+    uint32_t segment = _segmentCount;
+    if (ASMJIT_UNLIKELY(segment >= kMaxSegments))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    size_t segmentLength = getSegmentLength(segment);
+    if (ASMJIT_UNLIKELY(segmentLength > IntTraits<size_t>::maxValue() / sizeOfT))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    size_t allocatedSize;
+    void* p = heap->alloc(segmentLength * sizeOfT, allocatedSize);
+    if (ASMJIT_UNLIKELY(!p))
+      return DebugUtils::errored(kErrorNoHeapMemory);
+
+    // Existing segments are never moved or copied, only a new one is added.
+    _segments[segment] = p;
+    _segmentCount = segment + 1;
+
+    capacity += segmentLength;
+    _capacity = capacity;
+  }
+
+  return kErrorOk;
+}
+
 // ============================================================================
 // [asmjit::ZoneBitVector - Ops]
 // ============================================================================
@@ -609,10 +972,8 @@ Error ZoneBitVector::fill(size_t from, size_t to, bool value) noexcept {
 
   // Fill all bits in case there is a gap between the current `idx` and `endIdx`.
   if (idx < endIdx) {
-    BitWord pattern = _patternFromBit(value);
-    do {
-      data[idx++] = pattern;
-    } while (idx < endIdx);
+    BitOps::fill(data + idx, _patternFromBit(value), endIdx - idx);
+    idx = endIdx;
   }
 
   // Special case for non-zero `endBit`.
@@ -828,11 +1189,430 @@ ZoneHashNode* ZoneHashBase::_del(ZoneHashNode* node) noexcept {
   return nullptr;
 }
 
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Helpers]
+// ============================================================================
+
+typedef ZoneOpenHashBase OpenHash;
+
+static ASMJIT_INLINE size_t ZoneOpenHash_getDataSize(size_t capacity) noexcept {
+  return capacity * sizeof(ZoneHashNode*) + capacity + OpenHash::kGroupSize;
+}
+
+//! \internal
+//!
+//! Get the count of records a table of `capacity` can hold, keeps 1/8 empty.
+static ASMJIT_INLINE size_t ZoneOpenHash_getGrowth(size_t capacity) noexcept {
+  return capacity - capacity / 8;
+}
+
+//! \internal
+//!
+//! Insert `node` into the first free slot of its probe sequence.
+static void ZoneOpenHash_insert(OpenHash* self, ZoneHashNode* node) noexcept {
+  uint32_t h = OpenHash::_mix(node->_hVal);
+
+  size_t mask = self->_capacity - 1;
+  size_t pos = OpenHash::_h1(h) & mask;
+  size_t step = 0;
+
+  for (;;) {
+    uint32_t m = OpenHash::_matchFree(self->_ctrl + pos);
+    if (m) {
+      size_t i = (pos + Utils::findFirstBit(m)) & mask;
+      if (self->_ctrl[i] == OpenHash::kCtrlEmpty)
+        self->_growthLeft--;
+
+      self->_setCtrl(i, OpenHash::_h2(h));
+      self->_nodes[i] = node;
+      self->_size++;
+      return;
+    }
+
+    step += OpenHash::kGroupSize;
+    pos = (pos + step) & mask;
+  }
+}
+
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Reset]
+// ============================================================================
+
+void ZoneOpenHashBase::reset(ZoneHeap* heap) noexcept {
+  if (_capacity)
+    _heap->release(_nodes, ZoneOpenHash_getDataSize(_capacity));
+
+  _heap = heap;
+  _size = 0;
+  _capacity = 0;
+  _growthLeft = 0;
+  _ctrl = nullptr;
+  _nodes = nullptr;
+}
+
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Rehash]
+// ============================================================================
+
+Error ZoneOpenHashBase::_rehash(size_t newCapacity) noexcept {
+  ASMJIT_ASSERT(isInitialized());
+  ASMJIT_ASSERT(Utils::isPowerOf2(newCapacity) && newCapacity >= kMinCapacity);
+  ASMJIT_ASSERT(ZoneOpenHash_getGrowth(newCapacity) > _size);
+
+  ZoneHashNode** newNodes = static_cast<ZoneHashNode**>(_heap->alloc(ZoneOpenHash_getDataSize(newCapacity)));
+  if (ASMJIT_UNLIKELY(!newNodes))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  uint8_t* newCtrl = reinterpret_cast<uint8_t*>(newNodes + newCapacity);
+  ::memset(newCtrl, kCtrlEmpty, newCapacity + kGroupSize);
+
+  uint8_t* oldCtrl = _ctrl;
+  ZoneHashNode** oldNodes = _nodes;
+  size_t oldCapacity = _capacity;
+
+  _size = 0;
+  _capacity = newCapacity;
+  _growthLeft = ZoneOpenHash_getGrowth(newCapacity);
+  _ctrl = newCtrl;
+  _nodes = newNodes;
+
+  for (size_t i = 0; i < oldCapacity; i++) {
+    if (!(oldCtrl[i] & 0x80))
+      ZoneOpenHash_insert(this, oldNodes[i]);
+  }
+
+  if (oldCapacity)
+    _heap->release(oldNodes, ZoneOpenHash_getDataSize(oldCapacity));
+  return kErrorOk;
+}
+
+// ============================================================================
+// [asmjit::ZoneOpenHashBase - Ops]
+// ============================================================================
+
+ZoneHashNode* ZoneOpenHashBase::_put(ZoneHashNode* node) noexcept {
+  if (ASMJIT_UNLIKELY(!_growthLeft)) {
+    // Double the capacity, unless most of the used slots are deleted, in
+    // which case rehashing to the same capacity frees them.
+    size_t newCapacity = kMinCapacity;
+    if (_capacity)
+      newCapacity = _size * 2 < ZoneOpenHash_getGrowth(_capacity) ? _capacity : _capacity * 2;
+
+    if (ASMJIT_UNLIKELY(_rehash(newCapacity) != kErrorOk))
+      return nullptr;
+  }
+
+  ZoneOpenHash_insert(this, node);
+  return node;
+}
+
+ZoneHashNode* ZoneOpenHashBase::_del(ZoneHashNode* node) noexcept {
+  if (!_size) return nullptr;
+
+  uint32_t h = _mix(node->_hVal);
+  uint32_t h2 = _h2(h);
+
+  size_t mask = _capacity - 1;
+  size_t pos = _h1(h) & mask;
+  size_t step = 0;
+
+  for (;;) {
+    const uint8_t* group = _ctrl + pos;
+    uint32_t m = _matchGroup(group, h2);
+
+    while (m) {
+      size_t i = (pos + Utils::findFirstBit(m)) & mask;
+      if (_nodes[i] == node) {
+        // The slot must stay occupied (deleted), otherwise lookups of nodes
+        // that were inserted after it and probed past it would stop here.
+        _setCtrl(i, kCtrlDeleted);
+        _nodes[i] = nullptr;
+        _size--;
+        return node;
+      }
+      m &= m - 1;
+    }
+
+    if (_matchGroup(group, kCtrlEmpty))
+      return nullptr;
+
+    step += kGroupSize;
+    pos = (pos + step) & mask;
+  }
+}
+
 // ============================================================================
 // [asmjit::Zone - Test]
 // ============================================================================
 
 #if defined(ASMJIT_TEST)
+UNIT(base_zone_pool) {
+  Zone::PoolStats before, after;
+  size_t limit = Zone::getPoolLimit();
+  uint32_t i;
+
+  Zone::releasePool();
+  Zone::getPoolStats(&before);
+
+  EXPECT(before.cachedBytes == 0 && before.cachedBlocks == 0,
+    "Zone::releasePool() didn't release pooled blocks");
+
+  INFO("Blocks released by Zone must be reused");
+  for (i = 0; i < 100; i++) {
+    Zone zone(8192 - Zone::kZoneOverhead);
+    EXPECT(zone.alloc(64) != nullptr, "Zone::alloc() failed");
+    EXPECT(zone.alloc(16384) != nullptr, "Zone::alloc() failed");
+  }
+
+  Zone::getPoolStats(&after);
+  EXPECT(after.allocCount - before.allocCount == 2,
+    "Zone allocated %u blocks instead of reusing them", static_cast<unsigned int>(after.allocCount - before.allocCount));
+  EXPECT(after.reuseCount - before.reuseCount == 198,
+    "Zone reused %u blocks instead of 198", static_cast<unsigned int>(after.reuseCount - before.reuseCount));
+  EXPECT(after.releaseCount == before.releaseCount,
+    "Zone released blocks that should have been pooled");
+  EXPECT(after.cachedBlocks == 2,
+    "Pool should keep 2 blocks, not %u", static_cast<unsigned int>(after.cachedBlocks));
+
+  INFO("Blocks must not be pooled if the pool is disabled");
+  Zone::setPoolLimit(0);
+  Zone::getPoolStats(&before);
+  EXPECT(before.cachedBytes == 0 && before.releaseCount - after.releaseCount == 2,
+    "Zone::setPoolLimit() didn't release pooled blocks");
+
+  for (i = 0; i < 10; i++) {
+    Zone zone(8192 - Zone::kZoneOverhead);
+    EXPECT(zone.alloc(64) != nullptr, "Zone::alloc() failed");
+  }
+
+  Zone::getPoolStats(&after);
+  EXPECT(after.allocCount - before.allocCount == 10 && after.releaseCount - before.releaseCount == 10,
+    "Disabled pool shouldn't keep blocks");
+
+  Zone::setPoolLimit(limit);
+}
+
+UNIT(base_zone_stats) {
+  Zone zone(8192 - Zone::kZoneOverhead);
+  ZoneStats stats;
+  uint32_t i;
+
+  zone.getStats(&stats);
+  EXPECT(stats.reservedBytes == 0 && stats.usedBytes == 0 && stats.peakUsedBytes == 0 && stats.blockCount == 0,
+    "Zone without blocks should have empty stats");
+
+  INFO("Zone must account used bytes across blocks");
+  for (i = 0; i < 100; i++)
+    EXPECT(zone.alloc(1000) != nullptr, "Zone::alloc() failed");
+
+  zone.getStats(&stats);
+  EXPECT(stats.usedBytes >= 100000 && stats.usedBytes < 100000 + stats.blockCount * zone.getBlockAlignment(),
+    "Zone used %u bytes instead of 100000", static_cast<unsigned int>(stats.usedBytes));
+  EXPECT(stats.blockCount >= 13 && stats.reservedBytes >= stats.usedBytes,
+    "Zone reserved %u blocks", static_cast<unsigned int>(stats.blockCount));
+  EXPECT(stats.peakUsedBytes == stats.usedBytes,
+    "Zone peak must be equal to used bytes if the zone was never reset");
+
+  INFO("Zone must keep its peak and blocks after reset(false)");
+  size_t peak = stats.peakUsedBytes;
+  size_t blockCount = stats.blockCount;
+
+  zone.reset(false);
+  EXPECT(zone.alloc(64) != nullptr, "Zone::alloc() failed");
+  zone.getStats(&stats);
+  EXPECT(stats.usedBytes == 64 && stats.peakUsedBytes == peak && stats.blockCount == blockCount,
+    "Zone::reset(false) didn't keep blocks or the peak");
+
+  zone.reset(true);
+  zone.getStats(&stats);
+  EXPECT(stats.usedBytes == 0 && stats.reservedBytes == 0 && stats.blockCount == 0 && stats.peakUsedBytes == peak,
+    "Zone::reset(true) didn't release blocks or keep the peak");
+
+  INFO("ZoneHeap must account dynamic blocks");
+  ZoneHeap heap(&zone);
+  size_t allocatedSize;
+
+  void* small = heap.alloc(64, allocatedSize);
+  EXPECT(small != nullptr, "ZoneHeap::alloc() failed");
+  heap.getStats(&stats);
+  EXPECT(stats.usedBytes == 0 && stats.blockCount == 0,
+    "ZoneHeap shouldn't account chunks allocated from Zone");
+
+  void* large = heap.alloc(100000, allocatedSize);
+  EXPECT(large != nullptr, "ZoneHeap::alloc() failed");
+  heap.getStats(&stats);
+  EXPECT(stats.usedBytes == allocatedSize && stats.blockCount == 1 && stats.reservedBytes > allocatedSize,
+    "ZoneHeap didn't account a dynamic block");
+
+  heap.release(large, allocatedSize);
+  heap.getStats(&stats);
+  EXPECT(stats.usedBytes == 0 && stats.peakUsedBytes == allocatedSize,
+    "ZoneHeap::release() didn't update used bytes");
+
+  heap.release(small, 64);
+  heap.reset();
+  heap.getStats(&stats);
+  EXPECT(stats.reservedBytes == 0 && stats.blockCount == 0,
+    "ZoneHeap::reset() didn't clear stats");
+}
+
+UNIT(base_zone_state) {
+  Zone zone(1024 - Zone::kZoneOverhead);
+  Zone::State state;
+  uint32_t i;
+
+  INFO("Zone::restoreState() must reuse memory allocated after saveState()");
+  EXPECT(zone.alloc(100) != nullptr, "Zone::alloc() failed");
+  zone.saveState(&state);
+
+  uint8_t* first = static_cast<uint8_t*>(zone.alloc(64));
+  EXPECT(first != nullptr, "Zone::alloc() failed");
+  for (i = 0; i < 20; i++)
+    EXPECT(zone.alloc(200) != nullptr, "Zone::alloc() failed");
+
+  ZoneStats stats;
+  zone.getStats(&stats);
+  size_t blockCount = stats.blockCount;
+
+  zone.restoreState(state);
+  EXPECT(zone.alloc(64) == first, "Zone::restoreState() didn't restore the cursor");
+  for (i = 0; i < 20; i++)
+    EXPECT(zone.alloc(200) != nullptr, "Zone::alloc() failed");
+
+  zone.getStats(&stats);
+  EXPECT(stats.blockCount == blockCount,
+    "Zone allocated %u blocks instead of reusing them", static_cast<unsigned int>(stats.blockCount - blockCount));
+
+  INFO("Zone::restoreState() of a state saved before the first allocation");
+  Zone empty(1024 - Zone::kZoneOverhead);
+  empty.saveState(&state);
+  EXPECT(empty.alloc(2000) != nullptr, "Zone::alloc() failed");
+  empty.restoreState(state);
+  empty.getStats(&stats);
+  EXPECT(stats.usedBytes == 0 && stats.blockCount == 1,
+    "Zone::restoreState() didn't keep the block");
+}
+
+UNIT(base_zoneheap) {
+  Zone zone(8096 - Zone::kZoneOverhead);
+  ZoneHeap heap(&zone);
+
+  size_t allocatedSize;
+  uint32_t i;
+
+  INFO("Dynamic blocks must be rounded up to their size-class");
+  void* p = heap.alloc(600, allocatedSize);
+  EXPECT(p != nullptr && allocatedSize == 1024,
+    "ZoneHeap::alloc() returned %u bytes instead of 1024", static_cast<unsigned int>(allocatedSize));
+  ::memset(p, 0, allocatedSize);
+
+  INFO("Released dynamic blocks must be reused by the same size-class");
+  heap.release(p, 600);
+  EXPECT(heap._magazineCounts[0] == 1,
+    "Released block wasn't cached");
+  EXPECT(heap.alloc(1000, allocatedSize) == p && heap._magazineCounts[0] == 0,
+    "Cached block wasn't reused");
+  heap.release(p, allocatedSize);
+
+  INFO("Magazines must be bounded");
+  void* blocks[ZoneHeap::kMagazineCapacity + 2];
+  for (i = 0; i < ASMJIT_ARRAY_SIZE(blocks); i++)
+    blocks[i] = heap.alloc(4096);
+  for (i = 0; i < ASMJIT_ARRAY_SIZE(blocks); i++)
+    heap.release(blocks[i], 4096);
+  EXPECT(heap._magazineCounts[2] == ZoneHeap::kMagazineCapacity,
+    "Magazine keeps %u blocks", static_cast<unsigned int>(heap._magazineCounts[2]));
+
+  INFO("Large dynamic blocks must not be cached");
+  size_t largeSize = ZoneHeap::kDynamicMaxSize + 1;
+  p = heap.alloc(largeSize, allocatedSize);
+  EXPECT(p != nullptr && allocatedSize == largeSize,
+    "ZoneHeap::alloc() failed to allocate a large block");
+  heap.release(p, largeSize);
+  EXPECT(heap._dynamicBlocks == nullptr,
+    "All dynamic blocks should have been released");
+}
+
+struct ZoneOpenHashTestNode : public ZoneHashNode {
+  ASMJIT_INLINE ZoneOpenHashTestNode(uint32_t key, uint32_t hVal) noexcept
+    : ZoneHashNode(hVal),
+      _key(key) {}
+
+  uint32_t _key;
+};
+
+struct ZoneOpenHashTestKey {
+  ASMJIT_INLINE ZoneOpenHashTestKey(uint32_t key, uint32_t hVal) noexcept
+    : key(key),
+      hVal(hVal) {}
+
+  ASMJIT_INLINE bool matches(const ZoneOpenHashTestNode* node) const noexcept {
+    return node->_key == key;
+  }
+
+  uint32_t key;
+  uint32_t hVal;
+};
+
+UNIT(base_zoneopenhash) {
+  Zone zone(8096 - Zone::kZoneOverhead);
+  ZoneHeap heap(&zone);
+  ZoneOpenHash<ZoneOpenHashTestNode> hash(&heap);
+
+  uint32_t i;
+  uint32_t kCount = 10000;
+
+  // Every 16th key has the same hash to test collisions.
+  #define KEY_HASH(key) ((key) % 16 == 0 ? 0xABCDU : Utils::hashRound(0, key))
+
+  EXPECT(hash.get(ZoneOpenHashTestKey(0, KEY_HASH(0))) == nullptr,
+    "Empty hash table must not find anything");
+
+  INFO("Inserting %u nodes", kCount);
+  for (i = 0; i < kCount; i++) {
+    ZoneOpenHashTestNode* node = zone.newT<ZoneOpenHashTestNode>(i, KEY_HASH(i));
+    EXPECT(hash.put(node) == node, "ZoneOpenHash::put() failed");
+  }
+  EXPECT(hash.getSize() == kCount,
+    "ZoneOpenHash::getSize() returned %u", static_cast<unsigned int>(hash.getSize()));
+  EXPECT(Utils::isPowerOf2(hash.getCapacity()) && hash.getCapacity() > kCount,
+    "Invalid capacity");
+
+  for (i = 0; i < kCount; i++) {
+    ZoneOpenHashTestNode* node = hash.get(ZoneOpenHashTestKey(i, KEY_HASH(i)));
+    EXPECT(node != nullptr && node->_key == i, "Key %u not found", i);
+  }
+  EXPECT(hash.get(ZoneOpenHashTestKey(kCount, KEY_HASH(kCount))) == nullptr,
+    "Key %u that wasn't inserted found", kCount);
+
+  INFO("Deleting every other node");
+  for (i = 0; i < kCount; i += 2) {
+    ZoneOpenHashTestNode* node = hash.get(ZoneOpenHashTestKey(i, KEY_HASH(i)));
+    EXPECT(hash.del(node) == node, "ZoneOpenHash::del() failed");
+  }
+  EXPECT(hash.getSize() == kCount / 2,
+    "ZoneOpenHash::getSize() returned %u", static_cast<unsigned int>(hash.getSize()));
+
+  for (i = 0; i < kCount; i++) {
+    ZoneOpenHashTestNode* node = hash.get(ZoneOpenHashTestKey(i, KEY_HASH(i)));
+    EXPECT((node != nullptr) == ((i & 1) != 0), "Key %u %s", i, node ? "found after deletion" : "not found");
+  }
+
+  INFO("Reusing deleted slots");
+  size_t capacity = hash.getCapacity();
+  for (uint32_t r = 0; r < 10; r++) {
+    for (i = 0; i < kCount; i += 2) {
+      hash.put(zone.newT<ZoneOpenHashTestNode>(i, KEY_HASH(i)));
+      hash.del(hash.get(ZoneOpenHashTestKey(i, KEY_HASH(i))));
+    }
+  }
+  EXPECT(hash.getCapacity() == capacity,
+    "Capacity grew from %u to %u, deleted slots were not reused",
+    static_cast<unsigned int>(capacity), static_cast<unsigned int>(hash.getCapacity()));
+
+  #undef KEY_HASH
+}
+
 UNIT(base_zonevector) {
   Zone zone(8096 - Zone::kZoneOverhead);
   ZoneHeap heap(&zone);
@@ -863,6 +1643,60 @@ UNIT(base_zonevector) {
   EXPECT(vec.indexOf(kMax - 1) == static_cast<size_t>(kMax - 1));
 }
 
+UNIT(base_zonesegmentedvector) {
+  Zone zone(8096 - Zone::kZoneOverhead);
+  ZoneHeap heap(&zone);
+
+  size_t i;
+  size_t kMax = 100000;
+
+  ZoneSegmentedVector<size_t> vec;
+
+  INFO("ZoneSegmentedVector<size_t> basic tests");
+  EXPECT(vec.isEmpty());
+  EXPECT(vec.append(&heap, 0) == kErrorOk);
+  EXPECT(vec.getLength() == 1);
+  EXPECT(vec.getCapacity() == ZoneSegmentedVectorBase::getSegmentLength(0));
+  EXPECT(vec[0] == 0);
+
+  vec.clear();
+  EXPECT(vec.isEmpty());
+  EXPECT(vec.getCapacity() == ZoneSegmentedVectorBase::getSegmentLength(0));
+
+  size_t* first = nullptr;
+  for (i = 0; i < kMax; i++) {
+    EXPECT(vec.append(&heap, i) == kErrorOk);
+    if (i == 0)
+      first = &vec[0];
+  }
+
+  EXPECT(vec.getLength() == kMax);
+  EXPECT(&vec[0] == first,
+    "ZoneSegmentedVector must not move items when it grows");
+  for (i = 0; i < kMax; i++)
+    EXPECT(vec[i] == i, "ZoneSegmentedVector[%u] doesn't match", static_cast<unsigned int>(i));
+
+  INFO("ZoneSegmentedVector<size_t> segments are contiguous ranges");
+  size_t index = 0;
+  for (uint32_t segment = 0; segment < vec.getSegmentCount(); segment++) {
+    const size_t* items = vec.getSegment(segment);
+    size_t n = std::min<size_t>(ZoneSegmentedVectorBase::getSegmentLength(segment), kMax - index);
+    for (i = 0; i < n; i++, index++)
+      EXPECT(items[i] == index, "ZoneSegmentedVector segment %u is not contiguous", segment);
+  }
+  EXPECT(index == kMax);
+
+  INFO("ZoneSegmentedVector<size_t>::willGrow() can add more segments at once");
+  vec.truncate(10);
+  EXPECT(vec.getLength() == 10);
+  size_t capacity = vec.getCapacity();
+  EXPECT(vec.willGrow(&heap, capacity) == kErrorOk);
+  EXPECT(vec.getCapacity() - vec.getLength() >= capacity);
+
+  vec.release(&heap);
+  EXPECT(vec.isEmpty() && vec.getCapacity() == 0 && vec.getSegmentCount() == 0);
+}
+
 UNIT(base_ZoneBitVector) {
   Zone zone(8096 - Zone::kZoneOverhead);
   ZoneHeap heap(&zone);
@@ -906,6 +1740,34 @@ UNIT(base_ZoneBitVector) {
       EXPECT(vec.getAt(i) == static_cast<bool>(i & 1));
     }
   }
+
+  INFO("ZoneBitVector::and_() / andNot() / or_() / eq() / countOnes()");
+  for (count = 1; count < kMaxCount * 20; count += 37) {
+    ZoneBitVector other;
+
+    vec.clear();
+    EXPECT(vec.resize(&heap, count, true) == kErrorOk);
+    EXPECT(other.resize(&heap, count, false) == kErrorOk);
+
+    for (i = 0; i < count; i += 3)
+      other.setAt(i, true);
+
+    size_t nOther = (count + 2) / 3;
+    EXPECT(vec.countOnes() == count);
+    EXPECT(other.countOnes() == nOther);
+    EXPECT(vec.eq(other) == (nOther == count));
+
+    vec.andNot(other);
+    EXPECT(vec.countOnes() == count - nOther);
+
+    vec.or_(other);
+    EXPECT(vec.countOnes() == count);
+
+    vec.and_(other);
+    EXPECT(vec.eq(other));
+
+    other.release(&heap);
+  }
 }
 
 UNIT(base_zonestack) {
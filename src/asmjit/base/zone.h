@@ -9,8 +9,16 @@
 #define _ASMJIT_BASE_ZONE_H
 
 // [Dependencies]
+#include "../base/bitops.h"
 #include "../base/utils.h"
 
+#if ASMJIT_ARCH_X64 || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define ASMJIT_ZONE_SSE2 1
+# include <emmintrin.h>
+#else
+# define ASMJIT_ZONE_SSE2 0
+#endif
+
 // [Api-Begin]
 #include "../asmjit_apibegin.h"
 
@@ -19,6 +27,44 @@ namespace asmjit {
 //! \addtogroup asmjit_base
 //! \{
 
+// ============================================================================
+// [asmjit::ZoneStats]
+// ============================================================================
+
+//! Memory usage of \ref Zone, \ref ZoneHeap, or of a group of them.
+struct ZoneStats {
+  // --------------------------------------------------------------------------
+  // [Reset / Add]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_INLINE void reset() noexcept {
+    reservedBytes = 0;
+    usedBytes = 0;
+    peakUsedBytes = 0;
+    blockCount = 0;
+  }
+
+  //! Add `other` to these statistics.
+  //!
+  //! NOTE: The sum of peaks is an upper bound of the peak of the group, as the
+  //! peaks of its members don't have to happen at the same time.
+  ASMJIT_INLINE void add(const ZoneStats& other) noexcept {
+    reservedBytes += other.reservedBytes;
+    usedBytes += other.usedBytes;
+    peakUsedBytes += other.peakUsedBytes;
+    blockCount += other.blockCount;
+  }
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  size_t reservedBytes;                  //!< Bytes of memory blocks owned (allocated from the system or the pool).
+  size_t usedBytes;                      //!< Bytes handed out to the user, including alignment padding.
+  size_t peakUsedBytes;                  //!< High-water mark of `usedBytes`.
+  size_t blockCount;                     //!< Number of memory blocks owned.
+};
+
 // ============================================================================
 // [asmjit::Zone]
 // ============================================================================
@@ -45,6 +91,14 @@ public:
     uint8_t data[sizeof(void*)];         //!< Data.
   };
 
+  //! Saved state of `Zone`, see `saveState()` and `restoreState()`.
+  struct State {
+    uint8_t* ptr;                        //!< Pointer in the current block.
+    uint8_t* end;                        //!< End of the current block.
+    Block* block;                        //!< Current block.
+    size_t retiredSize;                  //!< Bytes used by blocks preceding the current one.
+  };
+
   enum {
     //! Zone allocator overhead.
     kZoneOverhead = Globals::kAllocOverhead + static_cast<int>(sizeof(Block))
@@ -78,9 +132,30 @@ public:
 
   //! Reset the `Zone` invalidating all blocks allocated.
   //!
-  //! If `releaseMemory` is true all buffers will be released to the system.
+  //! If `releaseMemory` is true all buffers will be released to the block
+  //! pool or to the system, see \ref setPoolLimit().
   ASMJIT_API void reset(bool releaseMemory = false) noexcept;
 
+  // --------------------------------------------------------------------------
+  // [State]
+  // --------------------------------------------------------------------------
+
+  //! Save the current state of the `Zone` to `state`.
+  ASMJIT_INLINE void saveState(State* state) const noexcept {
+    state->ptr = _ptr;
+    state->end = _end;
+    state->block = _block;
+    state->retiredSize = _retiredSize;
+  }
+
+  //! Restore the state previously saved by `saveState()`, O(1).
+  //!
+  //! All memory allocated after the state has been saved becomes free, but
+  //! blocks are kept and reused by subsequent allocations. The `Zone` must
+  //! not be reset in the meantime and nothing allocated after the state has
+  //! been saved can be used after it has been restored.
+  ASMJIT_API void restoreState(const State& state) noexcept;
+
   // --------------------------------------------------------------------------
   // [Accessors]
   // --------------------------------------------------------------------------
@@ -108,6 +183,21 @@ public:
     _ptr = p;
   }
 
+  // --------------------------------------------------------------------------
+  // [Stats]
+  // --------------------------------------------------------------------------
+
+  //! Get the number of bytes used since the last `reset()`.
+  ASMJIT_INLINE size_t getUsedSize() const noexcept {
+    return _retiredSize + (_ptr ? static_cast<size_t>(_ptr - _block->data) : size_t(0));
+  }
+
+  //! Get memory usage of the `Zone`.
+  //!
+  //! The peak is kept for the whole lifetime of the `Zone`, it's not cleared
+  //! by `reset()`, so it can be queried after the zone has been reset.
+  ASMJIT_API void getStats(ZoneStats* out) const noexcept;
+
   // --------------------------------------------------------------------------
   // [Alloc]
   // --------------------------------------------------------------------------
@@ -208,6 +298,14 @@ public:
       return nullptr;
     return new(p) T(p1);
   }
+  //! Like `new(std::nothrow) T(...)`, but allocated by `Zone`.
+  template<typename T, typename P1, typename P2>
+  ASMJIT_INLINE T* newT(P1 p1, P2 p2) noexcept {
+    void* p = alloc(sizeof(T));
+    if (ASMJIT_UNLIKELY(!p))
+      return nullptr;
+    return new(p) T(p1, p2);
+  }
 
   //! \internal
   ASMJIT_API void* _alloc(size_t size) noexcept;
@@ -218,6 +316,36 @@ public:
   //! Helper to duplicate formatted string, maximum length is 256 bytes.
   ASMJIT_API char* sformat(const char* str, ...) noexcept;
 
+  // --------------------------------------------------------------------------
+  // [Block Pool]
+  // --------------------------------------------------------------------------
+
+  //! Statistics of the block pool, see \ref getPoolStats().
+  struct PoolStats {
+    size_t limit;                        //!< Maximum number of bytes the pool keeps.
+    size_t cachedBytes;                  //!< Number of bytes of blocks in the pool.
+    size_t cachedBlocks;                 //!< Number of blocks in the pool.
+    uint64_t allocCount;                 //!< Number of blocks allocated by `malloc()`.
+    uint64_t releaseCount;               //!< Number of blocks released by `free()`.
+    uint64_t reuseCount;                 //!< Number of blocks reused from the pool.
+  };
+
+  //! Set the maximum number of bytes of released blocks the pool keeps.
+  //!
+  //! Blocks released by `reset(true)` (and by the destructor) are kept in a
+  //! process-wide pool and reused by any `Zone` that allocates a block of the
+  //! same size, so short-lived zones (like these used by \ref CodeHolder and
+  //! \ref CodeBuilder) don't have to call `malloc()` and `free()` each time.
+  //! Only blocks of default sizes are pooled, large blocks are always released.
+  //! Setting `limit` to zero disables the pool and releases all pooled blocks.
+  ASMJIT_API static void setPoolLimit(size_t limit) noexcept;
+  //! Get the maximum number of bytes of released blocks the pool keeps.
+  ASMJIT_API static size_t getPoolLimit() noexcept;
+  //! Get statistics of the block pool.
+  ASMJIT_API static void getPoolStats(PoolStats* out) noexcept;
+  //! Release all blocks kept by the pool to the system.
+  ASMJIT_API static void releasePool() noexcept;
+
   // --------------------------------------------------------------------------
   // [Members]
   // --------------------------------------------------------------------------
@@ -226,6 +354,11 @@ public:
   uint8_t* _end;                         //!< End of the current block's buffer.
   Block* _block;                         //!< Current block.
 
+  size_t _retiredSize;                   //!< Bytes used by blocks preceding the current one.
+  size_t _peakUsedSize;                  //!< High-water mark of used bytes (not cleared by `reset()`).
+  size_t _reservedSize;                  //!< Bytes of all blocks owned.
+  size_t _blockCount;                    //!< Number of blocks owned.
+
 #if ASMJIT_ARCH_64BIT
   uint32_t _blockSize;                   //!< Default size of a newly allocated block.
   uint32_t _blockAlignmentShift;         //!< Minimum alignment of each block.
@@ -273,7 +406,19 @@ class ZoneHeap {
     kHiMaxSize = kLoMaxSize + kHiGranularity * kHiCount,
 
     //! Alignment of every pointer returned by `alloc()`.
-    kBlockAlignment = kLoGranularity
+    kBlockAlignment = kLoGranularity,
+
+    // Dynamic blocks of these sizes are cached in magazines when released:
+    //   [1k, 2k, 4k, 8k, 16k, 32k, 64k, 128k]
+
+    //! Size of the smallest size-class of dynamic blocks.
+    kDynamicMinSize = 1024,
+    //! Number of size-classes of dynamic blocks.
+    kDynamicClassCount = 8,
+    //! Maximum size of a dynamic block that is cached in a magazine.
+    kDynamicMaxSize = kDynamicMinSize << (kDynamicClassCount - 1),
+    //! Maximum number of released dynamic blocks kept per size-class.
+    kMagazineCapacity = 4
   };
 
   //! Single-linked list used to store unused chunks.
@@ -285,9 +430,15 @@ class ZoneHeap {
   //! A block of memory that has been allocated dynamically and is not part of
   //! block-list used by the allocator. This is used to keep track of all these
   //! blocks so they can be freed by `reset()` if not freed explicitly.
+  //!
+  //! A pointer to the `DynamicBlock` is stored just before the memory returned
+  //! by `alloc()`, so `release()` finds it in O(1).
   struct DynamicBlock {
     DynamicBlock* prev;
     DynamicBlock* next;
+    ZoneHeap* heap;                      //!< Owner of the block (to verify `release()`).
+    size_t size;                         //!< Size of the memory returned by `alloc()`.
+    uint32_t sizeClass;                  //!< Size-class or `kDynamicClassCount` if not cached.
   };
 
   // --------------------------------------------------------------------------
@@ -332,6 +483,21 @@ class ZoneHeap {
   //! Get the `Zone` the `ZoneHeap` is using, or null if it's not initialized.
   ASMJIT_INLINE Zone* getZone() const noexcept { return _zone; }
 
+  // --------------------------------------------------------------------------
+  // [Stats]
+  // --------------------------------------------------------------------------
+
+  //! Get memory usage of dynamic blocks of the `ZoneHeap`, cleared by `reset()`.
+  //!
+  //! Chunks that fit into slots are allocated from the \ref Zone and are only
+  //! accounted by the \ref Zone, so stats of both can be added together.
+  ASMJIT_INLINE void getStats(ZoneStats* out) const noexcept {
+    out->reservedBytes = _dynamicReservedSize;
+    out->usedBytes = _dynamicUsedSize;
+    out->peakUsedBytes = _dynamicPeakSize;
+    out->blockCount = _dynamicBlockCount;
+  }
+
   // --------------------------------------------------------------------------
   // [Utilities]
   // --------------------------------------------------------------------------
@@ -354,6 +520,28 @@ class ZoneHeap {
     return true;
   }
 
+  //! \internal
+  //!
+  //! Get the size-class of a dynamic block of `size` bytes. Returns `true` if
+  //! the block can be cached, `sizeClass` and `allocatedSize` are filled with
+  //! the size-class and its size. Blocks that are larger are never cached.
+  static ASMJIT_INLINE bool _getDynamicClass(size_t size, uint32_t& sizeClass, size_t& allocatedSize) noexcept {
+    if (size > kDynamicMaxSize)
+      return false;
+
+    uint32_t i = 0;
+    size_t classSize = kDynamicMinSize;
+
+    while (classSize < size) {
+      classSize <<= 1;
+      i++;
+    }
+
+    sizeClass = i;
+    allocatedSize = classSize;
+    return true;
+  }
+
   //! \overload
   static ASMJIT_INLINE bool _getSlotIndex(size_t size, uint32_t& slot, size_t& allocatedSize) noexcept {
     ASMJIT_ASSERT(size > 0);
@@ -451,6 +639,13 @@ class ZoneHeap {
   Zone* _zone;                           //!< Zone used to allocate memory that fits into slots.
   Slot* _slots[kLoCount + kHiCount];     //!< Indexed slots containing released memory.
   DynamicBlock* _dynamicBlocks;          //!< Dynamic blocks for larger allocations (no slots).
+  DynamicBlock* _magazines[kDynamicClassCount]; //!< Released dynamic blocks per size-class.
+  uint32_t _magazineCounts[kDynamicClassCount]; //!< Number of blocks in each magazine.
+
+  size_t _dynamicReservedSize;           //!< Bytes of dynamic blocks owned, including cached ones.
+  size_t _dynamicUsedSize;               //!< Bytes of dynamic blocks in use.
+  size_t _dynamicPeakSize;               //!< High-water mark of `_dynamicUsedSize`.
+  size_t _dynamicBlockCount;             //!< Number of dynamic blocks owned, including cached ones.
 };
 
 // ============================================================================
@@ -685,7 +880,7 @@ public:
       ASMJIT_PROPAGATE(grow(heap, 1));
 
     T* dst = static_cast<T*>(_data) + index;
-    ::memmove(dst + 1, dst, _length - index);
+    ::memmove(dst + 1, dst, (_length - index) * sizeof(T));
     ::memcpy(dst, &item, sizeof(T));
 
     _length++;
@@ -774,7 +969,7 @@ public:
 
     T* data = static_cast<T*>(_data) + i;
     _length--;
-    ::memmove(data, data + 1, _length - i);
+    ::memmove(data, data + 1, (_length - i) * sizeof(T));
   }
 
   //! Swap this pod-vector with `other`.
@@ -827,6 +1022,201 @@ public:
   }
 };
 
+// ============================================================================
+// [asmjit::ZoneSegmentedVectorBase]
+// ============================================================================
+
+//! \internal
+class ZoneSegmentedVectorBase {
+public:
+  ASMJIT_NONCOPYABLE(ZoneSegmentedVectorBase)
+
+  enum {
+    //! Number of items of the first segment is `1 << kFirstSegmentShift`.
+    kFirstSegmentShift = 4,
+    //! Maximum number of segments, each segment doubles the capacity.
+    kMaxSegments = 26
+  };
+
+protected:
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new instance of `ZoneSegmentedVectorBase`.
+  explicit ASMJIT_INLINE ZoneSegmentedVectorBase() noexcept
+    : _length(0),
+      _capacity(0),
+      _segmentCount(0) {}
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+public:
+  //! Get if the vector is empty.
+  ASMJIT_INLINE bool isEmpty() const noexcept { return _length == 0; }
+  //! Get vector length.
+  ASMJIT_INLINE size_t getLength() const noexcept { return _length; }
+  //! Get vector capacity.
+  ASMJIT_INLINE size_t getCapacity() const noexcept { return _capacity; }
+
+  //! Get the number of segments allocated.
+  ASMJIT_INLINE uint32_t getSegmentCount() const noexcept { return _segmentCount; }
+  //! Get the number of items of the segment `segment`.
+  static ASMJIT_INLINE size_t getSegmentLength(uint32_t segment) noexcept {
+    return static_cast<size_t>(1) << (segment + kFirstSegmentShift);
+  }
+
+  // --------------------------------------------------------------------------
+  // [Ops]
+  // --------------------------------------------------------------------------
+
+  //! Makes the vector empty (won't change the capacity or release segments).
+  ASMJIT_INLINE void clear() noexcept { _length = 0; }
+  //! Reset the vector data and set its `length` to zero.
+  //!
+  //! Segments are not released, use it only if the heap is being reset.
+  ASMJIT_INLINE void reset() noexcept {
+    _length = 0;
+    _capacity = 0;
+    _segmentCount = 0;
+  }
+
+  //! Truncate the vector to at most `n` items.
+  ASMJIT_INLINE void truncate(size_t n) noexcept {
+    _length = std::min(_length, n);
+  }
+
+  // --------------------------------------------------------------------------
+  // [Memory Management]
+  // --------------------------------------------------------------------------
+
+protected:
+  //! Get the address of the item at `index`.
+  //!
+  //! Segment `k` holds `16 << k` items starting at index `16 * ((1 << k) - 1)`,
+  //! so the segment is given by the most significant bit of `index / 16 + 1`.
+  ASMJIT_INLINE void* _getItem(size_t index, size_t sizeOfT) const noexcept {
+    size_t x = (index >> kFirstSegmentShift) + 1;
+    uint32_t segment = Utils::findLastBit(static_cast<uint32_t>(x));
+    size_t offset = index - (((static_cast<size_t>(1) << segment) - 1) << kFirstSegmentShift);
+
+    ASMJIT_ASSERT(segment < _segmentCount);
+    return static_cast<uint8_t*>(_segments[segment]) + offset * sizeOfT;
+  }
+
+  ASMJIT_API void _release(ZoneHeap* heap, size_t sizeOfT) noexcept;
+  ASMJIT_API Error _grow(ZoneHeap* heap, size_t sizeOfT, size_t n) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+public:
+  size_t _length;                        //!< Length of the vector.
+  size_t _capacity;                      //!< Capacity of the vector (sum of lengths of all segments).
+  uint32_t _segmentCount;                //!< Number of segments allocated.
+  void* _segments[kMaxSegments];         //!< Segments, the first `_segmentCount` are valid.
+};
+
+// ============================================================================
+// [asmjit::ZoneSegmentedVector<T>]
+// ============================================================================
+
+//! Vector of POD items stored in segments of geometrically growing length.
+//!
+//! Unlike `ZoneVector<T>` it never moves items when it grows, it only adds a
+//! new segment, so addresses of items are stable and growing doesn't copy
+//! the data or leave the old array as dead memory in the zone. Indexing is
+//! O(1) through the table of segments, but slower than `ZoneVector<T>` and
+//! items are not contiguous, so use it for vectors that grow large and are
+//! accessed by index.
+template <typename T>
+class ZoneSegmentedVector : public ZoneSegmentedVectorBase {
+public:
+  ASMJIT_NONCOPYABLE(ZoneSegmentedVector<T>)
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  //! Create a new instance of `ZoneSegmentedVector<T>`.
+  explicit ASMJIT_INLINE ZoneSegmentedVector() noexcept : ZoneSegmentedVectorBase() {}
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get items of the segment `segment`, see `getSegmentLength()`.
+  ASMJIT_INLINE T* getSegment(uint32_t segment) noexcept {
+    ASMJIT_ASSERT(segment < _segmentCount);
+    return static_cast<T*>(_segments[segment]);
+  }
+  //! \overload
+  ASMJIT_INLINE const T* getSegment(uint32_t segment) const noexcept {
+    ASMJIT_ASSERT(segment < _segmentCount);
+    return static_cast<const T*>(_segments[segment]);
+  }
+
+  // --------------------------------------------------------------------------
+  // [Ops]
+  // --------------------------------------------------------------------------
+
+  //! Append `item` to the vector.
+  ASMJIT_INLINE Error append(ZoneHeap* heap, const T& item) noexcept {
+    if (ASMJIT_UNLIKELY(_length == _capacity))
+      ASMJIT_PROPAGATE(grow(heap, 1));
+
+    appendUnsafe(item);
+    return kErrorOk;
+  }
+
+  //! Append `item` to the vector (unsafe case).
+  //!
+  //! Can only be used together with `willGrow()`. If `willGrow(N)` returns
+  //! `kErrorOk` then N items can be added to the vector without checking if
+  //! there is a place for them. Used mostly internally.
+  ASMJIT_INLINE void appendUnsafe(const T& item) noexcept {
+    ASMJIT_ASSERT(_length < _capacity);
+
+    ::memcpy(_getItem(_length, sizeof(T)), &item, sizeof(T));
+    _length++;
+  }
+
+  //! Get item at index `i`.
+  ASMJIT_INLINE T& operator[](size_t i) noexcept {
+    ASMJIT_ASSERT(i < _length);
+    return *static_cast<T*>(_getItem(i, sizeof(T)));
+  }
+
+  //! Get item at index `i`.
+  ASMJIT_INLINE const T& operator[](size_t i) const noexcept {
+    ASMJIT_ASSERT(i < _length);
+    return *static_cast<const T*>(_getItem(i, sizeof(T)));
+  }
+
+  //! Get the last item.
+  ASMJIT_INLINE T& getLast() noexcept {
+    ASMJIT_ASSERT(_length > 0);
+    return operator[](_length - 1);
+  }
+
+  // --------------------------------------------------------------------------
+  // [Memory Management]
+  // --------------------------------------------------------------------------
+
+  //! Release all segments back to the `heap`.
+  ASMJIT_INLINE void release(ZoneHeap* heap) noexcept { _release(heap, sizeof(T)); }
+
+  //! Called to grow the vector to fit at least `n` items more.
+  ASMJIT_INLINE Error grow(ZoneHeap* heap, size_t n) noexcept { return ZoneSegmentedVectorBase::_grow(heap, sizeof(T), n); }
+
+  ASMJIT_INLINE Error willGrow(ZoneHeap* heap, size_t n = 1) noexcept {
+    return _capacity - _length < n ? grow(heap, n) : static_cast<Error>(kErrorOk);
+  }
+};
+
 // ============================================================================
 // [asmjit::ZoneBitVector]
 // ============================================================================
@@ -941,35 +1331,38 @@ public:
   ASMJIT_API Error fill(size_t fromIndex, size_t toIndex, bool value) noexcept;
 
   ASMJIT_INLINE void and_(const ZoneBitVector& other) noexcept {
-    BitWord* dst = _data;
-    const BitWord* src = other._data;
-
     size_t numWords = (std::min(_length, other._length) + kBitsPerWord - 1) / kBitsPerWord;
-    for (size_t i = 0; i < numWords; i++)
-      dst[i] = dst[i] & src[i];
+    BitOps::and_(_data, _data, other._data, numWords);
     _clearUnusedBits();
   }
 
   ASMJIT_INLINE void andNot(const ZoneBitVector& other) noexcept {
-    BitWord* dst = _data;
-    const BitWord* src = other._data;
-
     size_t numWords = (std::min(_length, other._length) + kBitsPerWord - 1) / kBitsPerWord;
-    for (size_t i = 0; i < numWords; i++)
-      dst[i] = dst[i] & ~src[i];
+    BitOps::andNot(_data, _data, other._data, numWords);
     _clearUnusedBits();
   }
 
   ASMJIT_INLINE void or_(const ZoneBitVector& other) noexcept {
-    BitWord* dst = _data;
-    const BitWord* src = other._data;
-
     size_t numWords = (std::min(_length, other._length) + kBitsPerWord - 1) / kBitsPerWord;
-    for (size_t i = 0; i < numWords; i++)
-      dst[i] = dst[i] | src[i];
+    BitOps::or_(_data, _data, other._data, numWords);
     _clearUnusedBits();
   }
 
+  //! Get whether this bit-vector has the same length and bits as `other`.
+  ASMJIT_INLINE bool eq(const ZoneBitVector& other) const noexcept {
+    if (_length != other._length)
+      return false;
+
+    size_t numWords = (_length + kBitsPerWord - 1) / kBitsPerWord;
+    return BitOps::equals(_data, other._data, numWords);
+  }
+
+  //! Get the number of bits set.
+  ASMJIT_INLINE size_t countOnes() const noexcept {
+    size_t numWords = (_length + kBitsPerWord - 1) / kBitsPerWord;
+    return BitOps::popcount(_data, numWords);
+  }
+
   ASMJIT_INLINE void _clearUnusedBits() noexcept {
     size_t idx = _length / kBitsPerWord;
     size_t bit = _length % kBitsPerWord;
@@ -1318,6 +1711,195 @@ public:
   ASMJIT_INLINE Node* del(Node* node) noexcept { return static_cast<Node*>(_del(node)); }
 };
 
+// ============================================================================
+// [asmjit::ZoneOpenHashBase]
+// ============================================================================
+
+//! Base of \ref ZoneOpenHash<>.
+//!
+//! Open-addressing hash table of pointers to \ref ZoneHashNode with capacity
+//! that is a power of two. Each slot has a control byte that is either empty,
+//! deleted, or contains 7 bits of the hash of its node. Control bytes are
+//! probed in groups of 16, which are compared with the hash at once by SSE2
+//! (if available), so most lookups touch only one node - the one that matches.
+//! The first group is mirrored after the last control byte, so a group can
+//! be loaded at any slot without wrapping around.
+class ZoneOpenHashBase {
+public:
+  ASMJIT_NONCOPYABLE(ZoneOpenHashBase)
+
+  enum {
+    //! Number of control bytes probed at once.
+    kGroupSize = 16,
+    //! Minimum capacity of a table that is not empty.
+    kMinCapacity = 16,
+
+    //! Control byte of an empty slot.
+    kCtrlEmpty = 0x80,
+    //! Control byte of a deleted slot.
+    kCtrlDeleted = 0xFE
+  };
+
+  // --------------------------------------------------------------------------
+  // [Construction / Destruction]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_INLINE ZoneOpenHashBase(ZoneHeap* heap) noexcept {
+    _heap = heap;
+    _size = 0;
+    _capacity = 0;
+    _growthLeft = 0;
+    _ctrl = nullptr;
+    _nodes = nullptr;
+  }
+  ASMJIT_INLINE ~ZoneOpenHashBase() noexcept { reset(nullptr); }
+
+  // --------------------------------------------------------------------------
+  // [Reset]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_INLINE bool isInitialized() const noexcept { return _heap != nullptr; }
+  ASMJIT_API void reset(ZoneHeap* heap) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Accessors]
+  // --------------------------------------------------------------------------
+
+  //! Get a `ZoneHeap` attached to this container.
+  ASMJIT_INLINE ZoneHeap* getHeap() const noexcept { return _heap; }
+
+  ASMJIT_INLINE size_t getSize() const noexcept { return _size; }
+  ASMJIT_INLINE size_t getCapacity() const noexcept { return _capacity; }
+
+  // --------------------------------------------------------------------------
+  // [Utilities]
+  // --------------------------------------------------------------------------
+
+  //! \internal
+  //!
+  //! Mix `hVal`, which is usually a weak hash of a string.
+  static ASMJIT_INLINE uint32_t _mix(uint32_t hVal) noexcept { return hVal * 0x9E3779B1U; }
+  //! \internal
+  //!
+  //! Get the 7 bits stored in a control byte from a mixed hash `h`.
+  static ASMJIT_INLINE uint32_t _h2(uint32_t h) noexcept { return h >> 25; }
+  //! \internal
+  //!
+  //! Get the first slot to probe from a mixed hash `h`.
+  static ASMJIT_INLINE size_t _h1(uint32_t h) noexcept { return static_cast<size_t>(h ^ (h >> 15)); }
+
+  //! \internal
+  //!
+  //! Get a mask of control bytes in the group at `ctrl` that are equal to `v`.
+  static ASMJIT_INLINE uint32_t _matchGroup(const uint8_t* ctrl, uint32_t v) noexcept {
+#if ASMJIT_ZONE_SSE2
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(group, _mm_set1_epi8(static_cast<char>(v)))));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < kGroupSize; i++)
+      mask |= static_cast<uint32_t>(ctrl[i] == v) << i;
+    return mask;
+#endif
+  }
+
+  //! \internal
+  //!
+  //! Get a mask of control bytes in the group at `ctrl` that are empty or deleted.
+  static ASMJIT_INLINE uint32_t _matchFree(const uint8_t* ctrl) noexcept {
+#if ASMJIT_ZONE_SSE2
+    __m128i group = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    return static_cast<uint32_t>(_mm_movemask_epi8(group));
+#else
+    uint32_t mask = 0;
+    for (uint32_t i = 0; i < kGroupSize; i++)
+      mask |= static_cast<uint32_t>(ctrl[i] >> 7) << i;
+    return mask;
+#endif
+  }
+
+  //! \internal
+  //!
+  //! Set the control byte of slot `i`, including its mirror.
+  ASMJIT_INLINE void _setCtrl(size_t i, uint32_t v) noexcept {
+    _ctrl[i] = static_cast<uint8_t>(v);
+    if (i < kGroupSize)
+      _ctrl[_capacity + i] = static_cast<uint8_t>(v);
+  }
+
+  // --------------------------------------------------------------------------
+  // [Ops]
+  // --------------------------------------------------------------------------
+
+  ASMJIT_API Error _rehash(size_t newCapacity) noexcept;
+  ASMJIT_API ZoneHashNode* _put(ZoneHashNode* node) noexcept;
+  ASMJIT_API ZoneHashNode* _del(ZoneHashNode* node) noexcept;
+
+  // --------------------------------------------------------------------------
+  // [Members]
+  // --------------------------------------------------------------------------
+
+  ZoneHeap* _heap;                       //!< ZoneHeap used to allocate data.
+  size_t _size;                          //!< Count of records inserted into the hash table.
+  size_t _capacity;                      //!< Count of slots (zero or a power of two).
+  size_t _growthLeft;                    //!< Count of records that can be inserted before rehash.
+
+  uint8_t* _ctrl;                        //!< Control bytes (`_capacity + kGroupSize`).
+  ZoneHashNode** _nodes;                 //!< Slots.
+};
+
+// ============================================================================
+// [asmjit::ZoneOpenHash<Node>]
+// ============================================================================
+
+//! Open-addressing variant of \ref ZoneHash<> that has the same API.
+//!
+//! It's faster than \ref ZoneHash<> when the number of nodes is large, as it
+//! doesn't have a maximum number of buckets and only compares keys of nodes
+//! whose hash is likely to be the same.
+template<typename Node>
+class ZoneOpenHash : public ZoneOpenHashBase {
+public:
+  explicit ASMJIT_INLINE ZoneOpenHash(ZoneHeap* heap = nullptr) noexcept
+    : ZoneOpenHashBase(heap) {}
+  ASMJIT_INLINE ~ZoneOpenHash() noexcept {}
+
+  template<typename Key>
+  ASMJIT_INLINE Node* get(const Key& key) const noexcept {
+    if (!_size) return nullptr;
+
+    uint32_t h = _mix(key.hVal);
+    uint32_t h2 = _h2(h);
+
+    size_t mask = _capacity - 1;
+    size_t pos = _h1(h) & mask;
+    size_t step = 0;
+
+    for (;;) {
+      const uint8_t* group = _ctrl + pos;
+      uint32_t m = _matchGroup(group, h2);
+
+      while (m) {
+        size_t i = (pos + Utils::findFirstBit(m)) & mask;
+        Node* node = static_cast<Node*>(_nodes[i]);
+
+        if (key.matches(node))
+          return node;
+        m &= m - 1;
+      }
+
+      if (_matchGroup(group, kCtrlEmpty))
+        return nullptr;
+
+      step += kGroupSize;
+      pos = (pos + step) & mask;
+    }
+  }
+
+  ASMJIT_INLINE Node* put(Node* node) noexcept { return static_cast<Node*>(_put(node)); }
+  ASMJIT_INLINE Node* del(Node* node) noexcept { return static_cast<Node*>(_del(node)); }
+};
+
 //! \}
 
 } // asmjit namespace
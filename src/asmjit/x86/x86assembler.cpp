@@ -296,6 +296,15 @@ static ASMJIT_INLINE bool x86IsJmpOrCall(uint32_t instId) noexcept {
          instId == X86Inst::kIdCall;
 }
 
+// Get whether `self` can use the absolute address of `mem`. Position independent
+// 64-bit code can't, except FS|GS relative addresses, which are thread-local
+// offsets that don't depend on where the code or its data are loaded.
+static ASMJIT_INLINE bool x86IsPicAddressValid(const X86Assembler* self, const X86Mem& mem) noexcept {
+  return !(self->getGlobalHints() & CodeEmitter::kHintPositionIndependent) ||
+         self->getArchType() == ArchInfo::kTypeX86 ||
+         mem.getSegmentId() >= X86Seg::kIdFs;
+}
+
 static ASMJIT_INLINE bool x86IsImplicitMem(const Operand_& op, uint32_t base) noexcept {
   return op.isMem() && op.as<X86Mem>().getBaseId() == base;
 }
@@ -3535,6 +3544,8 @@ CaseVexRvm_R:
   // --------------------------------------------------------------------------
 
 EmitX86OpMovAbs:
+  if (ASMJIT_UNLIKELY(!x86IsPicAddressValid(this, rmRel->as<X86Mem>())))
+    goto InvalidAddress;
   imLen = getGpSize();
 
   // Segment-override prefix.
@@ -3758,6 +3769,9 @@ EmitModSib:
         EMIT_32(relOffset);
       }
       else {
+        if (ASMJIT_UNLIKELY(!x86IsPicAddressValid(this, rmRel->as<X86Mem>())))
+          goto InvalidAddress;
+
         uint64_t baseAddress = getCodeInfo().getBaseAddress();
         relOffset = rmRel->as<X86Mem>().getOffsetLo32();
 
@@ -3771,7 +3785,7 @@ EmitModSib:
         if (baseAddress != Globals::kNoBaseAddress && !preferAbsolute) {
           const uint32_t kModRel32Size = 5;
           uint64_t rip64 = baseAddress +
-            static_cast<uint64_t>((uintptr_t)(cursor - _bufferData)) + imLen + kModRel32Size;
+            static_cast<uint64_t>((uintptr_t)(_bufferOffset + (size_t)(cursor - _bufferData))) + imLen + kModRel32Size;
 
           uint64_t rel64 = static_cast<uint64_t>(rmRel->as<X86Mem>().getOffset()) - rip64;
           if (Utils::isInt32(static_cast<int64_t>(rel64))) {
@@ -3811,11 +3825,12 @@ EmitModSib_LabelRip_X86:
           if (ASMJIT_UNLIKELY(err)) goto Failed;
 
           re->_sourceSectionId = _section->getId();
-          re->_sourceOffset = static_cast<uint64_t>((uintptr_t)(cursor - _bufferData));
+          re->_sourceOffset = static_cast<uint64_t>((uintptr_t)(_bufferOffset + (size_t)(cursor - _bufferData)));
           re->_data = static_cast<int64_t>(relOffset);
 
           if (label->isBound()) {
             // Bound label.
+            re->_targetSectionId = label->getSectionId();
             re->_data += static_cast<uint64_t>(label->getOffset());
             EMIT_32(0);
           }
@@ -3832,7 +3847,8 @@ EmitModSib_LabelRip_X86:
           if (ASMJIT_UNLIKELY(err)) goto Failed;
 
           re->_sourceSectionId = _section->getId();
-          re->_sourceOffset = static_cast<uint64_t>((uintptr_t)(cursor - _bufferData));
+          re->_targetSectionId = _section->getId();
+          re->_sourceOffset = static_cast<uint64_t>((uintptr_t)(_bufferOffset + (size_t)(cursor - _bufferData)));
           re->_data = re->_sourceOffset + static_cast<uint64_t>(static_cast<int64_t>(relOffset));
           EMIT_32(0);
         }
@@ -3845,13 +3861,13 @@ EmitModSib_LabelRip_X86:
           if (!label) goto InvalidLabel;
 
           relOffset -= (4 + imLen);
-          if (label->isBound()) {
+          if (label->isBound() && label->getSectionId() == _section->getId()) {
             // Bound label.
-            relOffset += label->getOffset() - static_cast<int32_t>((intptr_t)(cursor - _bufferData));
+            relOffset += label->getOffset() - static_cast<int32_t>((intptr_t)(_bufferOffset + (size_t)(cursor - _bufferData)));
             EMIT_32(static_cast<int32_t>(relOffset));
           }
           else {
-            // Non-bound label.
+            // Non-bound label or a label bound in another section.
             relSize = 4;
             goto EmitRel;
           }
@@ -3904,6 +3920,9 @@ EmitModVSib:
     }
     // ==========|> [INDEX + DISP32].
     else if (!(rmInfo & (kX86MemInfo_BaseLabel | kX86MemInfo_BaseRip))) {
+      if (ASMJIT_UNLIKELY(!x86IsPicAddressValid(this, rmRel->as<X86Mem>())))
+        goto InvalidAddress;
+
       // [INDEX << SHIFT + DISP32].
       EMIT_BYTE(x86EncodeMod(0, opReg, 4));
       EMIT_BYTE(x86EncodeSib(rmRel->as<X86Mem>().getShift(), rxReg, 5));
@@ -4254,7 +4273,7 @@ EmitJmpCall:
       EMIT_BYTE(rex | kX86ByteRex);
     }
 
-    uint64_t ip = static_cast<uint64_t>((intptr_t)(cursor - _bufferData));
+    uint64_t ip = static_cast<uint64_t>((intptr_t)(_bufferOffset + (size_t)(cursor - _bufferData)));
     uint32_t rel32 = 0;
     uint32_t opCode8 = commonData->getAltOpCode();
 
@@ -4275,13 +4294,13 @@ EmitJmpCall:
       label = _code->getLabelEntry(rmRel->as<Label>());
       if (!label) goto InvalidLabel;
 
-      if (label->isBound()) {
+      if (label->isBound() && label->getSectionId() == _section->getId()) {
         // Bound label.
         rel32 = static_cast<uint32_t>((static_cast<uint64_t>(label->getOffset()) - ip - inst32Size) & 0xFFFFFFFFU);
         goto EmitJmpCallRel;
       }
       else {
-        // Non-bound label.
+        // Non-bound label or a label bound in another section.
         if (opCode8 && (!opCode || (options & X86Inst::kOptionShortForm))) {
           EMIT_BYTE(opCode8);
           relOffset = -1;
@@ -4312,6 +4331,39 @@ EmitJmpCall:
       uint64_t baseAddress = getCodeInfo().getBaseAddress();
       uint64_t jumpAddress = rmRel->as<Imm>().getUInt64();
 
+      // Position independent code loads the address from the GOT, which makes
+      // the instruction independent of the base address (64-bit jmp/jcc/call).
+      if ((_globalHints & kHintPositionIndependent) && getArchType() != ArchInfo::kTypeX86 &&
+          opCode && (opCode8 || x86IsJmpOrCall(instId))) {
+        if (ASMJIT_UNLIKELY(_code->_relocations.willGrow(&_code->_baseHeap) != kErrorOk))
+          goto NoHeapMemory;
+
+        size_t gotOffset;
+        err = _code->addGotEntry(&gotOffset, jumpAddress);
+        if (ASMJIT_UNLIKELY(err)) goto Failed;
+
+        err = _code->newRelocEntry(&re, RelocEntry::kTypeRelToRel, 4);
+        if (ASMJIT_UNLIKELY(err)) goto Failed;
+
+        // Jcc - emit an inverted short jcc over `jmp [rip + GOT]` (6 bytes).
+        if (!x86IsJmpOrCall(instId)) {
+          EMIT_BYTE(opCode8 ^ 0x01);
+          EMIT_BYTE(6);
+        }
+
+        // Emit FF /2 (call) or FF /4 (jmp) with [RIP + DISP32].
+        EMIT_BYTE(0xFF);
+        EMIT_BYTE(x86EncodeMod(0, instId == X86Inst::kIdCall ? 2 : 4, 5));
+
+        re->_sourceSectionId = _section->getId();
+        re->_targetSectionId = _code->getGotSection()->getId();
+        re->_sourceOffset = static_cast<uint64_t>((uintptr_t)(_bufferOffset + (size_t)(cursor - _bufferData)));
+        re->_data = static_cast<uint64_t>(gotOffset) - 4;
+
+        EMIT_32(0);
+        goto EmitDone;
+      }
+
       // If the base-address is known calculate a relative displacement and
       // check if it fits in 32 bits (which is always true in 32-bit mode).
       // Emit relative displacement as it was a bound label if all checks ok.
@@ -4413,18 +4465,33 @@ EmitJmpCallRel:
 
 EmitRel:
   {
-    ASMJIT_ASSERT(!label->isBound());
     ASMJIT_ASSERT(relSize == 1 || relSize == 4);
+    size_t offset = _bufferOffset + (size_t)(cursor - _bufferData);
+
+    if (label->isBound()) {
+      // The label is bound in another section, the displacement is resolved
+      // by `CodeHolder::relocate()` after sections are laid out.
+      ASMJIT_ASSERT(re == nullptr && label->getSectionId() != _section->getId());
 
-    // Chain with label.
-    size_t offset = (size_t)(cursor - _bufferData);
-    LabelLink* link = _code->newLabelLink(label, _section->getId(), offset, relOffset);
+      err = _code->newRelocEntry(&re, RelocEntry::kTypeRelToRel, relSize);
+      if (ASMJIT_UNLIKELY(err)) goto Failed;
 
-    if (ASMJIT_UNLIKELY(!link))
-      goto NoHeapMemory;
+      re->_sourceSectionId = _section->getId();
+      re->_targetSectionId = label->getSectionId();
+      re->_sourceOffset = static_cast<uint64_t>(offset);
+      re->_data = static_cast<uint64_t>(static_cast<int64_t>(label->getOffset()) + relOffset);
+    }
+    else {
+      // Chain with label.
+      LabelLink* link = _code->newLabelLink(label, _section->getId(), offset, relOffset);
+      if (ASMJIT_UNLIKELY(!link))
+        goto NoHeapMemory;
 
-    if (re)
-      link->relocId = re->getId();
+      if (re)
+        link->relocId = re->getId();
+      else
+        link->size = relSize;
+    }
 
     // Emit label size as dummy data.
     if (relSize == 1)
@@ -4522,6 +4589,37 @@ Failed:
   return _emitFailed(err, instId, options, o0, o1, o2, o3);
 }
 
+// ============================================================================
+// [asmjit::X86Assembler - Stream]
+// ============================================================================
+
+Error X86Assembler::_emitStream(const InstRecord* records, size_t count, size_t* countOut) {
+  Error err = kErrorOk;
+  size_t i;
+
+  for (i = 0; i < count; i++) {
+    const InstRecord& record = records[i];
+    const Operand_* ops = record.operands;
+
+    // Operands are passed by reference, only the 5th and 6th operand have to
+    // be copied, as `_emit()` reads them from `_op4` and `_op5`.
+    _options = record.options;
+    _extraReg = record.extraReg;
+
+    if (ASMJIT_UNLIKELY(!ops[4].isNone() || !ops[5].isNone())) {
+      _op4 = ops[4];
+      _op5 = ops[5];
+      _options |= kOptionOp4Op5Used;
+    }
+
+    err = X86Assembler::_emit(record.instId, ops[0], ops[1], ops[2], ops[3]);
+    if (ASMJIT_UNLIKELY(err)) break;
+  }
+
+  if (countOut) *countOut = i;
+  return err;
+}
+
 // ============================================================================
 // [asmjit::X86Assembler - Align]
 // ============================================================================
@@ -4604,6 +4702,84 @@ Error X86Assembler::align(uint32_t mode, uint32_t alignment) {
   return kErrorOk;
 }
 
+// ============================================================================
+// [asmjit::X86Assembler - Test]
+// ============================================================================
+
+#if defined(ASMJIT_TEST)
+UNIT(x86_assembler_stream) {
+  CodeHolder codeA;
+  CodeHolder codeB;
+
+  codeA.init(CodeInfo(ArchInfo::kTypeX64));
+  codeB.init(CodeInfo(ArchInfo::kTypeX64));
+
+  X86Assembler a(&codeA);
+  X86Assembler b(&codeB);
+
+  CodeEmitter::InstRecord records[8];
+  for (uint32_t i = 0; i < ASMJIT_ARRAY_SIZE(records); i++)
+    records[i].reset();
+
+  records[0].instId = X86Inst::kIdAdd;
+  records[0].operands[0] = x86::rax;
+  records[0].operands[1] = x86::qword_ptr(x86::rbx, x86::rcx, 3, 16);
+
+  records[1].instId = X86Inst::kIdAdd;
+  records[1].options = X86Inst::kOptionLock;
+  records[1].operands[0] = x86::dword_ptr(x86::rdx);
+  records[1].operands[1] = x86::r9d;
+
+  records[2].instId = X86Inst::kIdImul;
+  records[2].operands[0] = x86::ecx;
+  records[2].operands[1] = x86::ebx;
+  records[2].operands[2] = imm(1000);
+
+  records[3].instId = X86Inst::kIdVaddps;
+  records[3].extraReg.init(x86::k1);
+  records[3].operands[0] = x86::zmm0;
+  records[3].operands[1] = x86::zmm1;
+  records[3].operands[2] = x86::zmm2;
+
+  records[4].instId = X86Inst::kIdVpermil2ps;
+  records[4].operands[0] = x86::xmm0;
+  records[4].operands[1] = x86::xmm1;
+  records[4].operands[2] = x86::xmm2;
+  records[4].operands[3] = x86::xmm3;
+  records[4].operands[4] = imm(2);
+
+  records[5].instId = X86Inst::kIdRet;
+
+  INFO("Checking emitStream() matches emit()");
+  size_t count = 0;
+  EXPECT(a.emitStream(records, 6, &count) == kErrorOk);
+  EXPECT(count == 6);
+
+  b.add(x86::rax, x86::qword_ptr(x86::rbx, x86::rcx, 3, 16));
+  b.lock().add(x86::dword_ptr(x86::rdx), x86::r9d);
+  b.imul(x86::ecx, x86::ebx, 1000);
+  b.setExtraReg(x86::k1);
+  b.vaddps(x86::zmm0, x86::zmm1, x86::zmm2);
+  b.emit(X86Inst::kIdVpermil2ps, x86::xmm0, x86::xmm1, x86::xmm2, x86::xmm3, imm(2));
+  b.ret();
+
+  EXPECT(b.getLastError() == kErrorOk);
+  EXPECT(a.getOffset() == b.getOffset(),
+    "Stream emission has %u bytes, expected %u", unsigned(a.getOffset()), unsigned(b.getOffset()));
+  EXPECT(::memcmp(a.getBufferData(), b.getBufferData(), a.getOffset()) == 0);
+
+  INFO("Checking emitStream() stops at the first failure");
+  records[6].instId = X86Inst::kIdAdd;
+  records[6].operands[0] = x86::dword_ptr(x86::rax);
+  records[6].operands[1] = x86::dword_ptr(x86::rbx);
+
+  size_t offset = a.getOffset();
+  EXPECT(a.emitStream(records + 5, 3, &count) != kErrorOk);
+  EXPECT(count == 1);
+  EXPECT(a.getOffset() == offset + 1);
+}
+#endif // ASMJIT_TEST
+
 } // asmjit namespace
 
 // [Api-End]
@@ -83,6 +83,7 @@ public:
 
   ASMJIT_API Error _emit(uint32_t instId, const Operand_& o0, const Operand_& o1, const Operand_& o2, const Operand_& o3) override;
   ASMJIT_API Error align(uint32_t mode, uint32_t alignment) override;
+  ASMJIT_API Error _emitStream(const InstRecord* records, size_t count, size_t* countOut) override;
 };
 
 //! \}
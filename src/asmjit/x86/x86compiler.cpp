@@ -52,6 +52,283 @@ Error X86Compiler::onAttach(CodeHolder* code) noexcept {
   return addPassT<X86RAPass>();
 }
 
+// ============================================================================
+// [asmjit::X86Compiler - Relax]
+// ============================================================================
+
+//! \internal
+//!
+//! Node of the layout computed by `X86Compiler_relaxJumps()`.
+struct X86RelaxItem {
+  ASMJIT_ENUM(Type) {
+    kTypeJump  = 0,                      //!< Jump to a label.
+    kTypeAlign = 1,                      //!< Alignment.
+    kTypeLabel = 2                       //!< Bound label.
+  };
+
+  CBNode* node;                          //!< Node of the item.
+  uint32_t type;                         //!< Type of the item.
+  uint32_t sectionId;                    //!< Section where the node is emitted.
+  size_t start;                          //!< Offset of the node when measured.
+  size_t end;                            //!< Offset after the node when measured.
+  size_t offset;                         //!< Offset of the node in the relaxed layout.
+  uint32_t data;                         //!< Label id (jump and label) or alignment.
+  uint32_t target;                       //!< Item index of the jump target.
+  uint32_t delta;                        //!< Size saved by the short form of the jump.
+  bool isShort;                          //!< The jump uses the short form.
+};
+
+// Get the size saved by the short form of a jump to a label, zero if the jump
+// has only one form. `jmp rel8|rel32` and `jcc rel8|0F rel32` are relaxed,
+// `jecxz` and `loop` have only the short form.
+static ASMJIT_INLINE uint32_t X86Compiler_getRelaxDelta(const CBNode* node) noexcept {
+  if (node->getType() != CBNode::kNodeInst || !node->isJmpOrJcc())
+    return 0;
+
+  const CBInst* inst = node->as<CBInst>();
+  uint32_t instId = inst->getInstId();
+
+  if (inst->getOpCount() == 0 || !inst->getOpArray()[0].isLabel())
+    return 0;
+
+  if (inst->getOptions() & (X86Inst::kOptionShortForm | X86Inst::kOptionLongForm))
+    return 0;
+
+  if (instId == X86Inst::kIdJmp)
+    return 3;
+
+  if (instId >= X86Inst::kIdJa && instId <= X86Inst::kIdJz && instId != X86Inst::kIdJecxz)
+    return 4;
+
+  return 0;
+}
+
+// Select the short or long form of each jump to a label that has no form set.
+//
+// The code is serialized to `dst` once with all such jumps in their long form
+// to measure it, and rolled back. The layout is then recomputed without emitting
+// anything: all jumps start short and a jump that doesn't reach its target is
+// changed to long until no jump changes. Only jumps, labels, and alignments are
+// tracked, the size of anything between them doesn't depend on the layout.
+static Error X86Compiler_relaxJumps(X86Compiler* self, Assembler* dst) noexcept {
+  CodeHolder* code = self->getCode();
+  Zone* zone = &self->_cbPassZone;
+
+  size_t nodeCount = 0;
+  CBNode* node;
+
+  for (node = self->getFirstNode(); node; node = node->getNext())
+    nodeCount++;
+
+  // Each node creates at most two items (`CBConstPool` aligns and binds).
+  X86RelaxItem* items = zone->allocT<X86RelaxItem>(nodeCount * 2 * sizeof(X86RelaxItem));
+  if (ASMJIT_UNLIKELY(!items))
+    return DebugUtils::errored(kErrorNoHeapMemory);
+
+  // Relaxation is optional, the code is serialized as is if the state of the
+  // CodeHolder can't be saved.
+  CodeHolder::Checkpoint cp;
+  if (code->saveCheckpoint(&cp) != kErrorOk)
+    return kErrorOk;
+
+  // Measure, without logging the code twice.
+  uint32_t globalOptions = dst->_globalOptions;
+  dst->_globalOptions &= ~CodeEmitter::kOptionLoggingEnabled;
+
+  Error err = kErrorOk;
+  size_t itemCount = 0;
+  size_t jumpCount = 0;
+
+  for (node = self->getFirstNode(); node; node = node->getNext()) {
+    uint32_t delta = X86Compiler_getRelaxDelta(node);
+    if (delta)
+      node->as<CBInst>()->addOptions(X86Inst::kOptionLongForm);
+
+    size_t start = dst->getOffset();
+    err = self->_serializeNode(dst, node);
+
+    if (ASMJIT_UNLIKELY(err)) {
+      if (delta)
+        node->as<CBInst>()->delOptions(X86Inst::kOptionLongForm);
+      break;
+    }
+
+    X86RelaxItem* item = &items[itemCount];
+    item->node = node;
+    item->sectionId = dst->_section->getId();
+    item->start = start;
+    item->end = dst->getOffset();
+    item->target = kInvalidValue;
+    item->delta = delta;
+    item->isShort = false;
+
+    switch (node->getType()) {
+      case CBNode::kNodeInst:
+        if (delta) {
+          item->type = X86RelaxItem::kTypeJump;
+          item->data = node->as<CBInst>()->getOpArray()[0].getId();
+          itemCount++;
+          jumpCount++;
+        }
+        break;
+
+      case CBNode::kNodeAlign: {
+        uint32_t alignment = node->as<CBAlign>()->getAlignment();
+        if (alignment > 1) {
+          item->type = X86RelaxItem::kTypeAlign;
+          item->data = alignment;
+          itemCount++;
+        }
+        break;
+      }
+
+      case CBNode::kNodeConstPool: {
+        uint32_t alignment = static_cast<uint32_t>(node->as<CBConstPool>()->getConstPool().getAlignment());
+        size_t labelOffset = start + Utils::alignDiff<size_t>(start, alignment);
+
+        item->type = X86RelaxItem::kTypeAlign;
+        item->end = labelOffset;
+        item->data = alignment;
+
+        item[1] = item[0];
+        item[1].type = X86RelaxItem::kTypeLabel;
+        item[1].start = labelOffset;
+        item[1].end = labelOffset;
+        item[1].data = node->as<CBLabel>()->getId();
+        itemCount += 2;
+        break;
+      }
+
+      case CBNode::kNodeFunc:
+      case CBNode::kNodeLabel:
+        item->type = X86RelaxItem::kTypeLabel;
+        item->end = start;
+        item->data = node->as<CBLabel>()->getId();
+        itemCount++;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+  size_t labelCount = code->getLabelsCount();
+  size_t sectionCount = code->getSections().getLength();
+
+  dst->_globalOptions = globalOptions;
+  code->rollback(cp);
+  code->releaseCheckpoint(cp);
+
+  uint32_t* labelItems = nullptr;
+  size_t* sectionOffsets = nullptr;
+  size_t* sectionEnds = nullptr;
+  bool* sectionSeen = nullptr;
+
+  if (!err && jumpCount) {
+    labelItems = zone->allocT<uint32_t>(labelCount * sizeof(uint32_t));
+    sectionOffsets = zone->allocT<size_t>(sectionCount * sizeof(size_t));
+    sectionEnds = zone->allocT<size_t>(sectionCount * sizeof(size_t));
+    sectionSeen = zone->allocT<bool>(sectionCount * sizeof(bool));
+
+    if (ASMJIT_UNLIKELY(!labelItems || !sectionOffsets || !sectionEnds || !sectionSeen))
+      err = DebugUtils::errored(kErrorNoHeapMemory);
+  }
+
+  size_t i;
+  if (!err && jumpCount) {
+    for (i = 0; i < labelCount; i++)
+      labelItems[i] = kInvalidValue;
+
+    for (i = 0; i < itemCount; i++) {
+      X86RelaxItem& item = items[i];
+      uint32_t labelIndex = Operand::unpackId(item.data);
+      if (item.type == X86RelaxItem::kTypeLabel && labelIndex < labelCount)
+        labelItems[labelIndex] = static_cast<uint32_t>(i);
+    }
+
+    // Only a jump to a label bound by this serialization in the same section
+    // can be short.
+    for (i = 0; i < itemCount; i++) {
+      X86RelaxItem& item = items[i];
+      if (item.type != X86RelaxItem::kTypeJump)
+        continue;
+
+      uint32_t labelIndex = Operand::unpackId(item.data);
+      uint32_t target = labelIndex < labelCount ? labelItems[labelIndex] : static_cast<uint32_t>(kInvalidValue);
+
+      if (target != kInvalidValue && items[target].sectionId == item.sectionId) {
+        item.target = target;
+        item.isShort = true;
+      }
+    }
+
+    // Each iteration changes at least one jump from short to long, the loop
+    // ends after at most `jumpCount + 1` iterations.
+    bool changed;
+    do {
+      ::memset(sectionSeen, 0, sectionCount * sizeof(bool));
+
+      for (i = 0; i < itemCount; i++) {
+        X86RelaxItem& item = items[i];
+        uint32_t sectionId = item.sectionId;
+
+        // The code between items has the same size as when it was measured.
+        if (!sectionSeen[sectionId]) {
+          sectionSeen[sectionId] = true;
+          sectionOffsets[sectionId] = item.start;
+        }
+        else {
+          sectionOffsets[sectionId] += item.start - sectionEnds[sectionId];
+        }
+
+        sectionEnds[sectionId] = item.end;
+        item.offset = sectionOffsets[sectionId];
+
+        switch (item.type) {
+          case X86RelaxItem::kTypeJump:
+            sectionOffsets[sectionId] += item.end - item.start - (item.isShort ? item.delta : 0);
+            break;
+
+          case X86RelaxItem::kTypeAlign:
+            sectionOffsets[sectionId] += Utils::alignDiff<size_t>(item.offset, item.data);
+            break;
+        }
+      }
+
+      changed = false;
+      for (i = 0; i < itemCount; i++) {
+        X86RelaxItem& item = items[i];
+        if (item.type != X86RelaxItem::kTypeJump || !item.isShort)
+          continue;
+
+        size_t shortEnd = item.offset + (item.end - item.start - item.delta);
+        intptr_t displacement = static_cast<intptr_t>(items[item.target].offset) - static_cast<intptr_t>(shortEnd);
+
+        if (!Utils::isInt8(displacement)) {
+          item.isShort = false;
+          changed = true;
+        }
+      }
+    } while (changed);
+  }
+
+  // Use the selected forms, or restore the original options on failure.
+  for (i = 0; i < itemCount; i++) {
+    X86RelaxItem& item = items[i];
+    if (item.type != X86RelaxItem::kTypeJump)
+      continue;
+
+    CBInst* inst = item.node->as<CBInst>();
+    if (err)
+      inst->delOptions(X86Inst::kOptionLongForm);
+    else if (item.isShort)
+      inst->setOptions((inst->getOptions() & ~X86Inst::kOptionLongForm) | X86Inst::kOptionShortForm);
+  }
+
+  zone->reset();
+  return err;
+}
+
 // ============================================================================
 // [asmjit::X86Compiler - Finalize]
 // ============================================================================
@@ -70,7 +347,15 @@ Error X86Compiler::finalize() {
 
   for (size_t i = 0, len = passes.getLength(); i < len; i++) {
     CBPass* pass = passes[i];
+    pass->_zoneStats.reset();
     err = pass->process(&_cbPassZone);
+
+    // The zone is not reset during `process()`, so its usage is also its peak.
+    ZoneStats passZoneStats;
+    _cbPassZone.getStats(&passZoneStats);
+    passZoneStats.peakUsedBytes = passZoneStats.usedBytes;
+    pass->_zoneStats.add(passZoneStats);
+
     _cbPassZone.reset();
     if (err) break;
   }
@@ -80,10 +365,18 @@ Error X86Compiler::finalize() {
 
   // TODO: There must be possibility to attach more assemblers, this is not so nice.
   if (_code->_cgAsm) {
+    if (_globalHints & kHintRelaxJumps) {
+      err = X86Compiler_relaxJumps(this, _code->_cgAsm);
+      if (ASMJIT_UNLIKELY(err)) return setLastError(err);
+    }
     return serialize(_code->_cgAsm);
   }
   else {
     X86Assembler a(_code);
+    if (_globalHints & kHintRelaxJumps) {
+      err = X86Compiler_relaxJumps(this, &a);
+      if (ASMJIT_UNLIKELY(err)) return setLastError(err);
+    }
     return serialize(&a);
   }
 }
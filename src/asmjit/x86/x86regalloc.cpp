@@ -2867,7 +2867,7 @@ ASMJIT_INLINE uint32_t X86VarAlloc::guessAlloc(VirtReg* vreg, uint32_t allocable
   CBNode* node = _node;
   for (i = 0; i < maxLookAhead; i++) {
     X86RAData* raData = node->getPassData<X86RAData>();
-    RABits* liveness = raData ? raData->liveness : static_cast<RABits*>(nullptr);
+    RALiveSet* liveness = raData ? raData->liveness : static_cast<RALiveSet*>(nullptr);
 
     // If the variable becomes dead it doesn't make sense to continue.
     if (liveness && !liveness->getBit(raId)) break;
@@ -3920,7 +3920,7 @@ _NextGroup:
           // Update TiedReg's unuse flags based on liveness of the next node.
           if (!node_->isJcc()) {
             X86RAData* raData = node_->getPassData<X86RAData>();
-            RABits* liveness;
+            RALiveSet* liveness;
 
             if (raData && next && next->hasPassData() && (liveness = next->getPassData<RAData>()->liveness)) {
               TiedReg* tiedArray = raData->tiedArray;
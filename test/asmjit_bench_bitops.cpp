@@ -0,0 +1,320 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Dependencies]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./asmjit.h"
+
+using namespace asmjit;
+
+// ============================================================================
+// [Configuration]
+// ============================================================================
+
+static const uint32_t kNumRepeats = 5;
+static const uint32_t kNumKernelIterations = 200000;
+
+static const uint32_t kNumCompileIterations = 20;
+static const uint32_t kNumVirtRegs = 512;
+static const uint32_t kNumBlocks = 256;
+
+static const uint32_t kNumLivenessBlocks = 4000;
+static const uint32_t kNumLivenessAccumulators = 8;
+
+// ============================================================================
+// [Performance]
+// ============================================================================
+
+struct Performance {
+  static inline uint32_t now() {
+    return OSUtils::getTickCount();
+  }
+
+  inline void reset() {
+    tick = 0;
+    best = 0xFFFFFFFF;
+  }
+
+  inline uint32_t start() { return (tick = now()); }
+  inline uint32_t diff() const { return now() - tick; }
+
+  inline uint32_t end() {
+    tick = diff();
+    if (best > tick)
+      best = tick;
+    return tick;
+  }
+
+  uint32_t tick;
+  uint32_t best;
+};
+
+static double gbps(uint32_t time, uint64_t numBytes) {
+  if (!time) return 0.0;
+
+  double bytesTotal = static_cast<double>(numBytes);
+  return (bytesTotal * 1000) / (static_cast<double>(time) * 1024 * 1024 * 1024);
+}
+
+static const char* levelName(uint32_t level) {
+  switch (level) {
+    case BitOps::kLevelSSE2: return "SSE2";
+    case BitOps::kLevelAVX2: return "AVX2";
+    default                : return "Scalar";
+  }
+}
+
+// ============================================================================
+// [Kernels]
+// ============================================================================
+
+// Runs the kernel used by liveness analysis on bit-arrays of `numWords` words,
+// which correspond to functions having `numWords * kBitsPerWord` virtual regs.
+static void benchKernels(uint32_t level, size_t numWords) {
+  Performance perf;
+  perf.reset();
+
+  BitOps::BitWord* a = static_cast<BitOps::BitWord*>(::malloc(numWords * sizeof(BitOps::BitWord)));
+  BitOps::BitWord* b = static_cast<BitOps::BitWord*>(::malloc(numWords * sizeof(BitOps::BitWord)));
+  BitOps::BitWord* c = static_cast<BitOps::BitWord*>(::malloc(numWords * sizeof(BitOps::BitWord)));
+  if (!a || !b || !c) return;
+
+  ::memset(a, 0x55, numWords * sizeof(BitOps::BitWord));
+  ::memset(b, 0x0F, numWords * sizeof(BitOps::BitWord));
+
+  const BitOps::Funcs* funcs = BitOps::getFuncs(level);
+  size_t sum = 0;
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    perf.start();
+    for (uint32_t i = 0; i < kNumKernelIterations; i++) {
+      ::memcpy(c, b, numWords * sizeof(BitOps::BitWord));
+      sum += funcs->orAndNotSrc(a, a, c, numWords) != 0;
+      sum += funcs->popcount(c, numWords);
+    }
+    perf.end();
+  }
+
+  // Each iteration reads `a` and `c` twice and writes them once.
+  uint64_t numBytes = static_cast<uint64_t>(kNumKernelIterations) * numWords * sizeof(BitOps::BitWord) * 5;
+  printf("BitOps (%-6s) Words %-5u | Time: %-6u [ms] | Speed: %7.3f [GB/s] | Check: %u\n",
+    levelName(level), static_cast<unsigned int>(numWords),
+    perf.best, gbps(perf.best, numBytes), static_cast<unsigned int>(sum & 0xFFFF));
+
+  ::free(a);
+  ::free(b);
+  ::free(c);
+}
+
+// ============================================================================
+// [Compiler]
+// ============================================================================
+
+#if defined(ASMJIT_BUILD_X86)
+// Generates a function that has `kNumVirtRegs` virtual registers that are live
+// across `kNumBlocks` basic blocks, which branch backwards to form loops.
+static void generateLargeFunc(X86Compiler& cc) {
+  using namespace asmjit::x86;
+
+  cc.addFunc(FuncSignature2<intptr_t, intptr_t*, intptr_t>(cc.getCodeInfo().getCdeclCallConv()));
+
+  X86Gp src = cc.newIntPtr("src");
+  X86Gp cnt = cc.newIntPtr("cnt");
+  cc.setArg(0, src);
+  cc.setArg(1, cnt);
+
+  X86Gp* regs = static_cast<X86Gp*>(::malloc(kNumVirtRegs * sizeof(X86Gp)));
+  Label* labels = static_cast<Label*>(::malloc(kNumBlocks * sizeof(Label)));
+  if (!regs || !labels) return;
+
+  uint32_t i;
+  for (i = 0; i < kNumVirtRegs; i++) {
+    regs[i] = cc.newIntPtr();
+    cc.mov(regs[i], ptr(src, static_cast<int32_t>((i % 64) * sizeof(intptr_t))));
+  }
+
+  for (i = 0; i < kNumBlocks; i++)
+    labels[i] = cc.newLabel();
+
+  uint32_t seed = 1;
+  for (i = 0; i < kNumBlocks; i++) {
+    cc.bind(labels[i]);
+
+    for (uint32_t j = 0; j < 4; j++) {
+      seed = seed * 1103515245 + 12345;
+      uint32_t x = (seed >> 8) % kNumVirtRegs;
+      seed = seed * 1103515245 + 12345;
+      uint32_t y = (seed >> 8) % kNumVirtRegs;
+      cc.add(regs[x], regs[y]);
+    }
+
+    cc.dec(cnt);
+    cc.jnz(labels[(i / 8) * 8]);
+  }
+
+  for (i = 1; i < kNumVirtRegs; i++)
+    cc.add(regs[0], regs[i]);
+
+  cc.ret(regs[0]);
+  cc.endFunc();
+
+  ::free(regs);
+  ::free(labels);
+}
+
+static void benchCompile(uint32_t level) {
+  Performance perf;
+  perf.reset();
+
+  CodeInfo ci(ArchInfo::kTypeHost);
+  ci.setCdeclCallConv(CallConv::kIdHostCDecl);
+  size_t codeSize = 0;
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    perf.start();
+    for (uint32_t i = 0; i < kNumCompileIterations; i++) {
+      CodeHolder code;
+      code.init(ci);
+
+      X86Compiler cc(&code);
+      generateLargeFunc(cc);
+      if (cc.finalize() != kErrorOk)
+        printf("X86Compiler failed\n");
+      codeSize = code.getCodeSize();
+    }
+    perf.end();
+  }
+
+  printf("X86Compiler (%-6s) VirtRegs %-5u | Time: %-6u [ms] | Code: %u [bytes]\n",
+    levelName(level), kNumVirtRegs, perf.best, static_cast<unsigned int>(codeSize));
+}
+
+// Generates a function similar to machine-generated code, where each of
+// `kNumLivenessBlocks` blocks has its own label and short-lived registers,
+// and only a few accumulators are live across blocks.
+static void generateManyBlocksFunc(X86Compiler& cc) {
+  using namespace asmjit::x86;
+
+  cc.addFunc(FuncSignature2<intptr_t, intptr_t*, intptr_t>(cc.getCodeInfo().getCdeclCallConv()));
+
+  X86Gp src = cc.newIntPtr("src");
+  X86Gp cnt = cc.newIntPtr("cnt");
+  cc.setArg(0, src);
+  cc.setArg(1, cnt);
+
+  X86Gp acc[kNumLivenessAccumulators];
+  uint32_t i;
+
+  for (i = 0; i < kNumLivenessAccumulators; i++) {
+    acc[i] = cc.newIntPtr();
+    cc.xor_(acc[i], acc[i]);
+  }
+
+  for (i = 0; i < kNumLivenessBlocks; i++) {
+    Label L = cc.newLabel();
+    Label L_Skip = cc.newLabel();
+    cc.bind(L);
+
+    X86Gp a = cc.newIntPtr();
+    X86Gp b = cc.newIntPtr();
+    X86Gp c = cc.newIntPtr();
+
+    cc.mov(a, ptr(src, static_cast<int32_t>((i % 64) * sizeof(intptr_t))));
+    cc.lea(b, ptr(a, a));
+    cc.mov(c, b);
+    cc.xor_(c, a);
+    cc.add(acc[i % kNumLivenessAccumulators], c);
+
+    cc.dec(cnt);
+    cc.jz(L_Skip);
+    cc.mov(ptr(src, static_cast<int32_t>((i % 64) * sizeof(intptr_t))), b);
+    cc.jmp(L);
+    cc.bind(L_Skip);
+  }
+
+  for (i = 1; i < kNumLivenessAccumulators; i++)
+    cc.add(acc[0], acc[i]);
+
+  cc.ret(acc[0]);
+  cc.endFunc();
+}
+
+static void benchLiveness(uint32_t mode) {
+  static const char* modeNames[] = { "Auto", "Dense", "Sparse" };
+
+  Performance perf;
+  perf.reset();
+
+  CodeInfo ci(ArchInfo::kTypeHost);
+  ci.setCdeclCallConv(CallConv::kIdHostCDecl);
+
+  size_t codeSize = 0;
+  StringBuilder zoneReport;
+  Zone::PoolStats before, after;
+
+  // Disable the pool so all zone blocks are allocated from the system.
+  size_t poolLimit = Zone::getPoolLimit();
+  Zone::setPoolLimit(0);
+  Zone::getPoolStats(&before);
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    CodeHolder code;
+    code.init(ci);
+
+    X86Compiler cc(&code);
+    cc.setLivenessMode(mode);
+    generateManyBlocksFunc(cc);
+
+    perf.start();
+    if (cc.finalize() != kErrorOk)
+      printf("X86Compiler failed\n");
+    perf.end();
+
+    codeSize = code.getCodeSize();
+    zoneReport.clear();
+    cc.dumpZoneStats(zoneReport);
+  }
+
+  Zone::getPoolStats(&after);
+  Zone::setPoolLimit(poolLimit);
+
+  printf("Liveness (%-6s) Blocks %-5u | Finalize: %-6u [ms] | Zone blocks/compile: %8.1f | Code: %u [bytes]\n",
+    modeNames[mode], kNumLivenessBlocks, perf.best,
+    static_cast<double>(after.allocCount - before.allocCount) / kNumRepeats,
+    static_cast<unsigned int>(codeSize));
+  printf("%s", zoneReport.getData());
+}
+#endif // ASMJIT_BUILD_X86
+
+// ============================================================================
+// [Main]
+// ============================================================================
+
+int main() {
+  uint32_t hostLevel = BitOps::getHostLevel();
+  uint32_t level;
+
+  static const size_t numWords[] = { 8, 32, 128, 1024 };
+  for (size_t i = 0; i < ASMJIT_ARRAY_SIZE(numWords); i++)
+    for (level = BitOps::kLevelScalar; level <= hostLevel; level++)
+      benchKernels(level, numWords[i]);
+
+#if defined(ASMJIT_BUILD_X86)
+  for (level = BitOps::kLevelScalar; level <= hostLevel; level++) {
+    BitOps::setLevel(level);
+    benchCompile(level);
+  }
+
+  benchLiveness(X86Compiler::kLivenessDense);
+  benchLiveness(X86Compiler::kLivenessSparse);
+  benchLiveness(X86Compiler::kLivenessAuto);
+#endif // ASMJIT_BUILD_X86
+
+  return 0;
+}
@@ -0,0 +1,277 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Dependencies]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./asmjit.h"
+
+using namespace asmjit;
+
+// ============================================================================
+// [Configuration]
+// ============================================================================
+
+static const uint32_t kNumRepeats = 5;
+static const uint32_t kNumIterations = 200;
+static const uint32_t kNumAllocs = 500;
+static const uint32_t kMaxThreads = 8;
+
+static const uint32_t kFragLive = 20000;
+static const uint32_t kFragOps = 200000;
+
+// ============================================================================
+// [Performance]
+// ============================================================================
+
+struct Performance {
+  static inline uint32_t now() {
+    return OSUtils::getTickCount();
+  }
+
+  inline void reset() {
+    tick = 0;
+    best = 0xFFFFFFFF;
+  }
+
+  inline uint32_t start() { return (tick = now()); }
+  inline uint32_t diff() const { return now() - tick; }
+
+  inline uint32_t end() {
+    tick = diff();
+    if (best > tick)
+      best = tick;
+    return tick;
+  }
+
+  uint32_t tick;
+  uint32_t best;
+};
+
+static double mops(uint32_t time, size_t numOps) {
+  if (!time) return 0.0;
+
+  double opsTotal = static_cast<double>(numOps);
+  return (opsTotal * 1000) / (static_cast<double>(time) * 1000 * 1000);
+}
+
+// ============================================================================
+// [Thread]
+// ============================================================================
+
+struct BenchThread {
+  VMemMgr* mgr;
+  uint32_t seed;
+  uint32_t failed;
+};
+
+// Models a JIT that compiles many small functions and later drops them.
+static void benchThreadRun(BenchThread* t) {
+  void* ptrs[kNumAllocs];
+  uint32_t seed = t->seed;
+
+  for (uint32_t i = 0; i < kNumIterations; i++) {
+    for (uint32_t j = 0; j < kNumAllocs; j++) {
+      seed = seed * 1103515245 + 12345;
+      size_t size = 32 + ((seed >> 16) % 480);
+
+      void* p = t->mgr->alloc(size);
+      if (!p) {
+        t->failed++;
+        ptrs[j] = nullptr;
+        continue;
+      }
+
+      static_cast<uint8_t*>(p)[0] = 0xC3;
+      ptrs[j] = p;
+    }
+
+    for (uint32_t j = 0; j < kNumAllocs; j++)
+      t->mgr->release(ptrs[j]);
+  }
+}
+
+#if ASMJIT_OS_WINDOWS
+static DWORD WINAPI benchThreadEntry(LPVOID arg) {
+  benchThreadRun(static_cast<BenchThread*>(arg));
+  return 0;
+}
+#else
+static void* benchThreadEntry(void* arg) {
+  benchThreadRun(static_cast<BenchThread*>(arg));
+  return nullptr;
+}
+#endif
+
+static bool runThreads(VMemMgr& mgr, uint32_t numThreads) {
+  BenchThread threads[kMaxThreads];
+  uint32_t i;
+  bool ok = true;
+
+#if ASMJIT_OS_WINDOWS
+  HANDLE handles[kMaxThreads];
+#else
+  pthread_t handles[kMaxThreads];
+#endif
+
+  for (i = 0; i < numThreads; i++) {
+    threads[i].mgr = &mgr;
+    threads[i].seed = i + 1;
+    threads[i].failed = 0;
+
+#if ASMJIT_OS_WINDOWS
+    handles[i] = ::CreateThread(nullptr, 0, benchThreadEntry, &threads[i], 0, nullptr);
+#else
+    ::pthread_create(&handles[i], nullptr, benchThreadEntry, &threads[i]);
+#endif
+  }
+
+  for (i = 0; i < numThreads; i++) {
+#if ASMJIT_OS_WINDOWS
+    ::WaitForSingleObject(handles[i], INFINITE);
+    ::CloseHandle(handles[i]);
+#else
+    ::pthread_join(handles[i], nullptr);
+#endif
+    if (threads[i].failed)
+      ok = false;
+  }
+
+  return ok;
+}
+
+// ============================================================================
+// [Main]
+// ============================================================================
+
+enum BenchMode {
+  kModeShared = 0,
+  kModeArenas = 1,
+  kModeLargePages = 2
+};
+
+static const char* benchModeNames[] = { "Shared", "Arenas", "LargePg" };
+
+// Returns the throughput in MOps/s, `base` is the throughput of the same mode
+// with a single thread, which is used to report how the mode scales.
+static double benchVMem(uint32_t numThreads, uint32_t mode, double base) {
+  Performance perf;
+  perf.reset();
+
+  size_t largePageHits = 0;
+  size_t largePageMisses = 0;
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    VMemMgr mgr;
+    if (mode == kModeArenas && mgr.setThreadArenas(true) != kErrorOk) {
+      printf("Failed to enable thread arenas\n");
+      return 0.0;
+    }
+
+    if (mode == kModeLargePages && mgr.setLargePages(true) != kErrorOk) {
+      printf("Large pages are not supported\n");
+      return 0.0;
+    }
+
+    perf.start();
+    bool ok = runThreads(mgr, numThreads);
+    perf.end();
+
+    if (!ok) {
+      printf("Allocation failed\n");
+      return 0.0;
+    }
+
+    largePageHits += mgr.getLargePageHits();
+    largePageMisses += mgr.getLargePageMisses();
+  }
+
+  size_t numOps = static_cast<size_t>(numThreads) * kNumIterations * kNumAllocs * 2;
+  double speed = mops(perf.best, numOps);
+
+  printf("VMemMgr %-7s (%u threads) | Time: %-6u [ms] | Speed: %7.3f [MOps/s] | Scaling: %5.2fx",
+    benchModeNames[mode], numThreads, perf.best, speed, base > 0.0 ? speed / base : 1.0);
+
+  if (mode == kModeLargePages)
+    printf(" | Large Pages: %u hits, %u misses",
+      static_cast<unsigned int>(largePageHits), static_cast<unsigned int>(largePageMisses));
+
+  printf("\n");
+  return speed;
+}
+
+// Keeps `kFragLive` allocations alive and replaces random ones, which fragments
+// the memory the same way a long-running JIT that recompiles functions does.
+static void benchFragmentation(uint32_t strategy) {
+  Performance perf;
+  perf.reset();
+
+  size_t usedBytes = 0;
+  size_t allocatedBytes = 0;
+
+  void** live = static_cast<void**>(::malloc(sizeof(void*) * kFragLive));
+  if (!live) return;
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    VMemMgr mgr;
+    mgr.setStrategy(strategy);
+
+    uint32_t seed = 1;
+    uint32_t i;
+
+    for (i = 0; i < kFragLive; i++) {
+      seed = seed * 1103515245 + 12345;
+      live[i] = mgr.alloc(32 + ((seed >> 16) % 480));
+    }
+
+    perf.start();
+    for (i = 0; i < kFragOps; i++) {
+      seed = seed * 1103515245 + 12345;
+      uint32_t index = (seed >> 8) % kFragLive;
+
+      seed = seed * 1103515245 + 12345;
+      size_t size = (seed & 0x80000000U) && (seed & 0x7) == 0 ? 2048 + ((seed >> 16) % 6144)
+                                                               : 32 + ((seed >> 16) % 480);
+
+      mgr.release(live[index]);
+      live[index] = mgr.alloc(size);
+    }
+    perf.end();
+
+    usedBytes = mgr.getUsedBytes();
+    allocatedBytes = mgr.getAllocatedBytes();
+
+    for (i = 0; i < kFragLive; i++)
+      mgr.release(live[i]);
+  }
+
+  ::free(live);
+
+  double usage = allocatedBytes ? (static_cast<double>(usedBytes) * 100.0) / static_cast<double>(allocatedBytes) : 0.0;
+  printf("VMemMgr %-8s (fragmented) | Time: %-6u [ms] | Speed: %7.3f [MOps/s] | Usage: %5.1f%%\n",
+    strategy == VMemMgr::kStrategyBitmap ? "Bitmap" : "FirstFit",
+    perf.best, mops(perf.best, static_cast<size_t>(kFragOps) * 2), usage);
+}
+
+int main() {
+  benchFragmentation(VMemMgr::kStrategyFirstFit);
+  benchFragmentation(VMemMgr::kStrategyBitmap);
+
+  // Each thread allocates and releases the same amount of memory, so a mode
+  // scales if its throughput grows with the number of threads (and CPUs).
+  double base[3] = { 0.0, 0.0, 0.0 };
+  for (uint32_t numThreads = 1; numThreads <= kMaxThreads; numThreads *= 2) {
+    for (uint32_t mode = kModeShared; mode <= kModeLargePages; mode++) {
+      double speed = benchVMem(numThreads, mode, base[mode]);
+      if (numThreads == 1)
+        base[mode] = speed;
+    }
+  }
+
+  return 0;
+}
@@ -22,6 +22,13 @@ using namespace asmjit;
 static const uint32_t kNumRepeats = 10;
 static const uint32_t kNumIterations = 5000;
 
+static const uint32_t kNumStreamIterations = 500;
+static const uint32_t kNumStreamInsts = 4096;
+
+static const uint32_t kNumLargeRepeats = 3;
+static const size_t kLargeCodeSize = 32 * 1024 * 1024;
+static const size_t kLargeChunkSize = 64 * 1024;
+
 // ============================================================================
 // [Performance]
 // ============================================================================
@@ -62,6 +69,37 @@ static double mbps(uint32_t time, size_t outputSize) {
 // ============================================================================
 
 #if defined(ASMJIT_BUILD_X86)
+// Fills `records` with `kNumStreamInsts` instructions of 3 shapes, registers
+// and immediates differ in each instruction.
+static void generateStreamRecords(CodeEmitter::InstRecord* records, uint32_t archType) {
+  bool is64Bit = archType == ArchInfo::kTypeX64;
+  uint32_t mask = is64Bit ? 15 : 7;
+
+  for (uint32_t i = 0; i < kNumStreamInsts; i += 3) {
+    X86Gp r0 = x86::gpd(i & mask);
+    X86Gp r1 = x86::gpd((i >> 4) & mask);
+    X86Gp rb = is64Bit ? X86Gp(x86::gpq((i >> 2) & mask)) : X86Gp(x86::gpd((i >> 2) & mask));
+
+    CodeEmitter::InstRecord* r = records + i;
+    r[0].reset();
+    r[1].reset();
+    r[2].reset();
+
+    r[0].instId = X86Inst::kIdAdd;
+    r[0].operands[0] = r0;
+    r[0].operands[1] = r1;
+
+    r[1].instId = X86Inst::kIdMov;
+    r[1].operands[0] = r1;
+    r[1].operands[1] = x86::dword_ptr(rb, static_cast<int32_t>(i * 1024));
+
+    r[2].instId = X86Inst::kIdImul;
+    r[2].operands[0] = r0;
+    r[2].operands[1] = r1;
+    r[2].operands[2] = imm(static_cast<int32_t>(1000 + i));
+  }
+}
+
 static void benchX86(uint32_t archType) {
   CodeHolder code;
   Performance perf;
@@ -98,6 +136,82 @@ static void benchX86(uint32_t archType) {
   printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s]\n",
     "X86Assembler", archName, perf.best, mbps(perf.best, asmOutputSize));
 
+  // --------------------------------------------------------------------------
+  // [Bench - Assembler (Stream)]
+  // --------------------------------------------------------------------------
+
+  // Rounded up to a multiple of 3 as each step generates 3 records.
+  const uint32_t kNumRecords = (kNumStreamInsts + 2) / 3 * 3;
+  CodeEmitter::InstRecord* records = static_cast<CodeEmitter::InstRecord*>(
+    ::malloc(kNumRecords * sizeof(CodeEmitter::InstRecord)));
+
+  if (records) {
+    generateStreamRecords(records, archType);
+
+    for (uint32_t useStream = 0; useStream < 2; useStream++) {
+      perf.reset();
+      for (r = 0; r < kNumRepeats; r++) {
+        asmOutputSize = 0;
+        perf.start();
+        for (i = 0; i < kNumStreamIterations; i++) {
+          code.init(CodeInfo(archType));
+          code.attach(&a);
+
+          if (useStream) {
+            a.emitStream(records, kNumRecords);
+          }
+          else {
+            for (uint32_t j = 0; j < kNumRecords; j++)
+              a.emitOpArray(records[j].instId, records[j].operands, records[j].getOpCount());
+          }
+          asmOutputSize += code.getCodeSize();
+
+          code.reset(false); // Detaches `a`.
+        }
+        perf.end();
+      }
+
+      printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s] | %s\n",
+        "X86Assembler", archName, perf.best, mbps(perf.best, asmOutputSize),
+        useStream ? "emitStream()" : "emitOpArray() of the same records");
+    }
+
+    ::free(records);
+  }
+
+  // --------------------------------------------------------------------------
+  // [Bench - Assembler (Large)]
+  // --------------------------------------------------------------------------
+
+  for (uint32_t useChunks = 0; useChunks < 2; useChunks++) {
+    perf.reset();
+    for (r = 0; r < kNumLargeRepeats; r++) {
+      perf.start();
+
+      code.init(CodeInfo(archType));
+      if (useChunks)
+        code.setBufferChunkSize(&code.getSectionEntry(0)->getBuffer(), kLargeChunkSize);
+      code.attach(&a);
+
+      while (a.getOffset() < kLargeCodeSize)
+        asmtest::generateOpcodes(a);
+
+      asmOutputSize = code.getCodeSize();
+      void* dst = ::malloc(asmOutputSize);
+      if (dst) {
+        code.relocate(dst);
+        ::free(dst);
+      }
+
+      code.reset(false); // Detaches `a`.
+      perf.end();
+    }
+
+    printf("%-12s (%s) | Time: %-6u [ms] | Speed: %7.3f [MB/s] | %s\n",
+      "X86Assembler", archName, perf.best, mbps(perf.best, asmOutputSize),
+      useChunks ? "32MB + relocate(), chunked buffer" : "32MB + relocate(), contiguous buffer");
+  }
+
   // --------------------------------------------------------------------------
   // [Bench - CodeBuilder]
   // --------------------------------------------------------------------------
@@ -0,0 +1,318 @@
+// [AsmJit]
+// Complete x86/x64 JIT and Remote Assembler for C++.
+//
+// [License]
+// Zlib - See LICENSE.md file in the package.
+
+// [Dependencies]
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "./asmjit.h"
+#include "./asmjit_test_misc.h"
+
+using namespace asmjit;
+
+// ============================================================================
+// [Configuration]
+// ============================================================================
+
+static const uint32_t kNumRepeats = 5;
+static const uint32_t kNumIterations = 5000;
+static const uint32_t kNumNames = 100000;
+
+// ============================================================================
+// [Performance]
+// ============================================================================
+
+struct Performance {
+  static inline uint32_t now() {
+    return OSUtils::getTickCount();
+  }
+
+  inline void reset() {
+    tick = 0;
+    best = 0xFFFFFFFF;
+  }
+
+  inline uint32_t start() { return (tick = now()); }
+  inline uint32_t diff() const { return now() - tick; }
+
+  inline uint32_t end() {
+    tick = diff();
+    if (best > tick)
+      best = tick;
+    return tick;
+  }
+
+  uint32_t tick;
+  uint32_t best;
+};
+
+static double perCompile(uint64_t count, uint32_t numCompiles) {
+  return static_cast<double>(count) / static_cast<double>(numCompiles);
+}
+
+static double mops(uint32_t time, size_t numOps) {
+  if (!time) return 0.0;
+
+  double opsTotal = static_cast<double>(numOps);
+  return (opsTotal * 1000) / (static_cast<double>(time) * 1000 * 1000);
+}
+
+// ============================================================================
+// [Hash]
+// ============================================================================
+
+struct NameNode : public ZoneHashNode {
+  inline NameNode(const char* name, uint32_t hVal)
+    : ZoneHashNode(hVal),
+      name(name) {}
+
+  const char* name;
+};
+
+struct NameKey {
+  inline NameKey(const char* name, uint32_t hVal)
+    : name(name),
+      hVal(hVal) {}
+
+  inline bool matches(const NameNode* node) const { return ::strcmp(node->name, name) == 0; }
+
+  const char* name;
+  uint32_t hVal;
+};
+
+// Inserts and looks up `kNumNames` names, which are formatted like labels
+// created by a code generator, by a `ZoneHash` or `ZoneOpenHash`. Hashes are
+// precomputed to only measure the hash table.
+template<typename HashT>
+static void benchHash(const char* hashName, char** names, const uint32_t* hashes) {
+  Performance insertPerf;
+  Performance lookupPerf;
+
+  insertPerf.reset();
+  lookupPerf.reset();
+
+  uint32_t found = 0;
+  uint32_t i;
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    Zone zone(65536 - Zone::kZoneOverhead);
+    ZoneHeap heap(&zone);
+    HashT hash(&heap);
+
+    insertPerf.start();
+    for (i = 0; i < kNumNames; i++) {
+      hash.put(zone.newT<NameNode>(names[i], hashes[i]));
+    }
+    insertPerf.end();
+
+    found = 0;
+    lookupPerf.start();
+    for (uint32_t j = 0; j < 10; j++) {
+      for (i = 0; i < kNumNames; i++)
+        found += hash.get(NameKey(names[i], hashes[i])) != nullptr;
+    }
+    lookupPerf.end();
+  }
+
+  printf("%-12s | Insert: %-6u [ms] %7.3f [MOps/s] | Lookup: %-6u [ms] %7.3f [MOps/s] | Found: %u\n",
+    hashName,
+    insertPerf.best, mops(insertPerf.best, kNumNames),
+    lookupPerf.best, mops(lookupPerf.best, kNumNames * 10),
+    found / 10);
+}
+
+// ============================================================================
+// [Vector]
+// ============================================================================
+
+// Appends `kNumNames` pointers to a `ZoneVector` or `ZoneSegmentedVector`,
+// like `CodeHolder` appends labels, and reads them back by index. Reports the
+// zone memory left behind by growing the vector.
+template<typename VectorT>
+static void benchVector(const char* vectorName, char** names) {
+  Performance appendPerf;
+  Performance readPerf;
+
+  appendPerf.reset();
+  readPerf.reset();
+
+  size_t sum = 0;
+  size_t reserved = 0;
+  uint32_t i;
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    Zone zone(65536 - Zone::kZoneOverhead);
+    ZoneHeap heap(&zone);
+    VectorT vec;
+
+    appendPerf.start();
+    for (uint32_t j = 0; j < 10; j++) {
+      vec.clear();
+      for (i = 0; i < kNumNames; i++) {
+        if (vec.willGrow(&heap) != kErrorOk)
+          return;
+        vec.appendUnsafe(names[i]);
+      }
+    }
+    appendPerf.end();
+
+    sum = 0;
+    readPerf.start();
+    for (uint32_t j = 0; j < 10; j++) {
+      for (i = 0; i < kNumNames; i++)
+        sum += reinterpret_cast<uintptr_t>(vec[i]) & 0xFF;
+    }
+    readPerf.end();
+
+    ZoneStats zoneStats, heapStats;
+    zone.getStats(&zoneStats);
+    heap.getStats(&heapStats);
+    reserved = zoneStats.reservedBytes + heapStats.reservedBytes;
+  }
+
+  printf("%-12s | Append: %-6u [ms] %7.3f [MOps/s] | Index : %-6u [ms] %7.3f [MOps/s] | Reserved: %u [KB] | Check: %u\n",
+    vectorName,
+    appendPerf.best, mops(appendPerf.best, kNumNames * 10),
+    readPerf.best, mops(readPerf.best, kNumNames * 10),
+    static_cast<unsigned int>(reserved / 1024),
+    static_cast<unsigned int>(sum & 0xFFFF));
+}
+
+// Creates and looks up `kNumNames` named labels through `CodeHolder`.
+static void benchNamedLabels(char** names) {
+  Performance insertPerf;
+  Performance lookupPerf;
+
+  insertPerf.reset();
+  lookupPerf.reset();
+
+  uint32_t found = 0;
+  uint32_t i;
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    CodeHolder code;
+    code.init(CodeInfo(ArchInfo::kTypeHost));
+
+    insertPerf.start();
+    for (i = 0; i < kNumNames; i++) {
+      uint32_t id;
+      code.newNamedLabelId(id, names[i], Globals::kInvalidIndex, Label::kTypeGlobal, 0);
+    }
+    insertPerf.end();
+
+    found = 0;
+    lookupPerf.start();
+    for (uint32_t j = 0; j < 10; j++) {
+      for (i = 0; i < kNumNames; i++)
+        found += code.getLabelIdByName(names[i]) != 0;
+    }
+    lookupPerf.end();
+  }
+
+  printf("%-12s | Insert: %-6u [ms] %7.3f [MOps/s] | Lookup: %-6u [ms] %7.3f [MOps/s] | Found: %u\n",
+    "CodeHolder",
+    insertPerf.best, mops(insertPerf.best, kNumNames),
+    lookupPerf.best, mops(lookupPerf.best, kNumNames * 10),
+    found / 10);
+}
+
+// ============================================================================
+// [Main]
+// ============================================================================
+
+#if defined(ASMJIT_BUILD_X86)
+// Models a JIT that compiles many short functions, each by a fresh `CodeHolder`
+// and `X86Compiler`, which own zones that are released after each compile.
+static void benchCompile(uint32_t archType, size_t poolLimit) {
+  Performance perf;
+  perf.reset();
+
+  Zone::PoolStats before, after;
+  const char* archName = archType == ArchInfo::kTypeX86 ? "X86" : "X64";
+
+  Zone::setPoolLimit(poolLimit);
+  Zone::getPoolStats(&before);
+
+  CodeInfo ci(archType);
+  ci.setCdeclCallConv(archType == ArchInfo::kTypeX86 ? CallConv::kIdX86CDecl : CallConv::kIdX86SysV64);
+
+  for (uint32_t r = 0; r < kNumRepeats; r++) {
+    perf.start();
+    for (uint32_t i = 0; i < kNumIterations; i++) {
+      CodeHolder code;
+      code.init(ci);
+
+      X86Compiler cc(&code);
+      asmtest::generateAlphaBlend(cc);
+      cc.finalize();
+    }
+    perf.end();
+  }
+
+  Zone::getPoolStats(&after);
+  uint32_t numCompiles = kNumRepeats * kNumIterations;
+
+  printf("X86Compiler (%s) Pool %-8s | Time: %-6u [ms] | malloc/compile: %6.2f | free/compile: %6.2f | reused/compile: %6.2f\n",
+    archName, poolLimit ? "Enabled" : "Disabled", perf.best,
+    perCompile(after.allocCount - before.allocCount, numCompiles),
+    perCompile(after.releaseCount - before.releaseCount, numCompiles),
+    perCompile(after.reuseCount - before.reuseCount, numCompiles));
+}
+#endif // ASMJIT_BUILD_X86
+
+int main() {
+  char** names = static_cast<char**>(::malloc(sizeof(char*) * kNumNames));
+  uint32_t* hashes = static_cast<uint32_t*>(::malloc(sizeof(uint32_t) * kNumNames));
+  if (!names || !hashes) return 1;
+
+  // Shuffle the names, so lookups don't benefit from hashes of consecutive
+  // names being consecutive as well.
+  uint32_t* order = static_cast<uint32_t*>(::malloc(sizeof(uint32_t) * kNumNames));
+  if (!order) return 1;
+
+  uint32_t seed = 1;
+  for (uint32_t i = 0; i < kNumNames; i++)
+    order[i] = i;
+
+  for (uint32_t i = kNumNames - 1; i > 0; i--) {
+    seed = seed * 1103515245 + 12345;
+    uint32_t j = (seed >> 8) % (i + 1);
+    uint32_t t = order[i]; order[i] = order[j]; order[j] = t;
+  }
+
+  for (uint32_t i = 0; i < kNumNames; i++) {
+    char buf[64];
+    ::snprintf(buf, sizeof(buf), "kernel_%u_block_%u", order[i] / 64, order[i] % 64);
+
+    names[i] = static_cast<char*>(::malloc(::strlen(buf) + 1));
+    ::strcpy(names[i], buf);
+    hashes[i] = Utils::hashString(buf, ::strlen(buf));
+  }
+
+  benchHash< ZoneHash<NameNode> >("ZoneHash", names, hashes);
+  benchHash< ZoneOpenHash<NameNode> >("ZoneOpenHash", names, hashes);
+  benchNamedLabels(names);
+  benchVector< ZoneVector<char*> >("ZoneVector", names);
+  benchVector< ZoneSegmentedVector<char*> >("SegmentedVec", names);
+
+  for (uint32_t i = 0; i < kNumNames; i++)
+    ::free(names[i]);
+  ::free(names);
+  ::free(hashes);
+  ::free(order);
+
+#if defined(ASMJIT_BUILD_X86)
+  size_t limit = Zone::getPoolLimit();
+
+  benchCompile(ArchInfo::kTypeX86, 0);
+  benchCompile(ArchInfo::kTypeX86, limit);
+  benchCompile(ArchInfo::kTypeX64, 0);
+  benchCompile(ArchInfo::kTypeX64, limit);
+#endif // ASMJIT_BUILD_X86
+
+  return 0;
+}
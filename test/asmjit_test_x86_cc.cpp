@@ -1514,6 +1514,74 @@ public:
   }
 };
 
+// ============================================================================
+// [X86Test_AllocManyBlocks]
+// ============================================================================
+
+class X86Test_AllocManyBlocks : public X86Test {
+public:
+  X86Test_AllocManyBlocks(const char* name, uint32_t livenessMode)
+    : X86Test(name),
+      _livenessMode(livenessMode) {}
+
+  enum { kNumBlocks = 200, kNumAcc = 4 };
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_AllocManyBlocks("[Alloc] Many blocks (dense liveness)", X86Compiler::kLivenessDense));
+    mgr.add(new X86Test_AllocManyBlocks("[Alloc] Many blocks (sparse liveness)", X86Compiler::kLivenessSparse));
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.setLivenessMode(_livenessMode);
+    cc.addFunc(FuncSignature0<int>(CallConv::kIdHost));
+
+    X86Gp acc[kNumAcc];
+    uint32_t i;
+
+    for (i = 0; i < kNumAcc; i++) {
+      acc[i] = cc.newInt32("acc%u", i);
+      cc.xor_(acc[i], acc[i]);
+    }
+
+    // Each block has its own short-lived registers and a loop, which adds
+    // the block index to an accumulator twice.
+    for (i = 0; i < kNumBlocks; i++) {
+      Label L_Loop = cc.newLabel();
+      X86Gp t = cc.newInt32("t%u", i);
+      X86Gp k = cc.newInt32("k%u", i);
+
+      cc.mov(t, static_cast<int>(i));
+      cc.mov(k, 2);
+
+      cc.bind(L_Loop);
+      cc.add(acc[i % kNumAcc], t);
+      cc.dec(k);
+      cc.jnz(L_Loop);
+    }
+
+    for (i = 1; i < kNumAcc; i++)
+      cc.add(acc[0], acc[i]);
+
+    cc.ret(acc[0]);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(void);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = func();
+    int expectRet = kNumBlocks * (kNumBlocks - 1);
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+
+  uint32_t _livenessMode;
+};
+
 // ============================================================================
 // [X86Test_AllocInt8]
 // ============================================================================
@@ -3493,6 +3561,228 @@ public:
   static void ASMJIT_FASTCALL handler() { longjmp(globalJmpBuf, 1); }
 };
 
+// ============================================================================
+// [X86Test_MiscRollback]
+// ============================================================================
+
+class X86Test_MiscRollback : public X86Test {
+public:
+  X86Test_MiscRollback() : X86Test("[Misc] Rollback") {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscRollback());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    cc.addFunc(FuncSignature1<int, int>(CallConv::kIdHost));
+
+    X86Gp a = cc.newInt32("a");
+    X86Gp r = cc.newInt32("r");
+    Label L_Exit = cc.newLabel();
+
+    cc.setArg(0, a);
+    cc.mov(r, a);
+
+    X86Compiler::Checkpoint cp;
+    if (cc.saveCheckpoint(&cp) != kErrorOk)
+      return;
+
+    // Speculative code, which creates registers, labels, and constants, and
+    // binds `L_Exit`, which was created before the checkpoint.
+    for (uint32_t i = 0; i < 2; i++) {
+      X86Gp t = cc.newInt32("t");
+      Label L_Loop = cc.newLabel();
+
+      cc.mov(t, 10);
+      cc.bind(L_Loop);
+      cc.add(r, cc.newInt32Const(kConstScopeLocal, 1000));
+      cc.dec(t);
+      cc.jnz(L_Loop);
+      cc.bind(L_Exit);
+
+      if (cc.rollback(cp) != kErrorOk)
+        return;
+    }
+
+    if (cc.releaseCheckpoint(cp) != kErrorOk)
+      return;
+
+    cc.imul(r, r, 3);
+    cc.add(r, cc.newInt32Const(kConstScopeLocal, 7));
+    cc.bind(L_Exit);
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet = func(5);
+    int expectRet = 5 * 3 + 7;
+
+    result.setFormat("ret=%d", resultRet);
+    expect.setFormat("ret=%d", expectRet);
+
+    return resultRet == expectRet;
+  }
+};
+
+// ============================================================================
+// [X86Test_MiscHotCold]
+// ============================================================================
+
+class X86Test_MiscHotCold : public X86Test {
+public:
+  X86Test_MiscHotCold() : X86Test("[Misc] HotCold"), _pass(nullptr) {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscHotCold());
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    _pass = cc.newPassT<CBHotColdPass>();
+    cc.addPass(_pass);
+
+    cc.addFunc(FuncSignature1<int, int>(CallConv::kIdHost));
+
+    X86Gp a = cc.newInt32("a");
+    X86Gp r = cc.newInt32("r");
+
+    Label L_Cold = cc.newLabel();
+    Label L_Done = cc.newLabel();
+
+    cc.setArg(0, a);
+    cc.mov(r, a);
+    cc.test(a, a);
+    cc.js(L_Cold);
+    cc.add(r, cc.newInt32Const(kConstScopeLocal, 1));
+
+    cc.bind(L_Done);
+    cc.ret(r);
+
+    // Moved to ".text.cold", it references the constant pool and jumps back.
+    cc.markCold(L_Cold);
+    cc.bind(L_Cold);
+    cc.neg(r);
+    cc.add(r, cc.newInt32Const(kConstScopeLocal, 100));
+    cc.jmp(L_Done);
+
+    cc.endFunc();
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultHot = func(5);
+    int resultCold = func(-5);
+    uint32_t resultMoved = _pass->getMovedCount();
+
+    int expectHot = 5 + 1;
+    int expectCold = 5 + 100;
+    uint32_t expectMoved = 1;
+
+    result.setFormat("hot=%d cold=%d moved=%u", resultHot, resultCold, resultMoved);
+    expect.setFormat("hot=%d cold=%d moved=%u", expectHot, expectCold, expectMoved);
+
+    return resultHot == expectHot && resultCold == expectCold && resultMoved == expectMoved;
+  }
+
+  CBHotColdPass* _pass;
+};
+
+// ============================================================================
+// [X86Test_MiscRelaxJumps]
+// ============================================================================
+
+class X86Test_MiscRelaxJumps : public X86Test {
+public:
+  X86Test_MiscRelaxJumps() : X86Test("[Misc] RelaxJumps"), _code(nullptr), _unrelaxedSize(0) {}
+
+  static void add(X86TestManager& mgr) {
+    mgr.add(new X86Test_MiscRelaxJumps());
+  }
+
+  static void generate(X86Compiler& cc) {
+    cc.addFunc(FuncSignature1<int, int>(CallConv::kIdHost));
+
+    X86Gp a = cc.newInt32("a");
+    X86Gp r = cc.newInt32("r");
+
+    Label L_Near = cc.newLabel();
+    Label L_Far = cc.newLabel();
+    Label L_Else = cc.newLabel();
+    Label L_End = cc.newLabel();
+
+    cc.setArg(0, a);
+    cc.mov(r, a);
+
+    // Short.
+    cc.cmp(a, 0);
+    cc.je(L_Near);
+    cc.inc(r);
+    cc.bind(L_Near);
+
+    // Long, jumps over 200 bytes.
+    cc.cmp(a, 1);
+    cc.jne(L_Far);
+    for (uint32_t i = 0; i < 40; i++)
+      cc.add(r, 1000);
+    cc.bind(L_Far);
+
+    // Short.
+    cc.cmp(a, 2);
+    cc.jne(L_Else);
+    cc.add(r, 10);
+    cc.jmp(L_End);
+    cc.bind(L_Else);
+    cc.sub(r, 10);
+    cc.bind(L_End);
+
+    cc.ret(r);
+    cc.endFunc();
+  }
+
+  virtual void compile(X86Compiler& cc) {
+    // Compile the same function without relaxation to compare the size.
+    CodeHolder code;
+    code.init(cc.getCodeInfo());
+
+    X86Compiler unrelaxed(&code);
+    generate(unrelaxed);
+    unrelaxed.finalize();
+    _unrelaxedSize = code.getCodeSize();
+
+    _code = cc.getCode();
+    _code->setGlobalHints(_code->getGlobalHints() | CodeEmitter::kHintRelaxJumps);
+    generate(cc);
+  }
+
+  virtual bool run(void* _func, StringBuilder& result, StringBuilder& expect) {
+    typedef int (*Func)(int);
+    Func func = ptr_as_func<Func>(_func);
+
+    int resultRet0 = func(0);
+    int resultRet1 = func(1);
+    int resultRet2 = func(2);
+    size_t resultSaved = _unrelaxedSize - _code->getCodeSize();
+
+    int expectRet0 = -10;
+    int expectRet1 = 2 + 40000 - 10;
+    int expectRet2 = 3 + 10;
+    size_t expectSaved = 4 + 4 + 3;
+
+    result.setFormat("ret={%d, %d, %d} saved=%u", resultRet0, resultRet1, resultRet2, static_cast<unsigned int>(resultSaved));
+    expect.setFormat("ret={%d, %d, %d} saved=%u", expectRet0, expectRet1, expectRet2, static_cast<unsigned int>(expectSaved));
+
+    return resultRet0 == expectRet0 && resultRet1 == expectRet1 && resultRet2 == expectRet2 && resultSaved == expectSaved;
+  }
+
+  CodeHolder* _code;
+  size_t _unrelaxedSize;
+};
+
 // ============================================================================
 // [X86Test_Bug100]
 // ============================================================================
@@ -3621,6 +3911,7 @@ int main(int argc, char* argv[]) {
   ADD_TEST(X86Test_AllocIfElse2);
   ADD_TEST(X86Test_AllocIfElse3);
   ADD_TEST(X86Test_AllocIfElse4);
+  ADD_TEST(X86Test_AllocManyBlocks);
   ADD_TEST(X86Test_AllocInt8);
   ADD_TEST(X86Test_AllocArgsIntPtr);
   ADD_TEST(X86Test_AllocArgsFloat);
@@ -3658,6 +3949,9 @@ int main(int argc, char* argv[]) {
   ADD_TEST(X86Test_MiscMultiFunc);
   ADD_TEST(X86Test_MiscFastEval);
   ADD_TEST(X86Test_MiscUnfollow);
+  ADD_TEST(X86Test_MiscRollback);
+  ADD_TEST(X86Test_MiscHotCold);
+  ADD_TEST(X86Test_MiscRelaxJumps);
 
   // Bugs.
   ADD_TEST(X86Test_Bug100);